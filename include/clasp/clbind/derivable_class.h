@@ -215,7 +215,7 @@ namespace detail {
     void add_static_constant(const char *name, int val);
     void add_inner_scope(scope_ &s);
 
-    void add_cast(class_id src, class_id target, cast_function cast);
+    void add_cast(class_id src, class_id target, cast_function cast, std::ptrdiff_t offset = detail::cast_graph::no_static_offset);
 
   private:
     derivable_class_registration *m_registration;
@@ -291,7 +291,8 @@ public:
   int gen_base_info(detail::type_<To>) {
     add_base(typeid(To), detail::static_cast_<T, To>::execute);
     add_cast(
-             reg::registered_class<T>::id, reg::registered_class<To>::id, detail::static_cast_<T, To>::execute);
+             reg::registered_class<T>::id, reg::registered_class<To>::id, detail::static_cast_<T, To>::execute,
+             detail::static_upcast_offset<T, To>());
 
     add_downcast((To *)0, (T *)0, boost::is_polymorphic<To>());
     return 0;
@@ -540,7 +541,8 @@ private:
   template <class U>
   void add_wrapper_cast(U *) {
     add_cast(
-             reg::registered_class<U>::id, reg::registered_class<T>::id, detail::static_cast_<U, T>::execute);
+             reg::registered_class<U>::id, reg::registered_class<T>::id, detail::static_cast_<U, T>::execute,
+             detail::static_upcast_offset<U, T>());
 
     add_downcast((T *)0, (U *)0, boost::is_polymorphic<T>());
   }
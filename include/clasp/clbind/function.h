@@ -146,28 +146,42 @@ public:
     std::tuple<translate::from_object<ARGS,PUREOUTS>...> all_args(arg_tuple<0,Pols,ARGS...>::goFrame(frame->arguments()));
     return apply_and_return<RT,Pols,decltype(closure->fptr),decltype(all_args)>::go(returnValues,std::move(closure->fptr),std::move(all_args));
   }
+
+  // The fixed arity entry points are what compiled code calls when it knows the
+  // callee. When the lambda list is just the required arguments they are
+  // translated where they were passed, without a frame or the lambda list handler.
+  static inline LCC_RETURN entry_point_fixed(core::T_O* lcc_closure, size_t lcc_nargs, core::T_O** lcc_args)
+  {
+    MyType* closure = gctools::untag_general<MyType*>((MyType*)lcc_closure);
+    if (!core::lisp_lambdaListHandlerDirectArgumentsP(closure->_lambdaListHandler,lcc_nargs))
+      return entry_point_n(lcc_closure,lcc_nargs,lcc_args);
+    INCREMENT_FUNCTION_CALL_COUNTER(closure);
+    core::MultipleValues& returnValues = core::lisp_multipleValues();
+    std::tuple<translate::from_object<ARGS,PUREOUTS>...> all_args(arg_tuple<0,Pols,ARGS...>::goFrame(lcc_args));
+    return apply_and_return<RT,Pols,decltype(closure->fptr),decltype(all_args)>::go(returnValues,std::move(closure->fptr),std::move(all_args));
+  }
     static inline LISP_ENTRY_0() {
-    return entry_point_n(lcc_closure,0,NULL);
+    return entry_point_fixed(lcc_closure,0,NULL);
   }
   static inline LISP_ENTRY_1() {
     core::T_O* args[1] = {lcc_farg0};
-    return entry_point_n(lcc_closure,1,args);
+    return entry_point_fixed(lcc_closure,1,args);
   }
   static inline LISP_ENTRY_2() {
     core::T_O* args[2] = {lcc_farg0,lcc_farg1};
-    return entry_point_n(lcc_closure,2,args);
+    return entry_point_fixed(lcc_closure,2,args);
   }
   static inline LISP_ENTRY_3() {
     core::T_O* args[3] = {lcc_farg0,lcc_farg1,lcc_farg2};
-    return entry_point_n(lcc_closure,3,args);
+    return entry_point_fixed(lcc_closure,3,args);
   }
   static inline LISP_ENTRY_4() {
     core::T_O* args[4] = {lcc_farg0,lcc_farg1,lcc_farg2,lcc_farg3};
-    return entry_point_n(lcc_closure,4,args);
+    return entry_point_fixed(lcc_closure,4,args);
   }
   static inline LISP_ENTRY_5() {
     core::T_O* args[5] = {lcc_farg0,lcc_farg1,lcc_farg2,lcc_farg3,lcc_farg4};
-    return entry_point_n(lcc_closure,5,args);
+    return entry_point_fixed(lcc_closure,5,args);
   }
 
 };
@@ -214,28 +228,42 @@ public:
     std::tuple<translate::from_object<ARGS>...> all_args(arg_tuple<0,policies<>,ARGS...>::goFrame(frame->arguments()));
     return clasp_apply_and_return<RT,core::policy::clasp,decltype(closure->fptr),decltype(all_args)>::go(returnValues,std::move(closure->fptr),std::move(all_args));
   }
+
+  // The fixed arity entry points are what compiled code calls when it knows the
+  // callee. When the lambda list is just the required arguments they are
+  // translated where they were passed, without a frame or the lambda list handler.
+  static inline LCC_RETURN entry_point_fixed(core::T_O* lcc_closure, size_t lcc_nargs, core::T_O** lcc_args)
+  {
+    MyType* closure = gctools::untag_general<MyType*>((MyType*)lcc_closure);
+    if (!core::lisp_lambdaListHandlerDirectArgumentsP(closure->_lambdaListHandler,lcc_nargs))
+      return entry_point_n(lcc_closure,lcc_nargs,lcc_args);
+    INCREMENT_FUNCTION_CALL_COUNTER(closure);
+    core::MultipleValues& returnValues = core::lisp_multipleValues();
+    std::tuple<translate::from_object<ARGS>...> all_args(arg_tuple<0,policies<>,ARGS...>::goFrame(lcc_args));
+    return clasp_apply_and_return<RT,core::policy::clasp,decltype(closure->fptr),decltype(all_args)>::go(returnValues,std::move(closure->fptr),std::move(all_args));
+  }
       static inline LISP_ENTRY_0() {
-    return entry_point_n(lcc_closure,0,NULL);
+    return entry_point_fixed(lcc_closure,0,NULL);
   }
   static inline LISP_ENTRY_1() {
     core::T_O* args[1] = {lcc_farg0};
-    return entry_point_n(lcc_closure,1,args);
+    return entry_point_fixed(lcc_closure,1,args);
   }
   static inline LISP_ENTRY_2() {
     core::T_O* args[2] = {lcc_farg0,lcc_farg1};
-    return entry_point_n(lcc_closure,2,args);
+    return entry_point_fixed(lcc_closure,2,args);
   }
   static inline LISP_ENTRY_3() {
     core::T_O* args[3] = {lcc_farg0,lcc_farg1,lcc_farg2};
-    return entry_point_n(lcc_closure,3,args);
+    return entry_point_fixed(lcc_closure,3,args);
   }
   static inline LISP_ENTRY_4() {
     core::T_O* args[4] = {lcc_farg0,lcc_farg1,lcc_farg2,lcc_farg3};
-    return entry_point_n(lcc_closure,4,args);
+    return entry_point_fixed(lcc_closure,4,args);
   }
   static inline LISP_ENTRY_5() {
     core::T_O* args[5] = {lcc_farg0,lcc_farg1,lcc_farg2,lcc_farg3,lcc_farg4};
-    return entry_point_n(lcc_closure,5,args);
+    return entry_point_fixed(lcc_closure,5,args);
   }
 
 };
@@ -35,10 +35,12 @@ THE SOFTWARE.
 #include <limits>
 #include <map>
 #include <memory>
+#include <type_traits>
 #include <vector>
 #include <clasp/clbind/typeid.h>
 #include <clasp/clbind/class_rep.h>
 #include <boost/scoped_ptr.hpp>
+#include <boost/type_traits/is_virtual_base_of.hpp>
 #include <clasp/clbind/inheritance.fwd.h>
 
 namespace clbind {
@@ -46,6 +48,9 @@ namespace detail {
 
 class cast_graph {
 public:
+  //! The offset of a cast that can't be known until an object is seen
+  static std::ptrdiff_t const no_static_offset;
+
   cast_graph();
   ~cast_graph();
 
@@ -57,8 +62,13 @@ public:
 */
   std::pair<void *, int> cast(
       void *p, class_id src, class_id target, class_id dynamic_id, void const *dynamic_ptr) const;
-  void insert(class_id src, class_id target, cast_function cast);
+/*!
+   Add an edge to the graph. If static_offset is given the cast always adds
+   it to the pointer, and the cast from src to target is cached right away.
+*/
+  void insert(class_id src, class_id target, cast_function cast, std::ptrdiff_t static_offset = no_static_offset);
   void dump(FILE* fout);
+  void statistics(size_t& entries, size_t& precomputed, size_t& capacity) const;
 private:
   class impl;
   boost::scoped_ptr<impl> m_impl;
@@ -142,6 +152,19 @@ struct static_cast_ {
   }
 };
 
+// The offset that static_cast_<S,T> adds to every pointer, or
+// cast_graph::no_static_offset when T is a virtual base of S and
+// the offset depends on the object.
+template <class S, class T>
+std::ptrdiff_t static_upcast_offset() {
+  if (boost::is_virtual_base_of<T, S>::value)
+    return cast_graph::no_static_offset;
+  // Converting to a non-virtual base never reads the object
+  static typename std::aligned_storage<sizeof(S), alignof(S)>::type storage;
+  S *s = reinterpret_cast<S *>(&storage);
+  return (char *)static_cast<T *>(s) - (char *)s;
+}
+
 template <class S, class T>
 struct dynamic_cast_ {
   static void *execute(void *p) {
@@ -72,6 +72,9 @@ struct CommandLineOptions {
   std::string _RCFileName;
   bool _NoRc;
   bool _PauseForDebugger;
+  int _GcMarkers;
+  size_t _HeapMin;
+  size_t _HeapMax;
   std::string _ResourceDir;
   std::vector<std::string> _Args;
   bool optionArgP(int& iarg,std::string& val, const std::string& default_);
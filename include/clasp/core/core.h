@@ -937,6 +937,7 @@ uint64_t lisp_nameword(T_sp name);
   List_sp lisp_parse_declares(const string &packageName, const string &declarestring);
   LambdaListHandler_sp lisp_function_lambda_list_handler(List_sp lambda_list, List_sp declares, std::set<int> pureOutValues = std::set<int>());
 size_t lisp_lambdaListHandlerNumberOfSpecialVariables(LambdaListHandler_sp llh);
+bool lisp_lambdaListHandlerDirectArgumentsP(LambdaListHandler_sp llh, size_t nargs);
 
 
   void lisp_defineSingleDispatchMethod(T_sp name,
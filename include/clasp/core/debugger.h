@@ -127,6 +127,10 @@ void add_dynamic_library_using_origin(add_dynamic_library* callback, bool is_exe
  
 bool lookup_address_in_library(gctools::clasp_ptr_t address, gctools::clasp_ptr_t& start, gctools::clasp_ptr_t& end, std::string& libraryName, bool& isExecutable, uintptr_t& vtableStart, uintptr_t& vtableEnd );
 bool lookup_address(uintptr_t address, const char*& symbol, uintptr_t& start, uintptr_t& end);
+T_sp lisp_function_name_for_address(void* ip);
+bool maybe_demangle(const std::string& fnName, std::string& output);
+/*! A printable name for a return address in lisp or C++ code, used by the profilers */
+std::string profiler_address_name(uintptr_t pc);
 bool library_with_name(const std::string& name, bool isExecutable, std::string& libraryPath, uintptr_t& start, uintptr_t& end, uintptr_t& vtableStart, uintptr_t& vtableEnd );
 
 }; // namespace core
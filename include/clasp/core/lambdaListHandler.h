@@ -210,7 +210,8 @@ public:
   // ---------
   // Following are the methods that deal with preparing Lexical ActivationFrames for arguments
 
-  /*! Return true if the LambdaListHandler only has required arguments */
+  /*! Return true if the LambdaListHandler only has required arguments and
+      they are bound lexically to frame slots 0...n-1 in order */
   bool requiredLexicalArgumentsOnlyP_() const;
 CL_LISPIFY_NAME("lambdaListHandlerRequiredLexicalArgumentsOnlyP");
 CL_DEFMETHOD   inline bool requiredLexicalArgumentsOnlyP() const { return this->_RequiredLexicalArgumentsOnly; };
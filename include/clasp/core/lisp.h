@@ -207,10 +207,10 @@ struct CommandLineOptions;
 struct globals_t {
     mutable mp::SharedMutex _ActiveThreadsMutex; // _ActiveThreads
     mutable mp::SharedMutex _DefaultSpecialBindingsMutex;
-    mutable mp::SharedMutex _FinalizersMutex;
     mutable mp::SharedMutex _SourceFilesMutex; // Protect _SourceFileIndices
     mutable mp::SharedMutex _PackagesMutex; // Protect _PackageNameIndexMap
     mutable mp::SharedMutex _ThePathnameTranslationsMutex; // Protect _ThePathnameTranslations
+    mutable mp::SharedMutex _PathnameComponentsMutex; // Protect _Roots._PathnameComponents
     mutable mp::SharedMutex _UnixSignalHandlersMutex; // Protect _UnixSignalHandlers
 #ifdef DEBUG_MONITOR_SUPPORT
     mutable mp::SharedMutex _MonitorMutex;
@@ -267,13 +267,13 @@ struct globals_t {
                 _PathMax(CLASP_MAXPATHLEN),
                 _ActiveThreadsMutex(ACTVTHRD_NAMEWORD),
                 _DefaultSpecialBindingsMutex(SPCLBIND_NAMEWORD),
-                _FinalizersMutex(MPSMESSG_NAMEWORD),
                 _SourceFilesMutex(SRCFILES_NAMEWORD),
                 _PackagesMutex(PKGSMUTX_NAMEWORD),
 #ifdef DEBUG_MONITOR_SUPPORT
                 _MonitorMutex(LOGMUTEX_NAMEWORD),
 #endif
                 _ThePathnameTranslationsMutex(PNTRANSL_NAMEWORD),
+                _PathnameComponentsMutex(PNCOMPNT_NAMEWORD),
                 _UnixSignalHandlersMutex(UNIXSIGN_NAMEWORD),
                 _StackWarnSize(gctools::_global_stack_max_size * 0.9), // 6MB default stack size before warnings
                 _StackSampleCount(0),
@@ -329,7 +329,8 @@ class Lisp {
     T_sp                       _TerminalIO;
     List_sp                    _ActiveThreads;
     List_sp                    _DefaultSpecialBindings;
-    WeakKeyHashTable_sp        _Finalizers;
+    SimpleVector_sp            _Finalizers; // FINALIZER_SHARDS weak-key-hash-tables, see finalizers.h
+    SimpleVector_sp            _ExecutorQueues; // task rings of the executor, see mpPackage.h
     HashTable_sp               _Sysprop;
     HashTable_sp               _ClassTable;
     CharacterInfo              charInfo; // Contains GC managed pointers
@@ -366,6 +367,7 @@ class Lisp {
     DoubleFloat_sp _RehashThreshold;
     T_sp _NullStream;
     List_sp _ThePathnameTranslations; /* alist */
+    SimpleVector_sp _PathnameComponents; // direct mapped intern table for pathname component strings
     Complex_sp _ImaginaryUnit;
     Complex_sp _ImaginaryUnitNegative;
     Ratio_sp _PlusHalf;
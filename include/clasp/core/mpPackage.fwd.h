@@ -331,6 +331,7 @@ void debug_mutex_unlock(Mutex* m);
 #define SINGDISP_NAMEWORD 0x00534944474e4953
 #define LOGMUTEX_NAMEWORD 0x004554554d474f4c
 #define PNTRANSL_NAMEWORD 0x00534e4152544e50
+#define PNCOMPNT_NAMEWORD 0x004e504d4f434e50
 #define UNIXSIGN_NAMEWORD 0x0047495358494e55
 #define DEBGINFO_NAMEWORD 0x00464e4947424544
 #define OPENDYLB_NAMEWORD 0x004c59444e45504f
@@ -338,15 +339,37 @@ void debug_mutex_unlock(Mutex* m);
 #define SUSPBARR_NAMEWORD 0x0052424250535553
 #define DISSASSM_NAMEWORD 0x0053534153534944
 #define JITGDBIF_NAMEWORD 0x004942444754494a
+#define JITPROFL_NAMEWORD 0x00464f525054494a
+#define ALLOCSMP_NAMEWORD 0x004d53434f4c4c41
+#define FINALIZE_NAMEWORD 0x005a494c414e4946
+#define FINLTHRD_NAMEWORD 0x005248544c4e4946
+#define CASTGRPH_NAMEWORD 0x0050524754534143
+#define SHRDBNCH_NAMEWORD 0x00434e4244524853
+#define EXECQUE_NAMEWORD  0x0045555143455845
+#define EXECPRK_NAMEWORD  0x004b525043455845
 #define MPSMESSG_NAMEWORD 0x005353454d53504d     // MPSMESSG
 
+/*! Acquisitions of a Mutex are added to the contention table by nameword
+    in batches of this many */
+#define MUTEX_ACQUISITIONS_BATCH 1024
+/*! The most times a contended Mutex::lock spins before it sleeps */
+#define MUTEX_MAX_SPINS 100
+
+/*! Contended locks of a Mutex spin for a while, adapting the count to how
+    long the lock has recently taken to become free (as glibc's adaptive
+    mutexes do), before they sleep in pthread_mutex_lock.  Only they read the
+    clock and update the contention table that mp:lock-contention-report
+    prints.  Acquisitions are counted under the lock and added to that table
+    in batches. */
 struct Mutex {
-  Mutex() {};
+  Mutex() : _Acquisitions(0), _Spins(0) {};
   uint64_t _NameWord;
   pthread_mutex_t _Mutex;
   gctools::Fixnum _Counter;
   bool _Recursive;
-  Mutex(uint64_t nameword, bool recursive=false) : _NameWord(nameword), _Counter(0), _Recursive(recursive) {
+  uint32_t _Acquisitions; // since they were last added to the contention table
+  int32_t _Spins;         // running estimate of how many spins a contended lock needs
+  Mutex(uint64_t nameword, bool recursive=false) : _NameWord(nameword), _Counter(0), _Recursive(recursive), _Acquisitions(0), _Spins(0) {
     
     if (!recursive) {
       pthread_mutex_init(&this->_Mutex,NULL);
@@ -362,16 +385,24 @@ struct Mutex {
 #ifdef DEBUG_THREADS
     debug_mutex_lock(this);
 #endif
+    if (pthread_mutex_trylock(&this->_Mutex)==0) {
+      this->acquired();
+      return true;
+    }
     if (waitp) {
 #ifdef DEBUG_DTRACE_LOCK_PROBE
       DtraceLockProbe _guard((char*)&this->_NameWord);
 #endif
-      bool result = (pthread_mutex_lock(&this->_Mutex)==0);
-      ++this->_Counter;
-      return result;
+      return this->lockContended();
     }
-    return pthread_mutex_trylock(&this->_Mutex)==0;
+    return false;
   };
+  void acquired() {
+    ++this->_Counter;
+    if (++this->_Acquisitions == MUTEX_ACQUISITIONS_BATCH) this->addAcquisitions();
+  }
+  bool lockContended();
+  void addAcquisitions();
   void unlock() {
 #ifdef DEBUG_THREADS
     debug_mutex_unlock(this);
@@ -516,6 +547,132 @@ struct SharedMutex : public sf::contention_free_shared_mutex<> {
   };
 
 
+  /*! A reader/writer lock whose state is a single 32-bit word: the number of
+      readers (or WRITE_LOCKED) in the low bits, and flags for a pending
+      upgrade and for sleeping readers and writers in the high bits.  An
+      uncontended lock or unlock is one atomic operation; contended threads
+      sleep on a futex rather than polling.  Once a writer is waiting new
+      readers wait behind it.  The slow paths are in mpPackage.cc.
+
+      Only one thread at a time may upgrade its read lock.  writeTryLock(true)
+      returns false if another thread is upgrading, and the caller must then
+      release its read lock before trying again, because the other upgrader is
+      waiting for it.  writeLock(true) in that case releases the read lock and
+      waits like any writer, so what was read under it must be checked again.
+
+      A lock made with readBiased true also lets readers count themselves in
+      per-thread slots (BRAVO, Dice & Kogan 2019), so the readers of a
+      read-mostly lock don't all write the same cache line.  A writer turns
+      that off and waits for the slots to empty; a reader turns it back on
+      once enough time has passed to pay for the writer's wait. */
+  class FutexSharedMutex {
+  public:
+    static constexpr uint32_t READ_LOCKED = 1;
+    static constexpr uint32_t MASK = (1u << 29) - 1;
+    static constexpr uint32_t WRITE_LOCKED = MASK;
+    static constexpr uint32_t MAX_READERS = MASK - 1;
+    static constexpr uint32_t UPGRADING = 1u << 29;
+    static constexpr uint32_t READERS_WAITING = 1u << 30;
+    static constexpr uint32_t WRITERS_WAITING = 1u << 31;
+    static constexpr size_t BIAS_SLOTS = 32;
+    struct alignas(64) BiasSlot {
+      std::atomic<uint32_t> _Readers{0};
+    };
+  public:
+    uint64_t _ReadNameWord;
+    uint64_t _WriteNameWord;
+    std::atomic<uint32_t> _State;
+    std::atomic<uint32_t> _WriterNotify;
+    std::atomic<uint32_t> _UpgradeNotify;
+    bool _Upgraded; // The writer got the lock by upgrading a read lock
+    bool _ReadBiased;
+    std::atomic<bool> _Bias;
+    std::atomic<uint64_t> _InhibitBiasUntil;
+    BiasSlot* _BiasSlots;
+  public:
+    FutexSharedMutex(uint64_t nameword = 0, uint64_t writenameword = 0, bool readBiased = false) :
+      _ReadNameWord(nameword),
+      _WriteNameWord(writenameword ? writenameword : nameword),
+      _State(0), _WriterNotify(0), _UpgradeNotify(0),
+      _Upgraded(false), _ReadBiased(readBiased), _Bias(readBiased), _InhibitBiasUntil(0),
+      _BiasSlots(readBiased ? new BiasSlot[BIAS_SLOTS] : NULL) {};
+    FutexSharedMutex(const FutexSharedMutex&) = delete;
+    ~FutexSharedMutex() { delete[] this->_BiasSlots; };
+
+    static bool readLockable(uint32_t state) {
+      return (state & MASK) < MAX_READERS && !(state & (UPGRADING | READERS_WAITING | WRITERS_WAITING));
+    }
+    static bool unlocked(uint32_t state) { return (state & MASK) == 0; }
+    static bool writeLocked(uint32_t state) { return (state & MASK) == WRITE_LOCKED; }
+
+    void readLock() {
+      if (this->_BiasSlots && this->biasedReadLock()) return;
+      uint32_t state = this->_State.load(std::memory_order_relaxed);
+      if (!readLockable(state) ||
+          !this->_State.compare_exchange_weak(state, state + READ_LOCKED, std::memory_order_acquire, std::memory_order_relaxed))
+        this->readContended();
+    }
+    void readUnlock() {
+      if (this->_BiasSlots && this->biasedReadUnlock()) return;
+      uint32_t state = this->_State.fetch_sub(READ_LOCKED, std::memory_order_release) - READ_LOCKED;
+      if (state & (UPGRADING | WRITERS_WAITING)) this->readUnlockContended(state);
+    }
+
+    /* Pass true for upgrade if this thread holds a read lock that should
+       become the write lock. */
+    bool writeTryLock(bool upgrade = false) {
+      if (upgrade) return this->upgrade();
+      uint32_t state = this->_State.load(std::memory_order_relaxed);
+      do {
+        if (!unlocked(state)) return false;
+      } while (!this->_State.compare_exchange_weak(state, state + WRITE_LOCKED, std::memory_order_acquire, std::memory_order_relaxed));
+      // Readers in the bias slots, perhaps this thread, still hold the lock
+      if (!this->tryRevokeBias()) {
+        state = this->_State.fetch_sub(WRITE_LOCKED, std::memory_order_release) - WRITE_LOCKED;
+        if (state & (READERS_WAITING | WRITERS_WAITING)) this->wakeWriterOrReaders(state);
+        return false;
+      }
+      this->_Upgraded = false;
+      return true;
+    }
+    void writeLock(bool upgrade = false) {
+      if (upgrade) {
+        if (this->upgrade()) return;
+        this->readUnlock();
+      }
+      uint32_t state = 0;
+      if (!this->_State.compare_exchange_weak(state, WRITE_LOCKED, std::memory_order_acquire, std::memory_order_relaxed))
+        this->writeContended();
+      this->revokeBias();
+      this->_Upgraded = upgrade;
+    }
+    /*! If the write lock came from an upgrade it goes back to being a read
+        lock unless releaseReadLock is true. */
+    void writeUnlock(bool releaseReadLock = false) {
+      if (this->_Upgraded && !releaseReadLock) {
+        this->_Upgraded = false;
+        this->downgrade();
+        return;
+      }
+      this->_Upgraded = false;
+      uint32_t state = this->_State.fetch_sub(WRITE_LOCKED, std::memory_order_release) - WRITE_LOCKED;
+      if (state & (READERS_WAITING | WRITERS_WAITING)) this->wakeWriterOrReaders(state);
+    }
+  private:
+    bool biasedReadLock();
+    bool biasedReadUnlock();
+    void readContended();
+    void readUnlockContended(uint32_t state);
+    void writeContended();
+    bool upgrade();
+    void downgrade();
+    void revokeBias();
+    bool tryRevokeBias();
+    void wakeWriterOrReaders(uint32_t state);
+    bool wakeWriter();
+  };
+
+
   struct ConditionVariable {
     pthread_cond_t _ConditionVariable;
     ConditionVariable() {
@@ -130,6 +130,9 @@ typedef enum {Nascent = 0, // Has not yet started, may proceed to Active
     dont_expose<ConditionVariable> _SuspensionCV;
     size_t _StackSize;
     dont_expose<pthread_t> _TheThread;
+    std::atomic<uint32_t> _ExitNotify;   // a futex, 1 once the process has exited
+    std::atomic<bool> _Joined;           // pthread_join was called on _TheThread
+    std::atomic<bool> _KillRequested;    // process-kill was called
     // Need to match fields in the two GC's
 #if defined(USE_BOEHM) || defined(USE_MMTK)
     dont_expose<void*> thr_o;
@@ -146,7 +149,7 @@ typedef enum {Nascent = 0, // Has not yet started, may proceed to Active
         _InitialSpecialBindings(initialSpecialBindings), _ThreadInfo(NULL),
         _ReturnValuesList(nil<core::T_O>()), _Aborted(false),
         _AbortCondition(nil<core::T_O>()), _StackSize(stack_size), _Phase(Nascent),
-        _SuspensionMutex(SUSPBARR_NAMEWORD) {
+        _SuspensionMutex(SUSPBARR_NAMEWORD), _ExitNotify(0), _Joined(false), _KillRequested(false) {
       if (!function) {
         printf("%s:%d Trying to create a process and the function is NULL\n", __FILE__, __LINE__ );
       }
@@ -231,17 +234,17 @@ namespace mp {
     LISP_CLASS(mp, MpPkg, SharedMutex_O, "SharedMutex",core::CxxObject_O);
   public:
     CL_LISPIFY_NAME("make-shared-mutex");
-    CL_LAMBDA(&optional (name "Anonymous Read Mutex") (write-lock-name "Anonymous Write Mutex"));
-    CL_DOCSTRING("Create and return a fresh shared mutex with the given name.")
-    CL_DEF_CLASS_METHOD static SharedMutex_sp make_shared_mutex(core::T_sp readName,core::T_sp writeLockName) {
-      auto l = gctools::GC<SharedMutex_O>::allocate(readName,writeLockName);
+    CL_LAMBDA(&optional (name "Anonymous Read Mutex") (write-lock-name "Anonymous Write Mutex") read-biased);
+    CL_DOCSTRING("Create and return a fresh shared mutex with the given name. If read-biased is true readers count themselves in per-thread slots, which is faster for a mutex that is rarely write locked.")
+    CL_DEF_CLASS_METHOD static SharedMutex_sp make_shared_mutex(core::T_sp readName,core::T_sp writeLockName,bool readBiased=false) {
+      auto l = gctools::GC<SharedMutex_O>::allocate(readName,writeLockName,readBiased);
       return l;
     };
   public:
     core::T_sp  _Name;
     core::T_sp  _Owner;
-    UpgradableSharedMutex _SharedMutex;
-    SharedMutex_O(core::T_sp readName, core::T_sp writeName=nil<core::T_O>()) : _Name(readName), _Owner(nil<T_O>()),_SharedMutex(lisp_nameword(readName), 256, writeName.nilp() ? lisp_nameword(readName) : lisp_nameword(writeName)) {};
+    FutexSharedMutex _SharedMutex;
+    SharedMutex_O(core::T_sp readName, core::T_sp writeName=nil<core::T_O>(), bool readBiased=false) : _Name(readName), _Owner(nil<T_O>()),_SharedMutex(lisp_nameword(readName), writeName.nilp() ? lisp_nameword(readName) : lisp_nameword(writeName), readBiased) {};
     void write_lock(bool upgrade=false) {
       this->_SharedMutex.writeLock(upgrade);
     };
@@ -270,7 +273,7 @@ namespace mp {
     virtual void fixupInternalsForSnapshotSaveLoad( snapshotSaveLoad::Fixup* fixup ) {
       if (snapshotSaveLoad::operation(fixup) == snapshotSaveLoad::LoadOp) {
 //        printf("%s:%d:%s About to initialize an mp::SharedMutex for a Package_O object\n", __FILE__, __LINE__, __FUNCTION__ );
-        new (&this->_SharedMutex) mp::UpgradableSharedMutex(core::lisp_nameword(this->_Name));
+        new (&this->_SharedMutex) mp::FutexSharedMutex(this->_SharedMutex._ReadNameWord, this->_SharedMutex._WriteNameWord, this->_SharedMutex._ReadBiased);
       }
     }
   };
@@ -334,6 +337,15 @@ namespace mp {
     string __repr__() const override;
   };
   void mp__interrupt_process(Process_sp process, core::T_sp func);
+
+/*! The executor has at most this many worker processes */
+#define EXECUTOR_MAX_WORKERS 256
+/*! Capacity of a task ring when it is first used; rings double when full */
+#define EXECUTOR_INITIAL_CAPACITY 64
+
+  /*! The task rings of the executor, kept in _lisp->_Roots._ExecutorQueues.
+      Element 0 is the injection queue and element i is the deque of worker i. */
+  core::SimpleVector_sp make_executor_queues();
 };
 
 #endif
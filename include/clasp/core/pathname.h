@@ -111,6 +111,10 @@ public:
   T_sp _Name;
   T_sp _Type;
   T_sp _Version;
+  /*! The namestring is computed lazily by clasp_namestring and cached here,
+      it is unbound until then.  Code that changes a component of an existing
+      pathname must call invalidateNamestring. */
+  mutable T_sp _Namestring;
 
 public:
   /*! Returns either a Pathname_sp or LogicalPathname_sp depending on host */
@@ -129,10 +133,13 @@ public:
                  _Directory(nil<T_O>()),
                  _Name(nil<T_O>()),
                  _Type(nil<T_O>()),
-                 _Version(kw::_sym_unspecific){};
+                 _Version(kw::_sym_unspecific),
+                 _Namestring(unbound<T_O>()){};
 
   virtual ~Pathname_O(){};
 
+  void invalidateNamestring() { this->_Namestring = unbound<T_O>(); };
+
   virtual bool equal(T_sp obj) const;
   virtual bool equalp(T_sp obj) const { return this->equal(obj); };
   virtual void sxhash_(HashGenerator &hg) const;
@@ -161,9 +168,15 @@ public:
 namespace core {
 bool clasp_stringMatch(T_sp s, size_t j, size_t ls,
                        T_sp p, size_t i, size_t lp);
+bool clasp_stringMatchRaw(const char* s, size_t j, size_t ls,
+                          String_sp p, size_t i, size_t lp);
 bool clasp_logical_hostname_p(T_sp host);
 bool clasp_wild_string_p(T_sp item);
 T_sp clasp_namestring(T_sp x, int flags);
+/*! Component strings of parsed pathnames are interned in a table of this
+    many slots (a power of two) held in _lisp->_Roots._PathnameComponents */
+#define PATHNAME_COMPONENT_CACHE_SIZE 1024
+T_sp clasp_intern_pathname_component(T_sp component);
 Pathname_sp clasp_mergePathnames(T_sp path, T_sp def, T_sp defaultVersion);
 
 bool cl__pathname_match_p(T_sp path, T_sp mask);
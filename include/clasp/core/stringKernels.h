@@ -0,0 +1,77 @@
+/*
+    File: stringKernels.h
+*/
+
+/*
+Copyright (c) 2014, Christian E. Schafmeister
+
+CLASP is free software; you can redistribute it and/or
+modify it under the terms of the GNU Library General Public
+License as published by the Free Software Foundation; either
+version 2 of the License, or (at your option) any later version.
+
+See directory 'clasp/licenses' for full details.
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+/* -^- */
+#if !defined(CLASP_CORE_STRING_KERNELS_H)
+#define CLASP_CORE_STRING_KERNELS_H
+
+#include <cstddef>
+#include <cstdint>
+
+/*! Vectorized kernels over the raw storage of simple strings.
+    Base strings store one byte per character (claspChar) and
+    character strings store 32 bits per character (claspCharacter).
+    On x86-64 SSE2 is always used and AVX2 is selected at runtime when
+    the processor supports it; everything else gets a portable scalar version.
+    All of the searching kernels return the length of the searched range
+    (n) when nothing is found. */
+namespace core {
+namespace strkern {
+
+typedef uint32_t (*case_fn)(uint32_t);
+
+/*! Index of the first element equal to c in [s, s+n) */
+size_t find_char(const uint8_t* s, size_t n, uint8_t c);
+size_t find_char(const uint32_t* s, size_t n, uint32_t c);
+
+/*! Index of the last element equal to c in [s, s+n) */
+size_t rfind_char(const uint8_t* s, size_t n, uint8_t c);
+size_t rfind_char(const uint32_t* s, size_t n, uint32_t c);
+
+/*! Index of the first occurrence of needle[0..m) in hay[0..n) */
+size_t search(const uint8_t* hay, size_t n, const uint8_t* needle, size_t m);
+size_t search(const uint32_t* hay, size_t n, const uint32_t* needle, size_t m);
+
+/*! Index of the first position where a and b differ, n if they are equal */
+size_t mismatch(const uint8_t* a, const uint8_t* b, size_t n);
+size_t mismatch(const uint32_t* a, const uint32_t* b, size_t n);
+
+/*! Like mismatch but A-Z and a-z compare equal.  Only ASCII letters are
+    folded, which is what the C toupper used by string-equal does. */
+size_t mismatch_ascii_ci(const uint8_t* a, const uint8_t* b, size_t n);
+size_t mismatch_ascii_ci(const uint32_t* a, const uint32_t* b, size_t n);
+
+/*! Convert src into dst (which may alias src).  Blocks that are entirely
+    ASCII are converted with vector instructions, other blocks call fallback
+    for every element. */
+void upcase(const uint8_t* src, uint8_t* dst, size_t n, case_fn fallback);
+void upcase(const uint32_t* src, uint32_t* dst, size_t n, case_fn fallback);
+void downcase(const uint8_t* src, uint8_t* dst, size_t n, case_fn fallback);
+void downcase(const uint32_t* src, uint32_t* dst, size_t n, case_fn fallback);
+
+}; // namespace strkern
+}; // namespace core
+
+#endif
@@ -83,6 +83,8 @@ class Symbol_O : public General_O {
   mutable std::atomic<uint32_t> _BindingIdx;
   std::atomic<uint32_t>  _Flags;
   std::atomic<T_sp>   _PropertyList;
+  // (area value ...) for core:get-sysprop, replaced whole - see sysprop.cc
+  std::atomic<T_sp>   _Sysprops;
 
   friend class Instance_O;
   friend class Package_O;
@@ -217,7 +219,7 @@ public:
     uint32_t index = this->_BindingIdx.load(std::memory_order_relaxed);
     auto& bindings = my_thread->_Bindings;
     if (bindings.thread_local_boundp(index))
-      return bindings.thread_local_value(this);
+      return bindings.thread_local_value_at(index);
     else
 #endif
       return globalValue();
@@ -234,8 +236,9 @@ public:
   inline T_sp atomicSymbolValue() const {
 #ifdef CLASP_THREADS
     uint32_t index = this->_BindingIdx.load(std::memory_order_relaxed);
-    if (my_thread->_Bindings.thread_local_boundp(index))
-      return threadLocalSymbolValue();
+    auto& bindings = my_thread->_Bindings;
+    if (bindings.thread_local_boundp(index))
+      return bindings.thread_local_value_at(index);
 #endif
     return globalValueSeqCst();
   }
@@ -243,10 +246,13 @@ public:
   inline void set_atomicSymbolValue(T_sp nv) {
 #ifdef CLASP_THREADS
     uint32_t index = this->_BindingIdx.load(std::memory_order_relaxed);
-    if (my_thread->_Bindings.thread_local_boundp(index))
-      set_threadLocalSymbolValue(nv);
+    auto& bindings = my_thread->_Bindings;
+    if (bindings.thread_local_boundp(index)) {
+      bindings.set_thread_local_value_at(nv, index);
+      return;
+    }
 #endif
-    return set_globalValueSeqCst(nv);
+    set_globalValueSeqCst(nv);
   }
 
   inline T_sp casSymbolValue(T_sp cmp, T_sp new_value) {
@@ -288,7 +294,7 @@ public:
     uint32_t index = this->_BindingIdx.load(std::memory_order_relaxed);
     auto& bindings = my_thread->_Bindings;
     if (bindings.thread_local_boundp(index))
-      set_threadLocalSymbolValue(obj);
+      bindings.set_thread_local_value_at(obj, index);
     else
 #endif
       set_globalValue(obj);
@@ -300,7 +306,7 @@ public:
     uint32_t index = this->_BindingIdx.load(std::memory_order_relaxed);
     auto& bindings = my_thread->_Bindings;
     if (bindings.thread_local_boundp(index))
-      set_threadLocalSymbolValue(val);
+      bindings.set_thread_local_value_at(val, index);
     else
 #endif
       CONS_CAR(cell) = val;
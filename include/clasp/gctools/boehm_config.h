@@ -204,7 +204,11 @@
 #define PACKAGE_VERSION "8.2.0"
 
 /* Define to enable parallel marking. */
-/* #undef PARALLEL_MARK */
+/* Clasp: koga defines BOEHM_PARALLEL_MARK in config.h unless configured
+   with :boehm-parallel-mark nil. */
+#ifdef BOEHM_PARALLEL_MARK
+#define PARALLEL_MARK 1
+#endif
 
 /* If defined, redirect free to this function. */
 /* #undef REDIRECT_FREE */
@@ -0,0 +1,60 @@
+/*
+    File: finalizers.h
+*/
+
+/*
+Copyright (c) 2014, Christian E. Schafmeister
+
+CLASP is free software; you can redistribute it and/or
+modify it under the terms of the GNU Library General Public
+License as published by the Free Software Foundation; either
+version 2 of the License, or (at your option) any later version.
+
+See directory 'clasp/licenses' for full details.
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+/* -^- */
+#ifndef gctools_finalizers_H
+#define gctools_finalizers_H
+
+/*! The Lisp finalizers of an object are kept in one of FINALIZER_SHARDS
+    weak-key-hash-tables in _lisp->_Roots._Finalizers, chosen by the badge of
+    the object, and each shard has its own lock. */
+#define FINALIZER_SHARDS 64
+
+/*! A thread that registers a finalizer while the finalizer thread has
+    finalizers waiting to run waits this long for it to catch up */
+#define FINALIZER_BACKPRESSURE_SECONDS 0.1
+
+namespace gctools {
+
+  core::SimpleVector_sp make_finalizer_shards();
+
+  /*! Remove the Lisp finalizers of object from its shard and return them */
+  core::List_sp take_finalizers(core::T_sp object);
+
+  /*! Call one Lisp finalizer of object, through gctools::call-finalizer
+      once that is defined so that an error in it is reported and doesn't
+      unwind out of the collector */
+  void call_finalizer(core::T_sp finalizer, core::T_sp object);
+
+  /*! Wait for the finalizer thread to finish the finalizers it is running */
+  void finalizer_thread_drain();
+
+  /*! Stop the finalizer thread (if it is running) and run finalizers
+      where the collector finds them again */
+  void finalizer_thread_stop();
+
+};
+
+#endif
@@ -733,6 +733,20 @@ namespace gctools {
       return sp;
     };
 
+    /*! Allocate an object that the collector may collect but will never move */
+    template <typename... ARGS>
+    static smart_pointer_type immobile_allocate_kind(const Header_s::StampWtagMtag& the_header, size_t size, ARGS &&... args) {
+#if defined(USE_BOEHM)
+      // Boehm never moves anything - keep the usual (possibly atomic) pool
+      smart_pointer_type sp = GCObjectAppropriatePoolAllocator<OT, GCInfo<OT>::Policy>::allocate_in_appropriate_pool_kind(the_header,size,std::forward<ARGS>(args)...);
+#else
+      smart_pointer_type sp = GCObjectAppropriatePoolAllocator<OT, collectable_immobile>::allocate_in_appropriate_pool_kind(the_header,size,std::forward<ARGS>(args)...);
+#endif
+      GCObjectInitializer<OT, GCInfo<OT>::NeedsInitialization>::initializeIfNeeded(sp);
+      GCObjectFinalizer<OT, GCInfo<OT>::NeedsFinalization>::finalizeIfNeeded(sp);
+      handle_all_queued_interrupts();
+      return sp;
+    };
 
 
 
@@ -843,6 +857,15 @@ namespace gctools {
       return GCObjectAllocator<OT>::allocate_kind(Header_s::StampWtagMtag(OT::static_ValueStampWtagMtag),size,length,std::forward<ARGS>(args)...);
     }
 
+    /*! Like allocate_container but the container is never moved by the collector,
+        so the address of its data stays valid for as long as it is alive. */
+    template <typename... ARGS>
+    static smart_pointer_type allocate_immobile_container(int64_t length, ARGS &&... args) {
+      size_t capacity = std::abs(length);
+      size_t size = sizeof_container_with_header<OT>(capacity);
+      return GCObjectAllocator<OT>::immobile_allocate_kind(Header_s::StampWtagMtag::make_StampWtagMtag(OT::static_ValueStampWtagMtag),size,length,std::forward<ARGS>(args)...);
+    }
+
 
     template <typename... ARGS>
     static smart_pointer_type allocate_container_null_terminated_string( bool static_container_p,
@@ -22,16 +22,36 @@
 
 namespace gctools {
 #ifdef USE_BOEHM
+/*! Fill the cons free list of THREAD with a batch of SIZE byte objects
+    from the collector - defined in boehmGarbageCollection.cc */
+void boehm_refill_cons_free_list(ThreadLocalStateLowLevel* thread, size_t size);
+
+/*! Take a cons from the free list of this thread. Only a refill takes the
+    allocation lock, so threads that cons a lot don't fight over it.
+    Interrupts must be disabled - a handler that conses would corrupt the list.
+    The list head is in the ThreadLocalStateLowLevel on the thread stack and so
+    the conses on it stay alive; the ones left when the thread exits are garbage. */
+inline void* boehm_thread_local_cons(size_t size) {
+  ThreadLocalStateLowLevel* thread = my_thread_low_level;
+  if (__builtin_expect(thread->_ConsFreeList == NULL, 0)) {
+    boehm_refill_cons_free_list(thread,size);
+  }
+  void* result = thread->_ConsFreeList;
+  thread->_ConsFreeList = GC_NEXT(result);
+  GC_NEXT(result) = NULL;
+  return MAYBE_MONITOR_ALLOC(result,size);
+}
+
 template <typename Cons, typename...ARGS>
 inline Cons* do_boehm_cons_allocation(size_t size,ARGS&&... args)
 { RAII_DISABLE_INTERRUPTS();
 #ifdef USE_PRECISE_GC
-  Header_s* header = reinterpret_cast<Header_s*>(ALIGNED_GC_MALLOC_KIND(STAMP_UNSHIFT_MTAG(STAMPWTAG_CONS),size,global_cons_kind,&global_cons_kind));
+  Header_s* header = reinterpret_cast<Header_s*>(boehm_thread_local_cons(size));
 # ifdef DEBUG_BOEHMPRECISE_ALLOC
   printf("%s:%d:%s cons = %p\n", __FILE__, __LINE__, __FUNCTION__, cons );
 # endif
 #else
-  Header_s::StampWtagMtag* header = reinterpret_cast<Header_s::StampWtagMtag*>(ALIGNED_GC_MALLOC(size));
+  Header_s::StampWtagMtag* header = reinterpret_cast<Header_s::StampWtagMtag*>(boehm_thread_local_cons(size));
 #endif
   Cons* cons = (Cons*)HeaderPtrToConsPtr(header);
   new (header) Header_s::StampWtagMtag(cons);
@@ -0,0 +1,68 @@
+/*
+    File: heapDump.h
+*/
+
+/*
+Copyright (c) 2014, Christian E. Schafmeister
+
+CLASP is free software; you can redistribute it and/or
+modify it under the terms of the GNU Library General Public
+License as published by the Free Software Foundation; either
+version 2 of the License, or (at your option) any later version.
+
+See directory 'clasp/licenses' for full details.
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+/* -^- */
+#ifndef gctools_heapDump_H
+#define gctools_heapDump_H
+
+#include <unordered_map>
+#include <vector>
+
+namespace gctools {
+
+/*! The object graph reachable from the roots, as found by the same stamp aware
+    object walkers that gatherAllObjects and snapshot save use.
+    Objects are numbered in the order they are discovered and the edges of
+    object i are _Edges[_EdgeStart[i].._EdgeStart[i+1]).
+    The contents of weak objects are not followed, so weak references
+    never keep anything alive in the graph. */
+struct HeapGraph {
+  struct Root {
+    RootType _Type;
+    size_t   _Index;
+    uint32_t _Object;
+  };
+  std::unordered_map<Header_s*, uint32_t> _Ids;
+  std::vector<Header_s*> _Objects;
+  std::vector<uint64_t>  _EdgeStart;
+  std::vector<uint32_t>  _Edges;
+  std::vector<Root>      _Roots;
+
+  /*! Return the number of header, giving it the next one if it is new */
+  uint32_t idFor(Header_s* header) {
+    auto it = this->_Ids.find(header);
+    if (it != this->_Ids.end()) return it->second;
+    uint32_t id = this->_Objects.size();
+    this->_Ids[header] = id;
+    this->_Objects.push_back(header);
+    return id;
+  }
+};
+
+void buildHeapGraph(HeapGraph& graph);
+
+};
+
+#endif
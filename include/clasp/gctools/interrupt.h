@@ -8,6 +8,10 @@ namespace gctools {
 
   void handle_signal_now(int signo);
   void handle_all_queued_interrupts();
+
+  void request_safepoint(core::ThreadLocalState* thread);
+  void clear_safepoint_request(core::ThreadLocalState* thread);
+  void safepoint();
   
   void initialize_signals(int clasp_signal);
   void initialize_unix_signal_handlers();
@@ -1037,6 +1037,36 @@ namespace gctools {
 
 int handleFatalCondition();
 
+/*! Threads that mark in a Boehm collection, from --gc-markers.
+    Zero lets the collector decide. Must be set before the collector starts. */
+extern int global_gc_markers;
+
+/*! Heap sizes in bytes from --heap-min/--heap-max or CLASP_HEAP_MIN/CLASP_HEAP_MAX.
+    Zero means the collector's default. Under Boehm and MPS global_heap_max is a
+    soft limit: a collection that leaves more than that in use makes the thread
+    that collected call ext:heap-limit-exceeded at its next safepoint, and past
+    half of it the collector holds back on growing. Under MMTk it is the fixed
+    heap size and nothing is signaled. */
+extern size_t global_heap_min;
+extern std::atomic<size_t> global_heap_max;
+extern std::atomic<bool> global_heap_limit_handling;
+/*! The main Lisp thread. It handles the soft limit for collections in threads
+    with _ServiceThread set and in threads that aren't Lisp threads. */
+extern std::atomic<core::ThreadLocalState*> global_heap_limit_thread;
+#if defined(USE_BOEHM)
+/*! The collector's free space divisor at startup, see heap_after_collection */
+extern GC_word global_free_space_divisor;
+#elif defined(USE_MPS)
+/*! The arena's spare commit limit at startup, see heap_after_collection */
+extern size_t global_spare_commit_limit;
+#endif
+/*! Called by the collector after a collection with the bytes still in use,
+    in the thread that collected. It may hold the allocation lock, so this
+    must not allocate. */
+void heap_after_collection(size_t in_use);
+/*! The bytes the collector has in use right now */
+size_t heap_in_use();
+
  
 /* Start up the garbage collector and the main function.
        The main function is wrapped within this function */
@@ -1187,7 +1217,8 @@ struct SafeGCPark {
 
 namespace gctools {
 
-typedef enum { LispRoot, CoreSymbolRoot, SymbolRoot } RootType;
+/*! walkRoots only reports the first three, heap-dump adds the others */
+typedef enum { LispRoot, CoreSymbolRoot, SymbolRoot, SymbolValueRoot, StackRoot } RootType;
 
 /* When walking root objects, this callback is called repeatedly
    with the address of the root.
@@ -0,0 +1,132 @@
+/*
+    File: metrics.h
+*/
+
+/*
+Copyright (c) 2014, Christian E. Schafmeister
+
+CLASP is free software; you can redistribute it and/or
+modify it under the terms of the GNU Library General Public
+License as published by the Free Software Foundation; either
+version 2 of the License, or (at your option) any later version.
+
+See directory 'clasp/licenses' for full details.
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+/* -^- */
+#ifndef gctools_metrics_H
+#define gctools_metrics_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+/*! Runtime metrics: counters, gauges and duration histograms that any part of
+    the runtime can update without taking a lock.  Every metric is listed in
+    one registry, which gctools:metrics-snapshot returns as a plist and
+    gctools:metrics-dump writes in the Prometheus text format. */
+namespace gctools {
+namespace metrics {
+
+  /*! Counts up, never down */
+  struct Counter {
+    std::atomic<uint64_t> _Value{0};
+    inline void add(uint64_t n = 1) { this->_Value.fetch_add(n, std::memory_order_relaxed); };
+    inline uint64_t value() const { return this->_Value.load(std::memory_order_relaxed); };
+  };
+
+  /*! A value that can go up and down */
+  struct Gauge {
+    std::atomic<int64_t> _Value{0};
+    inline void add(int64_t n) { this->_Value.fetch_add(n, std::memory_order_relaxed); };
+    inline void set(int64_t n) { this->_Value.store(n, std::memory_order_relaxed); };
+    inline int64_t value() const { return this->_Value.load(std::memory_order_relaxed); };
+  };
+
+  /*! Durations in nanoseconds.  Bucket i counts the durations below
+      2^(HISTOGRAM_FIRST_BUCKET_BITS+i) ns that did not fit in bucket i-1,
+      so the first bucket is everything under about a microsecond and the
+      last one is everything from 2^34 ns, about 17 seconds, up. */
+#define HISTOGRAM_FIRST_BUCKET_BITS 10
+#define HISTOGRAM_BUCKETS 26
+  struct Histogram {
+    std::atomic<uint64_t> _Buckets[HISTOGRAM_BUCKETS] = {};
+    std::atomic<uint64_t> _Count{0};
+    std::atomic<uint64_t> _Sum{0};
+    std::atomic<uint64_t> _Max{0};
+    static inline size_t bucket(uint64_t ns) {
+      size_t bits = ns ? 64 - __builtin_clzll(ns) : 0;
+      if (bits <= HISTOGRAM_FIRST_BUCKET_BITS) return 0;
+      size_t index = bits - HISTOGRAM_FIRST_BUCKET_BITS;
+      return index < HISTOGRAM_BUCKETS ? index : HISTOGRAM_BUCKETS - 1;
+    };
+    inline void record(uint64_t ns) {
+      this->_Buckets[bucket(ns)].fetch_add(1, std::memory_order_relaxed);
+      this->_Count.fetch_add(1, std::memory_order_relaxed);
+      this->_Sum.fetch_add(ns, std::memory_order_relaxed);
+      uint64_t max = this->_Max.load(std::memory_order_relaxed);
+      while (ns > max && !this->_Max.compare_exchange_weak(max, ns, std::memory_order_relaxed)) {};
+    };
+  };
+
+  typedef int64_t (*GaugeFunction)();
+
+  /*! Register a metric under NAME (lower case words separated by underscores).
+      The metric must live for the rest of the process.
+      Registration never blocks; registering more than the registry holds
+      prints a warning and the metric is not reported. */
+  void register_counter(const char* name, const char* help, Counter* counter);
+  void register_gauge(const char* name, const char* help, Gauge* gauge);
+  void register_gauge_function(const char* name, const char* help, GaugeFunction fn);
+  void register_histogram(const char* name, const char* help, Histogram* histogram);
+
+  inline uint64_t now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+  };
+
+  /*! Record the time from construction to destruction in a histogram */
+  struct RAIITimer {
+    Histogram& _Histogram;
+    uint64_t   _Start;
+    RAIITimer(Histogram& h) : _Histogram(h), _Start(now_ns()) {};
+    ~RAIITimer() { this->_Histogram.record(now_ns() - this->_Start); };
+  };
+
+  // Metrics updated from other parts of the runtime
+  extern Counter   global_GCCollections;
+  extern Histogram global_GCCollectionTime;
+  extern Histogram global_GCPauseTime;
+  extern Histogram global_GCMarkTime;
+  extern Gauge     global_GCMarkers;
+  extern Histogram global_JITCompileTime;
+  extern Histogram global_FasoLoadTime;
+  extern Histogram global_DiscriminatorCompileTime;
+  extern Counter   global_DispatchMisses;
+  extern Counter   global_ThreadsStarted;
+  extern Gauge     global_ThreadsActive;
+
+  /*! Called by the collector specific code in boehmGarbageCollection.cc and
+      mpsGarbageCollection.cc */
+  void gc_collection_begin();
+  void gc_collection_end();
+  void gc_world_stopped();
+  void gc_world_started();
+  void gc_mark_begin();
+  void gc_mark_end();
+  /*! Record the total bytes allocated so far at the end of a collection. */
+  void gc_allocation_sample(int64_t bytes);
+
+}; // namespace metrics
+}; // namespace gctools
+
+#endif
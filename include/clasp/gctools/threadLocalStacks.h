@@ -27,15 +27,36 @@ namespace core {
       : _ThreadLocalBindings(true) // don't allocate GC memory ctor
     {}; // 
   public:
+    /*! This thread's values of the specials it has bound, indexed by the
+        symbol's _BindingIdx. Indices belong to symbols, not threads: one is
+        handed out when a symbol is proclaimed special or first bound, and
+        returned to global_BindingIndexPool when the symbol dies. A thread
+        holds no index of its own, so there is nothing to give back when it
+        exits; its vector is garbage once its ThreadLocalState is gone. */
     mutable gctools::Vec0<T_sp>           _ThreadLocalBindings;
   public:
     size_t new_binding_index() const;
     void release_binding_index(size_t index) const;
     uint32_t ensure_binding_index(const Symbol_O*) const;
+    void reserve_binding_indices();
     // Access
     T_sp thread_local_value(const Symbol_O*) const;
     void set_thread_local_value(T_sp, const Symbol_O*);
-    bool thread_local_boundp(int index) const;
+    /*! True if this thread has a binding at index.
+        This is on the path of every special variable read, so it's inline.
+        A symbol with no index has NO_THREAD_LOCAL_BINDINGS, which is
+        larger than any vector we'll ever have, so the size check covers it. */
+    inline bool thread_local_boundp(uint32_t index) const {
+      return (index < this->_ThreadLocalBindings.size())
+        && !gctools::tagged_no_thread_local_bindingp(this->_ThreadLocalBindings[index].raw_());
+    }
+    /*! Only valid after thread_local_boundp(index) has returned true. */
+    inline T_sp thread_local_value_at(uint32_t index) const {
+      return this->_ThreadLocalBindings[index];
+    }
+    inline void set_thread_local_value_at(T_sp value, uint32_t index) const {
+      this->_ThreadLocalBindings[index] = value;
+    }
   public:
     T_sp* thread_local_reference(const uint32_t) const;
   };
@@ -8,6 +8,15 @@ namespace gctools {
 
   extern "C" void HitAllocationSizeThreshold();
   extern "C" void HitAllocationNumberThreshold();
+  extern "C" void HitAllocationSampleCountdown(stamp_t stamp, size_t size);
+
+  /*! Mean number of bytes between allocation samples (see allocationSampler.cc) */
+  #define ALLOCATION_SAMPLE_INTERVAL (512*1024)
+
+  struct AllocationSampleBuffer;
+  extern AllocationSampleBuffer* allocation_sample_buffer_claim();
+  extern void allocation_sample_buffer_release(AllocationSampleBuffer* buffer);
+  extern void allocation_sampler_merge();
 
   extern void monitorAllocation(stamp_t k, size_t sz);
   extern void count_allocation(const stamp_t k);
@@ -35,6 +44,9 @@ namespace gctools {
    std::atomic<int64_t> _HitAllocationSizeCounter;
    size_t               _AllocationNumberThreshold;
    size_t               _AllocationSizeThreshold;
+   // Bytes left to allocate in this thread before the next allocation sample
+   int64_t              _SampleCountdown;
+   uint64_t             _SampleRandom;
 #ifdef DEBUG_MONITOR_ALLOCATIONS
    MonitorAllocations _Monitor;
 #endif
@@ -44,16 +56,22 @@ namespace gctools {
    , _AllocationNumberThreshold(16386)
      , _HitAllocationNumberCounter(0)
      , _HitAllocationSizeCounter(0)
+     , _SampleCountdown(ALLOCATION_SAMPLE_INTERVAL)
+     , _SampleRandom(0)
    {};
  GlobalAllocationProfiler(size_t size, size_t number) : _AllocationSizeThreshold(size), _AllocationNumberThreshold(number)
      , _HitAllocationNumberCounter(0)
      , _HitAllocationSizeCounter(0)
+     , _SampleCountdown(ALLOCATION_SAMPLE_INTERVAL)
+     , _SampleRandom(0)
    {};
     
    inline void registerAllocation(stamp_t stamp, size_t size) {
      this->_BytesAllocated += size;
      this->_AllocationSizeCounter += size;
      this->_AllocationNumberCounter++;
+     this->_SampleCountdown -= size;
+     if (this->_SampleCountdown < 0) HitAllocationSampleCountdown(stamp,size);
 #ifdef DEBUG_MEMORY_PROFILE
      if (this->_AllocationSizeCounter >= this->_AllocationSizeThreshold) {
        HitAllocationSizeThreshold();
@@ -99,6 +117,14 @@ namespace gctools {
     void*                  _StackTop;
     int                    _DisableInterrupts;
     GlobalAllocationProfiler _Allocations;
+#if defined(USE_BOEHM)
+    // Conses the collector handed this thread a block at a time, linked
+    // through their first word (see do_boehm_cons_allocation)
+    void*                  _ConsFreeList;
+#endif
+    // Allocation samples this thread recorded that haven't been merged into
+    // the sampler's tables yet
+    AllocationSampleBuffer* _SampleBuffer;
     // Time unwinds
     std::chrono::time_point<std::chrono::high_resolution_clock> _start_unwind;
     std::chrono::duration<size_t,std::nano>   _unwind_time;
@@ -67,6 +67,18 @@ namespace core {
     /*! Save CONS records so we don't need to do allocations
         to add to _PendingInterrupts */
     List_sp               _SparePendingInterruptRecords; // signal_queue on ECL
+    /*! Something is waiting for this thread's next safepoint, see
+        request_safepoint in interrupt.cc */
+    std::atomic<bool>     _SafepointRequested;
+    /*! A collection in this thread left the heap over the soft limit, see
+        heap_after_collection in memoryManagement.cc */
+    std::atomic<bool>     _HeapLimitPending;
+    /*! This thread's allocation sample buffer is filling up, see
+        HitAllocationSampleCountdown in allocationSampler.cc */
+    std::atomic<bool>     _SampleMergePending;
+    /*! The finalizer thread and executor workers run no user handlers, so
+        they pass the soft heap limit on to the main thread */
+    bool                  _ServiceThread;
     List_sp               _CatchTags;
     List_sp               _BufferStr8NsPool;
     List_sp               _BufferStrWNsPool;
@@ -0,0 +1,42 @@
+/*
+    File: jitProfiling.h
+*/
+
+/*
+Copyright (c) 2014, Christian E. Schafmeister
+
+CLASP is free software; you can redistribute it and/or
+modify it under the terms of the GNU Library General Public
+License as published by the Free Software Foundation; either
+version 2 of the License, or (at your option) any later version.
+
+See directory 'clasp/licenses' for full details.
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+/* -^- */
+#ifndef llvmo_jitProfiling_H
+#define llvmo_jitProfiling_H
+
+#include <clasp/llvmo/code.h>
+
+namespace llvmo {
+
+/*! Tell external profilers (perf) about the functions in a newly linked
+    object file, by appending to /tmp/perf-<pid>.map and/or a jitdump file.
+    Does nothing unless enabled with the CLASP_PERF_MAP or CLASP_JITDUMP
+    environment variables or with ext:jit-profiling-start. */
+void jit_profiling_register_object_file(ObjectFile_sp ofi);
+
+};
+
+#endif
@@ -147,7 +147,7 @@ void class_registration::register_() const {
     class_ids->put(m_wrapper_id, m_wrapper_type);
 
   BOOST_FOREACH (cast_entry const &e, m_casts) {
-    casts->insert(e.src, e.target, e.cast);
+    casts->insert(e.src, e.target, e.cast, e.offset);
   }
 
   if (m_bases.size() == 0) {
@@ -218,9 +218,9 @@ void class_base::add_inner_scope(scope_ &s) {
   m_registration->m_scope.operator, (s);
 }
 
-void class_base::add_cast(class_id src, class_id target, cast_function cast) {
+void class_base::add_cast(class_id src, class_id target, cast_function cast, std::ptrdiff_t offset) {
 //  printf("%s:%d:%s   src[%lu] target[%lu] cast=%p\n", __FILE__,__LINE__,__FUNCTION__,src,target,(void*)cast);
-  m_registration->m_casts.push_back(cast_entry(src, target, cast));
+  m_registration->m_casts.push_back(cast_entry(src, target, cast, offset));
 }
 
 void add_custom_name(type_id const &i, std::string &s) {
@@ -139,7 +139,7 @@ void derivable_class_registration::register_() const {
     class_ids->put(m_wrapper_id, m_wrapper_type);
 
   BOOST_FOREACH (cast_entry const &e, m_casts) {
-    casts->insert(e.src, e.target, e.cast);
+    casts->insert(e.src, e.target, e.cast, e.offset);
   }
 
 //  printf("%s:%d Registering Derivable class %s\n", __FILE__, __LINE__, _rep_(className).c_str());
@@ -215,9 +215,9 @@ void derivable_class_base::add_inner_scope(scope_ &s) {
 }
 
 void derivable_class_base::add_cast(
-    class_id src, class_id target, cast_function cast) {
+    class_id src, class_id target, cast_function cast, std::ptrdiff_t offset) {
   //            printf("%s:%d:%s   src[%" PRu "] target[%lu]\n", __FILE__,__LINE__,__FUNCTION__,src,target);
-  m_registration->m_casts.push_back(cast_entry(src, target, cast));
+  m_registration->m_casts.push_back(cast_entry(src, target, cast, offset));
 }
 }
 
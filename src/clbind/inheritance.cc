@@ -30,6 +30,7 @@ THE SOFTWARE.
 
 #define CLBIND_BUILDING
 
+#include <atomic>
 #include <limits>
 #include <map>
 #include <vector>
@@ -38,10 +39,9 @@ THE SOFTWARE.
 //#pragma clang diagnostic ignored "-Wunused-local-typedef"
 #include <boost/dynamic_bitset.hpp>
 #include <boost/foreach.hpp>
-#include <boost/tuple/tuple.hpp>
-#include <boost/tuple/tuple_comparison.hpp>
 #pragma clang diagnostic pop
 #include <clasp/core/foundation.h>
+#include <clasp/core/mpPackage.h>
 #include <clasp/clbind/inheritance.h>
 
 namespace clbind {
@@ -50,73 +50,200 @@ namespace detail {
 class_id const class_id_map::local_id_base =
     std::numeric_limits<class_id>::max() / 2;
 
+std::ptrdiff_t const cast_graph::no_static_offset =
+    std::numeric_limits<std::ptrdiff_t>::min();
+
 namespace {
 
 
 typedef std::pair<std::ptrdiff_t, int> cache_entry;
 
+// The cast cache is read by every call to a wrapped method that needs its
+// object cast, from any number of threads, and is written only when a cast is
+// seen for the first time or a class is registered.
+// Lookups take no lock.  A table is an open addressed array of pointers to
+// entries that never change once they are published, and a slot only ever goes
+// from empty to full.  Writers hold the cast graph lock; when a table gets half
+// full (or is invalidated) a new one is published in its place.  Readers may
+// still be probing a table or entry that was replaced, so those are kept until
+// the cache is destroyed - there is one cache for the life of the process and
+// replacing happens while classes are being registered.
 class cache {
 public:
   static std::ptrdiff_t const unknown;
   static std::ptrdiff_t const invalid;
 
+  cache();
+
   cache_entry get(
       class_id src, class_id target, class_id dynamic_id, std::ptrdiff_t object_offset) const;
 
+  // The caller must hold the cast graph lock for these
   void put_entry(
       class_id src, class_id target, class_id dynamic_id, std::ptrdiff_t object_offset, std::ptrdiff_t offset, int distance);
-
+  void put_precomputed(class_id src, class_id target, std::ptrdiff_t offset);
   void invalidate();
+  void statistics(size_t& entries, size_t& precomputed, size_t& capacity) const;
 
 private:
-  typedef boost::tuple<
-      class_id, class_id, class_id, std::ptrdiff_t> key_type;
-  typedef std::map<key_type, cache_entry> map_type;
-  map_type m_cache;
+  struct entry {
+    class_id src;
+    class_id target;
+    class_id dynamic_id;
+    std::ptrdiff_t object_offset;
+    cache_entry value;
+  };
+  struct table {
+    table(size_t capacity)
+        : mask(capacity - 1), count(0), slots(new std::atomic<entry const *>[capacity]) {
+      for (size_t i = 0; i < capacity; ++i)
+        slots[i].store(NULL, std::memory_order_relaxed);
+    }
+    size_t mask;
+    size_t count;
+    std::unique_ptr<std::atomic<entry const *>[]> slots;
+  };
+  static size_t const initial_capacity = 1024;
+
+  static size_t hash(class_id src, class_id target, class_id dynamic_id, std::ptrdiff_t object_offset) {
+    uint64_t h = src * 0x9E3779B97F4A7C15ULL;
+    h = (h ^ target) * 0xC2B2AE3D27D4EB4FULL;
+    h = (h ^ dynamic_id) * 0x165667B19E3779F9ULL;
+    h = (h ^ (uint64_t)object_offset) * 0x9E3779B97F4A7C15ULL;
+    return h ^ (h >> 29);
+  }
+  static void add(table *t, entry const *e);
+  entry const *make_entry(
+      class_id src, class_id target, class_id dynamic_id, std::ptrdiff_t object_offset, cache_entry value);
+  void publish(size_t capacity);
+
+  std::atomic<table *> m_table;
+  std::vector<std::unique_ptr<table>> m_tables;    // every table ever published
+  std::vector<std::unique_ptr<entry>> m_entries;   // every entry ever published
+  std::vector<entry const *> m_precomputed;        // entries made at class registration
+  size_t m_computed;                               // entries in m_table found by searching
 };
 
 std::ptrdiff_t const cache::unknown =
     std::numeric_limits<std::ptrdiff_t>::max();
 std::ptrdiff_t const cache::invalid = cache::unknown - 1;
 
+cache::cache() : m_table(NULL), m_computed(0) {
+  this->publish(initial_capacity);
+}
+
 cache_entry cache::get(
     class_id src, class_id target, class_id dynamic_id, std::ptrdiff_t object_offset) const {
-  map_type::const_iterator i = m_cache.find(
-      key_type(src, target, dynamic_id, object_offset));
-  if ( i != m_cache.end() ) {
-//    printf("%s:%d:%s Returning cache key_type(%lu,%lu,%lu,%ld) -> cache_entry(%ld,%d)\n",
-//           __FILE__, __LINE__, __FUNCTION__, src, target, dynamic_id, object_offset, i->second.first, i->second.second );
-    return i->second;
-  } else {
+  table const *t = m_table.load(std::memory_order_acquire);
+  for (size_t i = hash(src, target, dynamic_id, object_offset) & t->mask;; i = (i + 1) & t->mask) {
+    entry const *e = t->slots[i].load(std::memory_order_acquire);
+    if (!e) {
 //    printf("%s:%d:%s Returning cache key_type(%lu,%lu,%lu,%ld) -> cache_entry(unknown,-1)\n",
 //           __FILE__, __LINE__, __FUNCTION__, src, target, dynamic_id, object_offset );
-    return cache_entry(unknown, -1 );
+      return cache_entry(unknown, -1);
+    }
+    if (e->src == src && e->target == target && e->dynamic_id == dynamic_id && e->object_offset == object_offset) {
+//    printf("%s:%d:%s Returning cache key_type(%lu,%lu,%lu,%ld) -> cache_entry(%ld,%d)\n",
+//           __FILE__, __LINE__, __FUNCTION__, src, target, dynamic_id, object_offset, e->value.first, e->value.second );
+      return e->value;
+    }
   }
 }
 
+void cache::add(table *t, entry const *e) {
+  size_t i = hash(e->src, e->target, e->dynamic_id, e->object_offset) & t->mask;
+  while (t->slots[i].load(std::memory_order_relaxed))
+    i = (i + 1) & t->mask;
+  t->slots[i].store(e, std::memory_order_release);
+  ++t->count;
+}
+
+cache::entry const *cache::make_entry(
+    class_id src, class_id target, class_id dynamic_id, std::ptrdiff_t object_offset, cache_entry value) {
+  m_entries.emplace_back(new entry{src, target, dynamic_id, object_offset, value});
+  return m_entries.back().get();
+}
+
+// Make a new table holding the precomputed entries and publish it
+void cache::publish(size_t capacity) {
+  while (capacity < 2 * (m_precomputed.size() + 1))
+    capacity *= 2;
+  table *t = new table(capacity);
+  for (entry const *e : m_precomputed)
+    add(t, e);
+  m_tables.emplace_back(t);
+  m_computed = 0;
+  m_table.store(t, std::memory_order_release);
+}
+
 void cache::put_entry( class_id src, class_id target, class_id dynamic_id, std::ptrdiff_t object_offset, std::ptrdiff_t offset, int distance ) {
 #if 0
   printf("%s:%d:%s Adding to cache key_type(%lu,%lu,%lu,%ld) -> cache_entry(%ld,%d)\n",
          __FILE__, __LINE__, __FUNCTION__, src, target, dynamic_id, object_offset, offset, distance );
 #endif
-  m_cache.insert(std::make_pair(
-      key_type(src, target, dynamic_id, object_offset), cache_entry(offset, distance)));
+  // Another thread may have cached it while we searched
+  if (this->get(src, target, dynamic_id, object_offset).first != unknown)
+    return;
+  table *t = m_table.load(std::memory_order_relaxed);
+  if (2 * (t->count + 1) > t->mask + 1) {
+    // Copy everything into a table twice the size
+    table *bigger = new table(2 * (t->mask + 1));
+    for (size_t i = 0; i <= t->mask; ++i)
+      if (entry const *e = t->slots[i].load(std::memory_order_relaxed))
+        add(bigger, e);
+    m_tables.emplace_back(bigger);
+    m_table.store(bigger, std::memory_order_release);
+    t = bigger;
+  }
+  add(t, this->make_entry(src, target, dynamic_id, object_offset, cache_entry(offset, distance)));
+  ++m_computed;
 }
 
+// A non-virtual upcast adds the same offset to every pointer and is one step,
+// so the entry for a cast of the most derived object is known before any
+// object has been seen.
+void cache::put_precomputed(class_id src, class_id target, std::ptrdiff_t offset) {
+  if (src == target || this->get(src, target, src, 0).first != unknown)
+    return;
+  entry const *e = this->make_entry(src, target, src, 0, cache_entry(offset, 1));
+  m_precomputed.push_back(e);
+  table *t = m_table.load(std::memory_order_relaxed);
+  if (2 * (t->count + 1) > t->mask + 1)
+    this->publish(2 * (t->mask + 1)); // includes e
+  else
+    add(t, e);
+}
+
+// A new edge can only change the casts that were found by searching.
+// Precomputed entries are single steps along an edge and stay correct.
 void cache::invalidate() {
-  m_cache.clear();
+  if (m_computed == 0)
+    return;
+  table *t = m_table.load(std::memory_order_relaxed);
+  this->publish(t->mask + 1);
+}
+
+void cache::statistics(size_t& entries, size_t& precomputed, size_t& capacity) const {
+  table const *t = m_table.load(std::memory_order_acquire);
+  entries = t->count;
+  precomputed = m_precomputed.size();
+  capacity = t->mask + 1;
 }
 
 } // namespace unnamed
 
 class cast_graph::impl {
 public:
+  impl() : m_mutex(CASTGRPH_NAMEWORD) {};
   std::pair<void *, int> cast(
       void *p, class_id src, class_id target, class_id dynamic_id, void const *dynamic_ptr) const;
-  void insert_impl(class_id src, class_id target, cast_function cast);
+  void insert_impl(class_id src, class_id target, cast_function cast, std::ptrdiff_t static_offset);
   void dump_impl(FILE* fout);
+  void statistics_impl(size_t& entries, size_t& precomputed, size_t& capacity) const;
 private:
 //  std::vector<vertex> m_vertices;
+  // Held while the graph is searched or changed and while the cache is written
+  mutable mp::Mutex m_mutex;
   mutable cache m_cache;
 };
 
@@ -148,12 +275,6 @@ std::pair<void *, int> cast_graph::impl::cast(
     return std::make_pair(p, 0);
   }
 
-  if (src >= _lisp->_Roots._CastGraph.size() || target >= _lisp->_Roots._CastGraph.size()) {
-#ifdef DEBUG_CAST_GRAPH
-    printf("%s:%d:%s returning B pair(%p, %d)\n", __FILE__, __LINE__, __FUNCTION__, (void*)0, -1 );
-#endif
-    return std::pair<void *, int>((void *)0, -1);
-  }
   std::ptrdiff_t const object_offset =
       (char const *)dynamic_ptr - (char const *)p;
 
@@ -176,6 +297,15 @@ std::pair<void *, int> cast_graph::impl::cast(
     return std::make_pair((char *)p + cached.first, cached.second);
   }
 
+  // Only the graph is searched under the lock; every later cast is a cache hit
+  mp::RAIIReadWriteLock<mp::Mutex> lock(m_mutex);
+  if (src >= _lisp->_Roots._CastGraph.size() || target >= _lisp->_Roots._CastGraph.size()) {
+#ifdef DEBUG_CAST_GRAPH
+    printf("%s:%d:%s returning B pair(%p, %d)\n", __FILE__, __LINE__, __FUNCTION__, (void*)0, -1 );
+#endif
+    return std::pair<void *, int>((void *)0, -1);
+  }
+
   std::queue<queue_entry> q;
   q.push(queue_entry(p, src, 0));
 
@@ -211,8 +341,9 @@ std::pair<void *, int> cast_graph::impl::cast(
 }
 
 void cast_graph::impl::insert_impl(
-    class_id src, class_id target, cast_function cast) {
+    class_id src, class_id target, cast_function cast, std::ptrdiff_t static_offset) {
 //  printf("%s:%d:%s src=%lu target=%lu cast=%p\n", __FILE__, __LINE__, __FUNCTION__, src, target, (void*)cast);
+  mp::RAIIReadWriteLock<mp::Mutex> lock(m_mutex);
   class_id const max_id = std::max(src, target);
 
   if (max_id >= _lisp->_Roots._CastGraph.size()) {
@@ -228,7 +359,15 @@ void cast_graph::impl::insert_impl(
     edges.insert(ii, edge(target, cast));
     m_cache.invalidate();
   }
+  if (static_offset != no_static_offset)
+    m_cache.put_precomputed(src, target, static_offset);
 }
+
+void cast_graph::impl::statistics_impl(size_t& entries, size_t& precomputed, size_t& capacity) const {
+  mp::RAIIReadWriteLock<mp::Mutex> lock(m_mutex);
+  m_cache.statistics(entries, precomputed, capacity);
+}
+
 void cast_graph::impl::dump_impl(FILE* fout) {
   for ( class_id ii = 0; ii < _lisp->_Roots._CastGraph.size(); ++ ii ) {
     gctools::Vec0<edge>& edges = _lisp->_Roots._CastGraph[ii].edges;
@@ -256,9 +395,13 @@ std::pair<void *, int> cast_graph::cast(
   return m_impl->cast(p, src, target, dynamic_id, dynamic_ptr);
 }
 
-void cast_graph::insert(class_id src, class_id target, cast_function cast) {
+void cast_graph::insert(class_id src, class_id target, cast_function cast, std::ptrdiff_t static_offset) {
 //  printf("%s:%d:%s src=%lu target=%lu cast=%p\n", __FILE__, __LINE__, __FUNCTION__, src, target, (void*)cast);
-  m_impl->insert_impl(src, target, cast);
+  m_impl->insert_impl(src, target, cast, static_offset);
+}
+
+void cast_graph::statistics(size_t& entries, size_t& precomputed, size_t& capacity) const {
+  m_impl->statistics_impl(entries, precomputed, capacity);
 }
 
 void cast_graph::dump(FILE* fout) {
@@ -291,6 +434,15 @@ CL_DEFUN void clbind__dump_class_id_map() {
 };
 
 
+CL_DOCSTRING(R"dx(Return the number of casts in the clbind cast cache, how many of them were
+precomputed when classes were registered and the capacity of the cache table.)dx")
+DOCGROUP(clasp)
+CL_DEFUN core::T_mv clbind__cast_cache_statistics() {
+  size_t entries, precomputed, capacity;
+  globalCastGraph->statistics(entries, precomputed, capacity);
+  return Values(core::make_fixnum(entries), core::make_fixnum(precomputed), core::make_fixnum(capacity));
+}
+
 CL_LAMBDA(&optional filename)
 DOCGROUP(clasp)
 CL_DEFUN void clbind__dump_cast_graph(core::T_sp filename) {
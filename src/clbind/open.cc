@@ -68,6 +68,7 @@ detail::class_id_map *globalClassIdMap;
 class Test {
 public:
   Test() : multiplier(1234) {};
+  virtual ~Test() {};
 public:
   int  multiplier;
   std::vector<int> numbers;
@@ -75,6 +76,9 @@ public:
   void setMultiplier(int m) {
     this->multiplier = m;
   }
+  int getMultiplier() const {
+    return this->multiplier;
+  }
   void set2(int n0, int n1) {
     this->numbers.clear();
     printf("%s:%d In set2 n0-> %d n1-> %d\n", __FILE__, __LINE__, n0, n1);
@@ -130,6 +134,20 @@ public:
   TestChild() : Test() {};
 };
 
+// A second base so that casting a TestGrandChild to it moves the pointer
+class TestMixin {
+public:
+  TestMixin() : tag(42) {};
+  virtual ~TestMixin() {};
+  int tag;
+  int getTag() const { return this->tag; }
+};
+
+class TestGrandChild : public TestChild, public TestMixin {
+public:
+  TestGrandChild() : TestChild(), TestMixin() {};
+};
+
 
 
 void initializeCastGraph() {
@@ -148,6 +166,7 @@ CLBIND_API void initialize_clbind() {
       .def_constructor("MAKE-TEST",constructor<>())
 //    .def_readwrite("multiplier",&Test::multiplier)
       .def("SET-MULTIPLIER",&Test::setMultiplier)
+      .def("GET-MULTIPLIER",&Test::getMultiplier)
       .def("set2",&Test::set2)
     .def("set3",&Test::set3)
     .def("set4",&Test::set4)
@@ -157,6 +176,10 @@ CLBIND_API void initialize_clbind() {
   class_<TestChild,Test>(m,"TestChild")
       .def_constructor("MAKE-TEST-CHILD",constructor<>())
     ;
+  class_<TestMixin>(m,"TestMixin")
+      .def("GET-TAG",&TestMixin::getTag);
+  class_<TestGrandChild,bases<TestChild,TestMixin>>(m,"TestGrandChild")
+      .def_constructor("MAKE-TEST-GRAND-CHILD",constructor<>());
 #endif
 }
 
@@ -1155,19 +1155,88 @@ CL_DEFUN clasp_ffi::ForeignData_sp ext__array_pointer(Array_sp source )
   return clasp_ffi::ForeignData_O::create(source->rowMajorAddressOfElement_(0));
 }
 
-CL_DOCSTRING(R"dx(Pin the objects in the list in memory and then call the thunk)dx")
+CL_DOCSTRING(R"dx(Pin the objects in the list in memory and then call the thunk.
+The objects are held on this frame's stack until the thunk returns, and a collector
+never moves an object that the stack refers to.)dx")
 DOCGROUP(clasp)
 CL_DEFUN T_mv ext__pinned_objects_funcall(List_sp objects, T_sp thunk)
 {
   size_t num = cl__length(objects);
-  T_O* pointerArray[num];
+  T_O* volatile pointerArray[num];
   size_t idx = 0;
   for ( auto cur : objects ) {
     T_sp obj = CONS_CAR(cur);
     pointerArray[idx] = obj.raw_();
     idx++;
   }
-  return eval::funcall(thunk);
+  T_mv result = eval::funcall(thunk);
+  // Keep pointerArray live until the thunk has returned
+  __asm__ __volatile__("" : : "r"(pointerArray) : "memory");
+  return result;
+}
+
+CL_DOCSTRING(R"dx(Do nothing with object, but keep it alive and unmoved up to this point.
+The compiler turns calls into a use of object that it cannot remove.)dx")
+DOCGROUP(clasp)
+CL_DEFUN void core__keep_alive(T_sp object)
+{
+  __asm__ __volatile__("" : : "r"(object.raw_()) : "memory");
+}
+
+CL_LAMBDA(element_type dimension &optional initial_element initial_element_supplied_p)
+CL_DECLARE();
+CL_DOCSTRING(R"dx(Make a simple vector of element-type with dimension elements that the garbage
+collector will never move, so the address of its data can be handed to foreign code for
+as long as the vector is alive. Unlike make-static-vector the vector is collected when it
+becomes garbage. element-type must be double-float, single-float, fixnum, ext:byte8 ...
+ext:byte64, ext:integer8 ... ext:integer64 or core:size-t.)dx")
+DOCGROUP(clasp)
+CL_DEFUN AbstractSimpleVector_sp ext__make_pinned_vector(T_sp element_type,
+                                                         size_t dimension,
+                                                         T_sp initialElement,
+                                                         bool initialElementSuppliedP) {
+#define MAKE(simple)\
+  simple::value_type init = initialElementSuppliedP ? simple::from_object(initialElement) : simple::default_initial_element();\
+  return gctools::GC<simple>::allocate_immobile_container(dimension, init, initialElementSuppliedP, 0, (simple::value_type*)NULL);
+  // macro over
+  if (element_type == cl::_sym_double_float) { MAKE(SimpleVector_double_O) }
+  else if (element_type == cl::_sym_single_float) { MAKE(SimpleVector_float_O) }
+  else if (element_type == ext::_sym_integer8) { MAKE(SimpleVector_int8_t_O) }
+  else if (element_type == ext::_sym_byte8) { MAKE(SimpleVector_byte8_t_O) }
+  else if (element_type == ext::_sym_integer16) { MAKE(SimpleVector_int16_t_O) }
+  else if (element_type == ext::_sym_byte16) { MAKE(SimpleVector_byte16_t_O) }
+  else if (element_type == ext::_sym_integer32) { MAKE(SimpleVector_int32_t_O) }
+  else if (element_type == ext::_sym_byte32) { MAKE(SimpleVector_byte32_t_O) }
+  else if (element_type == ext::_sym_integer64) { MAKE(SimpleVector_int64_t_O) }
+  else if (element_type == ext::_sym_byte64) { MAKE(SimpleVector_byte64_t_O) }
+  else if (element_type == _sym_size_t) { MAKE(SimpleVector_size_t_O) }
+  else if (element_type == cl::_sym_fixnum) { MAKE(SimpleVector_fixnum_O) }
+#undef MAKE
+  else SIMPLE_ERROR(("Handle make-pinned-vector :element-type %s") , _rep_(element_type));
+}
+
+CL_DOCSTRING(R"dx(Return a foreign pointer to the first element of vector, a simple vector of one
+of the element types make-pinned-vector accepts. The pointer is only good while the vector
+is kept alive and unmoved, see ext:with-pointer-to-vector-data.)dx")
+DOCGROUP(clasp)
+CL_DEFUN clasp_ffi::ForeignData_sp core__vector_data_pointer(T_sp vector)
+{
+  // Strings, general vectors and sub-byte vectors have no C representation to hand out
+  if (gc::IsA<SimpleVector_double_sp>(vector)
+      || gc::IsA<SimpleVector_float_sp>(vector)
+      || gc::IsA<SimpleVector_fixnum_sp>(vector)
+      || gc::IsA<SimpleVector_size_t_sp>(vector)
+      || gc::IsA<SimpleVector_byte64_t_sp>(vector)
+      || gc::IsA<SimpleVector_int64_t_sp>(vector)
+      || gc::IsA<SimpleVector_byte32_t_sp>(vector)
+      || gc::IsA<SimpleVector_int32_t_sp>(vector)
+      || gc::IsA<SimpleVector_byte16_t_sp>(vector)
+      || gc::IsA<SimpleVector_int16_t_sp>(vector)
+      || gc::IsA<SimpleVector_byte8_t_sp>(vector)
+      || gc::IsA<SimpleVector_int8_t_sp>(vector)) {
+    return clasp_ffi::ForeignData_O::create(gc::As_unsafe<AbstractSimpleVector_sp>(vector)->rowMajorAddressOfElement_(0));
+  }
+  SIMPLE_ERROR(("%s is not a simple vector of numbers that foreign code can use") , _rep_(vector));
 }
   
   
@@ -12,6 +12,7 @@
 #include <clasp/llvmo/code.h>
 #include <clasp/core/stackmap.h>
 #include <clasp/core/backtrace.h>
+#include <clasp/core/debugger.h>
 #ifdef USE_LIBUNWIND
 #define UNW_LOCAL_ONLY
 #include <libunwind.h>
@@ -463,6 +464,32 @@ static DebuggerFrame_sp make_frame(size_t fi, void* ip, const char* string, void
   else return make_lisp_frame(fi, ip, string, gc::As_unsafe<llvmo::ObjectFile_sp>(of), fbp);
 }
 
+// The name of the Lisp function containing ip, or NIL if ip is not in Lisp code.
+// Unlike make_frame this doesn't need a live frame, so it can be used to
+// symbolize return addresses that were recorded earlier (e.g. by the profiler).
+T_sp lisp_function_name_for_address(void* ip) {
+  T_sp of = llvmo::only_object_file_for_instruction_pointer(ip);
+  if (!gc::IsA<llvmo::ObjectFile_sp>(of)) return nil<T_O>();
+  llvmo::ObjectFile_sp ofi = gc::As_unsafe<llvmo::ObjectFile_sp>(of);
+  llvmo::SectionedAddress_sp sa = object_file_sectioned_address(ip, ofi, false);
+  llvmo::DWARFContext_sp dcontext = llvmo::DWARFContext_O::createDWARFContext(ofi);
+  bool XEPp = false;
+  int arityCode;
+  void* codeStart;
+  void* startAddress;
+  T_sp ep = dwarf_ep(ofi, dcontext, sa, codeStart, startAddress, XEPp, arityCode );
+  if (ep.notnilp()) {
+    T_sp fdesc = gc::As_unsafe<EntryPointBase_sp>(ep)->_FunctionDescription;
+    if (gc::IsA<FunctionDescription_sp>(fdesc))
+      return gc::As_unsafe<FunctionDescription_sp>(fdesc)->functionName();
+  }
+  // No entry point - use the name DWARF has for it.
+  const char* symbol; uintptr_t start; uintptr_t end;
+  if (lookup_address((uintptr_t)ip, symbol, start, end))
+    return SimpleBaseString_O::make(symbol);
+  return nil<T_O>();
+}
+
 static bool sanity_check_frame( void* ip, void* fbp) {
   MaybeTrace trace(__FUNCTION__);
   T_sp of = llvmo::only_object_file_for_instruction_pointer(ip);
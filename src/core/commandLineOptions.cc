@@ -100,6 +100,13 @@ void process_clasp_arguments(CommandLineOptions* options)
              "-n/--noinit          - Don't load the init.lisp (very minimal environment)\n"
              "-S/--seed #          - Seed the random number generator\n"
              "-w/--wait            - Print the PID and wait for the user to hit a key\n"
+             "--gc-markers #       - Number of threads that mark in a Boehm collection\n"
+             "                       (default 0 lets Boehm decide, 1 marks serially)\n"
+             "--heap-min size      - Start with a heap of this size, e.g. 512M or 2G\n"
+             "                       (Boehm and MPS; ignored by MMTk)\n"
+             "--heap-max size      - Soft heap limit - when a collection leaves more than this\n"
+             "                       in use, signal EXT:HEAP-LIMIT-EXCEEDED (a storage-condition)\n"
+             "                       in the thread that collected. Under MMTk, the fixed heap size\n"
              "-- {ARGS}*           - Trailing are added to core:*command-line-arguments*\n"
              "*feature* settings\n"
              " sanitizer=thread    - Setup codegen for thread sanitizer\n"
@@ -137,6 +144,8 @@ void process_clasp_arguments(CommandLineOptions* options)
              "export CLASP_DEBUG_SNAPSHOT  Dump info during snapshot loading\n"
              "export CLASP_DEBUG_OBJECT_FILES \"save\" saves all object files, anything else prints info about object file generation\n"
              "export CLASP_PAUSE_STARTUP (set to anything)  Pause right at startup before basic initialization\n"
+             "export CLASP_HEAP_MIN=<size>  Like --heap-min, which overrides it\n"
+             "export CLASP_HEAP_MAX=<size>  Like --heap-max, which overrides it\n"
              "export CLASP_PAUSE_OBJECTS_ADDED (set to anything)  Pause right at startup during snapshot load after objects are added to the jit\n"
              "export CLASP_PAUSE_INIT (set to anything)  Pause after startup and after basic initialization\n"
              "export CLASP_DUMP_FUNCTIONS (set to anything)  Dump all function definitions at startup\n"
@@ -290,6 +299,9 @@ void process_clasp_arguments(CommandLineOptions* options)
     } else if (arg == "-S" || arg == "--seed") {
       options->_RandomNumberSeed = atoi(options->_RawArguments[iarg + 1].c_str());
       iarg++;
+    } else if (arg == "--gc-markers" || arg == "--heap-min" || arg == "--heap-max") {
+      // Already processed by the constructor - the collector starts before this
+      iarg++;
     } else {
       options->_Args.push_back(arg);
     }
@@ -298,6 +310,18 @@ void process_clasp_arguments(CommandLineOptions* options)
 }
 
 
+// A heap size in bytes, or with a K, M or G suffix (powers of 1024)
+static size_t parse_heap_size(const std::string& text) {
+  char* end;
+  double value = strtod(text.c_str(), &end);
+  switch (toupper(*end)) {
+  case 'K': value *= 1024.0; break;
+  case 'M': value *= 1024.0 * 1024.0; break;
+  case 'G': value *= 1024.0 * 1024.0 * 1024.0; break;
+  }
+  return (value > 0.0) ? (size_t)value : 0;
+}
+
 CommandLineOptions::CommandLineOptions(int argc, char *argv[])
   : _ProcessArguments(process_clasp_arguments),
     _DontLoadImage(false),
@@ -320,13 +344,18 @@ CommandLineOptions::CommandLineOptions(int argc, char *argv[])
     _SilentStartup(true),
     _RCFileName(".clasprc"),
     _NoRc(false),
-    _PauseForDebugger(false)
+    _PauseForDebugger(false),
+    _GcMarkers(0),
+    _HeapMin(0),
+    _HeapMax(0)
 
 {
   for (int i = 0; i < argc; ++i) {
     this->_RawArguments.push_back(argv[i]);
   }
   this->_ExecutableName = this->_RawArguments[0];
+  if (const char* heap_min = getenv("CLASP_HEAP_MIN")) this->_HeapMin = parse_heap_size(heap_min);
+  if (const char* heap_max = getenv("CLASP_HEAP_MAX")) this->_HeapMax = parse_heap_size(heap_max);
   // --resource-dir is the one argument we must process now
   int iarg = 1;
   while ( iarg<this->_RawArguments.size() && this->_RawArguments[iarg] != "--" ) {
@@ -342,6 +371,15 @@ CommandLineOptions::CommandLineOptions(int argc, char *argv[])
       iarg++;
       this->_ExportedSymbolsFilename = this->_RawArguments[iarg];
       iarg++;
+    } else if (arg == "--gc-markers" && iarg+1 < this->_RawArguments.size()) {
+      this->_GcMarkers = atoi(this->_RawArguments[iarg+1].c_str());
+      iarg++;
+    } else if (arg == "--heap-min" && iarg+1 < this->_RawArguments.size()) {
+      this->_HeapMin = parse_heap_size(this->_RawArguments[iarg+1]);
+      iarg++;
+    } else if (arg == "--heap-max" && iarg+1 < this->_RawArguments.size()) {
+      this->_HeapMax = parse_heap_size(this->_RawArguments[iarg+1]);
+      iarg++;
     }
     iarg++;
   }
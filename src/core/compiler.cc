@@ -73,6 +73,7 @@ THE SOFTWARE.
 #include <clasp/llvmo/intrinsics.h>
 #include <clasp/llvmo/llvmoExpose.h>
 #include <clasp/llvmo/code.h>
+#include <clasp/gctools/metrics.h>
 #include <clasp/core/wrappers.h>
 
 
@@ -766,6 +767,7 @@ DOCGROUP(clasp)
 CL_LAMBDA(path-designator &optional (verbose *load-verbose*) (print t) (external-format :default))
 CL_DEFUN core::T_sp core__load_faso(T_sp pathDesig, T_sp verbose, T_sp print, T_sp external_format)
 {
+  gctools::metrics::RAIITimer timer(gctools::metrics::global_FasoLoadTime);
   String_sp sfilename = gc::As<String_sp>(cl__namestring(pathDesig));
   std::string filename = sfilename->get_std_string(); 
   char* name_buffer = (char*)malloc(filename.size()+1);
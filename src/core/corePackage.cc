@@ -107,6 +107,7 @@ THE SOFTWARE.
 #include <clasp/core/specialForm.h>
 #include <clasp/core/metaClass.h>
 #include <clasp/core/bignum.h>
+#include <clasp/core/mpPackage.h>
 #include <clasp/clbind/class_rep.h>
 
 //
@@ -114,6 +115,7 @@ THE SOFTWARE.
 //
 #define NAMESPACE_core
 #include <clasp/gctools/gc_interface.h>
+#include <clasp/gctools/finalizers.h>
 #undef NAMESPACE_core
 
 namespace core {
@@ -1177,7 +1179,8 @@ void CoreExposer_O::define_essential_globals(LispPtr lisp) {
   _sym_STARextension_startup_evalsSTAR->defparameter(nil<core::T_O>());
   SimpleBaseString_sp sbsr1 = SimpleBaseString_O::make("SYSPMNR");
   SimpleBaseString_sp sbsw1 = SimpleBaseString_O::make("SYSPMNW");
-  _lisp->_Roots._Finalizers = WeakKeyHashTable_O::create();
+  _lisp->_Roots._Finalizers = gctools::make_finalizer_shards();
+  _lisp->_Roots._ExecutorQueues = mp::make_executor_queues();
   _lisp->_Roots._Sysprop = gc::As<HashTableEql_sp>(HashTable_O::create_thread_safe(cl::_sym_eql,sbsr1,sbsw1));
   _sym_STARdebug_accessorsSTAR->defparameter(nil<T_O>());
   _sym_STARmodule_startup_function_nameSTAR->defparameter(SimpleBaseString_O::make(std::string(MODULE_STARTUP_FUNCTION_NAME)));
@@ -80,6 +80,7 @@
            #~"extensionPackage.cc"
            #~"array.cc"
            #~"string.cc"
+           #~"stringKernels.cc"
            #~"array_bit.cc"
            #~"grayPackage.cc"
            #~"closPackage.cc"
@@ -108,6 +109,7 @@
            #~"sequence.cc"
            #~"loadTimeValues.cc"
            #~"lightProfiler.cc"
+           #~"sampleProfiler.cc"
            #~"fileSystem.cc"
            #~"posixTime.cc"
            #~"hwinfo.cc"
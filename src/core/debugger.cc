@@ -292,7 +292,28 @@ bool lookup_address(uintptr_t address, const char*& symbol,
   } else return false; // no ranges available
 }
 
+// Walk the frame pointer chain looking for frame. This is the common case
+// (every non-local exit goes through frame_check) and it is much cheaper
+// than stepping libunwind through DWARF unwind tables.
+// Returns true if the frame was found, false if the chain ended or
+// passed frame without finding it - then we can't be sure, because some
+// frame in between may have been compiled without frame pointers.
+static bool frame_pointer_chain_contains(uintptr_t frame) {
+  uintptr_t fp = (uintptr_t)__builtin_frame_address(0);
+  uintptr_t top = (uintptr_t)my_thread_low_level->_StackTop;
+  while (fp && fp <= frame) {
+    if (fp == frame) return true;
+    uintptr_t next = *(uintptr_t*)fp;
+    if (next <= fp || next > top) break;
+    fp = next;
+  }
+  return false;
+}
+
 bool check_for_frame(uintptr_t frame) {
+  // The stack grows down, so a frame below ours has already been exited.
+  if (frame < (uintptr_t)__builtin_frame_address(0)) return false;
+  if (frame_pointer_chain_contains(frame)) return true;
   // We only actually do a check if we have libunwind capabilities.
 #ifdef USE_LIBUNWIND
   unw_context_t context; unw_cursor_t cursor;
@@ -918,6 +918,14 @@ size_t lisp_lambdaListHandlerNumberOfSpecialVariables(LambdaListHandler_sp lambd
 {
   return lambda_list_handler->numberOfSpecialVariables();
 }
+
+/*! Return true if a builtin with this lambda list handler can take nargs arguments
+    just as they were passed, without a frame or binding them through the handler */
+bool lisp_lambdaListHandlerDirectArgumentsP(LambdaListHandler_sp lambda_list_handler, size_t nargs)
+{
+  return lambda_list_handler->requiredLexicalArgumentsOnlyP()
+    && lambda_list_handler->numberOfRequiredArguments() == nargs;
+}
 LambdaListHandler_sp lisp_function_lambda_list_handler(List_sp lambda_list, List_sp declares, std::set<int> pureOutValues) {
   LambdaListHandler_sp llh = LambdaListHandler_O::create(lambda_list, declares, cl::_sym_function, pureOutValues);
   return llh;
@@ -311,7 +311,8 @@ HashTable_sp HashTable_O::create_thread_safe(T_sp test, SimpleBaseString_sp read
   DoubleFloat_sp rehashSize = DoubleFloat_O::create(2.0);
   DoubleFloat_sp rehashThreshold = DoubleFloat_O::create(DEFAULT_REHASH_THRESHOLD);
   HashTable_sp ht = gc::As_unsafe<HashTable_sp>(cl__make_hash_table(test, size, rehashSize, rehashThreshold));
-  ht->_Mutex = mp::SharedMutex_O::make_shared_mutex(readLockName,writeLockName);
+  // These tables are read far more often than they are written
+  ht->_Mutex = mp::SharedMutex_O::make_shared_mutex(readLockName,writeLockName,true);
   return ht;
 }
 
@@ -1002,11 +1003,14 @@ KeyValuePair* HashTable_O::rehash_upgrade_write_lock(bool expandTable, T_sp find
       this->_Mutex->write_unlock( false /*releaseReadLock*/);
       return result;
     }
+    // Another thread is upgrading and waits for our read lock to go away
+    this->_Mutex->read_unlock();
 #ifdef _TARGET_OS_DARWIN
     pthread_yield_np();
 #else
     pthread_yield();
 #endif
+    this->_Mutex->read_lock();
     goto tryAgain;
   } else {
     return this->rehash_no_lock(expandTable,findKey);
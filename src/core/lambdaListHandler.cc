@@ -1400,9 +1400,11 @@ CL_DEFMETHOD T_mv LambdaListHandler_O::processLambdaListHandler() const {
 bool LambdaListHandler_O::requiredLexicalArgumentsOnlyP_() const {
   bool requiredArgumentsOnlyP = (this->_OptionalArguments.size() == 0) && (!this->_RestArgument.isDefined()) && (this->_KeywordArguments.size() == 0) && (!this->_AllowOtherKeys.isTrue()) && (this->_AuxArguments.size() == 0);
   if (requiredArgumentsOnlyP) {
+    int index = 0;
     for (gctools::Vec0<RequiredArgument>::const_iterator it = this->_RequiredArguments.begin();
-         it != this->_RequiredArguments.end(); it++) {
-      if (!it->targetIsLexical())
+         it != this->_RequiredArguments.end(); it++, index++) {
+      // Pure out values leave gaps in the frame
+      if (!it->targetIsLexical() || it->targetFrameIndex() != index)
         return false;
     }
     return true;
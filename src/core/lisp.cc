@@ -136,6 +136,7 @@ THE SOFTWARE.
 #include <clasp/llvmo/intrinsics.h>
 #include <clasp/llvmo/code.h>
 #include <clasp/llvmo/llvmoExpose.h>
+#include <clasp/gctools/metrics.h>
 #include <clasp/core/wrappers.h>
 #ifdef CLASP_THREADS
 #include <clasp/core/mpPackage.h>
@@ -255,6 +256,7 @@ void Lisp::initialize() {
   this->_Roots.charInfo.initialize();
   this->_Roots._SourceFileIndices = HashTableEqual_O::create_default();
   this->_Roots._PackageNameIndexMap = HashTableEqual_O::create_default();
+  this->_Roots._PathnameComponents = SimpleVector_O::make(PATHNAME_COMPONENT_CACHE_SIZE, nil<T_O>());
 }
 
 template <class oclass>
@@ -597,6 +599,7 @@ void Lisp::startupLispEnvironment() {
   // Create the first process
   //
   mp::_sym_STARcurrent_processSTAR->defparameter(my_thread->_Process);
+  mp::_sym_STARprocess_exit_hooksSTAR->defparameter(nil<T_O>());
   this->add_process(my_thread->_Process);
   my_thread->_Process->_Phase = mp::Active;
   gctools::initialize_unix_signal_handlers();
@@ -672,6 +675,8 @@ void Lisp::setMakePackageAndExportSymbolCallbacks(MakePackageCallback mpc, Expor
 void Lisp::add_process(mp::Process_sp process) {
   WITH_READ_WRITE_LOCK(globals_->_ActiveThreadsMutex);
   this->_Roots._ActiveThreads = Cons_O::create(process,this->_Roots._ActiveThreads);
+  gctools::metrics::global_ThreadsStarted.add();
+  gctools::metrics::global_ThreadsActive.add(1);
 #ifdef DEBUG_ADD_PROCESS
   printf("%s:%d Added process %s @%p active threads now: %s\n", __FILE__, __LINE__, _rep_(process).c_str(), (void*)process.raw_(), _rep_(this->_Roots._ActiveThreads).c_str());
   fflush(stdout);
@@ -688,6 +693,7 @@ void Lisp::remove_process(mp::Process_sp process) {
       if (process == p) {
         // If the process is the first in the list, just set the ActiveThreads to the cdr.
         this->_Roots._ActiveThreads = cons_cdr(cur);
+        gctools::metrics::global_ThreadsActive.add(-1);
         return;
       } else {
         // Iterate through to find the process and rplacd it out.
@@ -696,6 +702,7 @@ void Lisp::remove_process(mp::Process_sp process) {
           p = gc::As<mp::Process_sp>(cons_car(next));
           if (p == process) {
             gc::As_unsafe<Cons_sp>(cur)->rplacd(cons_cdr(next));
+            gctools::metrics::global_ThreadsActive.add(-1);
             return;
           }
           cur = next;
@@ -185,6 +185,7 @@ CL_DEFUN T_sp core__load_no_package_set(T_sp lsource, T_sp verbose, T_sp print,
       T_sp kind;
       filename = pathname;
       pathname->_Type = oCaar(hooks);
+      pathname->invalidateNamestring();
       function = oCdar(hooks);
       kind = core__file_kind(pathname, true);
       if (kind == kw::_sym_file || kind == kw::_sym_special)
@@ -27,6 +27,13 @@ THE SOFTWARE.
 
 #include <sched.h>
 #include <sys/types.h>
+#include <unistd.h>
+#include <climits>
+#include <chrono>
+#if defined(_TARGET_OS_LINUX)
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#endif
 #include <clasp/core/foundation.h>
 #include <clasp/core/object.h>
 #include <clasp/core/lisp.h>
@@ -147,39 +154,62 @@ struct SafeRegisterDeregisterProcessWithLisp {
   }
 };
 
+SYMBOL_EXPORT_SC_(MpPkg, STARprocess_exit_hooksSTAR);
+
+static void process_exit_notify(Process_sp process);
+
+// Run the functions in mp:*process-exit-hooks* in the dying thread.  A hook
+// that exits the process doesn't stop the others from running.
+static void run_process_exit_hooks() {
+  core::List_sp hooks = _sym_STARprocess_exit_hooksSTAR->symbolValue();
+  for (auto cur : hooks) {
+    try {
+      core::eval::funcall(CONS_CAR(cur));
+    } catch (ExitProcess& e) {
+    } catch (AbortProcess& e) {
+    }
+  }
+}
+
+static void run_process_function(Process_sp process) {
+  core::List_sp args = process->_Arguments;
+  core::T_mv result_mv;
+  {
+    try {
+      result_mv = core::core__apply0(core::coerce::functionDesignator(process->_Function),args);
+    } catch (ExitProcess& e) {
+      // Exiting specially. Don't touch _ReturnValuesList - it's initialized to NIL just fine,
+      // and may have been set by mp:exit-process.
+      return;
+    } catch (AbortProcess& e) {
+      // Exiting specially for some weird reason. Mark this as an abort.
+      // NOTE: Should probably catch all attempts to exit, i.e. catch (...),
+      // but that might be a problem for the main thread.
+      process->_Aborted = true;
+      return;
+    }
+  }
+  ql::list return_values;
+  int nv = result_mv.number_of_values();
+  if (nv > 0) {
+    core::T_sp result0 = result_mv;
+    return_values << result0;
+    for (int i = 1; i < nv; ++i)
+      return_values << result_mv.valueGet_(i);
+  }
+  process->_ReturnValuesList = return_values.result();
+}
+
 void do_start_thread_inner(Process_sp process, core::List_sp bindings) {
   if (bindings.consp()) {
     core::Cons_sp pair = gc::As<core::Cons_sp>(CONS_CAR(bindings));
     core::DynamicScopeManager scope(pair->ocar(),core::eval::evaluate(pair->cdr(),nil<core::T_O>()));
     do_start_thread_inner(process,CONS_CDR(bindings));
   } else {
-    core::List_sp args = process->_Arguments;
     process->_Phase = Active;
-    core::T_mv result_mv;
-    {
-      try {
-        result_mv = core::core__apply0(core::coerce::functionDesignator(process->_Function),args);
-      } catch (ExitProcess& e) {
-        // Exiting specially. Don't touch _ReturnValuesList - it's initialized to NIL just fine,
-        // and may have been set by mp:exit-process.
-        return;
-      } catch (AbortProcess& e) {
-        // Exiting specially for some weird reason. Mark this as an abort.
-        // NOTE: Should probably catch all attempts to exit, i.e. catch (...),
-        // but that might be a problem for the main thread.
-        process->_Aborted = true;
-        return;
-      }
-    }
-    ql::list return_values;
-    int nv = result_mv.number_of_values();
-    if (nv > 0) {
-      core::T_sp result0 = result_mv;
-      return_values << result0;
-      for (int i = 1; i < nv; ++i)
-        return_values << result_mv.valueGet_(i);
-    }
-    process->_ReturnValuesList = return_values.result();
+    // A process killed before it started exits without running its function
+    if (!process->_KillRequested.load()) run_process_function(process);
+    run_process_exit_hooks();
   }
 }
 
@@ -241,15 +271,23 @@ void start_thread_inner(uintptr_t uniqueId, void* cold_end_of_stack) {
   gctools::my_thread_allocation_points.initializeAllocationPoints();
 #endif
   my_thread->initialize_thread(process,true);
+  my_thread->_Bindings.reserve_binding_indices();
 //  my_thread->create_sigaltstack();
   process->_ThreadInfo = my_thread;
   // Set the mp:*current-process* variable to the current process
   core::DynamicScopeManager scope(_sym_STARcurrent_processSTAR,process);
+  // Each process pushes its own exit hooks onto the global ones
+  core::DynamicScopeManager hooks_scope(_sym_STARprocess_exit_hooksSTAR,_sym_STARprocess_exit_hooksSTAR->symbolValue());
   core::List_sp reversed_bindings = core::cl__reverse(process->_InitialSpecialBindings);
   do_start_thread_inner(process,reversed_bindings);
   // Remove the process
   process->_Phase = Exited;
+  // An interrupt that came too late to run leaves a safepoint request, which
+  // nothing would clear once the thread is gone
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  gctools::clear_safepoint_request(my_thread);
   _lisp->remove_process(process);
+  process_exit_notify(process);
 #ifdef DEBUG_MONITOR_SUPPORT
     // When enabled, maintain a thread-local map of strings to FILE*
     // used for logging. This is so that per-thread log files can be
@@ -294,14 +332,14 @@ string Mutex_O::__repr__() const {
 }
 
 CL_LAMBDA(mutex &optional (upgrade nil))
-CL_DOCSTRING(R"dx(Obtain the write lock for this mutex. upgradep should be true if and only if this thread currently holds the shared lock for the same mutex.)dx")
+CL_DOCSTRING(R"dx(Obtain the write lock for this mutex. upgradep should be true if and only if this thread currently holds the shared lock for the same mutex. If another thread is already upgrading its shared lock, the shared lock is released while this thread waits, so anything read under it must be checked again.)dx")
 DOCGROUP(clasp)
 CL_DEFUN void mp__write_lock(SharedMutex_sp m, bool upgrade) {
   m->write_lock(upgrade);
 }
 
 CL_LAMBDA(mutex &optional (upgrade nil))
-CL_DOCSTRING(R"dx(Try to obtain the write lock for this mutex. If it cannot be obtained immediately, return false. Otherwise, return true.)dx")
+CL_DOCSTRING(R"dx(Try to obtain the write lock for this mutex. If it cannot be obtained immediately, return false. Otherwise, return true. If upgradep is true and this returns false, another thread is upgrading and waiting for this thread to release its shared lock.)dx")
 DOCGROUP(clasp)
 CL_DEFUN bool mp__write_try_lock(SharedMutex_sp m, bool upgrade) {
   return m->write_try_lock(upgrade);
@@ -329,13 +367,465 @@ CL_DEFUN void mp__shared_unlock(SharedMutex_sp m) {
 }
 
 
+#if defined(_TARGET_OS_LINUX)
+static inline void futex_wait(std::atomic<uint32_t>& word, uint32_t expected) {
+  syscall(SYS_futex, (uint32_t*)&word, FUTEX_WAIT_PRIVATE, expected, NULL, NULL, 0);
+}
+static inline bool futex_wake(std::atomic<uint32_t>& word, int count) {
+  return syscall(SYS_futex, (uint32_t*)&word, FUTEX_WAKE_PRIVATE, count, NULL, NULL, 0) > 0;
+}
+static inline void futex_timed_wait(std::atomic<uint32_t>& word, uint32_t expected, double seconds) {
+  struct timespec timeout;
+  timeout.tv_sec = (time_t)seconds;
+  timeout.tv_nsec = (long)((seconds - timeout.tv_sec) * 1000000000.0);
+  syscall(SYS_futex, (uint32_t*)&word, FUTEX_WAIT_PRIVATE, expected, &timeout, NULL, 0);
+}
+#else
+// Without a futex waiters poll, so there is nobody to wake
+static inline void futex_wait(std::atomic<uint32_t>& word, uint32_t expected) {
+  if (word.load(std::memory_order_relaxed) == expected) sched_yield();
+}
+static inline bool futex_wake(std::atomic<uint32_t>& word, int count) {
+  return false;
+}
+static inline void futex_timed_wait(std::atomic<uint32_t>& word, uint32_t expected, double seconds) {
+  if (word.load(std::memory_order_relaxed) == expected) usleep(std::min(seconds, 0.001) * 1000000.0);
+}
+#endif
+
+/*! Incremented and woken whenever a process exits, for wait-for-any-process */
+std::atomic<uint32_t> global_ProcessExits{0};
+
+// Called by the dying thread after the process has left the list of active processes
+static void process_exit_notify(Process_sp process) {
+  process->_ExitNotify.store(1, std::memory_order_release);
+  futex_wake(process->_ExitNotify, INT_MAX);
+  global_ProcessExits.fetch_add(1, std::memory_order_release);
+  futex_wake(global_ProcessExits, INT_MAX);
+}
+
+typedef std::chrono::steady_clock::time_point ProcessWaitDeadline;
+
+static ProcessWaitDeadline process_wait_deadline(core::T_sp timeout) {
+  if (timeout.nilp()) return ProcessWaitDeadline::max();
+  return std::chrono::steady_clock::now()
+    + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(core::clasp_to_double(timeout)));
+}
+
+// Sleep while word holds expected, but not past the deadline.  Queued
+// interrupts run when the sleep ends, so a waiting process can still be
+// killed.  Return false if the deadline has passed.
+static bool process_wait_step(std::atomic<uint32_t>& word, uint32_t expected, ProcessWaitDeadline deadline) {
+  if (deadline == ProcessWaitDeadline::max()) {
+    futex_wait(word, expected);
+  } else {
+    double remaining = std::chrono::duration<double>(deadline - std::chrono::steady_clock::now()).count();
+    if (remaining <= 0.0) return false;
+    futex_timed_wait(word, expected, remaining);
+  }
+  gctools::handle_all_queued_interrupts();
+  return true;
+}
+
+static inline void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#elif defined(__aarch64__)
+  __asm__ __volatile__("yield");
+#endif
+}
+
+static uint64_t steady_clock_ns() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/*! Entries in the lock contention table; names past this many are not recorded */
+#define LOCK_CONTENTION_ENTRIES 512
+
+struct LockContention {
+  std::atomic<uint64_t> _NameWord;
+  std::atomic<uint64_t> _Acquisitions;
+  std::atomic<uint64_t> _Contended;
+  std::atomic<uint64_t> _WaitNs;
+  std::atomic<uint64_t> _MaxWaitNs;
+};
+
+LockContention global_LockContention[LOCK_CONTENTION_ENTRIES];
+
+// Find or claim the entry for nameword; NULL if the table is full
+static LockContention* lock_contention_entry(uint64_t nameword) {
+  if (nameword == 0) nameword = 0x003f3f3f3f3f3f3f; // "???????"
+  size_t start = (nameword * 0x9E3779B97F4A7C15) >> 55;
+  for (size_t ii = 0; ii < LOCK_CONTENTION_ENTRIES; ++ii) {
+    LockContention& entry = global_LockContention[(start + ii) % LOCK_CONTENTION_ENTRIES];
+    uint64_t key = entry._NameWord.load(std::memory_order_acquire);
+    if (key == nameword) return &entry;
+    if (key == 0) {
+      if (entry._NameWord.compare_exchange_strong(key, nameword, std::memory_order_acq_rel)) return &entry;
+      if (key == nameword) return &entry;
+    }
+  }
+  return NULL;
+}
+
+void Mutex::addAcquisitions() {
+  LockContention* entry = lock_contention_entry(this->_NameWord);
+  if (entry) entry->_Acquisitions.fetch_add(this->_Acquisitions, std::memory_order_relaxed);
+  this->_Acquisitions = 0;
+}
+
+bool Mutex::lockContended() {
+  uint64_t start = steady_clock_ns();
+  int32_t maxSpins = std::min(2 * this->_Spins + 10, (int32_t)MUTEX_MAX_SPINS);
+  int32_t spins = 0;
+  bool result = true;
+  while (true) {
+    if (spins++ >= maxSpins) {
+      result = (pthread_mutex_lock(&this->_Mutex) == 0);
+      break;
+    }
+    cpu_relax();
+    if (pthread_mutex_trylock(&this->_Mutex) == 0) break;
+  }
+  // We hold the lock now so these updates are safe
+  this->_Spins += (spins - this->_Spins) / 8;
+  uint64_t wait = steady_clock_ns() - start;
+  LockContention* entry = lock_contention_entry(this->_NameWord);
+  if (entry) {
+    entry->_Contended.fetch_add(1, std::memory_order_relaxed);
+    entry->_WaitNs.fetch_add(wait, std::memory_order_relaxed);
+    uint64_t max = entry->_MaxWaitNs.load(std::memory_order_relaxed);
+    while (wait > max && !entry->_MaxWaitNs.compare_exchange_weak(max, wait, std::memory_order_relaxed));
+  }
+  this->acquired();
+  return result;
+}
+
+CL_DOCSTRING(R"dx(Return a list with an entry (name acquisitions contended wait-seconds max-wait-seconds)
+for each mutex name that has been locked since the statistics were last reset. Mutexes that
+share a name (the first seven characters of it) share an entry. Acquisitions are added in
+batches so recent ones may be missing.)dx")
+DOCGROUP(clasp)
+CL_DEFUN core::List_sp mp__lock_contention_statistics() {
+  ql::list result;
+  for (size_t ii = 0; ii < LOCK_CONTENTION_ENTRIES; ++ii) {
+    LockContention& entry = global_LockContention[ii];
+    uint64_t nameword = entry._NameWord.load(std::memory_order_acquire);
+    if (nameword == 0) continue;
+    char name[8];
+    memcpy(name, &nameword, 8);
+    name[7] = '\0';
+    ql::list one;
+    one << core::SimpleBaseString_O::make(std::string(name))
+        << core::Integer_O::create(entry._Acquisitions.load(std::memory_order_relaxed))
+        << core::Integer_O::create(entry._Contended.load(std::memory_order_relaxed))
+        << core::DoubleFloat_O::create(entry._WaitNs.load(std::memory_order_relaxed) / 1.0e9)
+        << core::DoubleFloat_O::create(entry._MaxWaitNs.load(std::memory_order_relaxed) / 1.0e9);
+    result << one.cons();
+  }
+  return result.cons();
+}
+
+CL_DOCSTRING(R"dx(Reset the counters that mp:lock-contention-report prints.)dx")
+DOCGROUP(clasp)
+CL_DEFUN void mp__reset_lock_contention_statistics() {
+  for (size_t ii = 0; ii < LOCK_CONTENTION_ENTRIES; ++ii) {
+    LockContention& entry = global_LockContention[ii];
+    entry._Acquisitions.store(0, std::memory_order_relaxed);
+    entry._Contended.store(0, std::memory_order_relaxed);
+    entry._WaitNs.store(0, std::memory_order_relaxed);
+    entry._MaxWaitNs.store(0, std::memory_order_relaxed);
+  }
+}
+
+/*! Spin this many times before sleeping on a futex */
+#define FUTEX_SPIN_COUNT 100
+/*! After a writer waits for the per-thread reader slots to empty the bias
+    stays off for this many times as long as the wait took (BRAVO's N) */
+#define BIAS_INHIBIT_FACTOR 9
+/*! The most read-biased locks that one thread can hold at once; past that it
+    takes the ordinary read lock */
+#define BIASED_READS_MAX 8
+
+static std::atomic<size_t> global_BiasSlotCounter{0};
+
+// The read-biased locks the current thread holds through its slot
+struct BiasedReads {
+  size_t _Slot;
+  size_t _Count;
+  FutexSharedMutex* _Locks[BIASED_READS_MAX];
+  BiasedReads() : _Slot(global_BiasSlotCounter.fetch_add(1) % FutexSharedMutex::BIAS_SLOTS), _Count(0) {};
+  bool holds(FutexSharedMutex* lock) const {
+    for (size_t ii = this->_Count; ii > 0; --ii) {
+      if (this->_Locks[ii - 1] == lock) return true;
+    }
+    return false;
+  }
+  bool remove(FutexSharedMutex* lock) {
+    for (size_t ii = this->_Count; ii > 0; --ii) {
+      if (this->_Locks[ii - 1] == lock) {
+        this->_Locks[ii - 1] = this->_Locks[--this->_Count];
+        return true;
+      }
+    }
+    return false;
+  }
+};
+
+static thread_local BiasedReads biased_reads;
+
+bool FutexSharedMutex::biasedReadLock() {
+  BiasedReads& reads = biased_reads;
+  if (reads._Count == BIASED_READS_MAX) return false;
+  if (this->_Bias.load(std::memory_order_acquire)) {
+    std::atomic<uint32_t>& readers = this->_BiasSlots[reads._Slot]._Readers;
+    readers.fetch_add(1, std::memory_order_seq_cst);
+    // A writer clears _Bias before it waits for the slots to empty
+    if (this->_Bias.load(std::memory_order_seq_cst)) {
+      reads._Locks[reads._Count++] = this;
+      return true;
+    }
+    readers.fetch_sub(1, std::memory_order_release);
+    return false;
+  }
+  // No writer can hold the lock while we hold a read lock, so the next one
+  // to come along will see the bias and revoke it.
+  uint32_t state = this->_State.load(std::memory_order_relaxed);
+  if (!readLockable(state) ||
+      !this->_State.compare_exchange_weak(state, state + READ_LOCKED, std::memory_order_acquire, std::memory_order_relaxed))
+    this->readContended();
+  if (steady_clock_ns() >= this->_InhibitBiasUntil.load(std::memory_order_relaxed))
+    this->_Bias.store(true, std::memory_order_release);
+  return true;
+}
+
+bool FutexSharedMutex::biasedReadUnlock() {
+  BiasedReads& reads = biased_reads;
+  if (reads._Count == 0 || !reads.remove(this)) return false;
+  this->_BiasSlots[reads._Slot]._Readers.fetch_sub(1, std::memory_order_release);
+  return true;
+}
+
+void FutexSharedMutex::revokeBias() {
+  if (!this->_BiasSlots || !this->_Bias.load(std::memory_order_relaxed)) return;
+  uint64_t start = steady_clock_ns();
+  this->_Bias.store(false, std::memory_order_seq_cst);
+  for (size_t ii = 0; ii < BIAS_SLOTS; ++ii) {
+    while (this->_BiasSlots[ii]._Readers.load(std::memory_order_acquire) != 0) sched_yield();
+  }
+  uint64_t now = steady_clock_ns();
+  this->_InhibitBiasUntil.store(now + (now - start) * BIAS_INHIBIT_FACTOR, std::memory_order_relaxed);
+}
+
+// Like revokeBias, but for writeTryLock: rather than wait for the slots to
+// empty, turn the bias back on and return false if any reader is in one.
+bool FutexSharedMutex::tryRevokeBias() {
+  if (!this->_BiasSlots || !this->_Bias.load(std::memory_order_relaxed)) return true;
+  this->_Bias.store(false, std::memory_order_seq_cst);
+  for (size_t ii = 0; ii < BIAS_SLOTS; ++ii) {
+    if (this->_BiasSlots[ii]._Readers.load(std::memory_order_acquire) != 0) {
+      this->_Bias.store(true, std::memory_order_release);
+      return false;
+    }
+  }
+  return true;
+}
+
+void FutexSharedMutex::readContended() {
+  bool slept = false;
+  auto spin = [this] () {
+    uint32_t state = this->_State.load(std::memory_order_relaxed);
+    for (size_t ii = 0; ii < FUTEX_SPIN_COUNT && writeLocked(state) && !(state & (READERS_WAITING | WRITERS_WAITING)); ++ii) {
+      cpu_relax();
+      state = this->_State.load(std::memory_order_relaxed);
+    }
+    return state;
+  };
+  uint32_t state = spin();
+  while (true) {
+    // A reader woken by a downgrade may go ahead of waiting writers
+    bool lockable = readLockable(state) ||
+      (slept && (state & MASK) < MAX_READERS && !unlocked(state) && !writeLocked(state) &&
+       !(state & (UPGRADING | READERS_WAITING)));
+    if (lockable) {
+      if (this->_State.compare_exchange_weak(state, state + READ_LOCKED, std::memory_order_acquire, std::memory_order_relaxed)) return;
+      continue;
+    }
+    if ((state & MASK) == MAX_READERS) {
+      SIMPLE_ERROR(("Too many readers of a shared mutex"));
+    }
+    if (!(state & READERS_WAITING)) {
+      if (!this->_State.compare_exchange_weak(state, state | READERS_WAITING, std::memory_order_relaxed, std::memory_order_relaxed)) continue;
+    }
+    futex_wait(this->_State, state | READERS_WAITING);
+    slept = true;
+    state = spin();
+  }
+}
+
+void FutexSharedMutex::readUnlockContended(uint32_t state) {
+  if (state & UPGRADING) {
+    // Wake the upgrader once it is the only reader left
+    if ((state & MASK) == READ_LOCKED) {
+      this->_UpgradeNotify.fetch_add(1, std::memory_order_seq_cst);
+      futex_wake(this->_UpgradeNotify, 1);
+    }
+    return;
+  }
+  if (unlocked(state)) this->wakeWriterOrReaders(state);
+}
+
+void FutexSharedMutex::writeContended() {
+  auto spin = [this] () {
+    uint32_t state = this->_State.load(std::memory_order_relaxed);
+    for (size_t ii = 0; ii < FUTEX_SPIN_COUNT && !unlocked(state) && !(state & WRITERS_WAITING); ++ii) {
+      cpu_relax();
+      state = this->_State.load(std::memory_order_relaxed);
+    }
+    return state;
+  };
+  uint32_t state = spin();
+  // Once we have slept we can't tell if other writers are waiting too,
+  // so we leave WRITERS_WAITING set when we take the lock.
+  uint32_t otherWritersWaiting = 0;
+  while (true) {
+    if (unlocked(state)) {
+      if (this->_State.compare_exchange_weak(state, state | WRITE_LOCKED | otherWritersWaiting, std::memory_order_acquire, std::memory_order_relaxed)) return;
+      continue;
+    }
+    if (!(state & WRITERS_WAITING)) {
+      if (!this->_State.compare_exchange_weak(state, state | WRITERS_WAITING, std::memory_order_relaxed, std::memory_order_relaxed)) continue;
+    }
+    otherWritersWaiting = WRITERS_WAITING;
+    uint32_t seq = this->_WriterNotify.load(std::memory_order_acquire);
+    state = this->_State.load(std::memory_order_relaxed);
+    if (unlocked(state) || !(state & WRITERS_WAITING)) continue;
+    futex_wait(this->_WriterNotify, seq);
+    state = spin();
+  }
+}
+
+bool FutexSharedMutex::wakeWriter() {
+  this->_WriterNotify.fetch_add(1, std::memory_order_release);
+  return futex_wake(this->_WriterNotify, 1);
+}
+
+// Called after the lock became unlocked with threads waiting for it.
+// Writers go first; readers are woken only if no writer was.
+void FutexSharedMutex::wakeWriterOrReaders(uint32_t state) {
+  if (state == WRITERS_WAITING) {
+    if (this->_State.compare_exchange_strong(state, 0, std::memory_order_relaxed, std::memory_order_relaxed)) {
+      this->wakeWriter();
+      return;
+    }
+  }
+  if (state == (READERS_WAITING | WRITERS_WAITING)) {
+    if (!this->_State.compare_exchange_strong(state, READERS_WAITING, std::memory_order_relaxed, std::memory_order_relaxed)) return;
+    if (this->wakeWriter()) return;
+    state = READERS_WAITING;
+  }
+  if (state == READERS_WAITING) {
+    if (this->_State.compare_exchange_strong(state, 0, std::memory_order_relaxed, std::memory_order_relaxed)) {
+      futex_wake(this->_State, INT_MAX);
+    }
+  }
+}
+
+bool FutexSharedMutex::upgrade() {
+  bool biased = this->_BiasSlots && biased_reads.holds(this);
+  uint32_t state = this->_State.load(std::memory_order_relaxed);
+  uint32_t next;
+  do {
+    if ((state & UPGRADING) || writeLocked(state)) return false;
+    // A read lock held through a bias slot moves into the state word
+    next = (state | UPGRADING) + (biased ? READ_LOCKED : 0);
+  } while (!this->_State.compare_exchange_weak(state, next, std::memory_order_acquire, std::memory_order_relaxed));
+  if (biased) this->biasedReadUnlock();
+  // New readers and writers now wait; wait for the readers already in.
+  while (true) {
+    uint32_t seq = this->_UpgradeNotify.load(std::memory_order_seq_cst);
+    state = this->_State.load(std::memory_order_seq_cst);
+    if ((state & MASK) == READ_LOCKED) {
+      if (this->_State.compare_exchange_weak(state, (state & ~(MASK | UPGRADING)) | WRITE_LOCKED,
+                                             std::memory_order_acquire, std::memory_order_relaxed)) break;
+      continue;
+    }
+    futex_wait(this->_UpgradeNotify, seq);
+  }
+  // Only now can no reader be turning the bias back on
+  this->revokeBias();
+  this->_Upgraded = true;
+  return true;
+}
+
+void FutexSharedMutex::downgrade() {
+  uint32_t state = this->_State.fetch_sub(WRITE_LOCKED - READ_LOCKED, std::memory_order_release) - (WRITE_LOCKED - READ_LOCKED);
+  if (state & READERS_WAITING) {
+    // We held the write lock so nobody else clears this bit
+    this->_State.fetch_and(~READERS_WAITING, std::memory_order_relaxed);
+    futex_wake(this->_State, INT_MAX);
+  }
+}
+
 void SharedMutex_O::setLockNames(core::SimpleBaseString_sp readLockName, core::SimpleBaseString_sp writeLockName)
 {
-  this->_SharedMutex.mReadMutex._value._NameWord = lisp_nameword(readLockName);
-  this->_SharedMutex.mWriteMutex._value._NameWord = lisp_nameword(writeLockName);
+  this->_SharedMutex._ReadNameWord = lisp_nameword(readLockName);
+  this->_SharedMutex._WriteNameWord = lisp_nameword(writeLockName);
 }
 
 
+struct SharedMutexContentionData {
+  size_t _First;
+  char   _Pad[64];
+  size_t _Second;
+};
+
+template <typename LockType>
+static size_t shared_mutex_contention_loop(LockType& lock, SharedMutexContentionData& data, size_t iterations, size_t write_every) {
+  size_t torn = 0;
+  for (size_t ii = 1; ii <= iterations; ++ii) {
+    if (write_every && ii % write_every == 0) {
+      lock.writeLock();
+      ++data._First;
+      ++data._Second;
+      lock.writeUnlock();
+    } else {
+      lock.readLock();
+      if (data._First != data._Second) ++torn;
+      lock.readUnlock();
+    }
+  }
+  return torn;
+}
+
+SYMBOL_EXPORT_SC_(KeywordPkg,upgradable);
+SYMBOL_EXPORT_SC_(KeywordPkg,futex);
+SYMBOL_EXPORT_SC_(KeywordPkg,futex_read_biased);
+
+UpgradableSharedMutex global_ContentionUpgradable(SHRDBNCH_NAMEWORD, 64);
+FutexSharedMutex global_ContentionFutex(SHRDBNCH_NAMEWORD);
+FutexSharedMutex global_ContentionFutexReadBiased(SHRDBNCH_NAMEWORD, 0, true);
+SharedMutexContentionData global_ContentionData;
+
+CL_LAMBDA(kind iterations &optional (write-every 100))
+CL_DOCSTRING(R"dx(Lock and unlock a shared mutex iterations times, taking the write lock every
+write-every iterations and the shared lock otherwise. kind is :upgradable for the old
+UpgradableSharedMutex, :futex for the lock shared mutexes use now or :futex-read-biased.
+Every thread that calls this with the same kind uses the same mutex, so calling it from
+several threads at once measures contention. Returns the number of times a reader saw a
+half finished write, which must be zero.)dx")
+DOCGROUP(clasp)
+CL_DEFUN size_t mp__shared_mutex_contention_loop(core::Symbol_sp kind, size_t iterations, size_t write_every) {
+  if (kind == kw::_sym_upgradable) {
+    return shared_mutex_contention_loop(global_ContentionUpgradable, global_ContentionData, iterations, write_every);
+  } else if (kind == kw::_sym_futex) {
+    return shared_mutex_contention_loop(global_ContentionFutex, global_ContentionData, iterations, write_every);
+  } else if (kind == kw::_sym_futex_read_biased) {
+    return shared_mutex_contention_loop(global_ContentionFutexReadBiased, global_ContentionData, iterations, write_every);
+  }
+  SIMPLE_ERROR(("Unknown shared mutex kind %s - use :upgradable, :futex or :futex-read-biased") , _rep_(kind));
+}
+
 string SharedMutex_O::__repr__() const {
   stringstream ss;
   ss << "#<SHARED-MUTEX ";
@@ -456,6 +946,8 @@ DOCGROUP(clasp)
 CL_DEFUN void mp__suspend_loop() {
   Process_sp this_process = gc::As<Process_sp>(_sym_STARcurrent_processSTAR->symbolValue());
   RAIILock<Mutex> lock(this_process->_SuspensionMutex._value);
+  // A process being killed has its exit queued behind us
+  if (this_process->_KillRequested.load()) return;
   this_process->_Phase = Suspended;
   while (this_process->_Phase == Suspended) {
     if (!(this_process->_SuspensionCV._value.wait(this_process->_SuspensionMutex._value)))
@@ -501,12 +993,26 @@ SYMBOL_EXPORT_SC_(MpPkg,process_error_process);
 SYMBOL_EXPORT_SC_(MpPkg,process_join_error);
 SYMBOL_EXPORT_SC_(MpPkg,process_join_error_original_condition);
 SYMBOL_EXPORT_SC_(KeywordPkg,original_condition);
+SYMBOL_EXPORT_SC_(MpPkg,process_join_timeout);
+SYMBOL_EXPORT_SC_(MpPkg,process_join_timeout_timeout);
+SYMBOL_EXPORT_SC_(KeywordPkg,timeout);
 
-CL_DOCSTRING(R"dx(Wait for the given process to finish executing. If the process's function returns normally, those values are returned. If the process exited due to EXIT-PROCESS, the values provided to that function are returned. If the process was aborted by ABORT-PROCESS or a control transfer, an error of type PROCESS-JOIN-ERROR is signaled.)dx")
+CL_LAMBDA(process &key timeout (default nil defaultp))
+CL_DOCSTRING(R"dx(Wait for the given process to finish executing. If the process's function returns normally, those values are returned. If the process exited due to EXIT-PROCESS, the values provided to that function are returned. If the process was aborted by ABORT-PROCESS or a control transfer, an error of type PROCESS-JOIN-ERROR is signaled. If TIMEOUT seconds pass before the process exits, DEFAULT is returned if it was given, otherwise an error of type PROCESS-JOIN-TIMEOUT is signaled.)dx")
 DOCGROUP(clasp)
-CL_DEFUN core::T_mv mp__process_join(Process_sp process) {
-  // ECL has a much more complicated process_join function
-  if (process->_Phase != Exited ) {
+CL_DEFUN core::T_mv mp__process_join(Process_sp process, core::T_sp timeout, core::T_sp default_value, bool defaultp) {
+  ProcessWaitDeadline deadline = process_wait_deadline(timeout);
+  while (process->_ExitNotify.load(std::memory_order_acquire) == 0) {
+    if (!process_wait_step(process->_ExitNotify, 0, deadline)) {
+      if (defaultp) return Values(default_value);
+      ERROR(_sym_process_join_timeout,
+            core::lisp_createList(kw::_sym_process, process,
+                                  kw::_sym_timeout, timeout));
+    }
+  }
+  // The thread is done with Lisp, release it.  Only the first joiner can.
+  bool joined = false;
+  if (process->_Joined.compare_exchange_strong(joined, true)) {
     pthread_join(process->_TheThread._value,NULL);
   }
   if (process->_Aborted)
@@ -517,6 +1023,23 @@ CL_DEFUN core::T_mv mp__process_join(Process_sp process) {
   else return cl__values_list(process->_ReturnValuesList);
 }
 
+CL_LAMBDA(processes &key timeout)
+CL_DOCSTRING(R"dx(Wait until one of the given processes has exited and return it, or return NIL if TIMEOUT seconds pass first. The process is not joined; call PROCESS-JOIN on it for its values.)dx")
+DOCGROUP(clasp)
+CL_DEFUN core::T_sp mp__wait_for_any_process(core::List_sp processes, core::T_sp timeout) {
+  ProcessWaitDeadline deadline = process_wait_deadline(timeout);
+  while (true) {
+    // Read the count before looking, so an exit after we look wakes us
+    uint32_t exits = global_ProcessExits.load(std::memory_order_acquire);
+    for (auto cur : processes) {
+      Process_sp process = gc::As<Process_sp>(CONS_CAR(cur));
+      if (process->_ExitNotify.load(std::memory_order_acquire)) return process;
+    }
+    if (processes.nilp() || !process_wait_step(global_ProcessExits, exits, deadline))
+      return nil<core::T_O>();
+  }
+}
+
 CL_DOCSTRING(R"dx(Interrupt the given process to make it call the given function with no arguments. Return no values.)dx")
 DOCGROUP(clasp)
 CL_DEFUN void mp__interrupt_process(Process_sp process, core::T_sp func) {
@@ -527,11 +1050,23 @@ CL_DEFUN void mp__interrupt_process(Process_sp process, core::T_sp func) {
 };
 
 SYMBOL_EXPORT_SC_(MpPkg,exit_process);
-CL_DOCSTRING(R"dx(Force a process to end. This function is not intended for regular usage and is not reliable.)dx")
+CL_DOCSTRING(R"dx(Force a process to end as if it called EXIT-PROCESS with no values. The exit is queued like an interrupt and happens at the next safepoint of the process: a function entry or loop iteration in compiled code, an allocation, SLEEP, a wait in PROCESS-JOIN or WAIT-FOR-ANY-PROCESS, or CHECK-PENDING-INTERRUPTS. A process that has not started yet exits as soon as it starts, and a suspended process is resumed to exit. Its exit hooks run either way. Return no values.)dx")
 DOCGROUP(clasp)
 CL_DEFUN void mp__process_kill(Process_sp process)
 {
-  mp__interrupt_process(process, _sym_exit_process);
+  if (process.raw_() == _sym_STARcurrent_processSTAR->symbolValue().raw_())
+    mp__exit_process(nil<core::T_O>());
+  // A nascent process sees this when it starts, a suspended one in suspend_loop
+  process->_KillRequested.store(true);
+  ProcessPhase phase = process->_Phase.load();
+  if (phase == Active || phase == Suspended) {
+    clasp_interrupt_process(process, _sym_exit_process);
+    RAIILock<Mutex> lock(process->_SuspensionMutex._value);
+    if (process->_Phase == Suspended) {
+      process->_Phase = Active;
+      process->_SuspensionCV._value.signal();
+    }
+  }
 }
 
 CL_LAMBDA(&rest values)
@@ -653,5 +1188,300 @@ CL_DEFUN void mp__check_pending_interrupts() {
   gctools::handle_all_queued_interrupts();
 }
 
+/*! The executor runs Lisp functions (tasks) on a pool of worker processes.
+    Each worker has a deque: it pushes and pops its own tasks at the tail and
+    idle workers steal the oldest task from the head.  Tasks submitted from
+    outside the pool go into the injection queue.  The tasks live in rings in
+    _lisp->_Roots._ExecutorQueues so that the collector sees them; the
+    indices and locks of the rings are kept here. */
+struct ExecutorQueue {
+  Mutex                 _Mutex;
+  std::atomic<size_t>   _Head{0}; // the oldest task, taken by thieves and from the injection queue
+  std::atomic<size_t>   _Tail{0}; // one past the newest task, pushed and popped by the owner
+  ExecutorQueue() : _Mutex(EXECQUE_NAMEWORD) {};
+};
+
+struct Executor {
+  ExecutorQueue             _Queues[EXECUTOR_MAX_WORKERS+1];
+  Mutex                     _Mutex;   // workers park and stop under this
+  ConditionVariable         _Wakeup;  // tasks were submitted or the workers should stop
+  ConditionVariable         _Stopped; // a worker exited
+  std::atomic<bool>         _Starting{false};
+  std::atomic<size_t>       _Workers{0};  // worker processes started
+  std::atomic<size_t>       _Live{0};     // worker processes that have not exited
+  std::atomic<int64_t>      _Pending{0};  // tasks in all queues
+  std::atomic<size_t>       _Sleepers{0}; // workers parked on _Wakeup
+  std::atomic<size_t>       _Submitting{0}; // submitters from outside the pool between their check and their push
+  bool                      _Stop = false;
+  std::atomic<uint64_t>     _Submitted{0};
+  std::atomic<uint64_t>     _Executed{0};
+  std::atomic<uint64_t>     _Stolen{0};
+  Executor() : _Mutex(EXECPRK_NAMEWORD) {};
+};
+
+Executor global_Executor;
+
+// The queue of the worker running in this thread, or 0 if it isn't a worker
+static thread_local size_t my_executor_queue = 0;
+// Picks the first victim when this thread steals
+static thread_local uint64_t my_executor_steal_seed = 0;
+
+core::SimpleVector_sp make_executor_queues() {
+  core::SimpleVector_sp queues = core::SimpleVector_O::make(EXECUTOR_MAX_WORKERS+1);
+  // Rings start out empty and are allocated by the first push
+  core::SimpleVector_sp empty = core::SimpleVector_O::make(0);
+  for (size_t ii = 0; ii <= EXECUTOR_MAX_WORKERS; ++ii) {
+    (*queues)[ii] = empty;
+  }
+  return queues;
+}
+
+static core::SimpleVector_sp executor_ring(size_t index) {
+  return gc::As_unsafe<core::SimpleVector_sp>((*_lisp->_Roots._ExecutorQueues)[index]);
+}
+
+// Replace a full ring with one twice its capacity.  The new ring is
+// allocated outside of the queue lock.
+static void executor_grow(size_t index, size_t capacity) {
+  size_t new_capacity = capacity ? 2*capacity : EXECUTOR_INITIAL_CAPACITY;
+  core::SimpleVector_sp bigger = core::SimpleVector_O::make(new_capacity);
+  ExecutorQueue& q = global_Executor._Queues[index];
+  RAIIReadWriteLock<Mutex> lock(q._Mutex);
+  core::SimpleVector_sp ring = executor_ring(index);
+  if (ring->length() != capacity) return; // another thread grew it first
+  size_t head = q._Head.load(std::memory_order_relaxed);
+  size_t tail = q._Tail.load(std::memory_order_relaxed);
+  for (size_t ii = head; ii < tail; ++ii) {
+    (*bigger)[ii % new_capacity] = (*ring)[ii % capacity];
+  }
+  (*_lisp->_Roots._ExecutorQueues)[index] = bigger;
+}
+
+static void executor_push(size_t index, core::T_sp task) {
+  ExecutorQueue& q = global_Executor._Queues[index];
+  while (true) {
+    size_t capacity;
+    {
+      RAIIReadWriteLock<Mutex> lock(q._Mutex);
+      core::SimpleVector_sp ring = executor_ring(index);
+      capacity = ring->length();
+      size_t tail = q._Tail.load(std::memory_order_relaxed);
+      if (tail - q._Head.load(std::memory_order_relaxed) < capacity) {
+        (*ring)[tail % capacity] = task;
+        q._Tail.store(tail+1, std::memory_order_release);
+        return;
+      }
+    }
+    executor_grow(index, capacity);
+  }
+}
+
+// Take the newest task (the owner's end) or the oldest one (the thieves' end)
+static bool executor_take(size_t index, bool newest, core::T_sp& task) {
+  ExecutorQueue& q = global_Executor._Queues[index];
+  // Most queues a thief looks at are empty, don't lock those
+  if (q._Tail.load(std::memory_order_acquire) == q._Head.load(std::memory_order_acquire)) return false;
+  RAIIReadWriteLock<Mutex> lock(q._Mutex);
+  size_t head = q._Head.load(std::memory_order_relaxed);
+  size_t tail = q._Tail.load(std::memory_order_relaxed);
+  if (tail == head) return false;
+  core::SimpleVector_sp ring = executor_ring(index);
+  size_t slot = (newest ? tail-1 : head) % ring->length();
+  task = (*ring)[slot];
+  (*ring)[slot] = nil<core::T_O>(); // don't keep the task alive
+  if (newest) q._Tail.store(tail-1, std::memory_order_relaxed);
+  else q._Head.store(head+1, std::memory_order_relaxed);
+  global_Executor._Pending.fetch_sub(1);
+  return true;
+}
+
+// Look for a task in the worker's own deque, then in the injection queue,
+// then in the deques of the other workers starting at a random one
+static bool executor_find_task(size_t index, core::T_sp& task) {
+  Executor& ex = global_Executor;
+  if (index && executor_take(index, true, task)) return true;
+  if (executor_take(0, false, task)) return true;
+  size_t workers = ex._Workers.load(std::memory_order_acquire);
+  if (workers == 0) return false;
+  my_executor_steal_seed += 0x9E3779B97F4A7C15;
+  size_t start = (my_executor_steal_seed >> 32) % workers;
+  for (size_t ii = 0; ii < workers; ++ii) {
+    size_t victim = 1 + (start+ii) % workers;
+    if (victim == index) continue;
+    if (executor_take(victim, false, task)) {
+      ex._Stolen.fetch_add(1, std::memory_order_relaxed);
+      return true;
+    }
+  }
+  return false;
+}
+
+static void executor_run(core::T_sp task) {
+  core::eval::funcall(task);
+  global_Executor._Executed.fetch_add(1, std::memory_order_relaxed);
+}
+
+// Count the worker out however it leaves its loop
+struct ExecutorWorkerExit {
+  ~ExecutorWorkerExit() {
+    Executor& ex = global_Executor;
+    my_executor_queue = 0;
+    ex._Mutex.lock();
+    ex._Live.fetch_sub(1);
+    ex._Stopped.broadcast();
+    ex._Mutex.unlock();
+  }
+};
+
+CL_LAMBDA(&optional (workers 0))
+CL_DOCSTRING(R"dx(Start the worker processes of the executor unless they are running, and return
+how many there are. WORKERS defaults to the number of processors online. The workers start
+with the bindings of mp:push-default-special-binding, like any process.)dx")
+DOCGROUP(clasp)
+CL_DEFUN size_t mp__start_executor(size_t workers) {
+  Executor& ex = global_Executor;
+  while (true) {
+    size_t running = ex._Workers.load(std::memory_order_acquire);
+    if (running) return running;
+    bool expected = false;
+    if (ex._Starting.compare_exchange_strong(expected, true)) break;
+    sched_yield(); // another thread is starting or stopping the workers
+  }
+  if (workers == 0) workers = sysconf(_SC_NPROCESSORS_ONLN);
+  workers = std::min(std::max(workers, (size_t)1), (size_t)EXECUTOR_MAX_WORKERS);
+  ex._Mutex.lock();
+  ex._Stop = false;
+  ex._Mutex.unlock();
+  core::Symbol_sp loop = _lisp->internWithPackageName("MP", "EXECUTOR-WORKER-LOOP");
+  for (size_t ii = 1; ii <= workers; ++ii) {
+    stringstream name;
+    name << "Executor-" << ii;
+    Process_sp process = Process_O::make_process(core::SimpleBaseString_O::make(name.str()), loop,
+                                                 core::Cons_O::create(core::make_fixnum(ii), nil<core::T_O>()),
+                                                 nil<core::T_O>(), DEFAULT_THREAD_STACK_SIZE);
+    ex._Live.fetch_add(1);
+    _lisp->add_process(process);
+    process->startProcess();
+  }
+  ex._Workers.store(workers, std::memory_order_release);
+  ex._Starting.store(false);
+  return workers;
+}
+
+CL_DOCSTRING(R"dx(Let the executor workers finish the queued tasks, then stop them and wait for
+them to exit. The next task submitted starts the workers again; one submitted while they are
+stopping waits for that and then starts them.)dx")
+DOCGROUP(clasp)
+CL_DEFUN void mp__stop_executor() {
+  Executor& ex = global_Executor;
+  if (my_executor_queue) SIMPLE_ERROR(("An executor worker cannot stop the executor"));
+  bool expected = false;
+  while (!ex._Starting.compare_exchange_strong(expected, true)) {
+    expected = false;
+    sched_yield();
+  }
+  // Let submitters that got in before us finish queueing their tasks
+  while (ex._Submitting.load()) sched_yield();
+  if (ex._Workers.load()) {
+    ex._Mutex.lock();
+    ex._Stop = true;
+    ex._Wakeup.broadcast();
+    while (ex._Live.load()) ex._Stopped.timed_wait(ex._Mutex, 1.0);
+    ex._Mutex.unlock();
+    ex._Workers.store(0);
+  }
+  ex._Starting.store(false);
+}
+
+CL_DOCSTRING(R"dx(The body of an executor worker, started by mp:start-executor. Runs tasks until
+mp:stop-executor is called and no tasks are queued.)dx")
+DOCGROUP(clasp)
+CL_DEFUN void mp__executor_worker_loop(size_t index) {
+  Executor& ex = global_Executor;
+  my_executor_queue = index;
+  my_executor_steal_seed = index;
+  my_thread->_ServiceThread = true;
+  ExecutorWorkerExit exit;
+  core::T_sp task;
+  while (true) {
+    if (executor_find_task(index, task)) {
+      executor_run(task);
+      task = nil<core::T_O>();
+      continue;
+    }
+    // Park.  A submitter increments _Pending before it looks at _Sleepers,
+    // and we count ourselves a sleeper before we look at _Pending, so one of
+    // us sees the other.
+    ex._Mutex.lock();
+    ex._Sleepers.fetch_add(1);
+    while (ex._Pending.load() <= 0 && !ex._Stop) ex._Wakeup.wait(ex._Mutex);
+    ex._Sleepers.fetch_sub(1);
+    bool stop = ex._Stop && ex._Pending.load() <= 0;
+    ex._Mutex.unlock();
+    if (stop) break;
+  }
+}
+
+CL_DOCSTRING(R"dx(Queue FUNCTION to be called with no arguments by an executor worker, starting the
+workers if they are not running. From a worker the task goes on the worker's own deque, otherwise
+on the injection queue. mp:submit wraps this and returns a future.)dx")
+DOCGROUP(clasp)
+CL_DEFUN void mp__PERCENTexecutor_submit(core::Function_sp function) {
+  Executor& ex = global_Executor;
+  // A worker is live until the queues are empty, so its own tasks can't be stranded.
+  // Anyone else counts itself in _Submitting before it looks at _Starting, and
+  // mp:stop-executor sets _Starting before it waits for _Submitting to drop to zero,
+  // so either the workers see this task or we wait until they have been stopped and
+  // start them again.
+  if (!my_executor_queue) {
+    while (true) {
+      mp__start_executor(0);
+      ex._Submitting.fetch_add(1);
+      if (!ex._Starting.load() && ex._Workers.load()) break;
+      ex._Submitting.fetch_sub(1);
+      sched_yield();
+    }
+  }
+  executor_push(my_executor_queue, function);
+  ex._Submitted.fetch_add(1, std::memory_order_relaxed);
+  ex._Pending.fetch_add(1);
+  if (ex._Sleepers.load() > 0) {
+    ex._Mutex.lock();
+    ex._Wakeup.signal();
+    ex._Mutex.unlock();
+  }
+  if (!my_executor_queue) ex._Submitting.fetch_sub(1);
+}
+
+CL_DOCSTRING(R"dx(Run one queued task and return true if the current process is an executor worker
+and there is a task to run, otherwise return false. A worker waiting for a future calls this so
+that it keeps running tasks instead of blocking.)dx")
+DOCGROUP(clasp)
+CL_DEFUN bool mp__PERCENTexecutor_run_one() {
+  size_t index = my_executor_queue;
+  if (!index) return false;
+  core::T_sp task;
+  if (!executor_find_task(index, task)) return false;
+  executor_run(task);
+  return true;
+}
+
+CL_DOCSTRING(R"dx(Return true if the current process is an executor worker.)dx")
+DOCGROUP(clasp)
+CL_DEFUN bool mp__executor_worker_p() {
+  return my_executor_queue != 0;
+}
+
+CL_DOCSTRING(R"dx(Return the number of executor workers running and, as further values, the number of
+tasks submitted, the number run and the number stolen from another worker's deque.)dx")
+DOCGROUP(clasp)
+CL_DEFUN core::T_mv mp__executor_statistics() {
+  Executor& ex = global_Executor;
+  return Values(core::make_fixnum(ex._Workers.load()),
+                core::Integer_O::create((uint64_t)ex._Submitted.load()),
+                core::Integer_O::create((uint64_t)ex._Executed.load()),
+                core::Integer_O::create((uint64_t)ex._Stolen.load()));
+}
+
 };
 
@@ -225,8 +225,8 @@ destructively_check_directory(List_sp directory, bool logical, bool delete_back)
   /* This function performs two tasks
 	 * 1) It ensures that the list is a valid directory list
 	 * 2) It ensures that all strings in the list are valid C strings without fill pointer
-	 *    All strings are copied, thus avoiding problems with the user modifying the
-	 *    list that was passed to MAKE-PATHNAME.
+	 *    All strings are replaced by their interned copies, thus avoiding problems with
+	 *    the user modifying the list that was passed to MAKE-PATHNAME.
 	 * 3) Redundant :back are removed.
 	 */
   /* INV: directory is always a list */
@@ -278,11 +278,8 @@ BEGIN:
         return kw::_sym_error;
       }
     } else if (cl__stringp(item)) {
-      String_sp sitem = gc::As_unsafe<String_sp>(item);
+      String_sp sitem = gc::As_unsafe<String_sp>(clasp_intern_pathname_component(item));
       size_t l = cl__length(sitem);
-      if (core__fits_in_base_string(sitem)) {
-        sitem = gc::As_unsafe<SimpleBaseString_sp>(core__copy_to_simple_base_string(sitem));
-      } else sitem = gc::As_unsafe<String_sp>(cl__copy_seq(sitem));
       gc::As<Cons_sp>(ptr)->rplaca(sitem);
       if (logical) continue;
       if (l && cl__char(sitem, 0).unsafe_character() == '.') {
@@ -389,8 +386,9 @@ Pathname_sp Pathname_O::makePathname(T_sp host, T_sp device, T_sp directory,
         translate_component_case(host, fromcase, tocase);
     p->_Device =
         translate_component_case(device, fromcase, tocase);
-    directory =
-        translate_list_case(directory, fromcase, tocase); // .as<List_O>()
+    // The directory list was already copied above
+    if (fromcase != tocase)
+      directory = translate_list_case(directory, fromcase, tocase);
     p->_Directory = directory;
     p->_Name =
         translate_component_case(name, fromcase, tocase);
@@ -522,6 +520,140 @@ static int is_semicolon(int c) { return c == ';'; }
 static int is_dot(int c) { return c == '.'; }
 static int is_null(int c) { return c == '\0'; }
 
+/*
+ * The characters of a namestring are copied once out of the storage of
+ * the string (which may be displaced, have a fill pointer or either
+ * element width) so that the parser scans a plain buffer instead of
+ * calling cl__char for every character. Allocating the components
+ * while parsing can then never invalidate what is being scanned.
+ */
+#define NAMESTRING_BUFFER_INLINE 256
+
+struct NamestringBuffer {
+  claspCharacter _Inline[NAMESTRING_BUFFER_INLINE];
+  std::vector<claspCharacter> _Heap;
+  const claspCharacter* _Chars;
+  size_t _Length;
+  NamestringBuffer(T_sp s) {
+    String_sp str = gc::As<String_sp>(s);
+    this->_Length = cl__length(str);
+    claspCharacter* chars = this->_Inline;
+    if (this->_Length > NAMESTRING_BUFFER_INLINE) {
+      this->_Heap.resize(this->_Length);
+      chars = this->_Heap.data();
+    }
+    AbstractSimpleVector_sp sv;
+    size_t start, end;
+    str->asAbstractSimpleVectorRange(sv, start, end);
+    if (gc::IsA<SimpleBaseString_sp>(sv)) {
+      const claspChar* src = (const claspChar*)sv->rowMajorAddressOfElement_(start);
+      for (size_t i = 0; i < this->_Length; ++i)
+        chars[i] = src[i];
+    } else {
+      const claspCharacter* src = (const claspCharacter*)sv->rowMajorAddressOfElement_(start);
+      memcpy(chars, src, this->_Length * sizeof(claspCharacter));
+    }
+    this->_Chars = chars;
+  }
+  NamestringBuffer(const NamestringBuffer&) = delete;
+  claspCharacter operator[](size_t i) const { return this->_Chars[i]; };
+  const claspCharacter* chars(size_t i) const { return this->_Chars + i; };
+};
+
+/*
+ * Component strings are interned in the direct mapped table
+ * _lisp->_Roots._PathnameComponents, so that pathnames parsed from
+ * similar namestrings share their directory and type strings and parsing
+ * the same text again does not allocate them again. A slot is simply
+ * overwritten when another string hashes to it. Only short base strings
+ * are interned, everything else is copied as before. Lookups take
+ * globals_->_PathnameComponentsMutex for reading, stores for writing.
+ * The interned strings are never handed out to Lisp: the pathname
+ * accessors return copies (see copy_shared_component), so nothing can
+ * modify a string that other pathnames share.
+ */
+#define PATHNAME_COMPONENT_MAX_LENGTH 64
+
+template <typename Char>
+static T_sp intern_component(const Char* chars, size_t len) {
+  uint32_t hash = 2166136261u;
+  bool base = true;
+  for (size_t i = 0; i < len; ++i) {
+    base &= clasp_base_char_p(chars[i]);
+    hash = (hash ^ chars[i]) * 16777619u;
+  }
+  if (!base) {
+    SimpleCharacterString_sp str = SimpleCharacterString_O::make(len);
+    for (size_t i = 0; i < len; ++i)
+      (*str)[i] = chars[i];
+    return str;
+  }
+  if (len > PATHNAME_COMPONENT_MAX_LENGTH) {
+    SimpleBaseString_sp str = SimpleBaseString_O::make(len);
+    for (size_t i = 0; i < len; ++i)
+      (*str)[i] = chars[i];
+    return str;
+  }
+  SimpleVector_sp table = _lisp->_Roots._PathnameComponents;
+  size_t slot = hash & (PATHNAME_COMPONENT_CACHE_SIZE - 1);
+  {
+    WITH_READ_LOCK(globals_->_PathnameComponentsMutex);
+    T_sp entry = (*table)[slot];
+    if (gc::IsA<SimpleBaseString_sp>(entry)) {
+      SimpleBaseString_sp sentry = gc::As_unsafe<SimpleBaseString_sp>(entry);
+      if (sentry->length() == len) {
+        size_t i = 0;
+        while (i < len && (*sentry)[i] == chars[i])
+          ++i;
+        if (i == len)
+          return sentry;
+      }
+    }
+  }
+  SimpleBaseString_sp str = SimpleBaseString_O::make(len);
+  for (size_t i = 0; i < len; ++i)
+    (*str)[i] = chars[i];
+  WITH_READ_WRITE_LOCK(globals_->_PathnameComponentsMutex);
+  (*table)[slot] = str;
+  return str;
+}
+
+/*! The accessors return this instead of a component string or directory
+    list of the pathname itself, which may be interned and shared. */
+static T_sp copy_shared_component(T_sp component) {
+  if (cl__stringp(component)) {
+    return cl__copy_seq(component);
+  } else if (component.consp()) {
+    List_sp list = cl__copy_list(component);
+    for (auto l : list) {
+      T_sp item = oCar(l);
+      if (cl__stringp(item))
+        l->rplaca(cl__copy_seq(item));
+    }
+    return list;
+  }
+  return component;
+}
+
+/*! Return the interned copy of a component string, the argument itself is
+    never returned unless it is the interned copy. Other objects are
+    returned unchanged. */
+T_sp clasp_intern_pathname_component(T_sp component) {
+  if (gc::IsA<SimpleBaseString_sp>(component)) {
+    SimpleBaseString_sp str = gc::As_unsafe<SimpleBaseString_sp>(component);
+    return intern_component((const claspChar*)str->rowMajorAddressOfElement_(0), str->length());
+  } else if (cl__stringp(component)) {
+    NamestringBuffer buffer(component);
+    return intern_component(buffer.chars(0), buffer._Length);
+  }
+  return component;
+}
+
+static T_sp
+make_component(const NamestringBuffer& s, size_t start, size_t end) {
+  return intern_component(s.chars(start), end - start);
+}
+
 
 /*
  * Parses a word from string `S' until either:
@@ -535,15 +667,14 @@ static int is_null(int c) { return c == '\0'; }
  *	5) A non empty string
  */
 static T_sp
-parse_word(T_sp st, delim_fn delim, int flags, size_t start,
+parse_word(const NamestringBuffer& s, delim_fn delim, int flags, size_t start,
            size_t end, size_t *end_of_word) {
   size_t i, j, last_delim = end;
   bool wild_inferiors = false;
-  String_sp ss = gc::As<String_sp>(st);
   i = j = start;
   for (; i < end; i++) {
     bool valid_char;
-    size_t c = cl__char(ss, i).unsafe_character();
+    size_t c = s[i];
     if (delim(c)) {
       if ((i == start) && (flags & WORD_ALLOW_LEADING_DOT)) {
         /* Leading dot is included */
@@ -558,7 +689,7 @@ parse_word(T_sp st, delim_fn delim, int flags, size_t start,
       if (!(flags & WORD_ALLOW_ASTERISK))
         valid_char = false; /* Asterisks not allowed in this word */
       else {
-        wild_inferiors = (i > start && cl__char(ss, i - 1).unsafe_character() == '*');
+        wild_inferiors = (i > start && s[i - 1] == '*');
         valid_char = true; /* single "*" */
       }
     } else if (c == ';' && (flags & WORD_DISALLOW_SEMICOLON)) {
@@ -592,14 +723,14 @@ parse_word(T_sp st, delim_fn delim, int flags, size_t start,
   case 0:
     if (flags & WORD_EMPTY_IS_NIL)
       return nil<T_O>();
-    return SimpleBaseString_O::make(""); // cl_core.null_string;
+    return make_component(s, j, j);
   case 1:
-      if (cl__char(ss, j).unsafe_character() == '*')
+    if (s[j] == '*')
       return kw::_sym_wild;
     break;
   case 2: {
-    size_t c0 = cl__char(ss, j).unsafe_character();
-    size_t c1 = cl__char(ss, j + 1).unsafe_character();
+    size_t c0 = s[j];
+    size_t c1 = s[j + 1];
     if (c0 == '*' && c1 == '*')
       return kw::_sym_wild_inferiors;
     if (!(flags & WORD_LOGICAL) && c0 == '.' && c1 == '.')
@@ -610,7 +741,7 @@ parse_word(T_sp st, delim_fn delim, int flags, size_t start,
     if (wild_inferiors) /* '**' surrounded by other characters */
       return kw::_sym_error;
   }
-  return make_one(ss, j, i);
+  return make_component(s, j, i);
 }
 
 /*
@@ -623,7 +754,7 @@ parse_word(T_sp st, delim_fn delim, int flags, size_t start,
  */
 
 static T_sp
-parse_directories(T_sp s, int flags, size_t start, size_t end,
+parse_directories(const NamestringBuffer& s, int flags, size_t start, size_t end,
                   size_t *end_of_dir) {
   size_t i, j;
   List_sp path = nil<T_O>();
@@ -677,7 +808,8 @@ CL_DEFUN T_sp core__pathname_translations(T_sp host, T_sp hostp, T_sp set) {
       QERROR_WRONG_TYPE_NTH_ARG(1, host, cl::_sym_string);
     host = cl__string_upcase(host);
     len = cl__length(host);
-    parse_word(host, is_null, WORD_LOGICAL, 0, len, &parsed_len);
+    NamestringBuffer buffer(host);
+    parse_word(buffer, is_null, WORD_LOGICAL, 0, len, &parsed_len);
     if (UNLIKELY(parsed_len < len)) {
       SIMPLE_ERROR(("Wrong host syntax %s") , _rep_(host));
     }
@@ -776,6 +908,7 @@ clasp_parseNamestring(T_sp s, size_t start, size_t end, size_t *ep,
                       T_sp default_host) {
   T_sp host, device, path, name, type, aux, version;
   bool logical = false;
+  NamestringBuffer buffer(s);
   
   if (start == end) {
     host = device = path = name = type = aux = version = nil<T_O>();
@@ -787,7 +920,7 @@ clasp_parseNamestring(T_sp s, size_t start, size_t end, size_t *ep,
 	 * there is no supplied *logical* host name. All other failures
 	 * result in _Nil<T_O>() as output.
 	 */
-  host = parse_word(s, is_colon, WORD_LOGICAL | WORD_INCLUDE_DELIM |
+  host = parse_word(buffer, is_colon, WORD_LOGICAL | WORD_INCLUDE_DELIM |
                                      WORD_DISALLOW_SEMICOLON,
                     start, end, ep);
   if (default_host.notnilp()) {
@@ -802,7 +935,7 @@ clasp_parseNamestring(T_sp s, size_t start, size_t end, size_t *ep,
 	 */
   logical = true;
   device = kw::_sym_unspecific;
-  path = parse_directories(s, WORD_LOGICAL, *ep, end, ep);
+  path = parse_directories(buffer, WORD_LOGICAL, *ep, end, ep);
   if ((path).consp()) {
     if (cons_car(path) != kw::_sym_relative &&
         cons_car(path) != kw::_sym_absolute)
@@ -813,23 +946,23 @@ clasp_parseNamestring(T_sp s, size_t start, size_t end, size_t *ep,
   }
   if (path == kw::_sym_error)
     return nil<Pathname_O>();
-  name = parse_word(s, is_dot, WORD_LOGICAL | WORD_ALLOW_ASTERISK |
+  name = parse_word(buffer, is_dot, WORD_LOGICAL | WORD_ALLOW_ASTERISK |
                                    WORD_EMPTY_IS_NIL,
                     *ep, end, ep);
   if (name == kw::_sym_error)
     return nil<Pathname_O>();
   type = nil<T_O>();
   version = nil<T_O>();
-  if (*ep == start || cl__char(gc::As<String_sp>(s), *ep - 1).unsafe_character() != '.')
+  if (*ep == start || buffer[*ep - 1] != '.')
     goto make_it;
-  type = parse_word(s, is_dot, WORD_LOGICAL | WORD_ALLOW_ASTERISK |
+  type = parse_word(buffer, is_dot, WORD_LOGICAL | WORD_ALLOW_ASTERISK |
                                    WORD_EMPTY_IS_NIL,
                     *ep, end, ep);
   if (type == kw::_sym_error)
     return nil<Pathname_O>();
-  if (*ep == start || cl__char(gc::As<String_sp>(s), *ep - 1).unsafe_character() != '.')
+  if (*ep == start || buffer[*ep - 1] != '.')
     goto make_it;
-  aux = parse_word(s, is_null, WORD_LOGICAL | WORD_ALLOW_ASTERISK |
+  aux = parse_word(buffer, is_null, WORD_LOGICAL | WORD_ALLOW_ASTERISK |
                                    WORD_EMPTY_IS_NIL,
                    *ep, end, ep);
   if (aux == kw::_sym_error) {
@@ -863,12 +996,12 @@ physical:
 	 * resource.
 	 */
 #if defined(CLASP_MS_WINDOWS_HOST)
-  if ((start + 1 <= end) && is_slash(cl__char(s, start))) {
+  if ((start + 1 <= end) && is_slash(buffer[start])) {
     device = nil<T_O>();
     goto maybe_parse_host;
   }
 #endif
-  device = parse_word(s, is_colon, WORD_INCLUDE_DELIM | WORD_EMPTY_IS_NIL |
+  device = parse_word(buffer, is_colon, WORD_INCLUDE_DELIM | WORD_EMPTY_IS_NIL |
                                        WORD_DISALLOW_SLASH,
                       start, end, ep);
   if (device == kw::_sym_error || device.nilp()) {
@@ -887,9 +1020,9 @@ maybe_parse_host:
     device = nil<T_O>();
   start = *ep;
   host = nil<T_O>();
-  if ((start + 2) <= end && is_slash(cl__char(gc::As<String_sp>(s), start).unsafe_character()) &&
-      is_slash(cl__char(gc::As<String_sp>(s), start + 1).unsafe_character())) {
-    host = parse_word(s, is_slash, WORD_EMPTY_IS_NIL,
+  if ((start + 2) <= end && is_slash(buffer[start]) &&
+      is_slash(buffer[start + 1])) {
+    host = parse_word(buffer, is_slash, WORD_EMPTY_IS_NIL,
                       start + 2, end, ep);
     if (host == kw::_sym_error) {
       host = nil<T_O>();
@@ -897,14 +1030,14 @@ maybe_parse_host:
       if (!cl__stringp(host))
         return nil<Pathname_O>();
       start = *ep;
-      if (is_slash(cl__char(gc::As<String_sp>(s), --start).unsafe_character()))
+      if (is_slash(buffer[--start]))
         *ep = start;
     }
   }
   if (cl__length(device) == 0)
     device = nil<T_O>();
 done_device_and_host:
-  path = parse_directories(s, 0, *ep, end, ep);
+  path = parse_directories(buffer, 0, *ep, end, ep);
   if ((path).consp()) {
     if (cons_car(path) != kw::_sym_relative &&
         cons_car(path) != kw::_sym_absolute)
@@ -914,16 +1047,16 @@ done_device_and_host:
   if (path == kw::_sym_error)
     return nil<Pathname_O>();
   start = *ep;
-  name = parse_word(s, is_dot,
+  name = parse_word(buffer, is_dot,
                     WORD_ALLOW_LEADING_DOT | WORD_SEARCH_LAST_DOT |
                         WORD_ALLOW_ASTERISK | WORD_EMPTY_IS_NIL,
                     start, end, ep);
   if (name == kw::_sym_error)
     return nil<Pathname_O>();
-  if ((*ep - start) <= 1 || cl__char(gc::As<String_sp>(s), *ep - 1).unsafe_character() != '.') {
+  if ((*ep - start) <= 1 || buffer[*ep - 1] != '.') {
     type = nil<T_O>();
   } else {
-    type = parse_word(s, is_null, WORD_ALLOW_ASTERISK, *ep, end, ep);
+    type = parse_word(buffer, is_null, WORD_ALLOW_ASTERISK, *ep, end, ep);
     if (type == kw::_sym_error)
       return nil<Pathname_O>();
   }
@@ -1254,21 +1387,13 @@ CL_DEFUN String_sp core__coerce_to_filename(T_sp pathname_orig) {
 }
 
 /*
-  clasp_namestring(x, flag) converts a pathname to a namestring.
-  if flag is true, then the pathname may be coerced to the requirements
-  of the filesystem, removing fields that have no meaning (such as
-  version, or type, etc); otherwise, when it is not possible to
-  produce a readable representation of the pathname, NIL is returned.
+  pathname_namestring(x) builds the namestring of a pathname, or NIL
+  when the components have no namestring representation.
 */
-T_sp clasp_namestring(T_sp tx, int flags) {
+static T_sp pathname_namestring(Pathname_sp x) {
   bool logical;
   T_sp l, y;
   T_sp host;
-  bool truncate_if_unreadable = flags & CLASP_NAMESTRING_TRUNCATE_IF_ERROR;
-
-  if (tx.nilp())
-    TYPE_ERROR(tx, Cons_O::createList(cl::_sym_or,cl::_sym_string,cl::_sym_Pathname_O));
-  Pathname_sp x = cl__pathname(tx);
 
   /* INV: Pathnames can only be created by mergin, parsing namestrings
 	 * or using clasp_make_pathname(). In all of these cases Clasp will complain
@@ -1278,9 +1403,6 @@ T_sp clasp_namestring(T_sp tx, int flags) {
   logical = core__logical_pathname_p(x);
   host = x->_Host;
   if (logical) {
-    if ((y = x->_Device) != kw::_sym_unspecific &&
-        truncate_if_unreadable)
-      return nil<T_O>();
     if (host.notnilp()) {
       cl__write_sequence(gc::As<String_sp>(host), buffer, make_fixnum(0), nil<T_O>());
       clasp_write_string(":", buffer);
@@ -1388,6 +1510,30 @@ NO_DIRECTORY:
         }
       }
     }
+  }
+  return cl__get_output_stream_string(buffer);
+}
+
+/*
+  clasp_namestring(x, flag) converts a pathname to a namestring.
+  if flag is true, then the pathname may be coerced to the requirements
+  of the filesystem, removing fields that have no meaning (such as
+  version, or type, etc); otherwise, when it is not possible to
+  produce a readable representation of the pathname, NIL is returned.
+  The namestring itself does not depend on the flags, so it is computed
+  once and cached in the pathname. The cached string is never returned
+  itself, callers get a copy they are free to modify.
+*/
+T_sp clasp_namestring(T_sp tx, int flags) {
+  bool truncate_if_unreadable = flags & CLASP_NAMESTRING_TRUNCATE_IF_ERROR;
+
+  if (tx.nilp())
+    TYPE_ERROR(tx, Cons_O::createList(cl::_sym_or,cl::_sym_string,cl::_sym_Pathname_O));
+  Pathname_sp x = cl__pathname(tx);
+  T_sp y = x->_Version;
+  if (core__logical_pathname_p(x)) {
+    if (x->_Device != kw::_sym_unspecific && truncate_if_unreadable)
+      return nil<T_O>();
   } else if (!truncate_if_unreadable) {
     /* Namestrings of physical pathnames have restrictions... */
     if (x->_Name.nilp() && x->_Type.nilp()) {
@@ -1399,18 +1545,24 @@ NO_DIRECTORY:
       return nil<T_O>();
     }
   }
-  String_sp sbuffer = gc::As<String_sp>(cl__get_output_stream_string(buffer));
+  T_sp namestring = x->_Namestring;
+  if (namestring.unboundp()) {
+    namestring = pathname_namestring(x);
+    x->_Namestring = namestring;
+  }
+  if (namestring.nilp())
+    return namestring;
 #ifdef CLASP_UNICODE
-  if (core__extended_string_p(buffer) &&
+  if (core__extended_string_p(namestring) &&
       (flags & CLASP_NAMESTRING_FORCE_BASE_STRING)) {
-    unlikely_if(!core__fits_in_base_string(buffer))
+    unlikely_if(!core__fits_in_base_string(namestring))
         FEerror("The filesystem does not accept filenames "
                 "with extended characters: ~S",
-                1, buffer.tagged_());
-    buffer = core__copy_to_simple_base_string(buffer);
+                1, namestring.tagged_());
+    return core__copy_to_simple_base_string(namestring);
   }
 #endif
-  return sbuffer;
+  return cl__copy_seq(namestring);
 }
 
 CL_LAMBDA(pathname)
@@ -1529,9 +1681,10 @@ CL_DEFUN T_sp cl__pathname_device(T_sp tpname, Symbol_sp scase) {
   if (tpname.nilp())
     TYPE_ERROR(tpname, Cons_O::createList(cl::_sym_or,cl::_sym_string,cl::_sym_Pathname_O));
   Pathname_sp pname = cl__pathname(tpname);
-  return translate_component_case(pname->_Device,
-                                  normalize_case(pname, kw::_sym_local),
-                                  normalize_case(pname, scase));
+  T_sp component = translate_component_case(pname->_Device,
+                                             normalize_case(pname, kw::_sym_local),
+                                             normalize_case(pname, scase));
+  return (component == pname->_Device) ? copy_shared_component(component) : component;
 }
 
 CL_LAMBDA(pname &key ((:case scase) :local))
@@ -1542,9 +1695,10 @@ CL_DEFUN T_sp cl__pathname_directory(T_sp tpname, Symbol_sp scase) {
   if (tpname.nilp())
     TYPE_ERROR(tpname, Cons_O::createList(cl::_sym_or,cl::_sym_string,cl::_sym_Pathname_O));
   Pathname_sp pname = cl__pathname(tpname);
-  return translate_component_case(pname->_Directory,
-                                  normalize_case(pname, kw::_sym_local),
-                                  normalize_case(pname, scase));
+  T_sp component = translate_component_case(pname->_Directory,
+                                             normalize_case(pname, kw::_sym_local),
+                                             normalize_case(pname, scase));
+  return (component == pname->_Directory) ? copy_shared_component(component) : component;
   // Directory
 }
 
@@ -1556,9 +1710,10 @@ CL_DEFUN T_sp cl__pathname_name(T_sp tpname, Symbol_sp scase) {
   if (tpname.nilp())
     TYPE_ERROR(tpname, Cons_O::createList(cl::_sym_or,cl::_sym_string,cl::_sym_Pathname_O));
   Pathname_sp pname = cl__pathname(tpname);
-  return translate_component_case(pname->_Name,
-                                  normalize_case(pname, kw::_sym_local),
-                                  normalize_case(pname, scase));
+  T_sp component = translate_component_case(pname->_Name,
+                                             normalize_case(pname, kw::_sym_local),
+                                             normalize_case(pname, scase));
+  return (component == pname->_Name) ? copy_shared_component(component) : component;
   // Name
 }
 
@@ -1570,9 +1725,10 @@ CL_DEFUN T_sp cl__pathname_type(T_sp tpname, Symbol_sp scase) {
   if (tpname.nilp())
     TYPE_ERROR(tpname, Cons_O::createList(cl::_sym_or,cl::_sym_string,cl::_sym_Pathname_O));
   Pathname_sp pname = cl__pathname(tpname);
-  return translate_component_case(pname->_Type,
-                                  normalize_case(pname, kw::_sym_local),
-                                  normalize_case(pname, scase));
+  T_sp component = translate_component_case(pname->_Type,
+                                             normalize_case(pname, kw::_sym_local),
+                                             normalize_case(pname, scase));
+  return (component == pname->_Type) ? copy_shared_component(component) : component;
   // Type
 }
 
@@ -1756,7 +1912,7 @@ bool clasp_stringMatch(T_sp s, size_t j, size_t ls,
     }
     case '?':
       /* Match any character */
-      if (j > ls)
+      if (j >= ls)
         return false;
       i++;
       j++;
@@ -1766,6 +1922,7 @@ bool clasp_stringMatch(T_sp s, size_t j, size_t ls,
 		   Trailing slash is interpreted as a slash. */
       if (++i >= lp)
         i--;
+      cp = cl__char(gc::As<String_sp>(p), i).unsafe_character();
     default:
         if ((j >= ls) || (cp != cl__char(gc::As<String_sp>(s), j).unsafe_character())) {
         /* Either there are no characters left in "s"
@@ -1780,6 +1937,50 @@ bool clasp_stringMatch(T_sp s, size_t j, size_t ls,
   return (j >= ls);
 }
 
+/*! Like clasp_stringMatch but the string is a raw byte sequence, for
+    instance the d_name of a directory entry, so that it can be matched
+    before making a lisp string out of it. */
+bool clasp_stringMatchRaw(const char* s, size_t j, size_t ls,
+                          String_sp p, size_t i, size_t lp) {
+  while (i < lp) {
+    size_t cp = cl__char(p, i).unsafe_character();
+    switch (cp) {
+    case '*': {
+      size_t next;
+      for (next = i + 1; next < lp && cl__char(p, next).unsafe_character() == '*'; next++)
+        ;
+      if (next == lp) {
+        return true;
+      }
+      while (j < ls) {
+        if (clasp_stringMatchRaw(s, j, ls, p, next, lp)) {
+          return true;
+        }
+        j++;
+      }
+      return false;
+    }
+    case '?':
+      if (j >= ls)
+        return false;
+      i++;
+      j++;
+      break;
+    case '\\':
+      if (++i >= lp)
+        i--;
+      cp = cl__char(p, i).unsafe_character();
+    default:
+      if ((j >= ls) || (cp != (unsigned char)s[j])) {
+        return false;
+      }
+      i++;
+      j++;
+    }
+  }
+  return (j >= ls);
+}
+
 static bool
 path_item_match(T_sp a, T_sp mask) {
   if (mask == kw::_sym_wild)
@@ -0,0 +1,348 @@
+/*
+    File: sampleProfiler.cc
+*/
+
+/*
+Copyright (c) 2014, Christian E. Schafmeister
+
+CLASP is free software; you can redistribute it and/or
+modify it under the terms of the GNU Library General Public
+License as published by the Free Software Foundation; either
+version 2 of the License, or (at your option) any later version.
+
+See directory 'clasp/licenses' for full details.
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+/* -^- */
+
+// A statistical profiler that runs inside clasp, so that no perf, dtrace
+// or sudo is needed.
+//
+// setitimer(ITIMER_PROF) has the kernel send SIGPROF to whichever thread is
+// using the CPU.  The signal handler follows the frame pointer chain of the
+// interrupted context (clasp compiles C++ and Lisp code with frame pointers)
+// and copies the return addresses into one process wide buffer.  Space in the
+// buffer is reserved with a single atomic fetch_add, so the handler never
+// locks or allocates and samples from different threads never interleave.
+// Each record is
+//   [ThreadLocalState* of the sampled thread] [depth] [pc0 (leaf)] ... [pcN]
+// When the buffer fills up further samples are counted as dropped.
+//
+// There is one process timer and one buffer rather than a timer_create
+// timer and a ring per thread: SIGEV_THREAD_ID is Linux only, and per-thread
+// timers would have to be made for every thread that starts while the
+// profiler runs.  The process timer already samples each thread in
+// proportion to the CPU it uses, and the shared buffer costs one uncontended
+// atomic add per sample at these rates.
+//
+// The handler replaces clasp's own SIGPROF handler (see interrupt.cc) while
+// the profiler is installed and stays installed after it stops, because a
+// tick of the timer may still be pending then.  Ticks that arrive while the
+// profiler is stopped are dropped; a SIGPROF sent with kill or sigqueue is
+// passed on to the handler that was there before, so Lisp still sees it.
+//
+// The return addresses are only symbolized in ext:profiler-report, against
+// the object files of JITted code (see lisp_function_name_for_address in
+// backtrace.cc) and with dladdr for C++ code.  The report is written as
+// folded stacks, one "root;...;leaf count" line per distinct stack, which
+// flamegraph.pl reads directly (see src/profiler/flame-folded).
+
+#include <signal.h>
+#include <sys/time.h>
+#include <ucontext.h>
+#include <dlfcn.h>
+#include <errno.h>
+#include <atomic>
+#include <map>
+#include <string>
+#include <clasp/core/foundation.h>
+#include <clasp/core/object.h>
+#include <clasp/core/lisp.h>
+#include <clasp/core/array.h>
+#include <clasp/core/lispStream.h>
+#include <clasp/core/designators.h>
+#include <clasp/core/debugger.h>
+#include <clasp/core/mpPackage.h>
+#include <clasp/core/multipleValues.h>
+#include <clasp/gctools/threadlocal.h>
+#include <clasp/core/wrappers.h>
+
+namespace core {
+
+#define PROFILER_MAX_DEPTH 512
+#define PROFILER_RECORD_HEADER 2
+// Words a typical sample takes, used to size the buffer from the frequency
+// and duration; deep stacks take more and shallow ones less.
+#define PROFILER_WORDS_PER_SAMPLE 64
+
+struct SampleProfiler {
+  uintptr_t*          _Buffer = NULL;
+  size_t              _Size = 0;
+  std::atomic<size_t> _Fill{0};
+  std::atomic<size_t> _Samples{0};
+  std::atomic<size_t> _Dropped{0};
+  std::atomic<int>    _InHandler{0};
+  std::atomic<bool>   _Running{false};
+  struct sigaction    _OldAction;
+};
+
+SampleProfiler global_SampleProfiler;
+
+// Fill pcs with the return addresses of the interrupted thread, leaf first.
+static size_t profiler_capture_stack(void* context, uintptr_t* pcs, size_t max) {
+  uintptr_t pc;
+  uintptr_t fp;
+#if defined(__x86_64__) && defined(_TARGET_OS_LINUX)
+  ucontext_t* uc = (ucontext_t*)context;
+  pc = (uintptr_t)uc->uc_mcontext.gregs[REG_RIP];
+  fp = (uintptr_t)uc->uc_mcontext.gregs[REG_RBP];
+#elif defined(__x86_64__) && defined(_TARGET_OS_DARWIN)
+  ucontext_t* uc = (ucontext_t*)context;
+  pc = (uintptr_t)uc->uc_mcontext->__ss.__rip;
+  fp = (uintptr_t)uc->uc_mcontext->__ss.__rbp;
+#else
+  // Start from the handler itself; the signal frames will be in the samples.
+  pc = (uintptr_t)__builtin_return_address(0);
+  fp = (uintptr_t)__builtin_frame_address(0);
+#endif
+  // The handler runs on the thread's stack below the interrupted frames,
+  // so every valid frame pointer lies between here and the top of the stack.
+  uintptr_t low = (uintptr_t)&pc;
+  uintptr_t top = (uintptr_t)my_thread_low_level->_StackTop;
+  size_t depth = 0;
+  pcs[depth++] = pc;
+  while (depth < max && low < fp && fp < top && (fp & (sizeof(uintptr_t)-1)) == 0) {
+    uintptr_t next = ((uintptr_t*)fp)[0];
+    uintptr_t ret = ((uintptr_t*)fp)[1];
+    if (ret == 0) break;
+    // Back up into the call instruction so the address is inside the caller.
+    pcs[depth++] = ret - 1;
+    if (next <= fp) break;
+    low = fp;
+    fp = next;
+  }
+  return depth;
+}
+
+// Was this SIGPROF sent by a process rather than by the profiling timer?
+static bool profiler_signal_sent(siginfo_t* info) {
+  if (!info) return false;
+#ifdef SI_TKILL
+  if (info->si_code == SI_TKILL) return true;
+#endif
+  return info->si_code == SI_USER || info->si_code == SI_QUEUE;
+}
+
+// Pass a SIGPROF on to the handler that was installed before ours.
+static void profiler_chain(int sig, siginfo_t* info, void* context) {
+  struct sigaction& old = global_SampleProfiler._OldAction;
+  if (old.sa_flags & SA_SIGINFO) {
+    if (old.sa_sigaction) old.sa_sigaction(sig, info, context);
+  } else if (old.sa_handler != SIG_IGN && old.sa_handler != SIG_DFL) {
+    old.sa_handler(sig);
+  }
+  // With SIG_DFL the process would be killed; the profiler has already
+  // changed what SIGPROF does, so drop it instead.
+}
+
+static void profiler_handler(int sig, siginfo_t* info, void* context) {
+  SampleProfiler& prof = global_SampleProfiler;
+  if (!prof._Running.load() && profiler_signal_sent(info)) {
+    profiler_chain(sig, info, context);
+    return;
+  }
+  int saved_errno = errno;
+  // Announce ourselves before looking at _Running so that
+  // ext:profiler-stop can wait for handlers that are still writing.
+  prof._InHandler.fetch_add(1);
+  if (prof._Running.load() && my_thread && my_thread_low_level) {
+    uintptr_t pcs[PROFILER_MAX_DEPTH];
+    size_t depth = profiler_capture_stack(context, pcs, PROFILER_MAX_DEPTH);
+    size_t words = depth + PROFILER_RECORD_HEADER;
+    size_t start = prof._Fill.fetch_add(words, std::memory_order_relaxed);
+    if (start + words <= prof._Size) {
+      uintptr_t* record = prof._Buffer + start;
+      record[1] = depth;
+      for (size_t i = 0; i < depth; ++i) record[PROFILER_RECORD_HEADER + i] = pcs[i];
+      // A zero thread word marks the end of the records, so write it last.
+      record[0] = (uintptr_t)my_thread;
+      prof._Samples.fetch_add(1, std::memory_order_relaxed);
+    } else {
+      prof._Dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+  prof._InHandler.fetch_sub(1);
+  errno = saved_errno;
+}
+
+static void profiler_set_timer(size_t frequency) {
+  struct itimerval timer;
+  timer.it_interval.tv_sec = 0;
+  timer.it_interval.tv_usec = frequency ? (1000000 / frequency) : 0;
+  if (frequency && timer.it_interval.tv_usec == 0) timer.it_interval.tv_usec = 1;
+  timer.it_value = timer.it_interval;
+  if (setitimer(ITIMER_PROF, &timer, NULL) != 0)
+    SIMPLE_ERROR(("Could not set the profiling timer: %s"), strerror(errno));
+}
+
+CL_LAMBDA(&key (frequency 997) (duration 30) buffer-size)
+CL_DOCSTRING(R"dx(Start the statistical profiler. FREQUENCY is the number of samples per second of CPU time.
+The buffer that holds the samples is made big enough for about DURATION seconds of CPU time, summed
+over all threads; samples taken after it fills are dropped. BUFFER-SIZE, if given, is the size of the
+buffer in words instead. Any samples from a previous run are discarded.)dx")
+DOCGROUP(clasp)
+CL_DEFUN void ext__profiler_start(size_t frequency, size_t duration, T_sp tbuffer_size) {
+  SampleProfiler& prof = global_SampleProfiler;
+  if (prof._Running.load()) SIMPLE_ERROR(("The profiler is already running"));
+  if (frequency == 0) SIMPLE_ERROR(("The profiler frequency must be positive"));
+  size_t buffer_size = tbuffer_size.notnilp()
+    ? clasp_to_size_t(tbuffer_size)
+    : frequency * duration * PROFILER_WORDS_PER_SAMPLE;
+  if (buffer_size < PROFILER_MAX_DEPTH + PROFILER_RECORD_HEADER)
+    buffer_size = PROFILER_MAX_DEPTH + PROFILER_RECORD_HEADER;
+  if (prof._Buffer) free(prof._Buffer);
+  // calloc so that the unused part of the buffer reads as the end marker.
+  prof._Buffer = (uintptr_t*)calloc(buffer_size, sizeof(uintptr_t));
+  if (!prof._Buffer) SIMPLE_ERROR(("Could not allocate %lu words for the profiler"), buffer_size);
+  prof._Size = buffer_size;
+  prof._Fill.store(0);
+  prof._Samples.store(0);
+  prof._Dropped.store(0);
+  // Install the handler again if something, e.g. ext:set-signal-handler,
+  // replaced it since the last run, and remember what it replaced.
+  struct sigaction action;
+  struct sigaction old;
+  action.sa_sigaction = profiler_handler;
+  sigemptyset(&action.sa_mask);
+  action.sa_flags = SA_SIGINFO | SA_RESTART;
+  if (sigaction(SIGPROF, &action, &old) != 0)
+    SIMPLE_ERROR(("Could not install the SIGPROF handler: %s"), strerror(errno));
+  if (!((old.sa_flags & SA_SIGINFO) && old.sa_sigaction == profiler_handler))
+    prof._OldAction = old;
+  prof._Running.store(true);
+  profiler_set_timer(frequency);
+}
+
+CL_DOCSTRING(R"dx(Stop the statistical profiler. Returns the number of samples taken and the number dropped.)dx")
+DOCGROUP(clasp)
+CL_DEFUN T_mv ext__profiler_stop() {
+  SampleProfiler& prof = global_SampleProfiler;
+  if (prof._Running.load()) {
+    profiler_set_timer(0);
+    prof._Running.store(false);
+    // Handlers that saw _Running true may still be writing their sample.
+    // The handler itself stays installed and chains to the old one, see
+    // the top of this file.
+    while (prof._InHandler.load() != 0) sched_yield();
+  }
+  return Values(make_fixnum(prof._Samples.load()), make_fixnum(prof._Dropped.load()));
+}
+
+// Folded stack format uses ; to separate frames and the last space to
+// separate the count.
+static std::string profiler_clean_name(const std::string& name) {
+  std::string result = name;
+  for (auto& c : result) {
+    if (c == ';') c = ':';
+    else if (c == '\n') c = ' ';
+  }
+  return result;
+}
+
+std::string profiler_address_name(uintptr_t pc) {
+  T_sp lname = lisp_function_name_for_address((void*)pc);
+  if (lname.notnilp()) {
+    if (gc::IsA<String_sp>(lname)) return gc::As_unsafe<String_sp>(lname)->get_std_string();
+    return _rep_(lname);
+  }
+  Dl_info info;
+  if (dladdr((void*)pc, &info) != 0) {
+    if (info.dli_sname) {
+      std::string demangled;
+      if (maybe_demangle(info.dli_sname, demangled)) return demangled;
+      return info.dli_sname;
+    }
+    if (info.dli_fname) {
+      const char* base = strrchr(info.dli_fname, '/');
+      std::stringstream ss;
+      ss << (base ? base + 1 : info.dli_fname) << "+0x" << std::hex << (pc - (uintptr_t)info.dli_fbase);
+      return ss.str();
+    }
+  }
+  std::stringstream ss;
+  ss << "0x" << std::hex << pc;
+  return ss.str();
+}
+
+static std::string profiler_thread_name(uintptr_t thread) {
+  WITH_READ_LOCK(globals_->_ActiveThreadsMutex);
+  for (auto cur : (List_sp)_lisp->_Roots._ActiveThreads) {
+    mp::Process_sp process = gc::As<mp::Process_sp>(CONS_CAR(cur));
+    if ((uintptr_t)process->_ThreadInfo == thread) {
+      T_sp name = process->_Name;
+      if (gc::IsA<String_sp>(name)) return gc::As_unsafe<String_sp>(name)->get_std_string();
+      return _rep_(name);
+    }
+  }
+  return "exited-thread";
+}
+
+CL_LAMBDA(&key (output t) threads)
+CL_DOCSTRING(R"dx(Write the samples from the last profiler run to the stream designator OUTPUT as folded stacks:
+one line per distinct stack, with the frames from the outermost to the innermost separated by semicolons,
+followed by a space and the number of samples.  If THREADS is true each stack starts with the name of
+the thread it was taken in. Returns the number of samples reported.)dx")
+DOCGROUP(clasp)
+CL_DEFUN size_t ext__profiler_report(T_sp output, T_sp threads) {
+  SampleProfiler& prof = global_SampleProfiler;
+  if (prof._Running.load()) SIMPLE_ERROR(("Stop the profiler before asking for a report"));
+  T_sp stream = coerce::outputStreamDesignator(output);
+  std::map<uintptr_t, std::string> names;
+  std::map<uintptr_t, std::string> thread_names;
+  std::map<std::string, size_t> stacks;
+  size_t end = std::min(prof._Fill.load(), prof._Size);
+  size_t pos = 0;
+  size_t count = 0;
+  while (pos + PROFILER_RECORD_HEADER <= end) {
+    uintptr_t* record = prof._Buffer + pos;
+    uintptr_t thread = record[0];
+    size_t depth = record[1];
+    if (thread == 0 || pos + PROFILER_RECORD_HEADER + depth > end) break;
+    std::string stack;
+    if (threads.notnilp()) {
+      auto it = thread_names.find(thread);
+      if (it == thread_names.end())
+        it = thread_names.emplace(thread, profiler_clean_name(profiler_thread_name(thread))).first;
+      stack = it->second;
+    }
+    for (size_t i = depth; i > 0; --i) {
+      uintptr_t pc = record[PROFILER_RECORD_HEADER + i - 1];
+      auto it = names.find(pc);
+      if (it == names.end())
+        it = names.emplace(pc, profiler_clean_name(profiler_address_name(pc))).first;
+      if (!stack.empty()) stack += ';';
+      stack += it->second;
+    }
+    stacks[stack]++;
+    count++;
+    pos += PROFILER_RECORD_HEADER + depth;
+  }
+  for (auto& entry : stacks) {
+    clasp_write_string(entry.first, stream);
+    clasp_write_string(fmt::sprintf(" %lu", entry.second), stream);
+    clasp_terpri(stream);
+  }
+  return count;
+}
+
+}; // namespace core
@@ -5,6 +5,7 @@
 #include <clasp/core/designators.h>
 #include <clasp/core/array.h>
 #include <clasp/core/character.h>
+#include <clasp/core/stringKernels.h>
 #include <clasp/core/ql.h>
 
 // ----------------------------------------------------------------------
@@ -202,6 +203,42 @@ StringCharPointer& operator++() {
 };
 
 
+/*! Address of the element at index in the storage of a string */
+template <typename T>
+inline const typename T::simple_element_type* string_element_address(const T& str, size_t index) {
+  return (const typename T::simple_element_type*)str.rowMajorAddressOfElement_(index);
+}
+
+/*! Strings with different element widths are compared one element at a time,
+    strings with the same element width use the vectorized kernels. */
+template <typename E1, typename E2>
+inline size_t string_mismatch(const E1* a, const E2* b, size_t n) {
+  for (size_t i = 0; i < n; ++i)
+    if (static_cast<claspCharacter>(a[i]) != static_cast<claspCharacter>(b[i])) return i;
+  return n;
+}
+inline size_t string_mismatch(const claspChar* a, const claspChar* b, size_t n) { return strkern::mismatch(a, b, n); }
+inline size_t string_mismatch(const claspCharacter* a, const claspCharacter* b, size_t n) { return strkern::mismatch(a, b, n); }
+
+template <typename E1, typename E2>
+inline size_t string_mismatch_ci(const E1* a, const E2* b, size_t n) {
+  for (size_t i = 0; i < n; ++i)
+    if (toupper(static_cast<claspCharacter>(a[i])) != toupper(static_cast<claspCharacter>(b[i]))) return i;
+  return n;
+}
+inline size_t string_mismatch_ci(const claspChar* a, const claspChar* b, size_t n) { return strkern::mismatch_ascii_ci(a, b, n); }
+inline size_t string_mismatch_ci(const claspCharacter* a, const claspCharacter* b, size_t n) { return strkern::mismatch_ascii_ci(a, b, n); }
+
+template <typename E1, typename E2>
+inline const E2* string_search_range(const E1* sub_start, const E1* sub_end, const E2* outer_start, const E2* outer_end) {
+  // The std::search convention is reversed -->  std::search(outer,sub,...)
+  return std::search(outer_start, outer_end, sub_start, sub_end);
+}
+template <typename E>
+inline const E* string_search_range(const E* sub_start, const E* sub_end, const E* outer_start, const E* outer_end) {
+  return outer_start + strkern::search(outer_start, outer_end - outer_start, sub_start, sub_end - sub_start);
+}
+
 template <typename T1, typename T2>
 bool template_string_equalp_bool(const T1& string1, const T2& string2, size_t start1, size_t end1, size_t start2, size_t end2) {
   StringCharPointer<T1> cp1(&string1,start1);
@@ -238,30 +275,12 @@ bool template_string_equalp_bool(const T1& string1, const T2& string2, size_t st
 template <typename T1,typename T2>
 T_sp template_string_EQ_(const T1& string1, const T2& string2, size_t start1, size_t end1, size_t start2, size_t end2)
 {
-  StringCharPointer<T1> cp1(&string1,start1);
-  StringCharPointer<T2> cp2(&string2,start2);
   size_t num1 = end1 - start1;
   size_t num2 = end2 - start2;
-  while (1) {
-    if (num1 == 0)
-      goto END_STRING1;
-    if (num2 == 0)
-      goto END_STRING2;
-    if ((static_cast<claspCharacter>(*cp1) != static_cast<claspCharacter>(*cp2)))
-      goto RETURN_FALSE;
-    --num1;
-    --num2;
-    ++cp1;
-    ++cp2;
-  }
- END_STRING1:
-  if (num2 == 0)
-    goto RETURN_TRUE;
-  goto RETURN_FALSE;
- END_STRING2:
- RETURN_FALSE:
-  return nil<T_O>();
- RETURN_TRUE:
+  if (num1 != num2) return nil<T_O>();
+  if (string_mismatch(string_element_address(string1,start1),
+                      string_element_address(string2,start2), num1) != num1)
+    return nil<T_O>();
   return _lisp->_true();
 }
 
@@ -269,31 +288,14 @@ T_sp template_string_EQ_(const T1& string1, const T2& string2, size_t start1, si
 template <typename T1, typename T2>
 T_sp template_string_NE_(const T1& string1, const T2& string2, size_t start1, size_t end1, size_t start2, size_t end2)
 {
-  StringCharPointer<T1> cp1(&string1,start1);
-  StringCharPointer<T2> cp2(&string2,start2);
   size_t num1 = end1 - start1;
   size_t num2 = end2 - start2;
-  while (1) {
-    if (num1 == 0)
-      goto END_STRING1;
-    if (num2 == 0)
-      goto END_STRING2;
-    if ((static_cast<claspCharacter>(*cp1) != static_cast<claspCharacter>(*cp2)))
-      goto RETURN_TRUE;
-    --num1;
-    --num2;
-    ++cp1;
-    ++cp2;
-  }
- END_STRING1:
-  if (num2 != 0)
-    goto RETURN_TRUE;
-  goto RETURN_FALSE;
- END_STRING2: // Did not hit end of string 1 at this point
- RETURN_TRUE: // strings are not equal
-  return make_fixnum((int)(cp1.offset() + start1));
- RETURN_FALSE:
-  return nil<T_O>();
+  size_t num = MIN(num1,num2);
+  size_t index = string_mismatch(string_element_address(string1,start1),
+                                 string_element_address(string2,start2), num);
+  // The strings are equal if they have the same length and no mismatch
+  if (index == num && num1 == num2) return nil<T_O>();
+  return make_fixnum((int)(index + start1));
 }
 
 /*! bounding index designator range from 0 to the end of each string */
@@ -431,61 +433,25 @@ T_sp template_string_GE_(const T1& string1, const T2& string2, size_t start1, si
 /*! bounding index designator range from 0 to the end of each string */
 template <typename T1, typename T2>
 T_sp template_string_equal(const T1& string1, const T2& string2, size_t start1, size_t end1, size_t start2, size_t end2) {
-  StringCharPointer<T1> cp1(&string1,start1);
-  StringCharPointer<T2> cp2(&string2,start2);
   size_t num1 = end1 - start1;
   size_t num2 = end2 - start2;
-  while (1) {
-    if (num1 == 0)
-      goto END_STRING1;
-    if (num2 == 0)
-      goto END_STRING2;
-    if ((toupper(static_cast<claspCharacter>(*cp1)) != toupper(static_cast<claspCharacter>(*cp2))))
-      goto RETURN_FALSE;
-    --num1;
-    --num2;
-    ++cp1;
-    ++cp2;
-  }
- END_STRING1:
-  if (num2 == 0)
-    goto RETURN_TRUE;
-  goto RETURN_FALSE;
- END_STRING2:
- RETURN_FALSE:
-  return nil<T_O>();
- RETURN_TRUE:
+  if (num1 != num2) return nil<T_O>();
+  if (string_mismatch_ci(string_element_address(string1,start1),
+                         string_element_address(string2,start2), num1) != num1)
+    return nil<T_O>();
   return _lisp->_true();
 }
 
 /*! bounding index designator range from 0 to the end of each string */
 template <typename T1, typename T2>
 T_sp template_string_not_equal(const T1& string1, const T2& string2, size_t start1, size_t end1, size_t start2, size_t end2) {
-  StringCharPointer<T1> cp1(&string1,start1);
-  StringCharPointer<T2> cp2(&string2,start2);
   size_t num1 = end1 - start1;
   size_t num2 = end2 - start2;
-  while (1) {
-    if (num1 == 0)
-      goto END_STRING1;
-    if (num2 == 0)
-      goto END_STRING2;
-    if ((toupper(static_cast<claspCharacter>(*cp1)) != toupper(static_cast<claspCharacter>(*cp2))))
-      goto RETURN_TRUE;
-    --num1;
-    --num2;
-    ++cp1;
-    ++cp2;
-  }
- END_STRING1:
-  if (num2 != 0)
-    goto RETURN_TRUE;
-  goto RETURN_FALSE;
- END_STRING2: // Did not hit end of string 1 at this point
- RETURN_TRUE: // strings are not equal
-  return make_fixnum((int)(cp1.offset() + start1)); //_lisp->_true();
- RETURN_FALSE:
-  return nil<T_O>();
+  size_t num = MIN(num1,num2);
+  size_t index = string_mismatch_ci(string_element_address(string1,start1),
+                                    string_element_address(string2,start2), num);
+  if (index == num && num1 == num2) return nil<T_O>();
+  return make_fixnum((int)(index + start1));
 }
 
 /*! bounding index designator range from 0 to the end of each string */
@@ -655,6 +621,11 @@ inline void setup_string_op_arguments(T_sp string1_desig, T_sp string2_desig,
     SIMPLE_ERROR(("start2 %d out of bounds for string %s") , istart2 , core::_rep_(string2));
   }
   iend2 = MIN(end2.nilp() ? cl__length(string2) : unbox_fixnum(gc::As<Fixnum_sp>(end2)), cl__length(string2));
+  // The comparisons work on raw [start,end) ranges so these must be ordered
+  if (istart1 > iend1)
+    SIMPLE_ERROR(("start1 %d is greater than end1 %d for string %s") , istart1 , iend1 , _rep_(string1));
+  if (istart2 > iend2)
+    SIMPLE_ERROR(("start2 %d is greater than end2 %d for string %s") , istart2 , iend2 , _rep_(string2));
 }
 
 #define TEMPLATE_SINGLE_STRING_DISPATCHER(_string_,_function_,istart,iend) \
@@ -1476,13 +1447,12 @@ CL_DEFUN T_sp core__base_string_concatenate(Vaslist_sp vargs) {
 template <typename T1,typename T2>
 T_sp template_search_string(const T1& sub, const T2& outer, size_t sub_start, size_t sub_end, size_t outer_start, size_t outer_end)
 {
-  // The std::search convention is reversed -->  std::search(outer,sub,...)
   const typename T2::simple_element_type* startp = (const typename T2::simple_element_type*)outer.rowMajorAddressOfElement_(0); // &outer[0];
   const typename T2::simple_element_type* cps = (const typename T2::simple_element_type*)outer.rowMajorAddressOfElement_(outer_start); //&outer[outer_start];
   const typename T2::simple_element_type* cpe = (const typename T2::simple_element_type*)outer.rowMajorAddressOfElement_(outer_end);
   const typename T1::simple_element_type* s_cps = (const typename T1::simple_element_type*)sub.rowMajorAddressOfElement_(sub_start); //&sub[sub_start];
   const typename T1::simple_element_type* s_cpe = (const typename T1::simple_element_type*)sub.rowMajorAddressOfElement_(sub_end);
-  const typename T2::simple_element_type* pos = std::search(cps,cpe,s_cps,s_cpe);
+  const typename T2::simple_element_type* pos = string_search_range(s_cps,s_cpe,cps,cpe);
   if (pos == cpe ) return nil<T_O>();
   // this should return the absolute position starting from 0, not relative to outer_start
   //now that I understood this in pointer arithmethic, compare to the beginning of the string, e.g. index 0
@@ -1498,6 +1468,82 @@ CL_DEFUN T_sp core__search_string(String_sp sub, size_t sub_start, size_t sub_en
 };
 
 
+template <typename T>
+T_sp template_position_char(const T& str, claspCharacter c, size_t start, size_t end, bool from_end) {
+  typedef typename T::simple_element_type CharacterType;
+  // A character that does not fit in the element type can't be in the string
+  if (static_cast<claspCharacter>(static_cast<CharacterType>(c)) != c) return nil<T_O>();
+  const CharacterType* cps = string_element_address(str,start);
+  size_t num = end - start;
+  size_t index = from_end ? strkern::rfind_char(cps,num,static_cast<CharacterType>(c))
+                          : strkern::find_char(cps,num,static_cast<CharacterType>(c));
+  if (index == num) return nil<T_O>();
+  return clasp_make_fixnum(start+index);
+}
+
+SYMBOL_EXPORT_SC_(CorePkg,position_char);
+CL_LAMBDA(c str start end from_end)
+CL_DOCSTRING(R"dx(Return the index of the first (or last if from_end) occurance of the character c in str between start and end.)dx")
+DOCGROUP(clasp)
+CL_DEFUN T_sp core__position_char(Character_sp c, String_sp str, size_t start, size_t end, T_sp from_end) {
+  AbstractSimpleVector_sp sv;
+  size_t svstart, svend;
+  str->asAbstractSimpleVectorRange(sv,svstart,svend);
+  T_sp pos;
+  if (SimpleBaseString_sp sbs = sv.asOrNull<SimpleBaseString_O>()) {
+    pos = template_position_char(*sbs,c.unsafe_character(),svstart+start,svstart+end,from_end.notnilp());
+  } else {
+    SimpleCharacterString_sp scs = gc::As<SimpleCharacterString_sp>(sv);
+    pos = template_position_char(*scs,c.unsafe_character(),svstart+start,svstart+end,from_end.notnilp());
+  }
+  if (pos.nilp()) return pos;
+  return clasp_make_fixnum(pos.unsafe_fixnum()-svstart);
+}
+
+static claspCharacter base_char_upcase(claspCharacter c) {
+  claspCharacter u = claspCharacter_upcase(c);
+  return clasp_base_char_p(u) ? u : c;
+}
+static claspCharacter base_char_downcase(claspCharacter c) {
+  claspCharacter u = claspCharacter_downcase(c);
+  return clasp_base_char_p(u) ? u : c;
+}
+
+/*! Convert the case of the characters of str between start and end in place */
+static void string_convert_case(String_sp str, size_t start, size_t end, bool upcase) {
+  AbstractSimpleVector_sp sv;
+  size_t svstart, svend;
+  str->asAbstractSimpleVectorRange(sv,svstart,svend);
+  if (SimpleBaseString_sp sbs = sv.asOrNull<SimpleBaseString_O>()) {
+    claspChar* cps = &(*sbs)[svstart+start];
+    if (upcase) strkern::upcase(cps,cps,end-start,base_char_upcase);
+    else strkern::downcase(cps,cps,end-start,base_char_downcase);
+  } else {
+    SimpleCharacterString_sp scs = gc::As<SimpleCharacterString_sp>(sv);
+    claspCharacter* cps = &(*scs)[svstart+start];
+    if (upcase) strkern::upcase(cps,cps,end-start,claspCharacter_upcase);
+    else strkern::downcase(cps,cps,end-start,claspCharacter_downcase);
+  }
+}
+
+SYMBOL_EXPORT_SC_(CorePkg,nstring_upcase_range);
+CL_LAMBDA(str start end)
+CL_DOCSTRING(R"dx(Destructively upcase the characters of str between start and end. Bounds are not checked.)dx")
+DOCGROUP(clasp)
+CL_DEFUN String_sp core__nstring_upcase_range(String_sp str, size_t start, size_t end) {
+  if (start < end) string_convert_case(str,start,end,true);
+  return str;
+}
+
+SYMBOL_EXPORT_SC_(CorePkg,nstring_downcase_range);
+CL_LAMBDA(str start end)
+CL_DOCSTRING(R"dx(Destructively downcase the characters of str between start and end. Bounds are not checked.)dx")
+DOCGROUP(clasp)
+CL_DEFUN String_sp core__nstring_downcase_range(String_sp str, size_t start, size_t end) {
+  if (start < end) string_convert_case(str,start,end,false);
+  return str;
+}
+
 CL_LISPIFY_NAME("core:split");
 DOCGROUP(clasp)
 CL_DEFUN List_sp core__split(const string& all, const string &chars) {
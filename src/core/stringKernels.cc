@@ -0,0 +1,389 @@
+/*
+    File: stringKernels.cc
+*/
+
+/*
+Copyright (c) 2014, Christian E. Schafmeister
+
+CLASP is free software; you can redistribute it and/or
+modify it under the terms of the GNU Library General Public
+License as published by the Free Software Foundation; either
+version 2 of the License, or (at your option) any later version.
+
+See directory 'clasp/licenses' for full details.
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+/* -^- */
+
+//
+// The kernels are written once as templates over a "block" class that
+// provides the vector operations for one instruction set and element width.
+// The block operations take pointers and return per-element bit masks
+// (bit j set means element j matched) so that no vector types cross
+// function boundaries.  This lets the AVX2 blocks be compiled with
+// __attribute__((target("avx2"))) and still be inlined once the templates
+// are instantiated inside of an AVX2 entry point.
+//
+#include <cstring>
+#include <clasp/core/stringKernels.h>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#define STRKERN_X86 1
+#endif
+
+namespace core {
+namespace strkern {
+
+template <typename T>
+inline bool ascii_upper_p(T c) { return (uint32_t)(c - 'A') < 26; }
+template <typename T>
+inline T ascii_fold(T c) { return ascii_upper_p(c) ? (c | 0x20) : c; }
+
+//
+// Scalar fallbacks.  These are used for the tails of the vector loops and
+// on processors without a vector implementation.
+//
+template <typename T>
+inline size_t scalar_find_char(const T* s, size_t n, T c) {
+  for (size_t i = 0; i < n; ++i)
+    if (s[i] == c) return i;
+  return n;
+}
+
+template <typename T>
+inline size_t scalar_rfind_char(const T* s, size_t n, T c) {
+  for (size_t i = n; i > 0; --i)
+    if (s[i - 1] == c) return i - 1;
+  return n;
+}
+
+template <typename T>
+inline size_t scalar_mismatch(const T* a, const T* b, size_t n) {
+  for (size_t i = 0; i < n; ++i)
+    if (a[i] != b[i]) return i;
+  return n;
+}
+
+template <typename T>
+inline size_t scalar_mismatch_ci(const T* a, const T* b, size_t n) {
+  for (size_t i = 0; i < n; ++i)
+    if (ascii_fold(a[i]) != ascii_fold(b[i])) return i;
+  return n;
+}
+
+/*! Check the candidate positions [start,end) of hay for needle */
+template <typename T>
+inline size_t scalar_search(const T* hay, size_t n, const T* needle, size_t m, size_t start) {
+  for (size_t i = start; i + m <= n; ++i) {
+    if (hay[i] == needle[0] && scalar_mismatch(hay + i + 1, needle + 1, m - 1) == m - 1)
+      return i;
+  }
+  return n;
+}
+
+template <typename T>
+inline void scalar_convert(const T* src, T* dst, size_t n, case_fn fallback) {
+  for (size_t i = 0; i < n; ++i)
+    dst[i] = (T)fallback(src[i]);
+}
+
+#ifdef STRKERN_X86
+//
+// Vector blocks
+//
+struct Sse2_u8 {
+  typedef uint8_t T;
+  static constexpr size_t W = 16;
+  static constexpr uint32_t Full = 0xFFFF;
+  static inline __m128i load(const T* p) { return _mm_loadu_si128((const __m128i*)p); }
+  static inline __m128i splat(T c) { return _mm_set1_epi8((char)c); }
+  static inline uint32_t bits(__m128i v) { return (uint32_t)_mm_movemask_epi8(v); }
+  static inline __m128i in26(__m128i v, T lo) {
+    __m128i t = _mm_add_epi8(v, _mm_set1_epi8((char)(0x80 - lo)));
+    return _mm_cmplt_epi8(t, _mm_set1_epi8((char)(0x80 + 26)));
+  }
+  static inline __m128i fold(__m128i v) { return _mm_or_si128(v, _mm_and_si128(in26(v, 'A'), _mm_set1_epi8(0x20))); }
+  static inline bool ascii(__m128i v) { return _mm_movemask_epi8(v) == 0; }
+  static inline uint32_t match(const T* p, T c) { return bits(_mm_cmpeq_epi8(load(p), splat(c))); }
+  static inline uint32_t match2(const T* p, T c1, const T* q, T c2) {
+    return bits(_mm_and_si128(_mm_cmpeq_epi8(load(p), splat(c1)), _mm_cmpeq_epi8(load(q), splat(c2))));
+  }
+  static inline uint32_t eq(const T* a, const T* b) { return bits(_mm_cmpeq_epi8(load(a), load(b))); }
+  static inline uint32_t eq_ci(const T* a, const T* b) { return bits(_mm_cmpeq_epi8(fold(load(a)), fold(load(b)))); }
+  static inline bool convert(const T* src, T* dst, T lo) {
+    __m128i v = load(src);
+    if (!ascii(v)) return false;
+    _mm_storeu_si128((__m128i*)dst, _mm_xor_si128(v, _mm_and_si128(in26(v, lo), _mm_set1_epi8(0x20))));
+    return true;
+  }
+};
+
+struct Sse2_u32 {
+  typedef uint32_t T;
+  static constexpr size_t W = 4;
+  static constexpr uint32_t Full = 0xF;
+  static inline __m128i load(const T* p) { return _mm_loadu_si128((const __m128i*)p); }
+  static inline __m128i splat(T c) { return _mm_set1_epi32((int)c); }
+  static inline uint32_t bits(__m128i v) { return (uint32_t)_mm_movemask_ps(_mm_castsi128_ps(v)); }
+  static inline __m128i in26(__m128i v, T lo) {
+    __m128i t = _mm_add_epi32(v, _mm_set1_epi32((int)(0x80000000u - lo)));
+    return _mm_cmplt_epi32(t, _mm_set1_epi32((int)(0x80000000u + 26)));
+  }
+  static inline __m128i fold(__m128i v) { return _mm_or_si128(v, _mm_and_si128(in26(v, 'A'), _mm_set1_epi32(0x20))); }
+  static inline bool ascii(__m128i v) {
+    return _mm_movemask_epi8(_mm_cmpeq_epi32(_mm_srli_epi32(v, 7), _mm_setzero_si128())) == 0xFFFF;
+  }
+  static inline uint32_t match(const T* p, T c) { return bits(_mm_cmpeq_epi32(load(p), splat(c))); }
+  static inline uint32_t match2(const T* p, T c1, const T* q, T c2) {
+    return bits(_mm_and_si128(_mm_cmpeq_epi32(load(p), splat(c1)), _mm_cmpeq_epi32(load(q), splat(c2))));
+  }
+  static inline uint32_t eq(const T* a, const T* b) { return bits(_mm_cmpeq_epi32(load(a), load(b))); }
+  static inline uint32_t eq_ci(const T* a, const T* b) { return bits(_mm_cmpeq_epi32(fold(load(a)), fold(load(b)))); }
+  static inline bool convert(const T* src, T* dst, T lo) {
+    __m128i v = load(src);
+    if (!ascii(v)) return false;
+    _mm_storeu_si128((__m128i*)dst, _mm_xor_si128(v, _mm_and_si128(in26(v, lo), _mm_set1_epi32(0x20))));
+    return true;
+  }
+};
+
+#define STRKERN_AVX2 __attribute__((target("avx2")))
+
+struct Avx2_u8 {
+  typedef uint8_t T;
+  static constexpr size_t W = 32;
+  static constexpr uint32_t Full = 0xFFFFFFFF;
+  STRKERN_AVX2 static inline __m256i load(const T* p) { return _mm256_loadu_si256((const __m256i*)p); }
+  STRKERN_AVX2 static inline __m256i splat(T c) { return _mm256_set1_epi8((char)c); }
+  STRKERN_AVX2 static inline uint32_t bits(__m256i v) { return (uint32_t)_mm256_movemask_epi8(v); }
+  STRKERN_AVX2 static inline __m256i in26(__m256i v, T lo) {
+    __m256i t = _mm256_add_epi8(v, _mm256_set1_epi8((char)(0x80 - lo)));
+    return _mm256_cmpgt_epi8(_mm256_set1_epi8((char)(0x80 + 26)), t);
+  }
+  STRKERN_AVX2 static inline __m256i fold(__m256i v) {
+    return _mm256_or_si256(v, _mm256_and_si256(in26(v, 'A'), _mm256_set1_epi8(0x20)));
+  }
+  STRKERN_AVX2 static inline bool ascii(__m256i v) { return _mm256_movemask_epi8(v) == 0; }
+  STRKERN_AVX2 static inline uint32_t match(const T* p, T c) { return bits(_mm256_cmpeq_epi8(load(p), splat(c))); }
+  STRKERN_AVX2 static inline uint32_t match2(const T* p, T c1, const T* q, T c2) {
+    return bits(_mm256_and_si256(_mm256_cmpeq_epi8(load(p), splat(c1)), _mm256_cmpeq_epi8(load(q), splat(c2))));
+  }
+  STRKERN_AVX2 static inline uint32_t eq(const T* a, const T* b) { return bits(_mm256_cmpeq_epi8(load(a), load(b))); }
+  STRKERN_AVX2 static inline uint32_t eq_ci(const T* a, const T* b) {
+    return bits(_mm256_cmpeq_epi8(fold(load(a)), fold(load(b))));
+  }
+  STRKERN_AVX2 static inline bool convert(const T* src, T* dst, T lo) {
+    __m256i v = load(src);
+    if (!ascii(v)) return false;
+    _mm256_storeu_si256((__m256i*)dst, _mm256_xor_si256(v, _mm256_and_si256(in26(v, lo), _mm256_set1_epi8(0x20))));
+    return true;
+  }
+};
+
+struct Avx2_u32 {
+  typedef uint32_t T;
+  static constexpr size_t W = 8;
+  static constexpr uint32_t Full = 0xFF;
+  STRKERN_AVX2 static inline __m256i load(const T* p) { return _mm256_loadu_si256((const __m256i*)p); }
+  STRKERN_AVX2 static inline __m256i splat(T c) { return _mm256_set1_epi32((int)c); }
+  STRKERN_AVX2 static inline uint32_t bits(__m256i v) { return (uint32_t)_mm256_movemask_ps(_mm256_castsi256_ps(v)); }
+  STRKERN_AVX2 static inline __m256i in26(__m256i v, T lo) {
+    __m256i t = _mm256_add_epi32(v, _mm256_set1_epi32((int)(0x80000000u - lo)));
+    return _mm256_cmpgt_epi32(_mm256_set1_epi32((int)(0x80000000u + 26)), t);
+  }
+  STRKERN_AVX2 static inline __m256i fold(__m256i v) {
+    return _mm256_or_si256(v, _mm256_and_si256(in26(v, 'A'), _mm256_set1_epi32(0x20)));
+  }
+  STRKERN_AVX2 static inline bool ascii(__m256i v) {
+    return _mm256_testz_si256(v, _mm256_set1_epi32(~0x7F));
+  }
+  STRKERN_AVX2 static inline uint32_t match(const T* p, T c) { return bits(_mm256_cmpeq_epi32(load(p), splat(c))); }
+  STRKERN_AVX2 static inline uint32_t match2(const T* p, T c1, const T* q, T c2) {
+    return bits(_mm256_and_si256(_mm256_cmpeq_epi32(load(p), splat(c1)), _mm256_cmpeq_epi32(load(q), splat(c2))));
+  }
+  STRKERN_AVX2 static inline uint32_t eq(const T* a, const T* b) { return bits(_mm256_cmpeq_epi32(load(a), load(b))); }
+  STRKERN_AVX2 static inline uint32_t eq_ci(const T* a, const T* b) {
+    return bits(_mm256_cmpeq_epi32(fold(load(a)), fold(load(b))));
+  }
+  STRKERN_AVX2 static inline bool convert(const T* src, T* dst, T lo) {
+    __m256i v = load(src);
+    if (!ascii(v)) return false;
+    _mm256_storeu_si256((__m256i*)dst, _mm256_xor_si256(v, _mm256_and_si256(in26(v, lo), _mm256_set1_epi32(0x20))));
+    return true;
+  }
+};
+
+//
+// Kernels parameterized on the block class
+//
+template <typename B>
+inline size_t vec_find_char(const typename B::T* s, size_t n, typename B::T c) {
+  size_t i = 0;
+  for (; i + B::W <= n; i += B::W) {
+    uint32_t m = B::match(s + i, c);
+    if (m) return i + __builtin_ctz(m);
+  }
+  size_t r = scalar_find_char(s + i, n - i, c);
+  return (r == n - i) ? n : i + r;
+}
+
+template <typename B>
+inline size_t vec_rfind_char(const typename B::T* s, size_t n, typename B::T c) {
+  size_t i = n;
+  for (; i >= B::W; i -= B::W) {
+    uint32_t m = B::match(s + i - B::W, c);
+    if (m) return i - B::W + (31 - __builtin_clz(m));
+  }
+  size_t r = scalar_rfind_char(s, i, c);
+  return (r == i) ? n : r;
+}
+
+template <typename B>
+inline size_t vec_mismatch(const typename B::T* a, const typename B::T* b, size_t n) {
+  size_t i = 0;
+  for (; i + B::W <= n; i += B::W) {
+    uint32_t m = B::eq(a + i, b + i);
+    if (m != B::Full) return i + __builtin_ctz(~m);
+  }
+  return i + scalar_mismatch(a + i, b + i, n - i);
+}
+
+template <typename B>
+inline size_t vec_mismatch_ascii_ci(const typename B::T* a, const typename B::T* b, size_t n) {
+  size_t i = 0;
+  for (; i + B::W <= n; i += B::W) {
+    uint32_t m = B::eq_ci(a + i, b + i);
+    if (m != B::Full) return i + __builtin_ctz(~m);
+  }
+  return i + scalar_mismatch_ci(a + i, b + i, n - i);
+}
+
+/*! Substring search filtering candidate positions on the first and
+    last element of the needle a whole vector at a time, then verifying
+    the survivors. */
+template <typename B>
+inline size_t vec_search(const typename B::T* hay, size_t n, const typename B::T* needle, size_t m) {
+  if (m == 0) return 0;
+  if (m > n) return n;
+  if (m == 1) return vec_find_char<B>(hay, n, needle[0]);
+  typename B::T first = needle[0];
+  typename B::T last = needle[m - 1];
+  size_t i = 0;
+  for (; i + m - 1 + B::W <= n; i += B::W) {
+    uint32_t mask = B::match2(hay + i, first, hay + i + m - 1, last);
+    while (mask) {
+      size_t j = i + __builtin_ctz(mask);
+      if (vec_mismatch<B>(hay + j + 1, needle + 1, m - 2) == m - 2) return j;
+      mask &= mask - 1;
+    }
+  }
+  return scalar_search(hay, n, needle, m, i);
+}
+
+template <typename B>
+inline void vec_convert(const typename B::T* src, typename B::T* dst, size_t n, typename B::T lo, case_fn fallback) {
+  size_t i = 0;
+  for (; i + B::W <= n; i += B::W) {
+    if (!B::convert(src + i, dst + i, lo)) scalar_convert(src + i, dst + i, B::W, fallback);
+  }
+  scalar_convert(src + i, dst + i, n - i, fallback);
+}
+
+//
+// Runtime selection between the SSE2 and AVX2 instantiations
+//
+static bool detect_avx2() {
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx2");
+}
+static const bool global_have_avx2 = detect_avx2();
+
+#define STRKERN_DISPATCH(_name_, _T_, _params_, _args_) \
+  STRKERN_AVX2 static size_t _name_##_avx2 _params_ { return vec_##_name_<Avx2_##_T_> _args_; } \
+  size_t _name_ _params_ { \
+    if (global_have_avx2) return _name_##_avx2 _args_; \
+    return vec_##_name_<Sse2_##_T_> _args_; \
+  }
+
+STRKERN_DISPATCH(find_char, u8, (const uint8_t* s, size_t n, uint8_t c), (s, n, c))
+STRKERN_DISPATCH(find_char, u32, (const uint32_t* s, size_t n, uint32_t c), (s, n, c))
+STRKERN_DISPATCH(rfind_char, u8, (const uint8_t* s, size_t n, uint8_t c), (s, n, c))
+STRKERN_DISPATCH(rfind_char, u32, (const uint32_t* s, size_t n, uint32_t c), (s, n, c))
+STRKERN_DISPATCH(search, u8, (const uint8_t* hay, size_t n, const uint8_t* needle, size_t m), (hay, n, needle, m))
+STRKERN_DISPATCH(search, u32, (const uint32_t* hay, size_t n, const uint32_t* needle, size_t m), (hay, n, needle, m))
+STRKERN_DISPATCH(mismatch, u8, (const uint8_t* a, const uint8_t* b, size_t n), (a, b, n))
+STRKERN_DISPATCH(mismatch, u32, (const uint32_t* a, const uint32_t* b, size_t n), (a, b, n))
+STRKERN_DISPATCH(mismatch_ascii_ci, u8, (const uint8_t* a, const uint8_t* b, size_t n), (a, b, n))
+STRKERN_DISPATCH(mismatch_ascii_ci, u32, (const uint32_t* a, const uint32_t* b, size_t n), (a, b, n))
+
+#define STRKERN_CONVERT(_name_, _T_, _ET_, _lo_) \
+  STRKERN_AVX2 static void _name_##_avx2(const _ET_* src, _ET_* dst, size_t n, case_fn fallback) { \
+    vec_convert<Avx2_##_T_>(src, dst, n, _lo_, fallback); \
+  } \
+  void _name_(const _ET_* src, _ET_* dst, size_t n, case_fn fallback) { \
+    if (global_have_avx2) _name_##_avx2(src, dst, n, fallback); \
+    else vec_convert<Sse2_##_T_>(src, dst, n, _lo_, fallback); \
+  }
+
+STRKERN_CONVERT(upcase, u8, uint8_t, 'a')
+STRKERN_CONVERT(upcase, u32, uint32_t, 'a')
+STRKERN_CONVERT(downcase, u8, uint8_t, 'A')
+STRKERN_CONVERT(downcase, u32, uint32_t, 'A')
+
+#else // STRKERN_X86
+
+//
+// Portable versions
+//
+size_t find_char(const uint8_t* s, size_t n, uint8_t c) {
+  const void* p = memchr(s, c, n);
+  return p ? (const uint8_t*)p - s : n;
+}
+size_t find_char(const uint32_t* s, size_t n, uint32_t c) { return scalar_find_char(s, n, c); }
+size_t rfind_char(const uint8_t* s, size_t n, uint8_t c) { return scalar_rfind_char(s, n, c); }
+size_t rfind_char(const uint32_t* s, size_t n, uint32_t c) { return scalar_rfind_char(s, n, c); }
+
+size_t search(const uint8_t* hay, size_t n, const uint8_t* needle, size_t m) {
+  if (m == 0) return 0;
+  if (m > n) return n;
+  size_t i = 0;
+  while (i + m <= n) {
+    size_t r = find_char(hay + i, n - m + 1 - i, needle[0]);
+    if (r == n - m + 1 - i) return n;
+    i += r;
+    if (memcmp(hay + i + 1, needle + 1, m - 1) == 0) return i;
+    ++i;
+  }
+  return n;
+}
+size_t search(const uint32_t* hay, size_t n, const uint32_t* needle, size_t m) {
+  if (m == 0) return 0;
+  if (m > n) return n;
+  return scalar_search(hay, n, needle, m, 0);
+}
+
+size_t mismatch(const uint8_t* a, const uint8_t* b, size_t n) { return scalar_mismatch(a, b, n); }
+size_t mismatch(const uint32_t* a, const uint32_t* b, size_t n) { return scalar_mismatch(a, b, n); }
+size_t mismatch_ascii_ci(const uint8_t* a, const uint8_t* b, size_t n) { return scalar_mismatch_ci(a, b, n); }
+size_t mismatch_ascii_ci(const uint32_t* a, const uint32_t* b, size_t n) { return scalar_mismatch_ci(a, b, n); }
+
+void upcase(const uint8_t* src, uint8_t* dst, size_t n, case_fn fallback) { scalar_convert(src, dst, n, fallback); }
+void upcase(const uint32_t* src, uint32_t* dst, size_t n, case_fn fallback) { scalar_convert(src, dst, n, fallback); }
+void downcase(const uint8_t* src, uint8_t* dst, size_t n, case_fn fallback) { scalar_convert(src, dst, n, fallback); }
+void downcase(const uint32_t* src, uint32_t* dst, size_t n, case_fn fallback) { scalar_convert(src, dst, n, fallback); }
+
+#endif // STRKERN_X86
+
+}; // namespace strkern
+}; // namespace core
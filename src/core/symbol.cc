@@ -317,12 +317,14 @@ Symbol_O::Symbol_O(const only_at_startup& dummy) : _HomePackage(nil<T_O>()),
                                                    _SetfFunction(unbound<Function_O>()),
                                                    _BindingIdx(NO_THREAD_LOCAL_BINDINGS),
                                                    _Flags(0),
-                                                   _PropertyList(nil<List_V>()) {};
+                                                   _PropertyList(nil<List_V>()),
+                                                   _Sysprops(nil<List_V>()) {};
 
 Symbol_O::Symbol_O() : Base(),
                        _BindingIdx(NO_THREAD_LOCAL_BINDINGS),
                        _Flags(0),
-                       _PropertyList(nil<List_V>()) {};
+                       _PropertyList(nil<List_V>()),
+                       _Sysprops(nil<List_V>()) {};
 
 
 void Symbol_O::finish_setup(Package_sp pkg, bool exportp, bool shadowp) {
@@ -506,8 +508,18 @@ ClassHolder_sp Symbol_O::find_class_holder() {
 }
 #endif
 
+// Give special variables their thread local binding index when they are
+// proclaimed, rather than on first binding, so that the index is already
+// known by the time code that reads or binds them is loaded and run.
+static void ensure_special_binding_index(const Symbol_O* sym) {
+#ifdef CLASP_THREADS
+  if (my_thread) my_thread->_Bindings.ensure_binding_index(sym);
+#endif
+}
+
 void Symbol_O::makeSpecial() {
   this->setf_specialP(true);
+  ensure_special_binding_index(this);
 }
 
 CL_LISPIFY_NAME("core:STARmakeSpecial");
@@ -529,6 +541,7 @@ T_sp Symbol_O::defparameter(T_sp val) {
   _OF();
   T_sp result = this->setf_symbolValue(val);
   this->setf_specialP(true);
+  ensure_special_binding_index(this);
   return result;
 }
 
@@ -766,6 +779,7 @@ SYMBOL_EXPORT_SC_(KeywordPkg,setf_function);
 SYMBOL_EXPORT_SC_(KeywordPkg,binding_idx);
 SYMBOL_EXPORT_SC_(KeywordPkg,flags);
 SYMBOL_EXPORT_SC_(KeywordPkg,property_list);
+SYMBOL_EXPORT_SC_(KeywordPkg,sysprops);
 
 DOCGROUP(clasp)
 CL_DEFUN void core__verify_symbol_layout(T_sp alist)
@@ -778,6 +792,7 @@ CL_DEFUN void core__verify_symbol_layout(T_sp alist)
   expect_offset(kw::_sym_binding_idx,alist,offsetof(Symbol_O,_BindingIdx)-gctools::general_tag);
   expect_offset(kw::_sym_flags,alist,offsetof(Symbol_O,_Flags)-gctools::general_tag);
   expect_offset(kw::_sym_property_list,alist,offsetof(Symbol_O,_PropertyList)-gctools::general_tag);
+  expect_offset(kw::_sym_sysprops,alist,offsetof(Symbol_O,_Sysprops)-gctools::general_tag);
 }
 
 };
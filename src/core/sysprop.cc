@@ -31,16 +31,56 @@ THE SOFTWARE.
 #include <clasp/core/symbol.h>
 #include <clasp/core/mpPackage.h>
 #include <clasp/core/sysprop.h>
+#include <clasp/core/ql.h>
 #include <clasp/core/wrappers.h>
 
 namespace core {
 
+/* Sysprops of a symbol under a symbol area - nearly all of them - are kept
+   in the symbol's _Sysprops slot as a plist (area value ...).  The plist is
+   never modified, a writer builds a new one and installs it with a CAS, so
+   a reader loads the slot once and walks it without a lock.  Other keys,
+   such as (SETF FOO) function names, go to the _Sysprop table of tables. */
+
+static inline bool symbol_sysprop_p(T_sp key, T_sp area) {
+  return key.notnilp() && gc::IsA<Symbol_sp>(key) && area.notnilp() && gc::IsA<Symbol_sp>(area);
+}
+
+// A copy of plist without the entry for area, sharing the tail after it.
+static T_sp symbol_sysprops_without(T_sp plist, T_sp area) {
+  ql::list rest;
+  for (T_sp cur = plist; cur.consp(); cur = CONS_CDR(CONS_CDR(cur))) {
+    if (CONS_CAR(cur) == area) {
+      rest.dot(CONS_CDR(CONS_CDR(cur)));
+      return rest.cons();
+    }
+    rest << CONS_CAR(cur) << CONS_CAR(CONS_CDR(cur));
+  }
+  return plist;
+}
+
+// The cons whose car is the value for area in plist, or NIL.
+static T_sp symbol_sysprop_cell(T_sp plist, T_sp area) {
+  for (T_sp cur = plist; cur.consp(); cur = CONS_CDR(CONS_CDR(cur))) {
+    if (CONS_CAR(cur) == area) return CONS_CDR(cur);
+  }
+  return nil<T_O>();
+}
 
 CL_LAMBDA(key area value)
 CL_DECLARE();
 CL_DOCSTRING(R"dx(put_sysprop - returns value)dx")
 DOCGROUP(clasp)
 CL_DEFUN T_sp core__put_sysprop(T_sp key, T_sp area, T_sp value) {
+  if (symbol_sysprop_p(key, area)) {
+    Symbol_sp sym = gc::As_unsafe<Symbol_sp>(key);
+    T_sp plist = sym->_Sysprops.load(std::memory_order_acquire);
+    while (true) {
+      T_sp updated = Cons_O::create(area, Cons_O::create(value, symbol_sysprops_without(plist, area)));
+      if (sym->_Sysprops.compare_exchange_weak(plist, updated, std::memory_order_release, std::memory_order_acquire))
+        return value;
+    }
+  }
   ASSERT(_lisp->_Roots._Sysprop.notnilp());
   HashTableEql_sp sysprops = gc::As_unsafe<HashTableEql_sp>(_lisp->_Roots._Sysprop);
   bool foundHashTable = false;
@@ -63,6 +103,11 @@ CL_DECLARE();
 CL_DOCSTRING(R"dx(get_sysprop - returns (values val foundp))dx")
 DOCGROUP(clasp)
 CL_DEFUN T_mv core__get_sysprop(T_sp key, T_sp area) {
+  if (symbol_sysprop_p(key, area)) {
+    T_sp cell = symbol_sysprop_cell(gc::As_unsafe<Symbol_sp>(key)->_Sysprops.load(std::memory_order_acquire), area);
+    if (cell.consp()) return Values(CONS_CAR(cell), _lisp->_true());
+    return Values(nil<T_O>(), nil<T_O>());
+  }
   ASSERT(_lisp->_Roots._Sysprop.notnilp());
   HashTableEql_sp sysprops = gc::As_unsafe<HashTableEql_sp>(_lisp->_Roots._Sysprop);
   if (sysprops.notnilp()) {
@@ -81,6 +126,16 @@ CL_DECLARE();
 CL_DOCSTRING(R"dx(rem_sysprop)dx")
 DOCGROUP(clasp)
 CL_DEFUN T_sp core__rem_sysprop(T_sp key, T_sp area) {
+  if (symbol_sysprop_p(key, area)) {
+    Symbol_sp sym = gc::As_unsafe<Symbol_sp>(key);
+    T_sp plist = sym->_Sysprops.load(std::memory_order_acquire);
+    while (symbol_sysprop_cell(plist, area).consp()) {
+      T_sp updated = symbol_sysprops_without(plist, area);
+      if (sym->_Sysprops.compare_exchange_weak(plist, updated, std::memory_order_release, std::memory_order_acquire))
+        return _lisp->_true();
+    }
+    return nil<T_O>();
+  }
   ASSERT(_lisp->_Roots._Sysprop.notnilp());
   HashTableEql_sp sysprops = gc::As_unsafe<HashTableEql_sp>(_lisp->_Roots._Sysprop);
   T_mv mv_values = sysprops->gethash(area, nil<T_O>());
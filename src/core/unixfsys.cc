@@ -48,6 +48,8 @@ THE SOFTWARE.
 #include <unistd.h>
 #include <pthread.h> // TODO: PORTING - frgo, 2017-08-04
 #include <signal.h>  // TODO: PORTING - frgo, 2017-08-04
+#include <set>
+#include <vector>
 
 #ifndef _MSC_VER
 #include <unistd.h>
@@ -804,6 +806,7 @@ enter_directory(Pathname_sp base_dir, T_sp subdir, bool ignore_if_failure) {
                    _rep_(output));
     }
     output->_Directory = newdir;
+    output->invalidateNamestring();
   }
   return output;
 }
@@ -1229,71 +1232,229 @@ CL_DEFUN Pathname_sp cl__user_homedir_pathname(T_sp host) {
 }
 
 static bool
-string_match(const char *s, T_sp pattern) {
+string_match(const char *s, size_t ls, T_sp pattern) {
   if (pattern.nilp() || pattern == kw::_sym_wild) {
     return 1;
   } else {
-    int ls = strlen(s);
-    String_sp strng = Str8Ns_O::create(s, strlen(s));
-    return clasp_stringMatch(strng, 0, ls,
-                             pattern, 0, cl__length(pattern));
+    String_sp spattern = gc::As<String_sp>(pattern);
+    return clasp_stringMatchRaw(s, 0, ls, spattern, 0, spattern->length());
   }
 }
 
+enum RawMatch { raw_no_match, raw_match, raw_unknown };
+
+static RawMatch
+raw_item_match(const char *s, size_t ls, bool present, T_sp mask) {
+  if (mask == kw::_sym_wild)
+    return raw_match;
+  if (mask.nilp())
+    return present ? raw_no_match : raw_match;
+  if (!cl__stringp(mask))
+    return raw_unknown;
+  if (!present)
+    return raw_no_match;
+  String_sp smask = gc::As_unsafe<String_sp>(mask);
+  return clasp_stringMatchRaw(s, 0, ls, smask, 0, smask->length()) ? raw_match : raw_no_match;
+}
+
 /*
- * list_current_directory() lists the files and directories which are contained
- * in the current working directory (as given by current_dir()). If ONLY_DIR is
- * true, the list is made of only the directories -- a propert which is checked
- * by following the symlinks.
+ * raw_pathname_match() decides whether the file name TEXT would match the
+ * name, type and version of MASK with pathname-match-p, splitting the name
+ * the way the namestring parser does. Names that the parser treats
+ * specially (wildcards, "..") are left to pathname-match-p.
+ */
+static RawMatch
+raw_pathname_match(const char *text, size_t len, Pathname_sp mask) {
+  if (memchr(text, '*', len))
+    return raw_unknown;
+  /* The type starts after the last dot, unless that is the leading dot */
+  size_t dot = len;
+  for (size_t i = len; i > 1; --i) {
+    if (text[i - 1] == '.') {
+      dot = i - 1;
+      break;
+    }
+  }
+  if (dot == 2 && text[0] == '.' && text[1] == '.')
+    return raw_unknown;
+  RawMatch name = raw_item_match(text, dot, true, mask->_Name);
+  if (name != raw_match)
+    return name;
+  RawMatch type = (dot < len) ? raw_item_match(text + dot + 1, len - dot - 1, true, mask->_Type)
+                              : raw_item_match(text, 0, false, mask->_Type);
+  if (type != raw_match)
+    return type;
+  /* A parsed file name always has version :NEWEST */
+  T_sp version = mask->_Version;
+  if (version.nilp() || version == kw::_sym_wild || version == kw::_sym_newest)
+    return raw_match;
+  return raw_no_match;
+}
+
+#define ONLY_DIRECTORIES 2
+#define NO_DIRECTORIES 4
+
+struct DirectoryEntry {
+  std::string _Name;
+  unsigned char _Type;
+  bool _NeedsPathnameMatch;
+};
+
+/*
+ * list_directory() lists the files and directories which are contained in
+ * the directory BASE_DIR and match TEXT_MASK and PATHNAME_MASK. It returns
+ * a list of (truename . kind). The entries are first read into a buffer and
+ * matched on their raw names, before any lisp object is made. The d_type
+ * of the entries is used instead of stat'ing them; symlinks are resolved
+ * only if FOLLOW_SYMLINKS is set, and then the kind is that of the target.
+ * If ONLY_DIRECTORIES (NO_DIRECTORIES) is set then entries that are not
+ * (are) directories are dropped, looking at the target of symlinks that
+ * are followed.
  */
 static T_sp
 list_directory(T_sp base_dir, T_sp text_mask, T_sp pathname_mask, int flags) {
-  T_sp out = nil<T_O>();
+  ql::list out;
   if (base_dir.nilp()) SIMPLE_ERROR(("%s is about to pass NIL to clasp_namestring") , __FUNCTION__);
-  T_sp prefix = clasp_namestring(base_dir, CLASP_NAMESTRING_FORCE_BASE_STRING);
-  T_sp component, component_path, kind;
-  char *text;
+  std::string prefix = gc::As<String_sp>(clasp_namestring(base_dir, CLASP_NAMESTRING_FORCE_BASE_STRING))->get_std_string();
+  Pathname_sp mask = pathname_mask.nilp() ? nil<Pathname_O>() : gc::As<Pathname_sp>(pathname_mask);
+  std::vector<DirectoryEntry> entries;
   DIR *dir;
   struct dirent *entry;
 
   clasp_disable_interrupts();
-  dir = opendir((char *)gc::As<String_sp>(prefix)->get_std_string().c_str());
+  dir = opendir(prefix.c_str());
   if (dir == NULL) {
-    out = nil<T_O>();
-    goto OUTPUT;
+    clasp_enable_interrupts();
+    return nil<T_O>();
   }
-
   while ((entry = readdir(dir))) {
-    text = entry->d_name;
+    const char *text = entry->d_name;
     if (text[0] == '.' &&
         (text[1] == '\0' ||
          (text[1] == '.' && text[2] == '\0')))
       continue;
-    if (!string_match(text, text_mask))
+    if ((flags & ONLY_DIRECTORIES) && entry->d_type != DT_DIR && entry->d_type != DT_UNKNOWN &&
+        !(entry->d_type == DT_LNK && (flags & FOLLOW_SYMLINKS)))
       continue;
-    component = SimpleBaseString_O::make(std::string(text));
-    stringstream concat;
-    String_sp str_prefix = coerce::stringDesignator(prefix);
-    concat << str_prefix->get_std_string();
-    String_sp str_component = coerce::stringDesignator(component);
-    concat << str_component->get_std_string();
-    // TODO Support proper strings
-    component = SimpleBaseString_O::make(concat.str());
-    if (component.nilp()) SIMPLE_ERROR(("%s was about to pass nil to pathname") , __FUNCTION__);
-    component_path = cl__pathname(component);
-    if (!pathname_mask.nilp()) {
-      if (!cl__pathname_match_p(component, pathname_mask)) // should this not be inverted?
-        continue;
+    if ((flags & NO_DIRECTORIES) && entry->d_type == DT_DIR)
+      continue;
+    size_t len = strlen(text);
+    if (!string_match(text, len, text_mask))
+      continue;
+    RawMatch match = mask.nilp() ? raw_match : raw_pathname_match(text, len, mask);
+    if (match == raw_no_match)
+      continue;
+    entries.push_back(DirectoryEntry{std::string(text, len), entry->d_type, match == raw_unknown});
+  }
+  closedir(dir);
+  clasp_enable_interrupts();
+
+  for (auto &ent : entries) {
+    std::string filename = prefix + ent._Name;
+    if (ent._NeedsPathnameMatch &&
+        !cl__pathname_match_p(SimpleBaseString_O::make(filename), mask))
+      continue;
+    T_sp kind;
+    switch (ent._Type) {
+    case DT_DIR: kind = kw::_sym_directory; break;
+    case DT_REG: kind = kw::_sym_file; break;
+    case DT_LNK: kind = kw::_sym_link; break;
+    case DT_UNKNOWN: kind = file_kind(filename.c_str(), false); break;
+    default: kind = kw::_sym_special; break;
+    }
+    if (kind.nilp()) // Removed since we read the directory
+      continue;
+    bool follow = (kind == kw::_sym_link && (flags & FOLLOW_SYMLINKS));
+    if (follow) {
+      T_sp target = file_kind(filename.c_str(), true);
+      if (target.nilp()) // Broken link, it is returned as it is
+        follow = false;
+      else
+        kind = target;
     }
-    T_mv component_path_mv = file_truename(component_path, component, flags);
-    component_path = component_path_mv;
-    kind = component_path_mv.valueGet_(1);
-    out = Cons_O::create(Cons_O::create(component_path, kind), out);
+    if ((flags & ONLY_DIRECTORIES) && kind != kw::_sym_directory)
+      continue;
+    if ((flags & NO_DIRECTORIES) && kind == kw::_sym_directory)
+      continue;
+    /* BASE_DIR is a truename, so a directory in it is named by
+       appending a separator and there is nothing to resolve. */
+    if (kind == kw::_sym_directory && !follow)
+      filename.push_back(DIR_SEPARATOR_CHAR);
+    SimpleBaseString_sp component = SimpleBaseString_O::make(filename);
+    Pathname_sp component_path = cl__pathname(component);
+    if (follow)
+      component_path = gc::As<Pathname_sp>(file_truename(component_path, component, flags));
+    out << Cons_O::create(component_path, kind);
+  }
+  return out.cons();
+}
+
+/*
+ * collect_subdirectories() appends the truename of every directory below
+ * PREFIX to OUT, at all levels. It works on the raw names, so walking a
+ * :WILD-INFERIORS component does not parse, merge and print a pathname for
+ * every level of the tree. Symlinks are only entered if FOLLOW_SYMLINKS is
+ * set; in that case SEEN holds the directories entered so far, so that a
+ * link to an ancestor does not send the walk around in circles.
+ */
+static void
+collect_subdirectories(const std::string &prefix, int flags,
+                       std::set<std::pair<dev_t, ino_t>> &seen,
+                       std::vector<std::string> &out) {
+  std::vector<DirectoryEntry> entries;
+  DIR *dir;
+  struct dirent *entry;
+
+  clasp_disable_interrupts();
+  dir = opendir(prefix.c_str());
+  if (dir == NULL) {
+    clasp_enable_interrupts();
+    return;
+  }
+  while ((entry = readdir(dir))) {
+    const char *text = entry->d_name;
+    if (text[0] == '.' &&
+        (text[1] == '\0' ||
+         (text[1] == '.' && text[2] == '\0')))
+      continue;
+    if (entry->d_type == DT_DIR || entry->d_type == DT_UNKNOWN ||
+        (entry->d_type == DT_LNK && (flags & FOLLOW_SYMLINKS)))
+      entries.push_back(DirectoryEntry{std::string(text), entry->d_type, false});
   }
   closedir(dir);
   clasp_enable_interrupts();
-OUTPUT:
-  return cl__nreverse(out);
+
+  for (auto &ent : entries) {
+    std::string path = prefix + ent._Name;
+    unsigned char type = ent._Type;
+    struct stat buf;
+    if (type == DT_UNKNOWN) {
+#ifdef HAVE_LSTAT
+      if (safe_lstat(path.c_str(), &buf) < 0)
+#else
+      if (safe_stat(path.c_str(), &buf) < 0)
+#endif
+        continue;
+      type = S_ISDIR(buf.st_mode) ? DT_DIR : S_ISLNK(buf.st_mode) ? DT_LNK : DT_REG;
+      if (type == DT_REG || (type == DT_LNK && !(flags & FOLLOW_SYMLINKS)))
+        continue;
+    }
+    if (type == DT_LNK) {
+      char resolved[PATH_MAX];
+      if (realpath(path.c_str(), resolved) == NULL) // Broken link
+        continue;
+      path = resolved;
+      if (safe_stat(path.c_str(), &buf) < 0 || !S_ISDIR(buf.st_mode))
+        continue;
+    } else if ((flags & FOLLOW_SYMLINKS) && safe_stat(path.c_str(), &buf) < 0)
+      continue;
+    if ((flags & FOLLOW_SYMLINKS) && !seen.insert(std::make_pair(buf.st_dev, buf.st_ino)).second)
+      continue;
+    if (path.back() != DIR_SEPARATOR_CHAR)
+      path.push_back(DIR_SEPARATOR_CHAR);
+    out.push_back(path);
+    collect_subdirectories(path, flags, seen, out);
+  }
 }
 
 CL_LAMBDA(template)
@@ -1643,7 +1804,7 @@ dir_files(T_sp base_dir, T_sp tpathname, int flags) {
                          type, true,
                          pathname->_Version, true,
                          kw::_sym_local);
-  for (all_files = list_directory(base_dir, nil<T_O>(), mask, flags);
+  for (all_files = list_directory(base_dir, nil<T_O>(), mask, flags | NO_DIRECTORIES);
        !all_files.nilp();
        all_files = oCdr(all_files)) {
     T_sp record = oCar(all_files);
@@ -1688,7 +1849,7 @@ AGAIN:
          * 2.1) If CAR(DIRECTORY) is a string or :WILD, we have to
          * enter & scan all subdirectories in our curent directory.
          */
-    T_sp next_dir = list_directory(base_dir, item, nil<T_O>(), flags);
+    T_sp next_dir = list_directory(base_dir, item, nil<T_O>(), flags | ONLY_DIRECTORIES);
     for (; !next_dir.nilp(); next_dir = oCdr(next_dir)) {
       T_sp record = oCar(next_dir);
       T_sp component = oCar(record);
@@ -1705,21 +1866,23 @@ AGAIN:
     /*
          * 2.2) If CAR(DIRECTORY) is :WILD-INFERIORS, we have to do
          * scan all subdirectories from _all_ levels, looking for a
-         * tree that matches the remaining part of DIRECTORY.
+         * tree that matches the remaining part of DIRECTORY. The
+         * whole tree is collected at once by name, and only the
+         * remaining part is matched through pathnames.
          */
-    T_sp next_dir = list_directory(base_dir, nil<T_O>(), nil<T_O>(), flags);
-    for (; !next_dir.nilp(); next_dir = oCdr(next_dir)) {
-      T_sp record = oCar(next_dir);
-      T_sp component = oCar(record);
-      T_sp kind = oCdr(record);
-      if (kind != kw::_sym_directory)
-        continue;
-      if (component.nilp()) SIMPLE_ERROR(("%s was about to pass nil to pathname") , __FUNCTION__);
-      item = dir_recursive(cl__pathname(component),
+    directory = oCdr(directory);
+    std::string prefix = gc::As<String_sp>(clasp_namestring(base_dir, CLASP_NAMESTRING_FORCE_BASE_STRING))->get_std_string();
+    std::set<std::pair<dev_t, ino_t>> seen;
+    struct stat buf;
+    if ((flags & FOLLOW_SYMLINKS) && safe_stat(prefix.c_str(), &buf) == 0)
+      seen.insert(std::make_pair(buf.st_dev, buf.st_ino));
+    std::vector<std::string> subdirs;
+    collect_subdirectories(prefix, flags, seen, subdirs);
+    for (auto &sub : subdirs) {
+      item = dir_recursive(cl__pathname(SimpleBaseString_O::make(sub)),
                            directory, filemask, flags);
       output = clasp_nconc(item, output);
     }
-    directory = oCdr(directory);
     goto AGAIN;
   } else { /* :ABSOLUTE, :RELATIVE, :UP, component without wildcards */
     /*
@@ -0,0 +1,363 @@
+/*
+    File: allocationSampler.cc
+*/
+
+/*
+Copyright (c) 2014, Christian E. Schafmeister
+
+CLASP is free software; you can redistribute it and/or
+modify it under the terms of the GNU Library General Public
+License as published by the Free Software Foundation; either
+version 2 of the License, or (at your option) any later version.
+
+See directory 'clasp/licenses' for full details.
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+/* -^- */
+
+// Sample allocations by the bytes allocated, the same way tcmalloc does.
+//
+// Every thread counts down _SampleCountdown in GlobalAllocationProfiler::registerAllocation,
+// which every allocation fast path already calls.  When it goes negative the
+// allocation that crossed zero is sampled by HitAllocationSampleCountdown and a new
+// countdown is drawn from an exponential distribution with a mean of the sampling interval.
+// Because the distances between samples are memoryless, an allocation of size bytes is
+// sampled with probability 1-exp(-size/interval), so each sample stands for
+// size/(1-exp(-size/interval)) bytes.  That makes the estimated totals unbiased for
+// small and large objects alike.
+//
+// The countdown always runs, so the fast path costs one subtract and one compare.
+// Only when the sampler has been started with gctools:allocation-sampler-start
+// does a sample record the stamp, the weight and the return addresses of a few frames.
+// It records them into a buffer that the thread claimed when it started, without
+// locking or allocating.  The buffers are merged into the per stamp and per site tables,
+// under a mutex, by whoever reads the tables and by the thread itself at its next
+// safepoint once its buffer is half full.  A sample that finds the buffer full is dropped
+// and counted.
+
+#include <cmath>
+#include <cstring>
+#include <map>
+#include <vector>
+#include <algorithm>
+#include <clasp/core/foundation.h>
+#include <clasp/core/object.h>
+#include <clasp/core/lisp.h>
+#include <clasp/core/array.h>
+#include <clasp/core/lispStream.h>
+#include <clasp/core/ql.h>
+#include <clasp/core/designators.h>
+#include <clasp/core/debugger.h>
+#include <clasp/core/mpPackage.h>
+#include <clasp/gctools/gc_interface.h>
+#include <clasp/gctools/threadlocal.h>
+#include <clasp/gctools/interrupt.h>
+#include <clasp/core/wrappers.h>
+
+namespace gctools {
+
+#define ALLOCATION_SAMPLER_MAX_DEPTH 64
+// Room for about 700 samples of the default depth
+#define ALLOCATION_SAMPLE_BUFFER_WORDS 8192
+// The session, the nowhere stamp, the weight and the depth come before the return addresses
+#define ALLOCATION_SAMPLE_RECORD_HEADER 4
+
+struct AllocationCounts {
+  size_t _Samples = 0;
+  double _Bytes = 0.0;
+};
+
+/*! The samples of one thread that haven't been merged yet.  The thread appends
+    records at _Tail and the merger, holding global_AllocationSamplerMutex, takes
+    them from _Head.  Both only grow and index the words modulo their number.
+    Buffers are never freed: a thread that exits releases its buffer, with any
+    records left in it, to the next thread that starts. */
+struct AllocationSampleBuffer {
+  AllocationSampleBuffer* _Next = NULL; // in global_AllocationSampleBuffers
+  std::atomic<bool>       _Claimed{true};
+  std::atomic<size_t>     _Head{0};
+  std::atomic<size_t>     _Tail{0};
+  uintptr_t               _Words[ALLOCATION_SAMPLE_BUFFER_WORDS];
+};
+
+std::atomic<AllocationSampleBuffer*> global_AllocationSampleBuffers{NULL};
+
+struct AllocationSampler {
+  std::atomic<bool>   _Running{false};
+  std::atomic<size_t> _Interval{ALLOCATION_SAMPLE_INTERVAL};
+  std::atomic<size_t> _Depth{8};
+  // Records from an earlier session are discarded when they are merged
+  std::atomic<uint64_t> _Session{0};
+  std::atomic<size_t> _Dropped{0};
+  size_t              _Samples = 0;
+  // Keyed by the nowhere stamp
+  std::map<size_t, AllocationCounts> _Stamps;
+  // Keyed by the nowhere stamp followed by the return addresses, innermost first
+  std::map<std::vector<uintptr_t>, AllocationCounts> _Sites;
+};
+
+AllocationSampler global_AllocationSampler;
+mp::Mutex global_AllocationSamplerMutex(ALLOCSMP_NAMEWORD);
+
+AllocationSampleBuffer* allocation_sample_buffer_claim() {
+  for (AllocationSampleBuffer* buffer = global_AllocationSampleBuffers.load(); buffer; buffer = buffer->_Next) {
+    bool expected = false;
+    if (!buffer->_Claimed.load(std::memory_order_relaxed)
+        && buffer->_Claimed.compare_exchange_strong(expected, true)) return buffer;
+  }
+  AllocationSampleBuffer* buffer = new AllocationSampleBuffer();
+  AllocationSampleBuffer* head = global_AllocationSampleBuffers.load();
+  do {
+    buffer->_Next = head;
+  } while (!global_AllocationSampleBuffers.compare_exchange_weak(head, buffer));
+  return buffer;
+}
+
+void allocation_sample_buffer_release(AllocationSampleBuffer* buffer) {
+  if (buffer) buffer->_Claimed.store(false, std::memory_order_release);
+}
+
+// Move the records of every buffer into the tables.  The caller holds
+// global_AllocationSamplerMutex.
+static void allocation_sampler_merge_locked() {
+  AllocationSampler& sampler = global_AllocationSampler;
+  uint64_t session = sampler._Session.load();
+  std::vector<uintptr_t> site;
+  for (AllocationSampleBuffer* buffer = global_AllocationSampleBuffers.load(); buffer; buffer = buffer->_Next) {
+    size_t head = buffer->_Head.load(std::memory_order_relaxed);
+    size_t tail = buffer->_Tail.load(std::memory_order_acquire);
+    while (head < tail) {
+      uintptr_t* words = buffer->_Words;
+      uint64_t record_session = words[head % ALLOCATION_SAMPLE_BUFFER_WORDS];
+      size_t nowhere = words[(head+1) % ALLOCATION_SAMPLE_BUFFER_WORDS];
+      double weight;
+      memcpy(&weight, &words[(head+2) % ALLOCATION_SAMPLE_BUFFER_WORDS], sizeof(weight));
+      size_t depth = words[(head+3) % ALLOCATION_SAMPLE_BUFFER_WORDS];
+      if (record_session == session) {
+        site.clear();
+        site.push_back(nowhere);
+        for (size_t ii = 0; ii < depth; ++ii)
+          site.push_back(words[(head+ALLOCATION_SAMPLE_RECORD_HEADER+ii) % ALLOCATION_SAMPLE_BUFFER_WORDS]);
+        sampler._Samples++;
+        AllocationCounts& bystamp = sampler._Stamps[nowhere];
+        bystamp._Samples++;
+        bystamp._Bytes += weight;
+        AllocationCounts& bysite = sampler._Sites[site];
+        bysite._Samples++;
+        bysite._Bytes += weight;
+      }
+      head += ALLOCATION_SAMPLE_RECORD_HEADER + depth;
+    }
+    buffer->_Head.store(head, std::memory_order_release);
+  }
+}
+
+void allocation_sampler_merge() {
+  mp::RAIIReadWriteLock<mp::Mutex> lock(global_AllocationSamplerMutex);
+  allocation_sampler_merge_locked();
+}
+
+static int64_t allocation_sample_next_countdown(GlobalAllocationProfiler& allocs, size_t interval) {
+  uint64_t x = allocs._SampleRandom;
+  if (x == 0) x = ((uintptr_t)&allocs) ^ (uint64_t)std::chrono::high_resolution_clock::now().time_since_epoch().count() ^ 0x9E3779B97F4A7C15;
+  // xorshift64*
+  x ^= x >> 12;
+  x ^= x << 25;
+  x ^= x >> 27;
+  allocs._SampleRandom = x;
+  uint64_t r = x * 0x2545F4914F6CDD1D;
+  // uniform in (0,1]
+  double u = ((double)(r >> 11) + 1.0) * (1.0 / 9007199254740992.0);
+  double next = -std::log(u) * (double)interval;
+  if (next < 1.0) return 1;
+  if (next > 32.0 * (double)interval) return 32 * (int64_t)interval;
+  return (int64_t)next;
+}
+
+// Fill pcs with the return addresses of our callers, innermost first.
+static size_t allocation_sample_capture_stack(uintptr_t* pcs, size_t max) {
+  uintptr_t fp = (uintptr_t)__builtin_frame_address(0);
+  uintptr_t low = fp;
+  uintptr_t top = (uintptr_t)my_thread_low_level->_StackTop;
+  size_t depth = 0;
+  while (depth < max && low <= fp && fp < top && (fp & (sizeof(uintptr_t)-1)) == 0) {
+    uintptr_t next = ((uintptr_t*)fp)[0];
+    uintptr_t ret = ((uintptr_t*)fp)[1];
+    if (ret == 0) break;
+    // Back up into the call instruction so the address is inside the caller.
+    pcs[depth++] = ret - 1;
+    if (next <= fp) break;
+    low = fp;
+    fp = next;
+  }
+  return depth;
+}
+
+extern "C" __attribute__((noinline)) void HitAllocationSampleCountdown(stamp_t stamp, size_t size) {
+  AllocationSampler& sampler = global_AllocationSampler;
+  GlobalAllocationProfiler& allocs = my_thread_low_level->_Allocations;
+  size_t interval = sampler._Interval.load(std::memory_order_relaxed);
+  allocs._SampleCountdown = allocation_sample_next_countdown(allocs, interval);
+  if (!sampler._Running.load(std::memory_order_relaxed)) return;
+  AllocationSampleBuffer* buffer = my_thread_low_level->_SampleBuffer;
+  if (!buffer) return;
+  uint64_t session = sampler._Session.load(std::memory_order_acquire);
+  double weight = (double)size / (1.0 - std::exp(-(double)size / (double)interval));
+  size_t nowhere = Header_s::StampWtagMtag::make_nowhere_stamp(stamp);
+  uintptr_t pcs[ALLOCATION_SAMPLER_MAX_DEPTH];
+  size_t depth = allocation_sample_capture_stack(pcs, std::min(sampler._Depth.load(std::memory_order_relaxed), (size_t)ALLOCATION_SAMPLER_MAX_DEPTH));
+  size_t tail = buffer->_Tail.load(std::memory_order_relaxed);
+  size_t used = tail - buffer->_Head.load(std::memory_order_acquire);
+  if (used + ALLOCATION_SAMPLE_RECORD_HEADER + depth > ALLOCATION_SAMPLE_BUFFER_WORDS) {
+    sampler._Dropped.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  uintptr_t* words = buffer->_Words;
+  words[tail % ALLOCATION_SAMPLE_BUFFER_WORDS] = session;
+  words[(tail+1) % ALLOCATION_SAMPLE_BUFFER_WORDS] = nowhere;
+  memcpy(&words[(tail+2) % ALLOCATION_SAMPLE_BUFFER_WORDS], &weight, sizeof(weight));
+  words[(tail+3) % ALLOCATION_SAMPLE_BUFFER_WORDS] = depth;
+  for (size_t ii = 0; ii < depth; ++ii)
+    words[(tail+ALLOCATION_SAMPLE_RECORD_HEADER+ii) % ALLOCATION_SAMPLE_BUFFER_WORDS] = pcs[ii];
+  buffer->_Tail.store(tail + ALLOCATION_SAMPLE_RECORD_HEADER + depth, std::memory_order_release);
+  // Past half full, have the thread merge its samples where it can take a lock
+  core::ThreadLocalState* thread = my_thread;
+  if (used >= ALLOCATION_SAMPLE_BUFFER_WORDS/2 && thread
+      && !thread->_SampleMergePending.exchange(true, std::memory_order_relaxed))
+    request_safepoint(thread);
+}
+
+static core::SimpleBaseString_sp allocation_sample_stamp_name(size_t nowhere) {
+  if (nowhere < global_unshifted_nowhere_stamp_names.size() && global_unshifted_nowhere_stamp_names[nowhere] != "")
+    return core::SimpleBaseString_O::make(global_unshifted_nowhere_stamp_names[nowhere]);
+  return core::SimpleBaseString_O::make(fmt::sprintf("stamp-%lu", nowhere));
+}
+
+CL_LAMBDA(&key (interval 524288) (depth 8))
+CL_DOCSTRING(R"dx(Start sampling allocations. On average one allocation in every INTERVAL bytes allocated by
+each thread is recorded along with DEPTH return addresses. Previous results are discarded.
+See allocation-sampler-stamps, allocation-sampler-sites and allocation-sampler-report.)dx")
+DOCGROUP(clasp)
+CL_DEFUN void gctools__allocation_sampler_start(size_t interval, size_t depth) {
+  if (interval == 0) SIMPLE_ERROR(("The allocation sampling interval must be positive"));
+  AllocationSampler& sampler = global_AllocationSampler;
+  {
+    mp::RAIIReadWriteLock<mp::Mutex> lock(global_AllocationSamplerMutex);
+    // Records left from the last session are discarded as they are merged
+    sampler._Session.fetch_add(1);
+    allocation_sampler_merge_locked();
+    sampler._Stamps.clear();
+    sampler._Sites.clear();
+    sampler._Samples = 0;
+    sampler._Dropped.store(0);
+    sampler._Depth.store(std::min(depth, (size_t)ALLOCATION_SAMPLER_MAX_DEPTH));
+    sampler._Interval.store(interval);
+    sampler._Running.store(true);
+  }
+  // Other threads pick up the new interval at their next sample.
+  GlobalAllocationProfiler& allocs = my_thread_low_level->_Allocations;
+  allocs._SampleCountdown = allocation_sample_next_countdown(allocs, interval);
+}
+
+CL_DOCSTRING(R"dx(Stop sampling allocations and return the number of samples taken.)dx")
+DOCGROUP(clasp)
+CL_DEFUN size_t gctools__allocation_sampler_stop() {
+  AllocationSampler& sampler = global_AllocationSampler;
+  mp::RAIIReadWriteLock<mp::Mutex> lock(global_AllocationSamplerMutex);
+  if (!sampler._Running.load()) return sampler._Samples;
+  sampler._Running.store(false);
+  allocation_sampler_merge_locked();
+  // Samples recorded by threads that hadn't yet seen the sampler stop don't count
+  sampler._Session.fetch_add(1);
+  return sampler._Samples;
+}
+
+CL_DOCSTRING(R"dx(Return a list of (stamp-name samples estimated-bytes) for every stamp that was sampled,
+the stamps with the most estimated bytes first.)dx")
+DOCGROUP(clasp)
+CL_DEFUN core::T_sp gctools__allocation_sampler_stamps() {
+  std::vector<std::pair<size_t, AllocationCounts>> stamps;
+  {
+    mp::RAIIReadWriteLock<mp::Mutex> lock(global_AllocationSamplerMutex);
+    allocation_sampler_merge_locked();
+    stamps.assign(global_AllocationSampler._Stamps.begin(), global_AllocationSampler._Stamps.end());
+  }
+  std::sort(stamps.begin(), stamps.end(),
+            [](const auto& a, const auto& b) { return a.second._Bytes > b.second._Bytes; });
+  ql::list result;
+  for (auto& entry : stamps) {
+    result << core::Cons_O::createList(allocation_sample_stamp_name(entry.first),
+                                       core::Integer_O::create((uint64_t)entry.second._Samples),
+                                       core::Integer_O::create((uint64_t)std::llround(entry.second._Bytes)));
+  }
+  return result.cons();
+}
+
+CL_LAMBDA(&key (limit 20))
+CL_DOCSTRING(R"dx(Return a list of (stamp-name samples estimated-bytes frames) for the LIMIT allocation sites
+with the most estimated bytes. FRAMES is a list of function names, innermost first.)dx")
+DOCGROUP(clasp)
+CL_DEFUN core::T_sp gctools__allocation_sampler_sites(size_t limit) {
+  std::vector<std::pair<std::vector<uintptr_t>, AllocationCounts>> sites;
+  {
+    mp::RAIIReadWriteLock<mp::Mutex> lock(global_AllocationSamplerMutex);
+    allocation_sampler_merge_locked();
+    sites.assign(global_AllocationSampler._Sites.begin(), global_AllocationSampler._Sites.end());
+  }
+  std::sort(sites.begin(), sites.end(),
+            [](const auto& a, const auto& b) { return a.second._Bytes > b.second._Bytes; });
+  if (sites.size() > limit) sites.resize(limit);
+  std::map<uintptr_t, core::SimpleBaseString_sp> names;
+  ql::list result;
+  for (auto& entry : sites) {
+    ql::list frames;
+    for (size_t i = 1; i < entry.first.size(); ++i) {
+      uintptr_t pc = entry.first[i];
+      auto it = names.find(pc);
+      if (it == names.end()) it = names.emplace(pc, core::SimpleBaseString_O::make(core::profiler_address_name(pc))).first;
+      frames << it->second;
+    }
+    result << core::Cons_O::createList(allocation_sample_stamp_name(entry.first[0]),
+                                       core::Integer_O::create((uint64_t)entry.second._Samples),
+                                       core::Integer_O::create((uint64_t)std::llround(entry.second._Bytes)),
+                                       frames.cons());
+  }
+  return result.cons();
+}
+
+CL_LAMBDA(&key (output t) (limit 20))
+CL_DOCSTRING(R"dx(Write the estimated bytes allocated for each stamp and for the LIMIT busiest allocation sites
+to the stream designator OUTPUT.)dx")
+DOCGROUP(clasp)
+CL_DEFUN void gctools__allocation_sampler_report(core::T_sp output, size_t limit) {
+  core::T_sp stream = core::coerce::outputStreamDesignator(output);
+  core::clasp_write_string(fmt::sprintf("%16s %8s  %s\n", "bytes", "samples", "stamp"), stream);
+  for (auto cur : (core::List_sp)gctools__allocation_sampler_stamps()) {
+    core::List_sp entry = CONS_CAR(cur);
+    core::clasp_write_string(fmt::sprintf("%16s %8s  %s\n", _rep_(oThird(entry)), _rep_(oSecond(entry)),
+                                          gc::As<core::String_sp>(oCar(entry))->get_std_string()), stream);
+  }
+  size_t dropped = global_AllocationSampler._Dropped.load();
+  if (dropped) core::clasp_write_string(fmt::sprintf("%lu samples were dropped because a thread's buffer was full\n", dropped), stream);
+  for (auto cur : (core::List_sp)gctools__allocation_sampler_sites(limit)) {
+    core::List_sp entry = CONS_CAR(cur);
+    core::clasp_terpri(stream);
+    core::clasp_write_string(fmt::sprintf("%s bytes in %s samples of %s\n", _rep_(oThird(entry)), _rep_(oSecond(entry)),
+                                          gc::As<core::String_sp>(oCar(entry))->get_std_string()), stream);
+    for (auto frame : (core::List_sp)oFourth(entry)) {
+      core::clasp_write_string(fmt::sprintf("    %s\n", gc::As<core::String_sp>(CONS_CAR(frame))->get_std_string()), stream);
+    }
+  }
+}
+
+}; // namespace gctools
@@ -35,6 +35,9 @@ THE SOFTWARE.
 #ifdef USE_BOEHM // whole file #ifdef USE_BOEHM
 #include <clasp/gctools/boehmGarbageCollection.h>
 #include <clasp/gctools/gcFunctions.h>
+#include <clasp/gctools/metrics.h>
+#include <clasp/gctools/finalizers.h>
+#include <unistd.h>
 #include <clasp/core/debugger.h>
 #include <clasp/core/compiler.h>
 #include <clasp/gctools/snapshotSaveLoad.h>
@@ -199,6 +202,38 @@ void clasp_warn_proc(char *msg, GC_word arg) {
 #endif
 }
 
+// Called by Boehm with the allocation lock held, so it must not allocate.
+void boehm_collection_event(GC_EventType event) {
+  switch (event) {
+  case GC_EVENT_START:
+      metrics::gc_collection_begin();
+      break;
+  case GC_EVENT_END: {
+      metrics::gc_collection_end();
+      // The unsafe version doesn't take the allocation lock, which we hold
+      struct GC_prof_stats_s stats;
+      GC_get_prof_stats_unsafe(&stats, sizeof(stats));
+      metrics::gc_allocation_sample(stats.allocd_bytes_before_gc + stats.bytes_allocd_since_gc);
+      heap_after_collection(stats.heapsize_full - stats.free_bytes_full);
+      break;
+  }
+  case GC_EVENT_PRE_STOP_WORLD:
+      metrics::gc_world_stopped();
+      break;
+  case GC_EVENT_POST_START_WORLD:
+      metrics::gc_world_started();
+      break;
+  case GC_EVENT_MARK_START:
+      metrics::gc_mark_begin();
+      break;
+  case GC_EVENT_MARK_END:
+      metrics::gc_mark_end();
+      break;
+  default:
+      break;
+  }
+}
+
 
 
 void run_finalizers(core::T_sp obj, void* data)
@@ -223,7 +258,7 @@ void run_finalizers(core::T_sp obj, void* data)
       abort();
     }
 //    printf("%s:%d     calling finalizer %p with obj %p\n", __FILE__, __LINE__, func.raw_(), obj.raw_());
-    core::eval::funcall(func,obj);
+    call_finalizer(func,obj);
   }
   // Now release the memory pointed to by data
   GC_FREE(data);
@@ -380,20 +415,59 @@ void boehm_clear_finalizer_list(gctools::Tagged object_tagged)
   int globalBoehmMarker = 0;
 #endif
 
+void boehm_refill_cons_free_list(ThreadLocalStateLowLevel* thread, size_t size) {
+  // Ask for what GC_malloc would give us: whole granules, plus the extra
+  // byte that keeps a pointer just past the end inside the object
+  size_t granule_size = (size + GC_all_interior_pointers + GC_GRANULE_BYTES - 1) & ~((size_t)GC_GRANULE_BYTES - 1);
+#ifdef USE_PRECISE_GC
+  GC_generic_malloc_many(granule_size, (int)global_cons_kind, &thread->_ConsFreeList);
+#else
+  GC_generic_malloc_many(granule_size, GC_I_NORMAL, &thread->_ConsFreeList);
+#endif
+  if (thread->_ConsFreeList == NULL) {
+    throw_hard_error("Out of memory while allocating conses");
+  }
+}
+
 };
 
 namespace gctools {
+// The number of marker threads Boehm settles on at startup: --gc-markers,
+// else the GC_MARKERS environment variable, else one per core up to 16.
+static int boehm_marker_count() {
+#ifdef BOEHM_PARALLEL_MARK
+  if (GC_get_parallel()) {
+    if (global_gc_markers > 0) return global_gc_markers;
+    const char* env = getenv("GC_MARKERS");
+    if (env && atoi(env) > 0) return atoi(env);
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    return (cores < 1) ? 1 : (cores > 16) ? 16 : (int)cores;
+  }
+#endif
+  return 1;
+}
+
 __attribute__((noinline))
 int initializeBoehm(MainFunctionType startupFn, int argc, char *argv[], bool mpiEnabled, int mpiRank, int mpiSize) {
   GC_set_handle_fork(1);
+#ifdef BOEHM_PARALLEL_MARK
+  if (global_gc_markers > 0) GC_set_markers_count(global_gc_markers);
+#endif
   GC_INIT();
   GC_allow_register_threads();
   GC_set_java_finalization(1);
   GC_set_all_interior_pointers(1); // tagged pointers require this
                                    //printf("%s:%d Turning on interior pointers\n",__FILE__,__LINE__);
   GC_set_warn_proc(clasp_warn_proc);
+  GC_set_on_collection_event(boehm_collection_event);
   //  GC_enable_incremental();
   GC_init();
+  metrics::global_GCMarkers.set(boehm_marker_count());
+  global_free_space_divisor = GC_get_free_space_divisor();
+  // Boehm grows the heap as the live data after each collection grows and
+  // returns blocks that stay free to the OS (USE_MUNMAP), so --heap-min only
+  // saves the collections on the way up.
+  if (global_heap_min > GC_get_heap_size()) GC_expand_hp(global_heap_min - GC_get_heap_size());
   void* topOfStack;
   // ctor sets up my_thread
   gctools::ThreadLocalStateLowLevel thread_local_state_low_level(&topOfStack);
@@ -17,6 +17,10 @@
            #~"gc_boot.cc"
            #~"interrupt.cc"
            #~"gcFunctions.cc"
+           #~"allocationSampler.cc"
+           #~"metrics.cc"
+           #~"finalizers.cc"
+           #~"heapDump.cc"
            #~"snapshotSaveLoad.cc"
            #~"gctoolsPackage.cc"
            #~"globals.cc"
@@ -0,0 +1,322 @@
+/*
+    File: finalizers.cc
+*/
+
+/*
+Copyright (c) 2014, Christian E. Schafmeister
+
+CLASP is free software; you can redistribute it and/or
+modify it under the terms of the GNU Library General Public
+License as published by the Free Software Foundation; either
+version 2 of the License, or (at your option) any later version.
+
+See directory 'clasp/licenses' for full details.
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+/* -^- */
+
+// Registering and running finalizers.
+//
+// The Lisp finalizers of an object are kept in one of FINALIZER_SHARDS weak-key-hash-tables
+// chosen by the object's badge, which doesn't change when the object moves.  Each shard has
+// its own lock so threads registering finalizers for different objects rarely meet.
+//
+// With Boehm the first call to gctools:finalize starts a finalizer thread and puts Boehm
+// in finalize-on-demand mode.  From then on the collector only notifies us that finalizers
+// are ready and the finalizer thread runs them, rather than whichever thread happens to be
+// allocating.  The ready finalizers wait in Boehm's own queue; to keep it from growing
+// without bound a thread that registers a finalizer while that queue is not empty waits up
+// to FINALIZER_BACKPRESSURE_SECONDS for the finalizer thread to drain it.
+//
+// gctools:garbage-collect still runs the ready finalizers itself so that code that collects
+// and then looks for the effects of finalizers sees them.
+//
+// Each finalizer is called through gctools::call-finalizer, which reports and discards
+// any error it signals. Anything else that unwinds out of a finalizer on the finalizer
+// thread, such as the thread being killed, is held until Boehm has returned and then
+// rethrown; the thread's state is reset on the way out however it exits.
+//
+// MPS has no finalizer thread.  Its finalization messages are handled by processMpsMessages,
+// which runs in whichever thread registers enough finalizers or polls for messages at an
+// allocation point, so with MPS finalizers still run in the allocating thread as before.
+
+#include <exception>
+#include <clasp/core/foundation.h>
+#include <clasp/core/object.h>
+#include <clasp/core/lisp.h>
+#include <clasp/core/array.h>
+#include <clasp/core/weakHashTable.h>
+#include <clasp/core/mpPackage.h>
+#include <clasp/gctools/gc_interface.h>
+#include <clasp/gctools/gcFunctions.h>
+#include <clasp/gctools/finalizers.h>
+#include <clasp/core/wrappers.h>
+
+namespace mp {
+  Process_sp mp__process_run_function(core::T_sp name, core::T_sp function, core::List_sp special_bindings);
+};
+
+namespace gctools {
+
+struct FinalizerShard {
+  mp::Mutex _Mutex;
+  FinalizerShard() : _Mutex(FINALIZE_NAMEWORD) {};
+};
+
+FinalizerShard global_FinalizerShards[FINALIZER_SHARDS];
+
+struct FinalizerThread {
+  mp::Mutex                 _Mutex;
+  mp::ConditionVariable     _Wakeup;  // finalizers are ready or the thread should stop
+  mp::ConditionVariable     _Drained; // the thread ran the ready finalizers or stopped
+  std::atomic<bool>         _Running{false};
+  std::atomic<bool>         _Starting{false};
+  bool                      _Ready = false;
+  bool                      _Stop = false;
+  bool                      _Busy = false;
+  std::atomic<core::ThreadLocalState*> _Thread{NULL}; // read by every thread that registers or runs finalizers
+  std::exception_ptr        _Unwinding; // only touched by the finalizer thread
+  std::atomic<uint64_t>     _Batches{0};
+  FinalizerThread() : _Mutex(FINLTHRD_NAMEWORD) {};
+};
+
+FinalizerThread global_FinalizerThread;
+
+core::SimpleVector_sp make_finalizer_shards() {
+  core::SimpleVector_sp shards = core::SimpleVector_O::make(FINALIZER_SHARDS);
+  for (size_t ii = 0; ii < FINALIZER_SHARDS; ++ii) {
+    (*shards)[ii] = core::WeakKeyHashTable_O::create();
+  }
+  return shards;
+}
+
+static size_t finalizer_shard(core::T_sp object) {
+  if (!object.generalp() && !object.consp()) return 0;
+  uint64_t badge = core::lisp_badge(object);
+  return ((badge * 0x9E3779B97F4A7C15) >> 32) % FINALIZER_SHARDS;
+}
+
+static core::WeakKeyHashTable_sp finalizer_shard_table(size_t shard) {
+  return gc::As_unsafe<core::WeakKeyHashTable_sp>((*_lisp->_Roots._Finalizers)[shard]);
+}
+
+core::List_sp take_finalizers(core::T_sp object) {
+  size_t shard = finalizer_shard(object);
+  mp::RAIIReadWriteLock<mp::Mutex> lock(global_FinalizerShards[shard]._Mutex);
+  core::WeakKeyHashTable_sp ht = finalizer_shard_table(shard);
+  core::T_mv res = ht->gethash(object);
+  if (res.second().nilp()) return nil<core::T_O>();
+  ht->remhash(object);
+  return res;
+}
+
+SYMBOL_SC_(GcToolsPkg, call_finalizer);
+
+void call_finalizer(core::T_sp finalizer, core::T_sp object) {
+  FinalizerThread& ft = global_FinalizerThread;
+  if (ft._Thread.load(std::memory_order_acquire) != my_thread) {
+    if (_sym_call_finalizer->fboundp())
+      core::eval::funcall(_sym_call_finalizer, finalizer, object);
+    else
+      core::eval::funcall(finalizer, object);
+    return;
+  }
+  // Once the thread is on its way out the remaining finalizers are skipped;
+  // they are already off Boehm's queue either way.
+  if (ft._Unwinding) return;
+  try {
+    if (_sym_call_finalizer->fboundp())
+      core::eval::funcall(_sym_call_finalizer, finalizer, object);
+    else
+      core::eval::funcall(finalizer, object);
+  } catch (...) {
+    ft._Unwinding = std::current_exception();
+  }
+}
+
+#ifdef USE_BOEHM
+// Called by Boehm when finalizers are ready.  It must not allocate.
+static void boehm_finalizer_notifier() {
+  FinalizerThread& ft = global_FinalizerThread;
+  ft._Mutex.lock();
+  ft._Ready = true;
+  ft._Wakeup.signal();
+  ft._Mutex.unlock();
+}
+#endif
+
+static void finalizer_thread_ensure() {
+#ifdef USE_BOEHM
+  FinalizerThread& ft = global_FinalizerThread;
+  if (ft._Running.load(std::memory_order_acquire)) return;
+  bool expected = false;
+  if (!ft._Starting.compare_exchange_strong(expected, true)) return;
+  core::Symbol_sp loop = _lisp->internWithPackageName("GCTOOLS", "FINALIZER-THREAD-LOOP");
+  ft._Mutex.lock();
+  ft._Stop = false;
+  ft._Ready = false;
+  ft._Mutex.unlock();
+  ft._Running.store(true, std::memory_order_release);
+  mp::mp__process_run_function(core::SimpleBaseString_O::make("Finalizer"), loop->symbolFunction(), nil<core::T_O>());
+#endif
+}
+
+// Make a thread that is registering finalizers wait while finalizers are piling up
+static void finalizer_backpressure() {
+#ifdef USE_BOEHM
+  FinalizerThread& ft = global_FinalizerThread;
+  if (!ft._Running.load(std::memory_order_relaxed) || ft._Thread.load(std::memory_order_acquire) == my_thread) return;
+  if (!GC_should_invoke_finalizers()) return;
+  ft._Mutex.lock();
+  ft._Ready = true;
+  ft._Wakeup.signal();
+  if (!ft._Stop) ft._Drained.timed_wait(ft._Mutex, FINALIZER_BACKPRESSURE_SECONDS);
+  ft._Mutex.unlock();
+#endif
+}
+
+void finalizer_thread_drain() {
+#ifdef USE_BOEHM
+  FinalizerThread& ft = global_FinalizerThread;
+  if (!ft._Running.load() || ft._Thread.load() == my_thread) return;
+  ft._Mutex.lock();
+  while (ft._Busy && ft._Running.load()) ft._Drained.timed_wait(ft._Mutex, 1.0);
+  ft._Mutex.unlock();
+#endif
+}
+
+void finalizer_thread_stop() {
+#ifdef USE_BOEHM
+  FinalizerThread& ft = global_FinalizerThread;
+  if (!ft._Running.load() || ft._Thread.load() == my_thread) return;
+  ft._Mutex.lock();
+  ft._Stop = true;
+  ft._Wakeup.signal();
+  while (ft._Running.load()) ft._Drained.timed_wait(ft._Mutex, 1.0);
+  ft._Mutex.unlock();
+#endif
+}
+
+CL_DOCSTRING(R"dx(The body of the finalizer thread that gctools:finalize starts. Runs finalizers
+as the garbage collector finds them until finalizer-thread-stop is called.)dx")
+DOCGROUP(clasp)
+CL_DEFUN void gctools__finalizer_thread_loop() {
+#ifdef USE_BOEHM
+  FinalizerThread& ft = global_FinalizerThread;
+  // However the loop is left, go back to running finalizers at allocation
+  // points and wake up anyone waiting in finalizer_thread_drain or _stop.
+  struct FinalizerThreadExit {
+    ~FinalizerThreadExit() {
+      FinalizerThread& ft = global_FinalizerThread;
+      GC_set_finalize_on_demand(0);
+      ft._Mutex.lock();
+      ft._Thread.store(NULL);
+      ft._Busy = false;
+      ft._Running.store(false);
+      ft._Starting.store(false);
+      ft._Drained.broadcast();
+      ft._Mutex.unlock();
+    }
+  } cleanup;
+  ft._Thread.store(my_thread, std::memory_order_release);
+  my_thread->_ServiceThread = true;
+  ft._Unwinding = nullptr;
+  GC_set_finalizer_notifier(boehm_finalizer_notifier);
+  GC_set_finalize_on_demand(1);
+  while (true) {
+    ft._Mutex.lock();
+    while (!ft._Ready && !ft._Stop && !GC_should_invoke_finalizers()) ft._Wakeup.wait(ft._Mutex);
+    bool stop = ft._Stop;
+    ft._Ready = false;
+    ft._Busy = !stop;
+    ft._Mutex.unlock();
+    if (stop) break;
+    while (GC_should_invoke_finalizers() && !ft._Unwinding) GC_invoke_finalizers();
+    if (ft._Unwinding) {
+      std::exception_ptr unwinding = ft._Unwinding;
+      ft._Unwinding = nullptr;
+      std::rethrow_exception(unwinding);
+    }
+    ft._Batches.fetch_add(1, std::memory_order_relaxed);
+    ft._Mutex.lock();
+    ft._Busy = false;
+    ft._Drained.broadcast();
+    ft._Mutex.unlock();
+  }
+#endif
+}
+
+CL_DOCSTRING(R"dx(Stop the finalizer thread and wait for it to exit. Finalizers then run when
+the garbage collector finds them until the next call to finalize starts the thread again.)dx")
+DOCGROUP(clasp)
+CL_DEFUN void gctools__finalizer_thread_stop() {
+  finalizer_thread_stop();
+}
+
+CL_DOCSTRING(R"dx(Return true if the finalizer thread is running and, as a second value,
+the number of times it has woken up to run finalizers.)dx")
+DOCGROUP(clasp)
+CL_DEFUN core::T_mv gctools__finalizer_thread_status() {
+  FinalizerThread& ft = global_FinalizerThread;
+  return Values(core::T_sp(ft._Running.load() ? _lisp->_true() : nil<core::T_O>()),
+                core::Integer_O::create((uint64_t)ft._Batches.load()));
+}
+
+/*! Call finalizer_callback with no arguments when object is finalized.*/
+DOCGROUP(clasp)
+CL_DEFUN void gctools__finalize(core::T_sp object, core::T_sp finalizer_callback) {
+  //printf("%s:%d making a finalizer for %p calling %p\n", __FILE__, __LINE__, (void*)object.tagged_(), (void*)finalizer_callback.tagged_());
+  finalizer_thread_ensure();
+  finalizer_backpressure();
+  // Allocate outside of the shard lock
+  core::Cons_sp finalizers = core::Cons_O::create(finalizer_callback, nil<core::T_O>());
+  size_t shard = finalizer_shard(object);
+  {
+    mp::RAIIReadWriteLock<mp::Mutex> lock(global_FinalizerShards[shard]._Mutex);
+    core::WeakKeyHashTable_sp ht = finalizer_shard_table(shard);
+    core::List_sp orig_finalizers = ht->gethash(object, nil<core::T_O>());
+    finalizers->rplacd(orig_finalizers);
+    ht->hash_table_setf_gethash(object, finalizers);
+    // Register the finalizer with the GC
+#if defined(USE_BOEHM)
+    boehm_set_finalizer_list(object.tagged_(), finalizers.tagged_());
+#elif defined(USE_MPS)
+    if (object.generalp() || object.consp()) {
+      my_mps_finalize(object.raw_());
+    }
+#elif defined(USE_MMTK)
+    MISSING_GC_SUPPORT();
+#endif
+  }
+};
+
+DOCGROUP(clasp)
+CL_DEFUN void gctools__definalize(core::T_sp object) {
+//  printf("%s:%d erasing finalizers for %p\n", __FILE__, __LINE__, (void*)object.tagged_());
+  size_t shard = finalizer_shard(object);
+  mp::RAIIReadWriteLock<mp::Mutex> lock(global_FinalizerShards[shard]._Mutex);
+  core::WeakKeyHashTable_sp ht = finalizer_shard_table(shard);
+  if (ht->gethash(object)) ht->remhash(object);
+#if defined(USE_BOEHM)
+  boehm_clear_finalizer_list(object.tagged_());
+#elif defined(USE_MPS)
+  // Don't use mps_definalize here - definalize is taken care of by erasing the weak-key-hash-table
+  // entry above.  We may still need to get a finalization message if this class needs
+  // its destructor be called.
+  MISSING_GC_SUPPORT();
+#elif defined(USE_MMTK)
+  MISSING_GC_SUPPORT();
+#endif
+}
+
+};
@@ -37,6 +37,8 @@ int gcFunctions_after;
 #include <clasp/core/symbolTable.h>
 #include <clasp/gctools/gctoolsPackage.h>
 #include <clasp/gctools/gcFunctions.h>
+#include <clasp/gctools/metrics.h>
+#include <clasp/gctools/finalizers.h>
 #include <clasp/llvmo/intrinsics.h>
 #include <clasp/llvmo/code.h>
 #include <clasp/llvmo/llvmoExpose.h>
@@ -122,6 +124,7 @@ DOCGROUP(clasp)
 CL_DEFUN void gctools__accumulate_discriminating_function_compilation_seconds(double seconds) {
   global_DiscriminatingFunctionCompilationSeconds =
       global_DiscriminatingFunctionCompilationSeconds + seconds;
+  metrics::global_DiscriminatorCompileTime.record((uint64_t)(seconds*1.0e9));
 }
 
 DOCGROUP(clasp)
@@ -235,6 +238,49 @@ CL_DEFUN core::T_sp gctools__bytes_allocated() {
 
 
 
+CL_DOCSTRING(R"dx(Return the number of bytes the collector has in use. Zero if the collector can't tell.)dx")
+DOCGROUP(clasp)
+CL_DEFUN core::Integer_sp gctools__heap_in_use() {
+  return core::Integer_O::create((uint64_t)heap_in_use());
+}
+
+CL_DOCSTRING(R"dx(Return the Boehm collector's free space divisor: the heap grows by about the bytes in use divided by this before the next collection. It goes up as the heap nears the soft limit. NIL under other collectors.)dx")
+DOCGROUP(clasp)
+CL_DEFUN core::T_sp gctools__free_space_divisor() {
+#if defined(USE_BOEHM)
+  return core::Integer_O::create((uint64_t)GC_get_free_space_divisor());
+#else
+  return nil<core::T_O>();
+#endif
+}
+
+CL_DOCSTRING(R"dx(Return the soft heap limit in bytes set by --heap-max, CLASP_HEAP_MAX or SET-HEAP-LIMIT, or NIL if there is none.)dx")
+DOCGROUP(clasp)
+CL_DEFUN core::T_sp gctools__heap_limit() {
+  size_t limit = global_heap_max.load();
+  if (limit == 0) return nil<core::T_O>();
+  return core::Integer_O::create((uint64_t)limit);
+}
+
+CL_LAMBDA(limit)
+CL_DOCSTRING(R"dx(Set the soft heap limit to LIMIT bytes, or remove it if LIMIT is NIL. When a
+collection leaves more than LIMIT bytes in use, the thread that collected (the main
+thread, if that was the finalizer thread or an executor worker) collects once more and
+then signals EXT:HEAP-LIMIT-EXCEEDED, a storage-condition. Past half of LIMIT the
+collector holds back on growing the heap. Under MMTk the heap size is
+fixed at startup and this has no effect. Return LIMIT.)dx")
+DOCGROUP(clasp)
+CL_DEFUN core::T_sp gctools__set_heap_limit(core::T_sp limit) {
+  if (limit.nilp()) {
+    global_heap_max.store(0);
+  } else if (limit.fixnump() && limit.unsafe_fixnum() > 0) {
+    global_heap_max.store((size_t)limit.unsafe_fixnum());
+  } else {
+    TYPE_ERROR(limit, core::Cons_O::createList(cl::_sym_or, cl::_sym_null, core::Cons_O::createList(cl::_sym_integer, core::make_fixnum(1))));
+  }
+  return limit;
+}
+
 CL_DOCSTRING(R"dx(Return the next unused kind)dx")
 DOCGROUP(clasp)
 CL_DEFUN size_t core__next_unused_kind() {
@@ -595,6 +641,7 @@ The following &KEY arguments are defined:
 DOCGROUP(clasp)
 CL_DEFUN void gctools__save_lisp_and_die(core::T_sp filename, core::T_sp executable) {
 #ifdef USE_PRECISE_GC
+  finalizer_thread_stop();
   throw(core::SaveLispAndDie(gc::As<core::String_sp>(filename)->get_std_string(), executable.notnilp(),
     globals_->_Bundle->_Directories->_LibDir));
 #else
@@ -751,50 +798,6 @@ CL_DEFUN void gctools__function_call_count_profiler(core::T_sp func) {
 };
 #endif // DEBUG_FUNCTION_CALL_COUNTER
 
-namespace gctools {
-/*! Call finalizer_callback with no arguments when object is finalized.*/
-DOCGROUP(clasp)
-CL_DEFUN void gctools__finalize(core::T_sp object, core::T_sp finalizer_callback) {
-  //printf("%s:%d making a finalizer for %p calling %p\n", __FILE__, __LINE__, (void*)object.tagged_(), (void*)finalizer_callback.tagged_());
-  WITH_READ_WRITE_LOCK(globals_->_FinalizersMutex);
-  core::WeakKeyHashTable_sp ht = _lisp->_Roots._Finalizers;
-  core::List_sp orig_finalizers = ht->gethash(object,nil<core::T_O>());
-  core::List_sp finalizers = core::Cons_O::create(finalizer_callback,orig_finalizers);
-//  printf("%s:%d      Adding finalizer to list new length --> %lu   list head %p\n", __FILE__, __LINE__, core::cl__length(finalizers), (void*)finalizers.tagged_());
-  ht->hash_table_setf_gethash(object,finalizers);
-    // Register the finalizer with the GC
-#if defined(USE_BOEHM)
-  boehm_set_finalizer_list(object.tagged_(),finalizers.tagged_());
-#elif defined(USE_MPS)
-  if (object.generalp() || object.consp()) {
-    my_mps_finalize(object.raw_());
-  }
-#elif defined(USE_MMTK)
-  MISSING_GC_SUPPORT();
-#endif
-};
-
-DOCGROUP(clasp)
-CL_DEFUN void gctools__definalize(core::T_sp object) {
-//  printf("%s:%d erasing finalizers for %p\n", __FILE__, __LINE__, (void*)object.tagged_());
-  WITH_READ_WRITE_LOCK(globals_->_FinalizersMutex);
-  core::WeakKeyHashTable_sp ht = _lisp->_Roots._Finalizers;
-  if (ht->gethash(object)) ht->remhash(object);
-#if defined(USE_BOEHM)
-  boehm_clear_finalizer_list(object.tagged_());
-#elif defined(USE_MPS)
-  // Don't use mps_definalize here - definalize is taken care of by erasing the weak-key-hash-table
-  // entry above.  We may still need to get a finalization message if this class needs
-  // its destructor be called.
-  MISSING_GC_SUPPORT();
-#elif defined(USE_MMTK)
-  MISSING_GC_SUPPORT();
-#endif
-}
-
-};
-
-
 namespace gctools {
 
 };
@@ -831,6 +834,7 @@ CL_DEFUN void gctools__garbage_collect() {
 #if defined(USE_BOEHM)
   GC_gcollect();
   GC_invoke_finalizers();
+  finalizer_thread_drain();
 #elif defined(USE_MPS)
   mps_arena_collect(global_arena);
   size_t finalizations;
@@ -899,6 +903,12 @@ bool debugging_configuration(bool setFeatures, bool buildReport, stringstream& s
 #endif
   if (buildReport) ss << (fmt::sprintf("USE_BOEHM_MEMORY_MARKER = %s\n" , (use_boehm_memory_marker ? "**DEFINED**" : "undefined") ));
 
+  bool boehm_parallel_mark = false;
+#ifdef BOEHM_PARALLEL_MARK
+  boehm_parallel_mark = true;
+#endif
+  if (buildReport) ss << (fmt::sprintf("BOEHM_PARALLEL_MARK = %s\n" , (boehm_parallel_mark ? "**DEFINED**" : "undefined") ));
+
   bool mps_recognize_zero_tags = false;
 #ifdef MPS_RECOGNIZE_ZERO_TAGS
   mps_recognize_zero_tags = true;
@@ -769,6 +769,7 @@ void dumpBoehmLayoutTables(FILE* fout) {
   Init__fixed_field(core::Symbol_O,3,SMART_PTR_OFFSET,_Function);
   Init__fixed_field(core::Symbol_O,4,SMART_PTR_OFFSET,_SetfFunction);
   Init__fixed_field(core::Symbol_O,5,SMART_PTR_OFFSET,_PropertyList);
+  Init__fixed_field(core::Symbol_O,6,SMART_PTR_OFFSET,_Sysprops);
 
   Init_class_kind(core::FuncallableInstance_O);
   Init__fixed_field(core::FuncallableInstance_O,0,SMART_PTR_OFFSET,_Rack);
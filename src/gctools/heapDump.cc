@@ -0,0 +1,530 @@
+/*
+    File: heapDump.cc
+*/
+
+/*
+Copyright (c) 2014, Christian E. Schafmeister
+
+CLASP is free software; you can redistribute it and/or
+modify it under the terms of the GNU Library General Public
+License as published by the Free Software Foundation; either
+version 2 of the License, or (at your option) any later version.
+
+See directory 'clasp/licenses' for full details.
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+/* -^- */
+
+// Write the object graph to a file and find out what is keeping memory alive.
+//
+// gctools:heap-dump walks the heap from the roots with the same walkers that
+// snapshot save uses, so it works in a release build.  Every object is written with
+// its type and size, followed by the pointers between objects and the roots.
+// Instances are typed by the name of their class so that every defclass and
+// defstruct gets its own line rather than all of them being core::Instance_O.
+//
+// gctools:heap-dump-analyze reads a dump, computes the dominator tree with
+// Lengauer-Tarjan and from it the retained size of every object: the bytes that
+// would be freed if that object became unreachable.  Per type the retained size
+// only counts objects that are not dominated by another object of the same type,
+// so a linked list of nodes is not counted once per node.
+//
+// Besides the collector's roots, the global value of every symbol and every
+// object the calling thread's stack points at are written as roots of their
+// own, so that what a global variable or a running function holds on to is
+// attributed to it rather than to _lisp, which reaches every symbol through
+// its packages. Other threads keep running during the dump, so their stacks
+// can't be read and aren't roots.
+//
+// The file format is
+//   "CLHEAPD1"
+//   u64 types, then for each type: u32 length, name bytes
+//   u64 objects, then for each object: u32 type, u64 size
+//   u64 edges, u64 edge-start[objects+1], u32 edge[edges]
+//   u64 roots, then for each root: u32 kind, u64 index, u32 object, u32 length, name bytes
+
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <unordered_set>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <clasp/core/foundation.h>
+#include <clasp/core/object.h>
+#include <clasp/core/lisp.h>
+#include <clasp/core/symbol.h>
+#include <clasp/core/instance.h>
+#include <clasp/core/array.h>
+#include <clasp/core/lispStream.h>
+#include <clasp/core/ql.h>
+#include <clasp/core/designators.h>
+#include <clasp/gctools/gc_interface.h>
+#include <clasp/gctools/memoryManagement.h>
+#include <clasp/gctools/heapDump.h>
+#include <clasp/core/wrappers.h>
+
+namespace gctools {
+
+#define HEAP_DUMP_MAGIC "CLHEAPD1"
+
+struct HeapDumpTypes {
+  std::vector<std::string>            _Names;
+  std::map<size_t, uint32_t>          _Stamps;
+  std::map<core::Instance_O*, uint32_t> _Classes;
+  uint32_t intern(const std::string& name) {
+    this->_Names.push_back(name);
+    return this->_Names.size() - 1;
+  }
+};
+
+static std::string heap_dump_stamp_name(size_t nowhere) {
+  if (nowhere < global_unshifted_nowhere_stamp_names.size() && global_unshifted_nowhere_stamp_names[nowhere] != "")
+    return global_unshifted_nowhere_stamp_names[nowhere];
+  return fmt::sprintf("stamp-%lu", nowhere);
+}
+
+static uint32_t heap_dump_type(HeapDumpTypes& types, Header_s* header) {
+  size_t nowhere = header->_stamp_wtag_mtag.nowhere_stamp();
+  if (!header->_stamp_wtag_mtag.consObjectP() && !header->_stamp_wtag_mtag.weakObjectP()) {
+    core::T_sp obj((gctools::Tagged)tag_general((core::T_O*)HeaderPtrToGeneralPtr<core::T_O>(header)));
+    if (gc::IsA<core::Instance_sp>(obj)) {
+      core::T_sp cls = gc::As_unsafe<core::Instance_sp>(obj)->_Class;
+      if (gc::IsA<core::Instance_sp>(cls)) {
+        core::Instance_sp icls = gc::As_unsafe<core::Instance_sp>(cls);
+        auto it = types._Classes.find(&*icls);
+        if (it != types._Classes.end()) return it->second;
+        core::T_sp name = icls->instanceRef(core::Instance_O::REF_CLASS_CLASS_NAME);
+        std::string sname = gc::IsA<core::Symbol_sp>(name)
+          ? gc::As_unsafe<core::Symbol_sp>(name)->formattedName(true)
+          : heap_dump_stamp_name(nowhere);
+        uint32_t type = types.intern(sname);
+        types._Classes[&*icls] = type;
+        return type;
+      }
+    }
+  }
+  auto it = types._Stamps.find(nowhere);
+  if (it != types._Stamps.end()) return it->second;
+  uint32_t type = types.intern(heap_dump_stamp_name(nowhere));
+  types._Stamps[nowhere] = type;
+  return type;
+}
+
+template <typename T>
+static void heap_dump_write(FILE* fout, const T& value) {
+  fwrite(&value, sizeof(T), 1, fout);
+}
+
+static void heap_dump_write_string(FILE* fout, const std::string& str) {
+  heap_dump_write(fout, (uint32_t)str.size());
+  fwrite(str.data(), 1, str.size(), fout);
+}
+
+template <typename T>
+static T heap_dump_read(FILE* fin, const std::string& filename) {
+  T value;
+  if (fread(&value, sizeof(T), 1, fin) != 1) {
+    fclose(fin);
+    SIMPLE_ERROR(("The heap dump %s is truncated"), filename);
+  }
+  return value;
+}
+
+static std::string heap_dump_read_string(FILE* fin, const std::string& filename) {
+  uint32_t len = heap_dump_read<uint32_t>(fin, filename);
+  std::string str(len, '\0');
+  if (len && fread(&str[0], 1, len, fin) != len) {
+    fclose(fin);
+    SIMPLE_ERROR(("The heap dump %s is truncated"), filename);
+  }
+  return str;
+}
+
+static uint32_t heap_dump_find(HeapGraph& graph, uintptr_t word) {
+  uintptr_t tag = word & ptag_mask;
+  Header_s* header;
+  if (tag == general_tag) header = (Header_s*)GeneralPtrToHeaderPtr((void*)(word & ptr_mask));
+  else if (tag == cons_tag) header = (Header_s*)ConsPtrToHeaderPtr((void*)(word & ptr_mask));
+  else return ~(uint32_t)0;
+  auto it = graph._Ids.find(header);
+  return (it == graph._Ids.end()) ? ~(uint32_t)0 : it->second;
+}
+
+// Add a root for the global value of every symbol in the graph and for every
+// object in it that the stack between stackLow and the top of this thread's
+// stack points at. Only words that point exactly at an object already in the
+// graph count, so stale words on the stack can't make up objects.
+static void heap_dump_extra_roots(HeapGraph& graph, std::vector<std::string>& rootNames, void* stackLow) {
+  size_t nobjects = graph._Objects.size();
+  for (size_t ii = 0; ii < nobjects; ++ii) {
+    Header_s* header = graph._Objects[ii];
+    if (!header->_stamp_wtag_mtag.stampP()) continue;
+    core::T_sp obj((gctools::Tagged)tag_general((core::T_O*)HeaderPtrToGeneralPtr<core::T_O>(header)));
+    if (!gc::IsA<core::Symbol_sp>(obj)) continue;
+    core::Symbol_sp sym = gc::As_unsafe<core::Symbol_sp>(obj);
+    // A symbol, NIL included, belongs to its package rather than to a variable
+    // that happens to hold it
+    core::T_sp val = sym->globalValue();
+    if (gc::IsA<core::Symbol_sp>(val)) continue;
+    uint32_t value = heap_dump_find(graph, (uintptr_t)val.raw_());
+    if (value == ~(uint32_t)0) continue;
+    graph._Roots.push_back(HeapGraph::Root{SymbolValueRoot, ii, value});
+    rootNames.push_back(sym->formattedName(true));
+  }
+  std::unordered_set<uint32_t> seen;
+  for (uintptr_t* cur = (uintptr_t*)stackLow; cur < (uintptr_t*)my_thread_low_level->_StackTop; ++cur) {
+    uint32_t object = heap_dump_find(graph, *cur);
+    if (object == ~(uint32_t)0 || !seen.insert(object).second) continue;
+    graph._Roots.push_back(HeapGraph::Root{StackRoot, (size_t)((uintptr_t*)my_thread_low_level->_StackTop - cur), object});
+    rootNames.push_back("stack");
+  }
+}
+
+CL_LAMBDA(filename)
+CL_DOCSTRING(R"dx(Write every object reachable from the roots, its type, its size and the pointers
+between objects to FILENAME. The global value of every symbol and the objects the calling thread's
+stack points at are roots too. Objects that are only referenced from thread stacks are not included
+and weak pointers are not followed. Returns the number of objects written.
+See heap-dump-analyze and heap-dump-report.)dx")
+DOCGROUP(clasp)
+CL_DEFUN size_t gctools__heap_dump(core::String_sp filename) {
+#ifdef USE_MMTK
+  SIMPLE_ERROR(("heap-dump needs a collector that can be parked and MMTk can't be"));
+#endif
+  std::string fname = filename->get_std_string();
+  FILE* fout = fopen(fname.c_str(), "w");
+  if (!fout) SIMPLE_ERROR(("Could not open %s for writing the heap dump"), fname);
+  HeapGraph graph;
+  HeapDumpTypes types;
+  std::vector<uint32_t> objectTypes;
+  std::vector<uint64_t> objectSizes;
+  std::vector<std::string> rootNames;
+  {
+    // The graph holds raw Header_s pointers, so nothing may be collected or
+    // moved until every object has been typed and sized. The class names are
+    // read from the objects in here but they are C++ strings, nothing is
+    // allocated from the collector while it is parked.
+    SafeGCPark park;
+    buildHeapGraph(graph);
+    objectTypes.resize(graph._Objects.size());
+    objectSizes.resize(graph._Objects.size());
+    for (size_t ii = 0; ii < graph._Objects.size(); ++ii) {
+      objectTypes[ii] = heap_dump_type(types, graph._Objects[ii]);
+      objectSizes[ii] = objectSize(graph._Objects[ii]);
+    }
+    for (auto& root : graph._Roots) {
+      if (root._Type == SymbolRoot && root._Index < (size_t)global_symbol_count) {
+        rootNames.push_back(global_symbols[root._Index]->formattedName(true));
+      } else {
+        rootNames.push_back("_lisp");
+      }
+    }
+    void* stackLow = &stackLow;
+    heap_dump_extra_roots(graph, rootNames, stackLow);
+  }
+  // Only indices are used from here on.
+  graph._Ids.clear();
+  graph._Objects.clear();
+  fwrite(HEAP_DUMP_MAGIC, 1, 8, fout);
+  heap_dump_write(fout, (uint64_t)types._Names.size());
+  for (auto& name : types._Names) heap_dump_write_string(fout, name);
+  heap_dump_write(fout, (uint64_t)objectTypes.size());
+  for (size_t ii = 0; ii < objectTypes.size(); ++ii) {
+    heap_dump_write(fout, objectTypes[ii]);
+    heap_dump_write(fout, objectSizes[ii]);
+  }
+  heap_dump_write(fout, (uint64_t)graph._Edges.size());
+  fwrite(graph._EdgeStart.data(), sizeof(uint64_t), graph._EdgeStart.size(), fout);
+  fwrite(graph._Edges.data(), sizeof(uint32_t), graph._Edges.size(), fout);
+  heap_dump_write(fout, (uint64_t)graph._Roots.size());
+  for (size_t ii = 0; ii < graph._Roots.size(); ++ii) {
+    heap_dump_write(fout, (uint32_t)graph._Roots[ii]._Type);
+    heap_dump_write(fout, (uint64_t)graph._Roots[ii]._Index);
+    heap_dump_write(fout, graph._Roots[ii]._Object);
+    heap_dump_write_string(fout, rootNames[ii]);
+  }
+  bool failed = ferror(fout);
+  if (fclose(fout) != 0 || failed) SIMPLE_ERROR(("Could not write the heap dump to %s"), fname);
+  return objectTypes.size();
+}
+
+struct HeapDumpFile {
+  std::vector<std::string> _TypeNames;
+  std::vector<uint32_t>    _Types;
+  std::vector<uint64_t>    _Sizes;
+  std::vector<uint64_t>    _EdgeStart;
+  std::vector<uint32_t>    _Edges;
+  std::vector<uint32_t>    _Roots;
+  std::vector<std::string> _RootNames;
+};
+
+static void heap_dump_load(const std::string& fname, HeapDumpFile& dump) {
+  FILE* fin = fopen(fname.c_str(), "r");
+  if (!fin) SIMPLE_ERROR(("Could not open the heap dump %s"), fname);
+  char magic[8];
+  if (fread(magic, 1, 8, fin) != 8 || strncmp(magic, HEAP_DUMP_MAGIC, 8) != 0) {
+    fclose(fin);
+    SIMPLE_ERROR(("%s is not a heap dump"), fname);
+  }
+  uint64_t ntypes = heap_dump_read<uint64_t>(fin, fname);
+  for (uint64_t ii = 0; ii < ntypes; ++ii) dump._TypeNames.push_back(heap_dump_read_string(fin, fname));
+  uint64_t nobjects = heap_dump_read<uint64_t>(fin, fname);
+  dump._Types.resize(nobjects);
+  dump._Sizes.resize(nobjects);
+  for (uint64_t ii = 0; ii < nobjects; ++ii) {
+    dump._Types[ii] = heap_dump_read<uint32_t>(fin, fname);
+    dump._Sizes[ii] = heap_dump_read<uint64_t>(fin, fname);
+    if (dump._Types[ii] >= ntypes) {
+      fclose(fin);
+      SIMPLE_ERROR(("The heap dump %s is corrupt"), fname);
+    }
+  }
+  uint64_t nedges = heap_dump_read<uint64_t>(fin, fname);
+  dump._EdgeStart.resize(nobjects + 1);
+  dump._Edges.resize(nedges);
+  if (fread(dump._EdgeStart.data(), sizeof(uint64_t), nobjects + 1, fin) != nobjects + 1 ||
+      fread(dump._Edges.data(), sizeof(uint32_t), nedges, fin) != nedges) {
+    fclose(fin);
+    SIMPLE_ERROR(("The heap dump %s is truncated"), fname);
+  }
+  uint64_t nroots = heap_dump_read<uint64_t>(fin, fname);
+  for (uint64_t ii = 0; ii < nroots; ++ii) {
+    heap_dump_read<uint32_t>(fin, fname); // kind
+    heap_dump_read<uint64_t>(fin, fname); // index
+    dump._Roots.push_back(heap_dump_read<uint32_t>(fin, fname));
+    dump._RootNames.push_back(heap_dump_read_string(fin, fname));
+  }
+  fclose(fin);
+  for (uint64_t ii = 0; ii < nobjects; ++ii) {
+    if (dump._EdgeStart[ii] > dump._EdgeStart[ii + 1] || dump._EdgeStart[ii + 1] > nedges)
+      SIMPLE_ERROR(("The heap dump %s is corrupt"), fname);
+  }
+  for (auto edge : dump._Edges) if (edge >= nobjects) SIMPLE_ERROR(("The heap dump %s is corrupt"), fname);
+  for (auto root : dump._Roots) if (root >= nobjects) SIMPLE_ERROR(("The heap dump %s is corrupt"), fname);
+}
+
+/*! Compute the immediate dominator of every vertex with the simple version of
+    Lengauer-Tarjan.  Vertex 0 is a super root that points at every root and
+    vertex v+1 is object v of the dump.  Returns the vertices in depth first order; unreachable vertices are left out and have an idom of -1. */
+static void heap_dump_dominators(const HeapDumpFile& dump, std::vector<int64_t>& idom, std::vector<int64_t>& order) {
+  size_t nobjects = dump._Types.size();
+  size_t nvertices = nobjects + 1;
+  auto successors = [&dump](size_t v, size_t& begin, size_t& end) -> const uint32_t* {
+    if (v == 0) {
+      begin = 0;
+      end = dump._Roots.size();
+      return dump._Roots.data();
+    }
+    begin = dump._EdgeStart[v - 1];
+    end = dump._EdgeStart[v];
+    return dump._Edges.data();
+  };
+  // Predecessors as compressed rows
+  std::vector<uint64_t> predStart(nvertices + 2, 0);
+  for (size_t v = 0; v < nvertices; ++v) {
+    size_t begin, end;
+    const uint32_t* succ = successors(v, begin, end);
+    for (size_t ii = begin; ii < end; ++ii) predStart[succ[ii] + 2]++;
+  }
+  for (size_t v = 1; v < predStart.size(); ++v) predStart[v] += predStart[v - 1];
+  std::vector<uint32_t> preds(predStart.back());
+  for (size_t v = 0; v < nvertices; ++v) {
+    size_t begin, end;
+    const uint32_t* succ = successors(v, begin, end);
+    for (size_t ii = begin; ii < end; ++ii) preds[predStart[succ[ii] + 1]++] = v;
+  }
+  // Depth first numbering
+  std::vector<int64_t> semi(nvertices, -1);
+  std::vector<int64_t> parent(nvertices, -1);
+  order.clear();
+  std::vector<std::pair<size_t, size_t>> stack;
+  semi[0] = 0;
+  order.push_back(0);
+  stack.emplace_back(0, 0);
+  while (!stack.empty()) {
+    size_t v = stack.back().first;
+    size_t begin, end;
+    const uint32_t* succ = successors(v, begin, end);
+    size_t& next = stack.back().second;
+    if (begin + next >= end) {
+      stack.pop_back();
+      continue;
+    }
+    size_t w = succ[begin + next++] + 1;
+    if (semi[w] >= 0) continue;
+    semi[w] = order.size();
+    parent[w] = v;
+    order.push_back(w);
+    stack.emplace_back(w, 0);
+  }
+  std::vector<int64_t> ancestor(nvertices, -1);
+  std::vector<int64_t> label(nvertices);
+  for (size_t v = 0; v < nvertices; ++v) label[v] = v;
+  std::vector<int64_t> bucketHead(nvertices, -1);
+  std::vector<int64_t> bucketNext(nvertices, -1);
+  idom.assign(nvertices, -1);
+  std::vector<int64_t> path;
+  auto eval = [&](int64_t v) -> int64_t {
+    if (ancestor[v] < 0) return v;
+    // Compress the path from v to the root of its forest tree
+    path.clear();
+    for (int64_t x = v; ancestor[ancestor[x]] >= 0; x = ancestor[x]) path.push_back(x);
+    for (auto it = path.rbegin(); it != path.rend(); ++it) {
+      int64_t x = *it;
+      int64_t a = ancestor[x];
+      if (semi[label[a]] < semi[label[x]]) label[x] = label[a];
+      ancestor[x] = ancestor[a];
+    }
+    return label[v];
+  };
+  for (size_t ii = order.size() - 1; ii > 0; --ii) {
+    int64_t w = order[ii];
+    for (uint64_t pp = predStart[w]; pp < predStart[w + 1]; ++pp) {
+      int64_t v = preds[pp];
+      if (semi[v] < 0) continue;
+      int64_t u = eval(v);
+      if (semi[u] < semi[w]) semi[w] = semi[u];
+    }
+    int64_t s = order[semi[w]];
+    bucketNext[w] = bucketHead[s];
+    bucketHead[s] = w;
+    int64_t p = parent[w];
+    ancestor[w] = p;
+    for (int64_t v = bucketHead[p]; v >= 0; v = bucketNext[v]) {
+      int64_t u = eval(v);
+      idom[v] = (semi[u] < semi[v]) ? u : p;
+    }
+    bucketHead[p] = -1;
+  }
+  for (size_t ii = 1; ii < order.size(); ++ii) {
+    int64_t w = order[ii];
+    if (idom[w] != order[semi[w]]) idom[w] = idom[idom[w]];
+  }
+}
+
+struct HeapDumpTypeTotals {
+  uint32_t _Type;
+  size_t   _Count = 0;
+  uint64_t _Shallow = 0;
+  uint64_t _Retained = 0;
+};
+
+CL_LAMBDA(filename &key (limit 30))
+CL_DOCSTRING(R"dx(Read a heap dump written by heap-dump and compute retained sizes from its dominator tree.
+Returns two values: a list of (type-name count shallow-bytes retained-bytes) for the LIMIT types
+that retain the most memory, and a list of (root-name retained-bytes) for the LIMIT roots that
+retain the most memory. The retained bytes of a type only count the objects that are not
+retained by another object of the same type.)dx")
+DOCGROUP(clasp)
+CL_DEFUN core::T_mv gctools__heap_dump_analyze(core::String_sp filename, size_t limit) {
+  HeapDumpFile dump;
+  heap_dump_load(filename->get_std_string(), dump);
+  size_t nobjects = dump._Types.size();
+  std::vector<int64_t> idom;
+  std::vector<int64_t> order;
+  heap_dump_dominators(dump, idom, order);
+  // Every vertex's dominator comes before it in depth first order
+  std::vector<uint64_t> retained(nobjects + 1, 0);
+  for (size_t v = 1; v <= nobjects; ++v) retained[v] = dump._Sizes[v - 1];
+  for (size_t ii = order.size() - 1; ii > 0; --ii) {
+    int64_t w = order[ii];
+    retained[idom[w]] += retained[w];
+  }
+  // Walk the dominator tree keeping count of how many ancestors have each type
+  std::vector<HeapDumpTypeTotals> totals(dump._TypeNames.size());
+  for (size_t tt = 0; tt < totals.size(); ++tt) totals[tt]._Type = tt;
+  std::vector<uint64_t> childStart(nobjects + 3, 0);
+  for (size_t ii = 1; ii < order.size(); ++ii) childStart[idom[order[ii]] + 2]++;
+  for (size_t v = 1; v < childStart.size(); ++v) childStart[v] += childStart[v - 1];
+  std::vector<uint32_t> children(order.size());
+  for (size_t ii = 1; ii < order.size(); ++ii) children[childStart[idom[order[ii]] + 1]++] = order[ii];
+  std::vector<size_t> typeDepth(totals.size(), 0);
+  std::vector<std::pair<int64_t, bool>> stack;
+  stack.emplace_back(0, true);
+  while (!stack.empty()) {
+    auto [v, enter] = stack.back();
+    stack.pop_back();
+    if (v == 0) {
+      for (uint64_t cc = childStart[v]; cc < childStart[v + 1]; ++cc) stack.emplace_back(children[cc], true);
+      continue;
+    }
+    uint32_t type = dump._Types[v - 1];
+    if (!enter) {
+      typeDepth[type]--;
+      continue;
+    }
+    HeapDumpTypeTotals& total = totals[type];
+    total._Count++;
+    total._Shallow += dump._Sizes[v - 1];
+    if (typeDepth[type] == 0) total._Retained += retained[v];
+    typeDepth[type]++;
+    stack.emplace_back(v, false);
+    for (uint64_t cc = childStart[v]; cc < childStart[v + 1]; ++cc) stack.emplace_back(children[cc], true);
+  }
+  std::sort(totals.begin(), totals.end(), [](const HeapDumpTypeTotals& a, const HeapDumpTypeTotals& b) {
+    return a._Retained > b._Retained;
+  });
+  ql::list types;
+  for (size_t ii = 0; ii < totals.size() && ii < limit; ++ii) {
+    if (totals[ii]._Count == 0) break;
+    types << core::Cons_O::createList(core::SimpleBaseString_O::make(dump._TypeNames[totals[ii]._Type]),
+                                      core::make_fixnum(totals[ii]._Count),
+                                      core::Integer_O::create((uint64_t)totals[ii]._Shallow),
+                                      core::Integer_O::create((uint64_t)totals[ii]._Retained));
+  }
+  std::vector<std::pair<uint64_t, size_t>> roots;
+  std::vector<bool> counted(dump._Types.size(), false);
+  for (size_t rr = 0; rr < dump._Roots.size(); ++rr) {
+    // Only count a root that dominates its object, and only the first root
+    // of an object, so shared objects aren't counted twice
+    uint32_t object = dump._Roots[rr];
+    if (idom[object + 1] == 0 && !counted[object]) {
+      counted[object] = true;
+      roots.emplace_back(retained[object + 1], rr);
+    }
+  }
+  std::sort(roots.begin(), roots.end(), [](auto& a, auto& b) { return a.first > b.first; });
+  ql::list rootList;
+  for (size_t ii = 0; ii < roots.size() && ii < limit; ++ii) {
+    rootList << core::Cons_O::createList(core::SimpleBaseString_O::make(dump._RootNames[roots[ii].second]),
+                                         core::Integer_O::create((uint64_t)roots[ii].first));
+  }
+  return Values(types.cons(), rootList.cons());
+}
+
+CL_LAMBDA(filename &key (output t) (limit 30))
+CL_DOCSTRING(R"dx(Write the LIMIT types and roots that retain the most memory in the heap dump FILENAME
+to the stream designator OUTPUT. See heap-dump-analyze.)dx")
+DOCGROUP(clasp)
+CL_DEFUN void gctools__heap_dump_report(core::String_sp filename, core::T_sp output, size_t limit) {
+  core::T_sp stream = core::coerce::outputStreamDesignator(output);
+  core::T_mv result = gctools__heap_dump_analyze(filename, limit);
+  core::List_sp types = result;
+  core::List_sp roots = result.second();
+  core::clasp_write_string(fmt::sprintf("%16s %16s %10s  %s\n", "retained", "shallow", "count", "type"), stream);
+  for (auto cur : types) {
+    core::List_sp entry = CONS_CAR(cur);
+    core::clasp_write_string(fmt::sprintf("%16s %16s %10s  %s\n",
+                                          core::_rep_(core::oFourth(entry)), core::_rep_(core::oThird(entry)), core::_rep_(core::oSecond(entry)),
+                                          gc::As<core::String_sp>(core::oCar(entry))->get_std_string()), stream);
+  }
+  core::clasp_write_string(fmt::sprintf("\n%16s  %s\n", "retained", "root"), stream);
+  for (auto cur : roots) {
+    core::List_sp entry = CONS_CAR(cur);
+    core::clasp_write_string(fmt::sprintf("%16s  %s\n", core::_rep_(core::oSecond(entry)),
+                                          gc::As<core::String_sp>(core::oCar(entry))->get_std_string()), stream);
+  }
+}
+
+};
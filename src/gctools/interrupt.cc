@@ -20,6 +20,14 @@ SYMBOL_EXPORT_SC_(CorePkg,terminal_interrupt);
 SYMBOL_EXPORT_SC_(ExtPkg,illegal_instruction);
 SYMBOL_EXPORT_SC_(ExtPkg,segmentation_violation);
 SYMBOL_EXPORT_SC_(ExtPkg,bus_error);
+SYMBOL_EXPORT_SC_(ExtPkg,heap_limit_exceeded);
+
+/*! The number of threads with a safepoint request outstanding. Compiled
+    code loads this at function entries and loop headers and only calls
+    cc_safepoint when it is nonzero, so a poll costs a load and a branch. */
+extern "C" {
+std::atomic<uint32_t> clasp_safepoint_requests(0);
+};
 
 namespace gctools {
 
@@ -131,12 +139,19 @@ void clasp_interrupt_process(mp::Process_sp process, core::T_sp function)
          * If FUNCTION is NIL, we just intend to wake up the process
          * from some call to ecl_musleep() Queue the interrupt for any
          * process stage that can potentially receive a signal  */
-  if (function.notnilp() && (process->_Phase >= mp::Nascent)) {
+  if (function.notnilp() && (process->_Phase != mp::Exited)) {
     // printf("%s:%d clasp_interrupt_process queuing signal\n", __FILE__, __LINE__);
     function = core::coerce::functionDesignator(function);
     queue_signal_or_interrupt(process->_ThreadInfo, function, true);
+    request_safepoint(process->_ThreadInfo);
+    // The thread drops its request as it exits (see start_thread_inner); if it
+    // got there before our request, drop it here, or the count stays up forever
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (process->_Phase == mp::Exited) clear_safepoint_request(process->_ThreadInfo);
   }
-        /* ... but only deliver if the process is still alive */
+        /* ... but only deliver if the process is still alive.  The signal
+           only breaks blocking system calls; the interrupt itself runs at
+           the next safepoint poll of the thread. */
   if (process->_Phase == mp::Active) do_interrupt_thread(process);
 }
 
@@ -175,6 +190,33 @@ static void queue_signal_or_interrupt(core::ThreadLocalState* thread, core::T_sp
 
 static void queue_signal(int signo) {
   queue_signal_or_interrupt(my_thread, core::clasp_make_fixnum(signo), false);
+  request_safepoint(my_thread);
+}
+
+// SAFEPOINTS
+// A request is a per-thread flag plus the global count that compiled code
+// polls.  Both are plain atomics, so requests can be made from signal
+// handlers and from the collector's callbacks.
+
+void request_safepoint(core::ThreadLocalState* thread) {
+  if (!thread->_SafepointRequested.exchange(true, std::memory_order_acq_rel))
+    clasp_safepoint_requests.fetch_add(1, std::memory_order_release);
+}
+
+void clear_safepoint_request(core::ThreadLocalState* thread) {
+  if (__builtin_expect(thread->_SafepointRequested.load(std::memory_order_relaxed), 0)
+      && thread->_SafepointRequested.exchange(false, std::memory_order_acq_rel))
+    clasp_safepoint_requests.fetch_sub(1, std::memory_order_release);
+}
+
+// The slow path of a compiled safepoint poll - some thread has a request.
+// If it isn't this one, or Lisp has interrupts disabled, return at once;
+// WITHOUT-INTERRUPTS runs what is pending when it exits.
+void safepoint() {
+  core::ThreadLocalState* thread = my_thread;
+  if (!thread->_SafepointRequested.load(std::memory_order_acquire)
+      || core::_sym_STARinterrupts_enabledSTAR->symbolValue().nilp()) return;
+  handle_all_queued_interrupts();
 }
 
 // Pop a thing from the queue.
@@ -206,9 +248,32 @@ void handle_queued_signal_or_interrupt(core::T_sp signal_code) {
   }
 }
 
+// A collection left the heap over the soft limit and flagged this thread to
+// handle it - see heap_after_collection. Call ext:heap-limit-exceeded unless
+// Lisp has interrupts disabled, in which case ask again for the next safepoint.
+static void handle_heap_limit() {
+  if (!ext::_sym_heap_limit_exceeded->fboundp()) return;
+  if (core::_sym_STARinterrupts_enabledSTAR->symbolValue().nilp()) {
+    request_safepoint(my_thread);
+    return;
+  }
+  my_thread->_HeapLimitPending.store(false, std::memory_order_relaxed);
+  struct HeapLimitHandling {
+    HeapLimitHandling() { global_heap_limit_handling.store(true); };
+    ~HeapLimitHandling() { global_heap_limit_handling.store(false); };
+  } handling;
+  core::eval::funcall(ext::_sym_heap_limit_exceeded);
+}
+
 // Do all the queued actions, emptying the queue.
 void handle_all_queued_interrupts()
 {
+  clear_safepoint_request(my_thread);
+  if (__builtin_expect(my_thread->_HeapLimitPending.load(std::memory_order_acquire), 0)) handle_heap_limit();
+  if (__builtin_expect(my_thread->_SampleMergePending.load(std::memory_order_relaxed), 0)) {
+    my_thread->_SampleMergePending.store(false, std::memory_order_relaxed);
+    allocation_sampler_merge();
+  }
   while (my_thread->_PendingInterrupts.consp()) {
     // printf("%s:%d:%s Handling a signal - there are pending interrupts\n", __FILE__, __LINE__, __FUNCTION__ );
     core::T_sp sig = pop_signal_or_interrupt(my_thread);
@@ -217,6 +282,13 @@ void handle_all_queued_interrupts()
   }
 }
 
+CL_DOCSTRING(R"dx(Return the number of threads with a safepoint request outstanding.)dx")
+DOCGROUP(clasp)
+CL_DEFUN size_t core__safepoint_requests() {
+  return clasp_safepoint_requests.load(std::memory_order_acquire);
+}
+
+CL_DOCSTRING(R"dx(Run the interrupts and deferred signals queued for this thread. Compiled code polls for them at function entries and loop headers, so this is only needed in code compiled with (optimize (speed 3) (safety 0)) or when waiting in foreign code.)dx")
 DOCGROUP(clasp)
 CL_DEFUN void core__check_pending_interrupts() {
   handle_all_queued_interrupts();
@@ -403,11 +475,10 @@ void fatal_error_handler(void *user_data, const std::string &reason, bool gen_cr
   abort();
 }
 
+// Only here to interrupt blocking system calls; the queued interrupt
+// runs at the next safepoint of the thread.
 void wake_up_thread(int sig)
 {
-  const char* msg = "In wake_up_thread interrupt.cc:296\n";
-  int len = strlen(msg);
-  write(1,msg,len);
 }
 
 // SIGNALS INITIALIZATION
@@ -38,7 +38,9 @@ THE SOFTWARE.
 #include <clasp/gctools/gc_boot.h>
 #include <clasp/gctools/gcFunctions.h>
 #include <clasp/gctools/memoryManagement.h>
+#include <clasp/gctools/heapDump.h>
 #include <clasp/core/mpPackage.h>
+#include <clasp/gctools/interrupt.h>
 #include <clasp/llvmo/llvmoExpose.h>
 #include <clasp/llvmo/code.h>
 //#include "main/allHeaders.cc"
@@ -498,6 +500,69 @@ void FinishAssingingBuiltinStamps() {
 //GCStack _ThreadLocalStack;
 const char *_global_stack_marker;
 size_t _global_stack_max_size;
+int global_gc_markers = 0;
+size_t global_heap_min = 0;
+std::atomic<size_t> global_heap_max{0};
+// Set while ext:heap-limit-exceeded runs, so that its emergency collection
+// and the ones in other threads meanwhile don't ask for it again.
+std::atomic<bool> global_heap_limit_handling{false};
+std::atomic<core::ThreadLocalState*> global_heap_limit_thread{NULL};
+#if defined(USE_BOEHM)
+GC_word global_free_space_divisor = 3;
+#elif defined(USE_MPS)
+size_t global_spare_commit_limit = 0;
+#endif
+
+// Past half the soft limit, trade time for space. Boehm grows the heap by
+// about in-use/divisor before it collects again, so raise the divisor until
+// that fits in what is left under the limit. MPS stops keeping freed memory
+// as spare and gives it back to the OS. Boehm's setter only sets a variable,
+// so it is safe with the allocation lock held; under MPS this runs from
+// processMpsMessages, outside the arena. GC_set_max_heap_size is not used:
+// the limit is soft, and a Boehm heap that can't grow is a fatal out of memory.
+static void heap_resize_policy(size_t in_use, size_t limit) {
+  bool tight = limit && in_use > limit / 2;
+#if defined(USE_BOEHM)
+  GC_word divisor = global_free_space_divisor;
+  if (tight) {
+    size_t headroom = (in_use < limit) ? limit - in_use : 0;
+    GC_word wanted = headroom ? (GC_word)(in_use / headroom) + 1 : 64;
+    divisor = std::min<GC_word>(64, std::max(divisor, wanted));
+  }
+  if (GC_get_free_space_divisor() != divisor) GC_set_free_space_divisor(divisor);
+#elif defined(USE_MPS)
+  size_t spare = tight ? 0 : global_spare_commit_limit;
+  if (mps_arena_spare_commit_limit(global_arena) != spare) mps_arena_spare_commit_limit_set(global_arena, spare);
+#endif
+}
+
+// Flag the thread that collected, so that a main thread blocked in
+// process-join or waiting for input doesn't keep the limit from being
+// signaled. Threads that run no user handlers, and threads that aren't Lisp
+// threads, hand it to the main thread instead. The request is only atomics.
+void heap_after_collection(size_t in_use) {
+  size_t limit = global_heap_max.load(std::memory_order_relaxed);
+  heap_resize_policy(in_use, limit);
+  if (limit && in_use > limit
+      && !global_heap_limit_handling.load(std::memory_order_relaxed)) {
+    core::ThreadLocalState* thread = my_thread;
+    if (!thread || thread->_ServiceThread) thread = global_heap_limit_thread.load(std::memory_order_acquire);
+    if (thread) {
+      thread->_HeapLimitPending.store(true, std::memory_order_release);
+      request_safepoint(thread);
+    }
+  }
+}
+
+size_t heap_in_use() {
+#if defined(USE_BOEHM)
+  return GC_get_heap_size() - GC_get_free_bytes();
+#elif defined(USE_MPS)
+  return mps_arena_committed(global_arena) - mps_arena_spare_committed(global_arena);
+#else
+  return 0;
+#endif
+}
 /*! Keeps track of the next available header KIND value */
 stamp_t global_next_header_stamp = (stamp_t)STAMPWTAG_max+1;
 
@@ -1030,4 +1095,68 @@ size_t objectSize( Header_s* header ) {
   } 
 }
 
+
+static Header_s* heapGraphHeader(uintptr_t client, uintptr_t tag) {
+  if (tag == gctools::general_tag) return (Header_s*)GeneralPtrToHeaderPtr((void*)client);
+  if (tag == gctools::cons_tag) return (Header_s*)ConsPtrToHeaderPtr((void*)client);
+  return NULL;
+}
+
+struct HeapGraphWalk {
+  HeapGraph* _Graph;
+};
+
+void heapGraphEdge( uintptr_t* clientAddress, uintptr_t client, uintptr_t tag, void* userData ) {
+  HeapGraph* graph = ((HeapGraphWalk*)userData)->_Graph;
+  Header_s* header = heapGraphHeader(client,tag);
+  if (!header) return;
+  graph->_Edges.push_back(graph->idFor(header));
+}
+
+/* Like gatherAllObjects but number every object and record every pointer
+   between objects.  The objects are scanned in the order they are numbered,
+   so the edges of each object are contiguous. */
+void buildHeapGraph(HeapGraph& graph) {
+  HeapGraphWalk walk;
+  walk._Graph = &graph;
+  PointerFix savedPointerFix = globalMemoryWalkPointerFix;
+  globalMemoryWalkPointerFix = heapGraphEdge;
+  walkRoots( +[](gctools::Tagged* rootAddress, RootType rootType, size_t rootIndex, void* data ) {
+    HeapGraph* graph = (HeapGraph*)data;
+    gctools::Tagged tagged = *rootAddress;
+    uintptr_t tag = tagged&ptag_mask;
+    uintptr_t client = tagged&ptr_mask;
+    // _lisp is an untagged pointer to a general object
+    if (rootType == LispRoot || rootType == CoreSymbolRoot) tag = gctools::general_tag;
+    if (!client) return;
+    Header_s* header = heapGraphHeader(client,tag);
+    if (!header) return;
+    HeapGraph::Root root;
+    root._Type = rootType;
+    root._Index = rootIndex;
+    root._Object = graph->idFor(header);
+    graph->_Roots.push_back(root);
+  } , (void*)&graph );
+  for ( size_t index = 0; index < graph._Objects.size(); ++index ) {
+    graph._EdgeStart.push_back(graph._Edges.size());
+    Header_s* header = graph._Objects[index];
+    if (header->_stamp_wtag_mtag.consObjectP()) {
+      size_t consSize;
+      uintptr_t client = (uintptr_t)HeaderPtrToConsPtr(header);
+      uintptr_t clientLimit = mw_cons_skip(client,consSize);
+      mw_cons_scan( 0, client, clientLimit, &walk );
+    } else if (header->_stamp_wtag_mtag.weakObjectP()) {
+      // Weak references do not retain anything
+    } else {
+      size_t objectSize;
+      uintptr_t client = (uintptr_t)HeaderPtrToGeneralPtr<void*>(header);
+      mw_obj_skip( client, false, objectSize );
+      uintptr_t clientLimit = client + objectSize;
+      mw_obj_scan( 0, client, clientLimit, &walk );
+    }
+  }
+  graph._EdgeStart.push_back(graph._Edges.size());
+  globalMemoryWalkPointerFix = savedPointerFix;
+}
+
 };
@@ -0,0 +1,349 @@
+/*
+    File: metrics.cc
+*/
+
+/*
+Copyright (c) 2014, Christian E. Schafmeister
+
+CLASP is free software; you can redistribute it and/or
+modify it under the terms of the GNU Library General Public
+License as published by the Free Software Foundation; either
+version 2 of the License, or (at your option) any later version.
+
+See directory 'clasp/licenses' for full details.
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+/* -^- */
+
+// The metrics registry is a fixed array of entries.  A registration reserves
+// an entry with one fetch_add and publishes it by setting _Ready, so neither
+// registering nor reading a snapshot ever takes a lock and both can happen
+// from any thread, including from inside a collection.
+
+#include <clasp/core/foundation.h>
+#include <clasp/core/object.h>
+#include <clasp/core/lisp.h>
+#include <clasp/core/array.h>
+#include <clasp/core/lispStream.h>
+#include <clasp/core/designators.h>
+#include <clasp/core/numbers.h>
+#include <clasp/core/ql.h>
+#include <clasp/gctools/gcFunctions.h>
+#include <clasp/gctools/threadlocal.h>
+#include <clasp/gctools/metrics.h>
+#if defined(USE_MPS)
+#include <clasp/gctools/mpsGarbageCollection.h>
+#endif
+#include <clasp/core/wrappers.h>
+
+namespace gctools {
+namespace metrics {
+
+#define METRICS_MAX 128
+
+enum MetricKind { metric_counter, metric_gauge, metric_gauge_function, metric_histogram };
+
+struct MetricEntry {
+  std::atomic<bool> _Ready{false};
+  const char*       _Name;
+  const char*       _Help;
+  MetricKind        _Kind;
+  void*             _Metric;
+  GaugeFunction     _Function;
+};
+
+MetricEntry global_Metrics[METRICS_MAX];
+std::atomic<size_t> global_MetricsCount{0};
+
+static void register_metric(const char* name, const char* help, MetricKind kind, void* metric, GaugeFunction fn) {
+  size_t index = global_MetricsCount.fetch_add(1);
+  if (index >= METRICS_MAX) {
+    printf("%s:%d Too many metrics - could not register %s\n", __FILE__, __LINE__, name);
+    return;
+  }
+  MetricEntry& entry = global_Metrics[index];
+  entry._Name = name;
+  entry._Help = help;
+  entry._Kind = kind;
+  entry._Metric = metric;
+  entry._Function = fn;
+  entry._Ready.store(true, std::memory_order_release);
+}
+
+void register_counter(const char* name, const char* help, Counter* counter) {
+  register_metric(name, help, metric_counter, counter, NULL);
+}
+void register_gauge(const char* name, const char* help, Gauge* gauge) {
+  register_metric(name, help, metric_gauge, gauge, NULL);
+}
+void register_gauge_function(const char* name, const char* help, GaugeFunction fn) {
+  register_metric(name, help, metric_gauge_function, NULL, fn);
+}
+void register_histogram(const char* name, const char* help, Histogram* histogram) {
+  register_metric(name, help, metric_histogram, histogram, NULL);
+}
+
+Counter   global_GCCollections;
+Histogram global_GCCollectionTime;
+Histogram global_GCPauseTime;
+Histogram global_GCMarkTime;
+Gauge     global_GCMarkers;
+Histogram global_JITCompileTime;
+Histogram global_FasoLoadTime;
+Histogram global_DiscriminatorCompileTime;
+Counter   global_DispatchMisses;
+Counter   global_ThreadsStarted;
+Gauge     global_ThreadsActive;
+
+// The collector reports these from the thread doing the collection.
+std::atomic<uint64_t> global_CollectionStart{0};
+std::atomic<uint64_t> global_WorldStopped{0};
+std::atomic<uint64_t> global_MarkStart{0};
+
+void gc_collection_begin() {
+  global_CollectionStart.store(now_ns(), std::memory_order_relaxed);
+}
+
+void gc_collection_end() {
+  uint64_t start = global_CollectionStart.exchange(0, std::memory_order_relaxed);
+  global_GCCollections.add();
+  if (start) global_GCCollectionTime.record(now_ns() - start);
+}
+
+void gc_world_stopped() {
+  global_WorldStopped.store(now_ns(), std::memory_order_relaxed);
+}
+
+void gc_world_started() {
+  uint64_t start = global_WorldStopped.exchange(0, std::memory_order_relaxed);
+  if (start) global_GCPauseTime.record(now_ns() - start);
+}
+
+void gc_mark_begin() {
+  global_MarkStart.store(now_ns(), std::memory_order_relaxed);
+}
+
+void gc_mark_end() {
+  uint64_t start = global_MarkStart.exchange(0, std::memory_order_relaxed);
+  if (start) global_GCMarkTime.record(now_ns() - start);
+}
+
+static int64_t heap_size_bytes() {
+#if defined(USE_BOEHM)
+  return GC_get_heap_size();
+#elif defined(USE_MPS)
+  return mps_arena_committed(global_arena);
+#else
+  return 0;
+#endif
+}
+
+static int64_t heap_free_bytes() {
+#if defined(USE_BOEHM)
+  return GC_get_free_bytes();
+#elif defined(USE_MPS)
+  return mps_arena_spare_committed(global_arena);
+#else
+  return 0;
+#endif
+}
+
+static int64_t allocated_bytes() {
+#if defined(USE_BOEHM)
+  return GC_get_total_bytes();
+#else
+  // Only the calling thread's count is available without stopping the world.
+  return my_thread_low_level->_Allocations._BytesAllocated;
+#endif
+}
+
+// The allocation rate is measured over a window that ends now and starts
+// at the older of the last two samples, so it always spans at least one
+// whole collection cycle.  The collector takes the samples; reading the
+// rate changes nothing, so scrapers that read it close together agree.
+// Collections don't overlap, so there is only ever one writer.  The next
+// sample overwrites the older slot, so a reader retries if the count
+// changed while it was reading.  Only Boehm can count the bytes allocated
+// by all threads, so only Boehm takes samples; elsewhere the window starts
+// at startup.
+#define ALLOCATION_SAMPLES 2
+
+struct AllocationSample {
+  std::atomic<uint64_t> _Time{0};
+  std::atomic<int64_t>  _Bytes{0};
+};
+
+AllocationSample    global_AllocationSamples[ALLOCATION_SAMPLES];
+std::atomic<size_t> global_AllocationSampleCount{0};
+
+void gc_allocation_sample(int64_t bytes) {
+  size_t count = global_AllocationSampleCount.load();
+  AllocationSample& sample = global_AllocationSamples[count % ALLOCATION_SAMPLES];
+  sample._Time.store(now_ns());
+  sample._Bytes.store(bytes);
+  global_AllocationSampleCount.store(count + 1);
+}
+
+static int64_t allocation_bytes_per_second() {
+  uint64_t time;
+  int64_t start_bytes;
+  size_t count;
+  do {
+    count = global_AllocationSampleCount.load();
+    if (count == 0) return 0;
+    size_t oldest = (count < ALLOCATION_SAMPLES) ? 0 : count % ALLOCATION_SAMPLES;
+    time = global_AllocationSamples[oldest]._Time.load();
+    start_bytes = global_AllocationSamples[oldest]._Bytes.load();
+  } while (count != global_AllocationSampleCount.load());
+  uint64_t now = now_ns();
+  int64_t bytes = allocated_bytes();
+  if (now <= time || bytes < start_bytes) return 0;
+  return (int64_t)((double)(bytes - start_bytes) * 1.0e9 / (double)(now - time));
+}
+
+struct BuiltinMetrics {
+  BuiltinMetrics() {
+    register_counter("gc_collections", "Number of garbage collections", &global_GCCollections);
+    register_histogram("gc_collection_seconds", "Duration of garbage collections", &global_GCCollectionTime);
+    register_histogram("gc_pause_seconds", "Time the world was stopped for garbage collection", &global_GCPauseTime);
+    register_histogram("gc_mark_seconds", "Time spent marking in garbage collections", &global_GCMarkTime);
+    register_gauge("gc_markers", "Number of threads that mark in a collection", &global_GCMarkers);
+    register_gauge_function("heap_size_bytes", "Bytes of memory held by the collector", heap_size_bytes);
+    register_gauge_function("heap_free_bytes", "Bytes of the heap that are free", heap_free_bytes);
+    register_gauge_function("allocated_bytes", "Bytes allocated since startup", allocated_bytes);
+    register_gauge_function("allocation_bytes_per_second", "Allocation rate since the collection before the last one", allocation_bytes_per_second);
+    register_histogram("jit_compile_seconds", "Time to compile and link a module in the JIT", &global_JITCompileTime);
+    register_histogram("faso_load_seconds", "Time to load a faso file", &global_FasoLoadTime);
+    register_histogram("discriminator_compile_seconds", "Time to build generic function discriminators", &global_DiscriminatorCompileTime);
+    register_counter("dispatch_misses", "Generic function dispatch misses", &global_DispatchMisses);
+    register_counter("threads_started", "Number of threads started", &global_ThreadsStarted);
+    register_gauge("threads_active", "Number of running threads", &global_ThreadsActive);
+    // Until the first collection the rate is measured from startup.
+    gc_allocation_sample(0);
+  }
+};
+
+BuiltinMetrics global_BuiltinMetrics;
+
+static double histogram_bucket_bound_seconds(size_t bucket) {
+  return (double)(1ULL << (HISTOGRAM_FIRST_BUCKET_BITS + bucket)) * 1.0e-9;
+}
+
+static core::Symbol_sp metric_keyword(const char* name) {
+  std::string keyword(name);
+  for (auto& c : keyword) c = (c == '_') ? '-' : toupper(c);
+  return _lisp->internKeyword(keyword);
+}
+
+static core::T_sp histogram_plist(Histogram* histogram) {
+  ql::list buckets;
+  for (size_t i = 0; i < HISTOGRAM_BUCKETS; ++i) {
+    uint64_t count = histogram->_Buckets[i].load(std::memory_order_relaxed);
+    if (count) buckets << core::Cons_O::create(core::clasp_make_double_float(histogram_bucket_bound_seconds(i)),
+                                               core::Integer_O::create(count));
+  }
+  ql::list plist;
+  plist << _lisp->internKeyword("COUNT") << core::Integer_O::create(histogram->_Count.load(std::memory_order_relaxed))
+        << _lisp->internKeyword("SUM") << core::clasp_make_double_float(histogram->_Sum.load(std::memory_order_relaxed) * 1.0e-9)
+        << _lisp->internKeyword("MAX") << core::clasp_make_double_float(histogram->_Max.load(std::memory_order_relaxed) * 1.0e-9)
+        << _lisp->internKeyword("BUCKETS") << buckets.cons();
+  return plist.cons();
+}
+
+}; // namespace metrics
+
+using namespace metrics;
+
+CL_DOCSTRING(R"dx(Return the current value of every runtime metric as a plist.
+Counters and gauges are integers. Duration histograms are plists of :count, :sum and :max
+(in seconds) and :buckets, a list of (upper-bound-seconds . count) for the non-empty buckets.
+:allocation-bytes-per-second is the rate since the collection before the last one; reading it
+changes nothing.)dx")
+DOCGROUP(clasp)
+CL_DEFUN core::T_sp gctools__metrics_snapshot() {
+  ql::list plist;
+  size_t count = std::min(global_MetricsCount.load(), (size_t)METRICS_MAX);
+  for (size_t i = 0; i < count; ++i) {
+    MetricEntry& entry = global_Metrics[i];
+    if (!entry._Ready.load(std::memory_order_acquire)) continue;
+    plist << metric_keyword(entry._Name);
+    switch (entry._Kind) {
+    case metric_counter:
+        plist << core::Integer_O::create(((Counter*)entry._Metric)->value());
+        break;
+    case metric_gauge:
+        plist << core::Integer_O::create((Fixnum)((Gauge*)entry._Metric)->value());
+        break;
+    case metric_gauge_function:
+        plist << core::Integer_O::create((Fixnum)entry._Function());
+        break;
+    case metric_histogram:
+        plist << histogram_plist((Histogram*)entry._Metric);
+        break;
+    }
+  }
+  return plist.cons();
+}
+
+CL_LAMBDA(&optional (output t))
+CL_DOCSTRING(R"dx(Write every runtime metric to the stream designator OUTPUT in the Prometheus text
+exposition format. Metric names are prefixed with clasp_.)dx")
+DOCGROUP(clasp)
+CL_DEFUN void gctools__metrics_dump(core::T_sp output) {
+  core::T_sp stream = core::coerce::outputStreamDesignator(output);
+  std::stringstream ss;
+  size_t count = std::min(global_MetricsCount.load(), (size_t)METRICS_MAX);
+  for (size_t i = 0; i < count; ++i) {
+    MetricEntry& entry = global_Metrics[i];
+    if (!entry._Ready.load(std::memory_order_acquire)) continue;
+    std::string name = std::string("clasp_") + entry._Name;
+    ss << "# HELP " << name << " " << entry._Help << "\n";
+    switch (entry._Kind) {
+    case metric_counter:
+        ss << "# TYPE " << name << " counter\n";
+        ss << name << " " << ((Counter*)entry._Metric)->value() << "\n";
+        break;
+    case metric_gauge:
+        ss << "# TYPE " << name << " gauge\n";
+        ss << name << " " << ((Gauge*)entry._Metric)->value() << "\n";
+        break;
+    case metric_gauge_function:
+        ss << "# TYPE " << name << " gauge\n";
+        ss << name << " " << entry._Function() << "\n";
+        break;
+    case metric_histogram: {
+      Histogram* histogram = (Histogram*)entry._Metric;
+      ss << "# TYPE " << name << " histogram\n";
+      uint64_t cumulative = 0;
+      for (size_t b = 0; b < HISTOGRAM_BUCKETS - 1; ++b) {
+        cumulative += histogram->_Buckets[b].load(std::memory_order_relaxed);
+        ss << name << "_bucket{le=\"" << histogram_bucket_bound_seconds(b) << "\"} " << cumulative << "\n";
+      }
+      cumulative += histogram->_Buckets[HISTOGRAM_BUCKETS - 1].load(std::memory_order_relaxed);
+      ss << name << "_bucket{le=\"+Inf\"} " << cumulative << "\n";
+      ss << name << "_sum " << (histogram->_Sum.load(std::memory_order_relaxed) * 1.0e-9) << "\n";
+      ss << name << "_count " << histogram->_Count.load(std::memory_order_relaxed) << "\n";
+      break;
+    }
+    }
+  }
+  core::clasp_write_string(ss.str(), stream);
+}
+
+CL_DOCSTRING(R"dx(Count a generic function dispatch miss in the runtime metrics)dx")
+DOCGROUP(clasp)
+CL_DEFUN void gctools__note_dispatch_miss() {
+  global_DispatchMisses.add();
+}
+
+}; // namespace gctools
@@ -44,7 +44,11 @@ THREAD_LOCAL MMTk_Mutator my_mutator;
 namespace gctools {
 __attribute__((noinline))
 int initializeMmtk(MainFunctionType startupFn, int argc, char *argv[], bool mpiEnabled, int mpiRank, int mpiSize) {
-  gc_init((size_t)(1024*1024*1024)*(size_t)4);
+  // This MMTk binding fixes the heap size at gc_init and has no collection
+  // hook, so --heap-max sets that size; --heap-min, growth, shrinking and the
+  // soft limit aren't available.
+  size_t heap_size = global_heap_max.load() ? global_heap_max.load() : (size_t)(1024*1024*1024)*(size_t)4;
+  gc_init(heap_size);
   
   void* topOfStack;
   my_mutator = bind_mutator(topOfStack);
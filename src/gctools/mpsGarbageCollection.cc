@@ -66,6 +66,8 @@ templated_class_jump_table_index, jump_table_index, NULL
 #include <clasp/core/compiler.h>
 #include <clasp/core/lispStream.h>
 #include <clasp/gctools/snapshotSaveLoad.h>
+#include <clasp/gctools/metrics.h>
+#include <clasp/gctools/finalizers.h>
 
 #ifdef USE_MPS
 
@@ -631,6 +633,8 @@ std::atomic<size_t> global_finalization_requests;
 mp::Mutex* global_mps_messages_mutex = NULL;
 #endif
 
+mps_clock_t global_mps_gc_start_clock = 0;
+
 size_t processMpsMessages(size_t& finalizations) {
   if (global_mps_messages_mutex == NULL) {
     global_mps_messages_mutex = new mp::Mutex(MPSMESSG_NAMEWORD);
@@ -652,6 +656,7 @@ size_t processMpsMessages(size_t& finalizations) {
     assert(b); /* we just checked there was one */
     if (type == mps_message_type_gc_start()) {
       ++mGcStart;
+      global_mps_gc_start_clock = mps_message_clock(global_arena, message);
 #if 1
       if (getenv("CLASP_GC_MESSAGES")) {
         printf("%s:%d Message: mps_message_type_gc_start()\n", __FILE__, __LINE__);
@@ -659,6 +664,15 @@ size_t processMpsMessages(size_t& finalizations) {
 #endif
     } else if (type == mps_message_type_gc()) {
       ++mGc;
+      // MPS collects incrementally, so there is no single pause to report,
+      // only the time from the start message to the end of the collection.
+      gctools::metrics::global_GCCollections.add();
+      if (global_mps_gc_start_clock) {
+        mps_clock_t end_clock = mps_message_clock(global_arena, message);
+        gctools::metrics::global_GCCollectionTime.record((uint64_t)((double)(end_clock - global_mps_gc_start_clock) * 1.0e9 / (double)mps_clocks_per_sec()));
+        global_mps_gc_start_clock = 0;
+      }
+      gctools::heap_after_collection(gctools::heap_in_use());
 #if 1
       if (getenv("CLASP_GC_MESSAGES")) {
         printf("%s:%d Message: mps_message_type_gc()\n", __FILE__, __LINE__);
@@ -717,27 +731,17 @@ size_t processMpsMessages(size_t& finalizations) {
       printf("%s:%d     finalizing object with badge: 0x%zx\n", __FILE__, __LINE__, lisp_badge(obj));
 #endif
       if (live_object) {
+        // Unlike Boehm there is no finalizer thread here (see finalizers.cc), so the
+        // finalizers run in the thread that is processing the messages.
         bool invoked_finalizer = false;
-        // Ok, I'm super worried about a deadlock here.
-        // What if (1) someone was doing an allocation and that registered a finalizer.
-        // Then (2) while registering the finalizer the allocator adds it to the _lisp->_Roots._Finalizers,which
-        // will (3) grab the WITH_READ_WRITE_LOCK(globals_->_FinalizersMutex)
-        // and (4) start allocating objects with MPS and something gets allocated with a finalizer...
-        // THEN (5) processMpsMessages gets called and (6) it grabs the WITH_READ_LOCK(globals_->_FinalizersMutex)
-        // ... I think that will dead lock!!!!!!!!
-        // Hmmm, can anything be allocated with a finalizer in (4)?????  Maybe not.
-        WITH_READ_LOCK(globals_->_FinalizersMutex);
-        auto ht = _lisp->_Roots._Finalizers;
-        core::T_mv res = ht->gethash(obj);
-        if (res.second().notnilp()) {
-          printf("%s:%d           Trying to pass object %p to finalizer at %p\n", __FILE__, __LINE__, (void*)obj.tagged_(), (void*)res.tagged_());
-          core::List_sp finalizers = res;
+        // The finalizers are taken out of their shard under the shard lock and run
+        // after it is released, so a finalizer that registers a finalizer can't deadlock.
+        core::List_sp finalizers = gctools::take_finalizers(obj);
+        if (finalizers.notnilp()) {
           for ( auto cur : finalizers ) {
             core::T_sp finalizer = oCar(cur);
-            core::eval::funcall(finalizer,obj);
-//            printf("%s:%d Ran finalizer callback.\n", __FILE__, __LINE__ );
+            gctools::call_finalizer(finalizer,obj);
           }
-          ht->remhash(obj);
           invoked_finalizer = true;
         }
 #ifndef RUNNING_PRECISEPREP
@@ -919,6 +923,8 @@ int initializeMemoryPoolSystem(MainFunctionType startupFn, int argc, char *argv[
 
   // Try something like   export CLASP_MPS_CONFIG="32 32 16 80 32 80 64"   to debug MPS
   maybeParseClaspMpsConfig(arenaSizeMb, spareCommitLimitMb, nurseryKb, nurseryMortalityPercent, generation1Kb, generation1MortalityPercent, keyExtendByKb );
+  // --heap-min reserves a bigger arena up front; the arena still grows past it
+  if (gctools::global_heap_min > arenaSizeMb * 1024 * 1024) arenaSizeMb = (gctools::global_heap_min + 1024 * 1024 - 1) / (1024 * 1024);
 
   double nurseryMortalityFraction = nurseryMortalityPercent / 100.0;
   double generation1MortalityFraction = generation1MortalityPercent / 100.0;
@@ -947,7 +953,8 @@ int initializeMemoryPoolSystem(MainFunctionType startupFn, int argc, char *argv[
 
   // David suggested this - it never gives back memory to the OS
   // TODO: Try turning this off for type inference
-  mps_arena_spare_commit_limit_set(global_arena, spareCommitLimitMb * 1024 * 1024);
+  gctools::global_spare_commit_limit = spareCommitLimitMb * 1024 * 1024;
+  mps_arena_spare_commit_limit_set(global_arena, gctools::global_spare_commit_limit);
 
   mps_fmt_t obj_fmt;
   MPS_ARGS_BEGIN(args) {
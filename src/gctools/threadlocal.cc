@@ -89,6 +89,17 @@ uint32_t DynamicBindingStack::ensure_binding_index(const Symbol_O* var) const {
   } else return binding_index;
 }
 
+// Make room for every binding index handed out so far, so that a new thread
+// doesn't grow its vector one symbol at a time as it binds the usual
+// variables (*standard-output* etc.) for the first time.
+void DynamicBindingStack::reserve_binding_indices() {
+#ifdef CLASP_THREADS
+  size_t count = mp::global_LastBindingIndex.load(std::memory_order_relaxed);
+  if (count > this->_ThreadLocalBindings.size())
+    this->_ThreadLocalBindings.resize(count,no_thread_local_binding<T_O>());
+#endif
+}
+
 T_sp* DynamicBindingStack::thread_local_reference(const uint32_t index) const {
   unlikely_if (index >= this->_ThreadLocalBindings.size())
     this->_ThreadLocalBindings.resize(index+1,no_thread_local_binding<T_O>());
@@ -105,20 +116,16 @@ void DynamicBindingStack::set_thread_local_value(T_sp value, const Symbol_O* sym
   *thread_local_reference(ensure_binding_index(sym)) = value;
 }
 
-bool DynamicBindingStack::thread_local_boundp(int32_t index) const {
-  if (index == NO_THREAD_LOCAL_BINDINGS) return false;
-  else if (index >= this->_ThreadLocalBindings.size()) return false;
-  else if (gctools::tagged_no_thread_local_bindingp(_ThreadLocalBindings[index].raw_()))
-    return false;
-  else return true;
-}
-
 };
 
 namespace gctools {
 ThreadLocalStateLowLevel::ThreadLocalStateLowLevel(void* stack_top) :
   _DisableInterrupts(false)
   ,  _StackTop(stack_top)
+#if defined(USE_BOEHM)
+  , _ConsFreeList(NULL)
+#endif
+  , _SampleBuffer(allocation_sample_buffer_claim())
 #ifdef DEBUG_RECURSIVE_ALLOCATIONS
   , _RecursiveAllocationCounter(0)
 #endif
@@ -126,7 +133,9 @@ ThreadLocalStateLowLevel::ThreadLocalStateLowLevel(void* stack_top) :
 {};
 
 ThreadLocalStateLowLevel::~ThreadLocalStateLowLevel()
-{};
+{
+  allocation_sample_buffer_release(this->_SampleBuffer);
+};
 
 };
 namespace core {
@@ -139,6 +148,10 @@ ThreadLocalState::ThreadLocalState(bool dummy) :
   _unwinds(0)
   , _CleanupFunctions(NULL)
   ,_PendingInterrupts()
+  ,_SafepointRequested(false)
+  ,_HeapLimitPending(false)
+  ,_SampleMergePending(false)
+  ,_ServiceThread(false)
   ,_CatchTags()
   ,_ObjectFiles()
   ,_BufferStr8NsPool()
@@ -178,6 +191,8 @@ void ThreadLocalState::finish_initialization_main_thread(core::T_sp theNilObject
   this->_ObjectFiles.theObject = theNilObject.theObject;
   this->_BufferStr8NsPool.theObject = theNilObject.theObject;
   this->_BufferStrWNsPool.theObject = theNilObject.theObject;
+  // The main thread handles the soft heap limit for threads that can't
+  gctools::global_heap_limit_thread.store(this, std::memory_order_release);
   return;
  ERR:
   printf("%s:%d:%s one of the reinitialize symbols was already initialized\n", __FILE__, __LINE__, __FUNCTION__ );
@@ -188,6 +203,10 @@ void ThreadLocalState::finish_initialization_main_thread(core::T_sp theNilObject
 ThreadLocalState::ThreadLocalState() :
   _unwinds(0)
   , _PendingInterrupts(nil<core::T_O>())
+  , _SafepointRequested(false)
+  , _HeapLimitPending(false)
+  , _SampleMergePending(false)
+  , _ServiceThread(false)
   , _CatchTags(nil<core::T_O>())
   , _ObjectFiles(nil<core::T_O>())
   , _CleanupFunctions(NULL)
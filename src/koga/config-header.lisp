@@ -15,6 +15,8 @@
                  "FORCE_STARTUP_EXTERNAL_LINKAGE" (if (force-startup-external-linkage configuration) 1 0)
                  "USE_PRECISE_GC" *variant-precise*
                  "USE_BOEHM" (eq :boehm *variant-gc*)
+                 "BOEHM_PARALLEL_MARK" (and (eq :boehm *variant-gc*)
+                                            (boehm-parallel-mark configuration))
                  "USE_MMTK" (eq :mmtk *variant-gc*)
                  "USE_MPS" (eq :mps *variant-gc*)
                  "RUNNING_PRECISEPREP" *variant-prep*
@@ -188,6 +188,11 @@
          :initform nil
          :type boolean
          :documentation "The number of concurrent jobs during aclasp, bclasp and clasp compilation.")
+   (boehm-parallel-mark :accessor boehm-parallel-mark
+                        :initarg :boehm-parallel-mark
+                        :initform t
+                        :type boolean
+                        :documentation "Build Boehm with PARALLEL_MARK so that collections mark on several threads.")
    (always-inline-mps-allocations :accessor always-inline-mps-allocations
                                   :initform t
                                   :initarg :always-inline-mps-allocations
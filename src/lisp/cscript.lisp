@@ -147,6 +147,7 @@
              #~"kernel/clos/inspect.lisp"
              #~"kernel/lsp/fli.lisp"
              #~"kernel/lsp/posix.lisp"
+             #~"kernel/lsp/executor.lisp"
              #~"modules/sockets/sockets.lisp"
              #~"kernel/lsp/top.lisp"
              #~"kernel/tag/pre-epilogue-bclasp.lisp"
@@ -248,6 +248,24 @@
     (:cmp-ast cmp-ast) (:value-ast ast:value-ast))
 
 (ast:define-children cas-ast (cmp-ast ast:value-ast))
+;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+;;;
+;;; Class RMW-AST
+;;;
+;;; Abstract. Class for atomic read-modify-write ASTs. The place is set to
+;;; the result of OPERATION on its old value and the value, and the old
+;;; value is returned.
+
+(defclass rmw-ast (ast:one-value-ast-mixin atomic-ast)
+  (;; One of :XCHG :ADD :SUB :AND :OR :XOR.
+   (%operation :initarg :operation :reader operation)
+   (%value-ast :initarg :value-ast :reader ast:value-ast)))
+
+(cleavir-io:define-save-info rmw-ast
+    (:operation operation) (:value-ast ast:value-ast))
+
+(ast:define-children rmw-ast (ast:value-ast))
+
 
 ;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 ;;;
@@ -329,6 +347,11 @@
 
 (defclass cas-rack-ast (cas-ast rack-ref-ast) ())
 
+(defclass rmw-rack-ast (rmw-ast rack-ref-ast) ())
+
+(ast:define-children rmw-rack-ast
+    (ast:value-ast rack-ast ast:slot-number-ast))
+
 ;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 ;;;
 ;;; Class SLOT-CAS-AST
@@ -351,7 +374,7 @@
 
 ;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 ;;;
-;;; Class ATOMIC-VREF-AST, ATOMIC-VSET-AST, VCAS-AST
+;;; Class ATOMIC-VREF-AST, ATOMIC-VSET-AST, VCAS-AST, VRMW-AST
 ;;;
 ;;; Atomic operations on an element of a (simple-array * (*))
 
@@ -378,6 +401,10 @@
 
 (defclass vcas-ast (cas-ast vref-ast) ())
 
+(defclass vrmw-ast (rmw-ast vref-ast) ())
+
+(ast:define-children vrmw-ast (ast:value-ast ast:array-ast ast:index-ast))
+
 ;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 ;;;
 ;;; Class BIND-AST
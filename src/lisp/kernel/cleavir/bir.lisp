@@ -123,6 +123,12 @@
 
 (defclass fence (atomic bir:no-input bir:no-output bir:instruction) ())
 
+;;; Read-modify-write instructions store the result of OPERATION on the old
+;;; value and their value input, and output the old value.
+(defclass rmw (atomic)
+  ((%operation :initarg :operation :reader operation
+               :type (member :xchg :add :sub :and :or :xor))))
+
 ;;; we just make the bmir directly for atomic car and cdr
 
 (defmethod ast-to-bir:compile-ast ((ast cc-ast:fence-ast) inserter system)
@@ -236,6 +242,7 @@
 (defclass atomic-rack-read (atomic bir:one-output bir:instruction) ())
 (defclass atomic-rack-write (atomic bir:no-output bir:instruction) ())
 (defclass cas-rack (atomic bir:one-output bir:instruction) ())
+(defclass rmw-rack (rmw bir:one-output bir:instruction) ())
 
 (defmethod ast-to-bir:compile-ast ((ast cc-ast:atomic-rack-read-ast)
                                    inserter system)
@@ -270,12 +277,25 @@
        (make-instance 'cas-rack :order (cc-ast:order ast)
                       :inputs args :outputs (list out)))
       (list out))))
+(defmethod ast-to-bir:compile-ast ((ast cc-ast:rmw-rack-ast) inserter system)
+  (ast-to-bir:with-compiled-asts (args ((cleavir-ast:value-ast ast)
+                                        (cc-ast:rack-ast ast)
+                                        (cleavir-ast:slot-number-ast ast))
+                                       inserter system)
+    (let ((out (make-instance 'bir:output)))
+      (ast-to-bir:insert
+       inserter
+       (make-instance 'rmw-rack
+         :order (cc-ast:order ast) :operation (cc-ast:operation ast)
+         :inputs args :outputs (list out)))
+      (list out))))
 
 (defclass abstract-vref (bir:instruction)
   ((%element-type :initarg :element-type :reader element-type)))
 (defclass vref (atomic bir:one-output abstract-vref) ())
 (defclass vset (atomic bir:no-output abstract-vref) ())
 (defclass vcas (atomic bir:one-output abstract-vref) ())
+(defclass vrmw (rmw bir:one-output abstract-vref) ())
 
 (defmethod ast-to-bir:compile-ast ((ast cc-ast:atomic-vref-ast) inserter system)
   (ast-to-bir:with-compiled-asts (args ((cleavir-ast:array-ast ast)
@@ -312,6 +332,19 @@
          :order (cc-ast:order ast) :inputs args :outputs (list out)
          :element-type (cleavir-ast:element-type ast)))
       (list out))))
+(defmethod ast-to-bir:compile-ast ((ast cc-ast:vrmw-ast) inserter system)
+  (ast-to-bir:with-compiled-asts (args ((cleavir-ast:value-ast ast)
+                                        (cleavir-ast:array-ast ast)
+                                        (cleavir-ast:index-ast ast))
+                                       inserter system)
+    (let ((out (make-instance 'bir:output)))
+      (ast-to-bir:insert
+       inserter
+       (make-instance 'vrmw
+         :order (cc-ast:order ast) :operation (cc-ast:operation ast)
+         :inputs args :outputs (list out)
+         :element-type (cleavir-ast:element-type ast)))
+      (list out))))
 
 ;;;
 ;;; vaslist stuff
@@ -16,6 +16,12 @@
              (lambda-name (when lambda-name-info
                             (car (cdr (cst:raw lambda-name-info)))))
              (cmp:*track-inlinee-name* (cons lambda-name cmp:*track-inlinee-name*))
+             ;; Used to tell whether a THROW is in the same function as its
+             ;; CATCH; see the compiler macro for CORE:THROW-FUNCTION.
+             (core::*lexical-function-depth*
+               (if core::*lexical-function-depth*
+                   (1+ core::*lexical-function-depth*)
+                   0))
              (original-lambda-list (if lambda-list (cst:raw lambda-list) nil)))
         (let ((function-ast (call-next-method)))
           (setf (ast:name function-ast)
@@ -359,6 +359,15 @@
       :value-ast (cst-to-ast:convert new env system)
       :rack-ast (cst-to-ast:convert rack env system)
       :slot-number-ast (cst-to-ast:convert index env system))))
+(defmethod cst-to-ast:convert-special
+    ((symbol (eql 'core::rmw-rack)) cst env (system clasp-cleavir:clasp))
+  (cst:db origin (rmw order op value rack index) cst
+    (declare (ignore rmw))
+    (make-instance 'cc-ast:rmw-rack-ast
+      :order (cst:raw order) :operation (cst:raw op) :origin cst
+      :value-ast (cst-to-ast:convert value env system)
+      :rack-ast (cst-to-ast:convert rack env system)
+      :slot-number-ast (cst-to-ast:convert index env system))))
 
 (defmethod cst-to-ast:convert-special
     ((symbol (eql 'core::atomic-vref)) cst env (system clasp-cleavir:clasp))
@@ -387,6 +396,16 @@
       :value-ast (cst-to-ast:convert nv env system)
       :array-ast (cst-to-ast:convert vector env system)
       :index-ast (cst-to-ast:convert index env system))))
+(defmethod cst-to-ast:convert-special
+    ((symbol (eql 'core::vrmw)) cst env (system clasp-cleavir:clasp))
+  (cst:db origin (vr order uaet op value vector index) cst
+    (declare (ignore vr))
+    (make-instance 'cc-ast:vrmw-ast
+      :order (cst:raw order) :element-type (cst:raw uaet)
+      :operation (cst:raw op) :origin cst
+      :value-ast (cst-to-ast:convert value env system)
+      :array-ast (cst-to-ast:convert vector env system)
+      :index-ast (cst-to-ast:convert index env system))))
 
 ;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 ;;;
@@ -1046,6 +1046,39 @@
     (&whole f (&rest forms) &body body)
   `(cleavir-cst-to-ast:with-current-source-form (,@forms) ,@body))
 
+;;; A THROW to a constant tag, lexically inside a CATCH for that tag and in
+;;; the same function, can only be caught by that CATCH. So we can exit
+;;; with a RETURN-FROM to the block the CATCH macro puts around its body,
+;;; which is a local exit (a branch, or at worst a longjmp) rather than a
+;;; C++ exception. See CL:CATCH in claspmacros.lisp for the bookkeeping.
+(defun lexical-catch-block (tag env)
+  (let ((depth core::*lexical-function-depth*))
+    (when (and depth
+               (consp tag) (eq (first tag) 'quote)
+               (consp (cdr tag)) (null (cddr tag)) (symbolp (second tag)))
+      (multiple-value-bind (expansion expandedp)
+          (macroexpand-1 'core::%lexical-catches env)
+        (when expandedp
+          (loop with tag = (second tag)
+                for (catch-tag block catch-depth) in (second expansion)
+                ;; A catch with a variable tag might catch this throw.
+                when (null block) return nil
+                when (eq catch-tag tag)
+                  return (and (eql catch-depth depth) block)))))))
+
+(define-cleavir-compiler-macro core:throw-function
+    (&whole form tag thunk &environment env)
+  ;; Only symbols that evaluate to themselves are their own tag; the
+  ;; value of a DEFCONSTANT may be anything. This is the same test the
+  ;; CATCH macro uses to record a constant tag.
+  (let ((block (lexical-catch-block (if (or (keywordp tag) (member tag '(nil t))) `',tag tag) env)))
+    ;; THUNK is the (lambda () (declare ...) (progn result-form))
+    ;; made by the CL:THROW macro.
+    (if (and block (consp thunk) (eq (first thunk) 'lambda)
+             (= (length thunk) 4) (null (second thunk)))
+        `(return-from ,block ,(fourth thunk))
+        form)))
+
 ;;; NOTE: The following two macros don't actually rely on anything cleavir-specific
 ;;; for validity. However, they do rely on their efficiency being from
 ;;; multiple-value-bind being efficient, which it is not without the above version.
@@ -1359,6 +1392,8 @@
   `(progn (core::primop core:set-breakstep) nil))
 (define-cleavir-compiler-macro core:unset-breakstep (&whole form)
   `(progn (core::primop core:unset-breakstep) nil))
+(define-cleavir-compiler-macro core:keep-alive (&whole form object)
+  `(progn (core::primop core:keep-alive ,object) nil))
 
 (debug-inline "primop")
 
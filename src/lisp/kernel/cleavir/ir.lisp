@@ -237,13 +237,22 @@ And convert everything to JIT constants."
         (let ((foreign-result (cmp::irc-call-or-invoke function-type func arguments)))
           (%intrinsic-invoke-if-landing-pad-or-call (clasp-ffi::to-translator-name (first foreign-types)) (list foreign-result))))))
 
+;;; Representation selection gives foreign-call-pointer unboxed floats where
+;;; it can (see foreign-argument-vrtype), and these skip the translators.
+(defun foreign-call-unboxed-type-p (type)
+  (member type '(:double :float :single-float)))
+
+(defun foreign-call-argument (type arg)
+  (if (and (foreign-call-unboxed-type-p type)
+           (not (llvm-sys:type-equal (llvm-sys:get-type arg) cmp:%t*%)))
+      arg
+      (%intrinsic-invoke-if-landing-pad-or-call
+       (clasp-ffi::from-translator-name type) (list arg))))
+
 (defun unsafe-foreign-call-pointer (call-or-invoke foreign-types pointer args abi)
   (declare (ignore call-or-invoke abi))
   ;; Write excess arguments into the multiple-value array
-  (let* ((arguments (mapcar (lambda (type arg)
-                              (%intrinsic-invoke-if-landing-pad-or-call
-                               (clasp-ffi::from-translator-name type) (list arg)))
-                            (second foreign-types) args))
+  (let* ((arguments (mapcar #'foreign-call-argument (second foreign-types) args))
          (function-type (cmp:function-type-create-on-the-fly foreign-types))
          (function-pointer-type (llvm-sys:type-get-pointer-to function-type))
          (pointer-t* pointer)
@@ -252,9 +261,11 @@ And convert everything to JIT constants."
             (%intrinsic-call "cc_getPointer" (list pointer-t*)) function-pointer-type
             "cast-function-pointer")))
     ;;; FIXME: Do these calls also need an INVOKE version if landing-pad is set????
-    (if (eq :void (first foreign-types))
-        (progn
-          (cmp::irc-call-or-invoke function-type function-pointer arguments)
-          (%intrinsic-invoke-if-landing-pad-or-call (clasp-ffi::to-translator-name (first foreign-types)) nil))
-        (let ((result-in-t* (cmp::irc-call-or-invoke function-type function-pointer arguments)))
-          (%intrinsic-invoke-if-landing-pad-or-call (clasp-ffi::to-translator-name (first foreign-types)) (list result-in-t*))))))
+    (cond ((eq :void (first foreign-types))
+           (cmp::irc-call-or-invoke function-type function-pointer arguments)
+           (%intrinsic-invoke-if-landing-pad-or-call (clasp-ffi::to-translator-name (first foreign-types)) nil))
+          ((foreign-call-unboxed-type-p (first foreign-types))
+           (cmp::irc-call-or-invoke function-type function-pointer arguments))
+          (t
+           (let ((result-in-t* (cmp::irc-call-or-invoke function-type function-pointer arguments)))
+             (%intrinsic-invoke-if-landing-pad-or-call (clasp-ffi::to-translator-name (first foreign-types)) (list result-in-t*)))))))
@@ -76,10 +76,11 @@
    #:wrapped-stamp-ast #:derivable-stamp-ast
    #:bind-vaslist-ast #:rest-alloc #:make-bind-vaslist-ast #:vaslist-ast
    #:atomic-car-ast #:atomic-cdr-ast #:atomic-rplaca-ast #:atomic-rplacd-ast
-   #:fence-ast #:cmp-ast #:order
+   #:fence-ast #:cmp-ast #:order #:operation
    #:cas-car-ast #:cas-cdr-ast #:slot-cas-ast
-   #:atomic-vref-ast #:atomic-vset-ast #:vcas-ast
+   #:atomic-vref-ast #:atomic-vset-ast #:vcas-ast #:vrmw-ast
    #:atomic-rack-read-ast #:atomic-rack-write-ast #:cas-rack-ast #:rack-ast
+   #:rmw-ast #:rmw-rack-ast
    #:bind-ast
    #:unwind-protect-ast #:cleanup-ast
    #:invoke-ast #:multiple-value-invoke-ast #:destinations
@@ -96,9 +97,9 @@
            #:foreign-call-pointer #:foreign-types
            #:defcallback #:defcallback-args
            #:mv-foreign-call #:function-name
-           #:atomic #:order #:fence
-           #:atomic-rack-read #:atomic-rack-write #:cas-rack
-           #:vref #:vset #:vcas #:element-type #:simple-p #:boxed-p))
+           #:atomic #:order #:fence #:rmw #:operation
+           #:atomic-rack-read #:atomic-rack-write #:cas-rack #:rmw-rack
+           #:vref #:vset #:vcas #:vrmw #:element-type #:simple-p #:boxed-p))
 
 (defpackage #:cc-bir-to-bmir
   (:use #:cl)
@@ -27,6 +27,17 @@
      (environment clasp-global-environment))
   (>= (policy:optimize-value optimize 'debug) 3))
 
+;;; Should the compiler poll for interrupts at function entries and loop
+;;; headers? A poll is a load and a well predicted branch, so only code that
+;;; asks for (speed 3) (safety 0) goes without, and can't be interrupted
+;;; while it loops without allocating.
+(defmethod policy:compute-policy-quality
+    ((quality (eql 'insert-safepoint-polls))
+     optimize
+     (environment clasp-global-environment))
+  (or (> (policy:optimize-value optimize 'safety) 0)
+      (< (policy:optimize-value optimize 'speed) 3)))
+
 ;;; This policy indicates that the compiler should note calls that could be
 ;;; transformed (i.e. eliminated by inlining, replacement with a primop, etc.)
 ;;; but couldn't be due to lack of information.
@@ -88,6 +99,7 @@
     (insert-type-checks boolean t)
     (insert-minimum-type-checks boolean t)
     (insert-step-conditions boolean t)
+    (insert-safepoint-polls boolean t)
     (note-untransformed-calls boolean t)
     (note-boxing boolean t)
     (note-consing-&rest boolean t)
@@ -104,6 +116,7 @@
     (insert-type-checks boolean t)
     (insert-minimum-type-checks boolean t)
     (insert-step-conditions boolean t)
+    (insert-safepoint-polls boolean t)
     (note-untransformed-calls boolean t)
     (note-boxing boolean t)
     (note-consing-&rest boolean t)
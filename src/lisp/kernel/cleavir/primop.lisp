@@ -321,6 +321,82 @@
     (%intrinsic-invoke-if-landing-pad-or-call "cc_simpleDoubleVectorAset" args)
     (first args)))
 
+;;; FLI memory access. These take a pointer designator (anything that
+;;; clasp-ffi:%mem-ref accepts) and a byte offset, and load or store the
+;;; foreign value directly. Floats and integers that fit in a fixnum are
+;;; never boxed; see the clasp-ffi:%mem-ref transforms in transform.lisp.
+
+(defun %fli-address (pointer offset type)
+  (cmp:irc-bit-cast
+   (%intrinsic-invoke-if-landing-pad-or-call
+    "cc_fli_address"
+    (list pointer (cmp:irc-ashr offset cmp:+fixnum-shift+ :exact t)))
+   (llvm-sys:type-get-pointer-to type)))
+
+(defun %fixnum-from-foreign (value signedp)
+  (cmp:irc-shl (if signedp
+                   (cmp:irc-sext value cmp:%i64%)
+                   (cmp:irc-zext value cmp:%i64%))
+               cmp:+fixnum-shift+ :nsw t))
+
+(defun %fixnum-to-foreign (fixnum type)
+  (cmp:irc-trunc (cmp:irc-ashr fixnum cmp:+fixnum-shift+ :exact t) type))
+
+(macrolet ((def-fli-access (ref set rtype type load store)
+             `(progn
+                (defvprimop (,ref :flags (:flushable))
+                    ((,rtype) :object :fixnum) (inst)
+                  (let* ((inputs (bir:inputs inst))
+                         (value (cmp:irc-load
+                                 (%fli-address (in (first inputs))
+                                               (in (second inputs)) ,type))))
+                    (declare (ignorable value))
+                    ,load))
+                ;; Like df-vset, these return the stored value.
+                (defvprimop ,set ((,rtype) ,rtype :object :fixnum) (inst)
+                  (let* ((inputs (bir:inputs inst))
+                         (value (in (first inputs))))
+                    (cmp:irc-store ,store
+                                   (%fli-address (in (second inputs))
+                                                 (in (third inputs)) ,type))
+                    value)))))
+  (def-fli-access core::fli-ref-double core::fli-set-double
+    :double-float cmp:%double% value value)
+  (def-fli-access core::fli-ref-float core::fli-set-float
+    :single-float cmp:%float% value value)
+  (def-fli-access core::fli-ref-int8 core::fli-set-int8
+    :fixnum cmp:%i8% (%fixnum-from-foreign value t)
+    (%fixnum-to-foreign value cmp:%i8%))
+  (def-fli-access core::fli-ref-uint8 core::fli-set-uint8
+    :fixnum cmp:%i8% (%fixnum-from-foreign value nil)
+    (%fixnum-to-foreign value cmp:%i8%))
+  (def-fli-access core::fli-ref-int16 core::fli-set-int16
+    :fixnum cmp:%i16% (%fixnum-from-foreign value t)
+    (%fixnum-to-foreign value cmp:%i16%))
+  (def-fli-access core::fli-ref-uint16 core::fli-set-uint16
+    :fixnum cmp:%i16% (%fixnum-from-foreign value nil)
+    (%fixnum-to-foreign value cmp:%i16%))
+  (def-fli-access core::fli-ref-int32 core::fli-set-int32
+    :fixnum cmp:%i32% (%fixnum-from-foreign value t)
+    (%fixnum-to-foreign value cmp:%i32%))
+  (def-fli-access core::fli-ref-uint32 core::fli-set-uint32
+    :fixnum cmp:%i32% (%fixnum-from-foreign value nil)
+    (%fixnum-to-foreign value cmp:%i32%))
+  ;; 64 bit integers only need boxing when they don't fit in a fixnum,
+  ;; and the translators take care of that.
+  (def-fli-access core::fli-ref-int64 core::fli-set-int64
+    :object cmp:%i64%
+    (%intrinsic-invoke-if-landing-pad-or-call "to_object_int64" (list value))
+    (%intrinsic-invoke-if-landing-pad-or-call "from_object_int64" (list value)))
+  (def-fli-access core::fli-ref-uint64 core::fli-set-uint64
+    :object cmp:%i64%
+    (%intrinsic-invoke-if-landing-pad-or-call "to_object_uint64" (list value))
+    (%intrinsic-invoke-if-landing-pad-or-call "from_object_uint64" (list value)))
+  (def-fli-access core::fli-ref-pointer core::fli-set-pointer
+    :object cmp:%i64*%
+    (%intrinsic-invoke-if-landing-pad-or-call "to_object_pointer" (list value))
+    (%intrinsic-invoke-if-landing-pad-or-call "from_object_pointer" (list value))))
+
 ;;;
 
 (defvprimop (core::fixnum-lognot :flags (:flushable)) ((:fixnum) :fixnum) (inst)
@@ -422,3 +498,8 @@
 (defeprimop core:unset-breakstep () (inst)
   (declare (ignore inst))
   (%intrinsic-call "cc_unset_breakstep" ()))
+
+;;; Pinning
+
+(defeprimop core:keep-alive 1 (inst)
+  (%intrinsic-call "cc_keep_alive" (list (in (first (bir:inputs inst))))))
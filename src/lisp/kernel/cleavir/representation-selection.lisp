@@ -107,6 +107,31 @@
   '(:vaslist))
 (defmethod %definition-rtype ((inst cc-bir:mv-foreign-call) (datum bir:datum))
   :multiple-values)
+;;; Foreign calls return floats unboxed, and take them unboxed when the
+;;; argument is known to be a float of the right format (otherwise the
+;;; translator converts whatever real it gets), so there's no need to box
+;;; one just for the translator to unbox it again.
+(defun foreign-type-vrtype (foreign-type)
+  (case foreign-type
+    ((:double) :double-float)
+    ((:float :single-float) :single-float)
+    (otherwise :object)))
+(defun foreign-argument-vrtype (foreign-type datum)
+  (let* ((sys clasp-cleavir:*clasp-system*)
+         (vrtype (foreign-type-vrtype foreign-type)))
+    (if (and (not (eq vrtype :object))
+             (cleavir-ctype:subtypep
+              (cleavir-ctype:primary (bir:ctype datum) sys)
+              (cleavir-ctype:range (if (eq vrtype :double-float)
+                                       'double-float
+                                       'single-float)
+                                   '* '* sys)
+              sys))
+        vrtype
+        :object)))
+(defmethod %definition-rtype ((inst cc-bir:foreign-call-pointer)
+                              (datum bir:datum))
+  (list (foreign-type-vrtype (first (cc-bir:foreign-types inst)))))
 (defmethod %definition-rtype ((inst bir:thei) (datum bir:datum))
   ;; THEI really throws a wrench in some stuff.
   (definition-rtype (bir:input inst)))
@@ -268,6 +293,12 @@
 (defmethod %use-rtype ((inst bir:primop) (datum bir:datum))
   (list (nth (position datum (bir:inputs inst))
              (rest (clasp-cleavir:primop-rtype-info (bir:info inst))))))
+(defmethod %use-rtype ((inst cc-bir:foreign-call-pointer) (datum bir:datum))
+  (let ((pos (position datum (rest (bir:inputs inst)))))
+    (if pos
+        (list (foreign-argument-vrtype
+               (nth pos (second (cc-bir:foreign-types inst))) datum))
+        '(:object))))
 (defmethod %use-rtype ((inst bir:unwind) (datum bir:datum))
   (use-rtype (nth (position datum (bir:inputs inst)) (bir:outputs inst))))
 (defmethod %use-rtype ((inst bir:jump) (datum bir:datum))
@@ -670,6 +701,15 @@
 (defmethod insert-casts ((instruction cc-bir:mv-foreign-call))
   (object-inputs instruction)
   (cast-output instruction :multiple-values))
+(defmethod insert-casts ((instruction cc-bir:foreign-call-pointer))
+  (let ((inputs (bir:inputs instruction))
+        (foreign-types (cc-bir:foreign-types instruction)))
+    (object-input instruction (first inputs))
+    (loop for input in (rest inputs)
+          for type in (second foreign-types)
+          do (maybe-cast-before instruction input
+                                (list (foreign-argument-vrtype type input))))
+    (cast-output instruction (list (foreign-type-vrtype (first foreign-types))))))
 (defmethod insert-casts ((instruction bir:values-save))
   (let* ((input (bir:input instruction)) (output (bir:output instruction))
          (inputrt (cc-bmir:rtype input)) (outputrt (cc-bmir:rtype output)))
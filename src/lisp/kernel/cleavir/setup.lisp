@@ -188,6 +188,7 @@
     ((eq name 'core::atomic-vref) t)
     ((eq name 'core::atomic-vset) t)
     ((eq name 'core::vcas) t)
+    ((eq name 'core::vrmw) t)
     ((eq name 'core::bind-vaslist) t)
     ((eq name 'core::primop) t)
     ((eq (symbol-package name) (find-package :cleavir-primop)) t)
@@ -508,6 +508,52 @@ Optimizations are available for any of:
   '(truly-the double-float
     (core::primop core::df-vset value arr idx)))
 
+;;; FLI memory access with a constant foreign type is done inline, without
+;;; boxing the address or (where possible) the value. The pointer may be
+;;; anything %mem-ref accepts, and is checked by the primop.
+(macrolet ((def-fli-transforms (ref set type &rest keywords)
+             `(progn
+                ,@(loop for kw in keywords
+                        append `((deftransform clasp-ffi::%mem-ref
+                                     (ptr (kw (eql ,kw)))
+                                   '(truly-the ,type (core::primop ,ref ptr 0)))
+                                 (deftransform clasp-ffi::%mem-ref
+                                     (ptr (kw (eql ,kw)) (offset fixnum))
+                                   '(truly-the ,type
+                                     (core::primop ,ref ptr offset)))
+                                 (deftransform clasp-ffi::%mem-set
+                                     (ptr (kw (eql ,kw)) (value ,type))
+                                   '(truly-the ,type
+                                     (core::primop ,set value ptr 0)))
+                                 (deftransform clasp-ffi::%mem-set
+                                     (ptr (kw (eql ,kw)) (value ,type)
+                                          (offset fixnum))
+                                   '(truly-the ,type
+                                     (core::primop ,set value ptr offset))))))))
+  (def-fli-transforms core::fli-ref-double core::fli-set-double
+    double-float :double)
+  (def-fli-transforms core::fli-ref-float core::fli-set-float
+    single-float :float :single-float)
+  (def-fli-transforms core::fli-ref-int8 core::fli-set-int8
+    (signed-byte 8) :int8 :char)
+  (def-fli-transforms core::fli-ref-uint8 core::fli-set-uint8
+    (unsigned-byte 8) :uint8 :unsigned-char :uchar)
+  (def-fli-transforms core::fli-ref-int16 core::fli-set-int16
+    (signed-byte 16) :int16 :short)
+  (def-fli-transforms core::fli-ref-uint16 core::fli-set-uint16
+    (unsigned-byte 16) :uint16 :unsigned-short :ushort)
+  (def-fli-transforms core::fli-ref-int32 core::fli-set-int32
+    (signed-byte 32) :int32 :int)
+  (def-fli-transforms core::fli-ref-uint32 core::fli-set-uint32
+    (unsigned-byte 32) :uint32 :unsigned-int :uint)
+  (def-fli-transforms core::fli-ref-int64 core::fli-set-int64
+    (signed-byte 64) :int64 :long :long-long :llong)
+  (def-fli-transforms core::fli-ref-uint64 core::fli-set-uint64
+    (unsigned-byte 64) :uint64 :size
+    :unsigned-long :ulong :unsigned-long-long :ullong)
+  (def-fli-transforms core::fli-ref-pointer core::fli-set-pointer
+    t :pointer))
+
 (deftransform aref ((arr vector) (index t))
   '(row-major-aref arr index))
 (deftransform (setf aref) ((val t) (arr vector) (index t))
@@ -1270,6 +1270,17 @@
                         :label (datum-name-as-string (bir:output inst)))
        (bir:output inst)))
 
+(defmethod translate-simple-instruction ((inst cc-bir:rmw-rack) abi)
+  (declare (ignore abi))
+  (out (cmp::irc-rack-rmw (in (second (bir:inputs inst)))
+                          (cmp:irc-untag-fixnum
+                           (in (third (bir:inputs inst)))
+                           cmp:%size_t% "slot-location")
+                          (in (first (bir:inputs inst)))
+                          (cc-bir:operation inst)
+                          :order (cmp::order-spec->order (cc-bir:order inst)))
+       (bir:output inst)))
+
 (defun gen-vector-effective-address (array index element-type fixnum-type)
   (let* ((type (llvm-sys:type-get-pointer-to
                 (cmp::simple-vector-llvm-type element-type)))
@@ -1282,31 +1293,114 @@
      cast
      (list (%i32 0) (%i32 cmp::+simple-vector-data-slot+) untagged) "aref")))
 
+;;; The atomic vector instructions take and return objects, so elements of
+;;; specialized vectors are converted to and from their stored form here.
+;;; The atomic expander for AREF has already checked the types.
+(defun vector-element-alignment (element-type)
+  (case element-type
+    ((ext:byte8 ext:integer8 base-char) 1)
+    ((ext:byte16 ext:integer16) 2)
+    ((ext:byte32 ext:integer32 single-float character) 4)
+    (otherwise 8)))
+
+(defun unbox-vector-element (value element-type)
+  (case element-type
+    ((t) value)
+    ((ext:byte8 ext:byte16 ext:byte32)
+     (cmp:irc-trunc (cmp:irc-untag-fixnum value cmp:%i64%)
+                    (cmp::element-type->llvm-type element-type)))
+    ((fixnum) (cmp:irc-untag-fixnum value cmp:%i64%))
+    ((ext:byte64)
+     (%intrinsic-invoke-if-landing-pad-or-call "from_object_uint64" (list value)))
+    ((ext:integer64)
+     (%intrinsic-invoke-if-landing-pad-or-call "from_object_int64" (list value)))
+    ((double-float) (cmp:irc-unbox-double-float value))
+    (otherwise
+     (error "BUG: Atomic access to vectors of ~a is not supported" element-type))))
+
+(defun box-vector-element (value element-type)
+  (case element-type
+    ((t) value)
+    ((ext:byte8 ext:byte16 ext:byte32)
+     (cmp:irc-tag-fixnum (cmp:irc-zext value cmp:%i64%)))
+    ((fixnum) (cmp:irc-tag-fixnum value))
+    ((ext:byte64)
+     (%intrinsic-invoke-if-landing-pad-or-call "to_object_uint64" (list value)))
+    ((ext:integer64)
+     (%intrinsic-invoke-if-landing-pad-or-call "to_object_int64" (list value)))
+    ((double-float) (cmp:irc-box-double-float value))
+    (otherwise
+     (error "BUG: Atomic access to vectors of ~a is not supported" element-type))))
+
 (defmethod translate-simple-instruction ((inst cc-bir:vref) abi)
-  (let ((inputs (bir:inputs inst)))
-    (out (cmp:irc-load-atomic
-          (gen-vector-effective-address
-           (in (first inputs)) (in (second inputs)) (cc-bir:element-type inst)
-           (%default-int-type abi))
-          :order (cmp::order-spec->order (cc-bir:order inst)))
+  (let ((et (cc-bir:element-type inst))
+        (inputs (bir:inputs inst)))
+    (out (box-vector-element
+          (cmp:irc-load-atomic
+           (gen-vector-effective-address
+            (in (first inputs)) (in (second inputs)) et
+            (%default-int-type abi))
+           :align (vector-element-alignment et)
+           :order (cmp::order-spec->order (cc-bir:order inst)))
+          et)
          (bir:output inst))))
 (defmethod translate-simple-instruction ((inst cc-bir:vset) abi)
-  (let ((inputs (bir:inputs inst)))
+  (let ((et (cc-bir:element-type inst))
+        (inputs (bir:inputs inst)))
     (cmp:irc-store-atomic
-     (in (first inputs))
+     (unbox-vector-element (in (first inputs)) et)
      (gen-vector-effective-address
-      (in (second inputs)) (in (third inputs)) (cc-bir:element-type inst)
+      (in (second inputs)) (in (third inputs)) et
       (%default-int-type abi))
+     :align (vector-element-alignment et)
      :order (cmp::order-spec->order (cc-bir:order inst)))))
 (defmethod translate-simple-instruction ((inst cc-bir:vcas) abi)
-  (let ((et (cc-bir:element-type inst))
-        (inputs (bir:inputs inst)))
-    (out (cmp:irc-cmpxchg
-          ;; This will err if et = bit or the like.
-          (gen-vector-effective-address
-           (in (third inputs)) (in (fourth inputs)) et
-           (%default-int-type abi))
-          (in (first inputs)) (in (second inputs)))
+  (let* ((et (cc-bir:element-type inst))
+         (inputs (bir:inputs inst))
+         (address
+           ;; This will err if et = bit or the like.
+           (gen-vector-effective-address
+            (in (third inputs)) (in (fourth inputs)) et
+            (%default-int-type abi)))
+         (old (unbox-vector-element (in (first inputs)) et))
+         (new (unbox-vector-element (in (second inputs)) et))
+         (order (cmp::order-spec->order (cc-bir:order inst)))
+         (align (vector-element-alignment et)))
+    (out (box-vector-element
+          (if (eq et 'double-float)
+              ;; cmpxchg only works on integers and pointers, so doubles
+              ;; are compared by their bits, i.e. as if by EQL.
+              (cmp:irc-bit-cast
+               (cmp:irc-cmpxchg (cmp:irc-bit-cast address cmp:%i64*%)
+                                (cmp:irc-bit-cast old cmp:%i64%)
+                                (cmp:irc-bit-cast new cmp:%i64%)
+                                :order order :align align)
+               cmp:%double%)
+              (cmp:irc-cmpxchg address old new :order order :align align))
+          et)
+         (bir:output inst))))
+(defmethod translate-simple-instruction ((inst cc-bir:vrmw) abi)
+  (let* ((et (cc-bir:element-type inst))
+         (inputs (bir:inputs inst))
+         (address (gen-vector-effective-address
+                   (in (second inputs)) (in (third inputs)) et
+                   (%default-int-type abi)))
+         (value (unbox-vector-element (in (first inputs)) et))
+         (operation (cc-bir:operation inst))
+         (order (cmp::order-spec->order (cc-bir:order inst))))
+    (out (box-vector-element
+          (if (eq et 't)
+              ;; Only :XCHG gets here for general vectors, but atomicrmw
+              ;; wants an integer.
+              (cmp:irc-int-to-ptr
+               (cmp:irc-atomicrmw (cmp:irc-bit-cast address cmp:%i64*%)
+                                  (cmp:irc-ptr-to-int value cmp:%i64%)
+                                  operation :order order)
+               cmp:%t*%)
+              (cmp:irc-atomicrmw address value operation
+                                 :order order
+                                 :align (vector-element-alignment et)))
+          et)
          (bir:output inst))))
 
 (defmethod translate-simple-instruction ((inst cc-bmir:mtf) abi)
@@ -1608,10 +1702,55 @@
                         (t (error "BUG: Bad rtype ~a" rt)))
               do (setf (gethash phi *datum-values*) dat))))))
 
+;;; Iblocks that begin with a safepoint poll: the start of the function and
+;;; the targets of back edges, so that a thread running compiled code,
+;;; allocating or not, reaches a poll in bounded time.
+(defvar *safepoint-iblocks*)
+
+(defun compute-safepoint-iblocks (function)
+  (let ((seen (make-hash-table :test #'eq))
+        (polled (make-hash-table :test #'eq)))
+    (flet ((pollp (iblock)
+             (policy:policy-value (bir:policy (bir:start iblock))
+                                  'insert-safepoint-polls)))
+      (when (pollp (bir:start function))
+        (setf (gethash (bir:start function) polled) t))
+      ;; Iblocks are in flow order, so an edge to one we've seen already
+      ;; goes back.
+      (bir:do-iblocks (ib function)
+        (setf (gethash ib seen) t)
+        (dolist (next (bir:next (bir:end ib)))
+          (when (and (gethash next seen) (pollp next))
+            (setf (gethash next polled) t)))))
+    polled))
+
+;;; A poll loads the number of threads with a safepoint request and calls
+;;; cc_safepoint if it's nonzero. See request_safepoint in interrupt.cc.
+(defun insert-safepoint-poll ()
+  (let* ((requests (llvm-sys:get-or-create-external-global
+                    cmp:*the-module* "clasp_safepoint_requests"
+                    cmp:%i32% 'llvm-sys:external-linkage))
+         (pending (cmp:irc-icmp-ne
+                   (cmp:irc-load-atomic requests :align 4
+                                                 :label "safepoint-requests")
+                   (%i32 0)))
+         (poll (cmp:irc-basic-block-create "safepoint"))
+         (after (cmp:irc-basic-block-create "after-safepoint")))
+    (cmp:irc-cond-br pending poll after)
+    (cmp:irc-begin-block poll)
+    (%intrinsic-invoke-if-landing-pad-or-call "cc_safepoint" nil)
+    (cmp:irc-br after)
+    (cmp:irc-begin-block after)))
+
 (defun layout-iblock (iblock abi)
   (cmp:irc-begin-block (iblock-tag iblock))
   (cmp:with-landing-pad (maybe-entry-landing-pad
                          (bir:dynamic-environment iblock) *tags*)
+    (when (gethash iblock *safepoint-iblocks*)
+      (cmp:with-debug-info-source-position ((ensure-origin
+                                             (inst-source (bir:start iblock))
+                                             999904))
+        (insert-safepoint-poll)))
     (let ((*enclose-initializers* '()))
       (loop with end = (bir:end iblock)
             for instruction = (bir:start iblock)
@@ -1732,6 +1871,7 @@
   (let* ((*tags* (make-hash-table :test #'eq))
          (*datum-values* (make-hash-table :test #'eq))
          (*dynenv-storage* (make-hash-table :test #'eq))
+         (*safepoint-iblocks* (compute-safepoint-iblocks function))
          (jit-function-name (cmp:jit-function-name lambda-name))
          (cmp:*current-function-name* jit-function-name)
          (cmp:*gv-current-function-name*
@@ -674,6 +674,7 @@ Return true iff a new entry was added; so for example it will return false if an
      (when (maybe-update-instances arguments)
        (return-from dispatch-miss (apply generic-function arguments)))
      ;; OK, real miss.
+     (gctools:note-dispatch-miss)
      #+debug-fastgf
      (progn
        (gf-log "----{---- A dispatch-miss occurred[(1- (core:next-number))->{}]  -> {}  %N" (1- (core:next-number)) (clos::generic-function-name generic-function))
@@ -605,6 +605,50 @@ or return to an outer frame, undoing all the function calls so far."
   (:REPORT "Memory limit reached. Please jump to an outer pointer, quit program and enlarge the
 memory limits before executing the program again."))
 
+(define-condition ext:heap-limit-exceeded (ext:storage-exhausted)
+  ((in-use :initarg :in-use :reader ext:heap-limit-exceeded-in-use)
+   (limit :initarg :limit :reader ext:heap-limit-exceeded-limit))
+  (:REPORT
+   (lambda (condition stream)
+     (format stream "~:d bytes of the heap are still in use after a full collection,
+over the limit of ~:d bytes set by --heap-max, CLASP_HEAP_MAX or GCTOOLS:SET-HEAP-LIMIT."
+             (ext:heap-limit-exceeded-in-use condition)
+             (ext:heap-limit-exceeded-limit condition)))))
+
+;; Called from gctools/interrupt.cc at the first safepoint after a collection
+;; left more of the heap in use than the soft limit, in the thread that
+;; collected - or in the main thread if that was the finalizer thread or an
+;; executor worker.
+(defun ext:heap-limit-exceeded ()
+  (gctools:garbage-collect)
+  (let ((in-use (gctools:heap-in-use))
+        (limit (gctools:heap-limit)))
+    (when (and limit (> in-use limit))
+      (let ((raised (+ in-use (ceiling in-use 2))))
+        (restart-case (error 'ext:heap-limit-exceeded :in-use in-use :limit limit)
+          (continue ()
+            :report (lambda (stream)
+                      (format stream "Raise the heap limit to ~:d bytes and continue." raised))
+            (gctools:set-heap-limit raised))
+          (use-value (new-limit)
+            :report "Set a new heap limit (NIL for none) and continue."
+            :interactive (lambda ()
+                           (format *query-io* "~&New heap limit in bytes: ")
+                           (list (read *query-io*)))
+            (gctools:set-heap-limit new-limit)))))))
+
+;; Called from gctools/finalizers.cc for every finalizer, so that one that
+;; signals an error doesn't unwind into the collector or take the finalizer
+;; thread down; the error is reported and the next finalizer runs.
+(defun gctools::call-finalizer (finalizer object)
+  (handler-case (funcall finalizer object)
+    (serious-condition (condition)
+      (handler-case
+          (format *error-output* "~&;;; The finalizer ~s signaled an error: ~a~%"
+                  finalizer condition)
+        (serious-condition () nil))
+      nil)))
+
 (define-condition ext:illegal-instruction (error)
   ()
   (:REPORT "Illegal instruction.
@@ -772,6 +816,16 @@ due to error:~%  ~:*~a~]"
              (mp:process-join-error-original-condition condition))))
   (:documentation "PROCESS-JOIN signals a condition of this type when the thread being joined ended abnormally."))
 
+#+threads
+(define-condition mp:process-join-timeout (mp:process-error)
+  ((timeout :initarg :timeout :reader mp:process-join-timeout-timeout))
+  (:report
+   (lambda (condition stream)
+     (format stream "Failed to join process: Process ~s did not exit within ~a seconds."
+             (mp:process-error-process condition)
+             (mp:process-join-timeout-timeout condition))))
+  (:documentation "PROCESS-JOIN signals a condition of this type when its timeout passes before the process exits and no default was given."))
+
 #+threads
 (progn
   ;; Somewhat KLUDGE-y way to add an ABORT restart to every new thread.
@@ -88,9 +88,11 @@
             %void%
             %i1%
             %exception-struct%
+            %i16%
             %i32%
             %i32*%
             %i64%
+            %i64*%
             %i8**%
             %i8*%
             %i8%
@@ -236,6 +238,7 @@
             irc-store
             irc-store-atomic
             irc-cmpxchg
+            irc-atomicrmw
             irc-struct-gep
             vaslist-start
             irc-read-slot
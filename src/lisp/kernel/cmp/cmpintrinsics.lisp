@@ -405,7 +405,8 @@ Boehm and MPS use a single pointer"
    (%t*% :setf-function) ; index=5 offset=40
    (%i32% :binding-idx) ; index=6 offset=48
    (%i32% :flags) ; index=7 offset=56
-   (%t*% :property-list))) ; index=8 offset=64
+   (%t*% :property-list) ; index=8 offset=64
+   (%t*% :sysprops))) ; index=9
 
 (defconstant +symbol.function-index+ (c++-field-index :function info.%symbol%))
 (defconstant +symbol.setf-function-index+ (c++-field-index :setf-function info.%symbol%))
@@ -734,6 +734,17 @@ representing a tagged fixnum."
 (defun irc-rack-write (rack index value &key (order 'llvm-sys:monotonic))
   (irc-store-atomic value (irc-rack-slot-address rack index) :order order))
 
+;;; Returns the old value. The operation is on the tagged word, so apart from
+;;; :XCHG it's only meaningful when the slot and value are fixnums, whose tag
+;;; bits are zero.
+(defun irc-rack-rmw (rack index value operation
+                     &key (order 'llvm-sys:sequentially-consistent))
+  (irc-int-to-ptr
+   (irc-atomicrmw (irc-bit-cast (irc-rack-slot-address rack index) %i64*%)
+                  (irc-ptr-to-int value %i64%)
+                  operation :order order)
+   %t*% "old"))
+
 (defun irc-read-slot (instance index)
   "Read a value from the rack of an instance"
   (let ((dataN* (irc-instance-slot-address instance index)))
@@ -973,7 +984,7 @@ the type LLVMContexts don't match - so they were defined in different threads!"
     ((llvm-sys:acquire-release) 'llvm-sys:acquire)
     ((llvm-sys:release) 'llvm-sys:monotonic)))
 
-(defun irc-%cmpxchg (ptr cmp new order)
+(defun irc-%cmpxchg (ptr cmp new order &optional (align 8))
   ;; Sanity check I'm putting in when this is new that should maybe be removed, future reader
   (let ((cmp-type (llvm-sys:get-type cmp)))
     (unless (and (llvm-sys:type-equal cmp-type (llvm-sys:get-type new))
@@ -983,13 +994,14 @@ the type LLVMContexts don't match - so they were defined in different threads!"
   ;; actual gen
   (llvm-sys:create-atomic-cmp-xchg *irbuilder*
                                    ptr cmp new
-                                   8 ; llvm::MaybeAlign(0)
+                                   align
                                    order
                                    (reduce-failure-order order)
                                    1 #+(or)'llvm-sys:system))
 
 (defun irc-cmpxchg (ptr cmp new
-                    &key (label "") (order 'llvm-sys:sequentially-consistent))
+                    &key (label "") (align 8)
+                      (order 'llvm-sys:sequentially-consistent))
   ;; cmpxchg instructions involve two memory orders: First, the "success" order
   ;; for the RMW operation, and second, the "failure" order for only the read
   ;; in case the comparison fails. I don't honestly know how this works at the
@@ -1000,7 +1012,7 @@ the type LLVMContexts don't match - so they were defined in different threads!"
  ;;; was done too, so we don't really need the flag.
   ;; Of course we might want to work with the flag directly instead, but that's
   ;; a reorganization at a higher level.
-  (irc-extract-value (irc-%cmpxchg ptr cmp new order) (list 0) label))
+  (irc-extract-value (irc-%cmpxchg ptr cmp new order align) (list 0) label))
 
 (defun translate-rmw-op (op)
   (cond ((eq op :xchg) 'llvm-sys:xchg)
@@ -1018,12 +1030,16 @@ the type LLVMContexts don't match - so they were defined in different threads!"
         ((eq op :fsub) 'llvm-sys:fsub)
         (t (error "Unknown atomic RMW operation: ~s" op))))
 
-(defun irc-atomicrmw (pointer value operation &optional (label "old"))
+(defun irc-atomicrmw (pointer value operation
+                      &key (label "old") (align 8)
+                        (order 'llvm-sys:sequentially-consistent))
   (declare (ignore label)) ; LLVM can't name atomic RMWs for whatever reason?
+  ;; Returns the value that was in memory before the operation.
   (llvm-sys:create-atomic-rmw *irbuilder*
                               (translate-rmw-op operation)
                               pointer value
-                              'llvm-sys:sequentially-consistent
+                              align
+                              order
                               1 #+(or)'llvm-sys:system))
 
 (defun irc-phi (return-type num-reserved-values &optional (label "phi"))
@@ -65,6 +65,7 @@
     (core::atomic-rack-read codegen-atomic-rack-read)
     (core::atomic-rack-write codegen-atomic-rack-write)
     (core::cas-rack codegen-cas-rack)
+    (core::rmw-rack codegen-rmw-rack)
     (llvm-inline codegen-llvm-inline)
     (:gc-profiling codegen-gc-profiling)
     (core::debug-message codegen-debug-message)
@@ -1477,6 +1478,24 @@ jump to blocks within this tagbody."
                   :order order)
      result)))
 
+;;; CORE::RMW-RACK
+
+(defun codegen-rmw-rack (result rest env)
+  (let ((order (order-spec->order (first rest)))
+        (operation (second rest)) (nv (third rest))
+        (rack (fourth rest)) (index (fifth rest))
+        (newt (alloca-t* "value"))
+        (rackt (alloca-t* "rack")) (indext (alloca-t* "index")))
+    (codegen newt nv env)
+    (codegen rackt rack env)
+    (codegen indext index env)
+    (irc-t*-result
+     (irc-rack-rmw (irc-load rackt)
+                   (irc-untag-fixnum (irc-load indext) %size_t% "slot-location")
+                   (irc-load newt) operation
+                   :order order)
+     result)))
+
 ;;; DBG-i32
 
 (defparameter *nexti* 10000)
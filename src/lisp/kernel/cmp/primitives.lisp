@@ -179,6 +179,8 @@
          (primitive         "unreachableError" :void nil)
          (primitive         "cc_set_breakstep" :void nil)
          (primitive         "cc_unset_breakstep" :void nil)
+         (primitive         "cc_keep_alive" :void (list :t*))
+         (primitive-unwinds "cc_safepoint" :void nil)
          (primitive-unwinds "cc_breakstep" :void (list :t* :t*))
          (primitive         "cc_breakstep_after" :void (list :t*))
          (primitive-unwinds "cc_wrong_number_of_arguments" :void (list :t* :size_t :size_t :size_t)
@@ -467,6 +469,7 @@
          (primitive-unwinds "from_object_pointer" :i64* (list :t*))
          (primitive-unwinds "to_object_pointer" :t* (list :i64*))
          (primitive-unwinds "to_object_void" :t* (list))
+         (primitive-unwinds "cc_fli_address" :i8* (list :t* :i64))
          ;; === END OF TRANSLATORS ===
          (primitive         "cx_read_stamp" :t* (list :t* :i64))
          (primitive         "cc_read_derivable_cxx_stamp_untagged_object" :i64 (list :i8*))
@@ -181,24 +181,13 @@ the file system."
     (error "Bad parameters Start ~s End ~s for ~s" start end real-string))
   (values start end))
 
-(defmacro %transform-string (real-string new-start new-end predicate transformation)
-  (let ((index1 (gensym))
-	(index2 (gensym))
-	(char (gensym)))
-    `(dotimes (,index1 (- ,new-end ,new-start) , real-string)
-       (let* ((,index2 (+ ,new-start ,index1))
-	      (,char (char ,real-string ,index2)))
-	 (when (,predicate ,char)
-	   (setf (char ,real-string ,index2)
-		 (,transformation ,char)))))))
-  
 (defun string-upcase (string-designator &key (start 0) end)
   ;;;string-designator to string
   (let ((real-string (%real-string string-designator)))
     (multiple-value-bind
           (new-start new-end)
         (%verify-string-args start end real-string)
-      (%transform-string real-string new-start new-end lower-case-p char-upcase))))
+      (core:nstring-upcase-range real-string new-start new-end))))
 
 (defun string-downcase (string-designator &key (start 0) end)
   ;;;string-designator to string
@@ -206,7 +195,7 @@ the file system."
     (multiple-value-bind
           (new-start new-end)
         (%verify-string-args start end real-string)
-      (%transform-string real-string new-start new-end upper-case-p char-downcase))))
+      (core:nstring-downcase-range real-string new-start new-end))))
 
 (defun nstring-upcase (real-string &key (start 0) end)
   (unless (stringp real-string)
@@ -214,7 +203,7 @@ the file system."
   (multiple-value-bind
         (new-start new-end)
       (%verify-string-args start end real-string)
-    (%transform-string real-string new-start new-end lower-case-p char-upcase)))
+    (core:nstring-upcase-range real-string new-start new-end)))
 
 (defun nstring-downcase (real-string &key (start 0) end)
   (unless (stringp real-string)
@@ -222,7 +211,7 @@ the file system."
   (multiple-value-bind
         (new-start new-end)
       (%verify-string-args start end real-string)
-    (%transform-string real-string new-start new-end upper-case-p char-downcase)))
+    (core:nstring-downcase-range real-string new-start new-end)))
 
 (defun float-radix (arg)
   ;; Unless you are internally representing
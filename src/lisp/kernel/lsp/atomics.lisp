@@ -22,6 +22,11 @@
 * a form to atomically read the value of PLACE
 * a form to atomically write the value of PLACE
 * a form to perform an atomic EQ-based compare-and-swap of PLACE
+Expanders for places with native read-modify-write operations return an
+eighth value, a function of an operation (one of :XCHG :ADD :SUB :AND :OR
+:XOR) and a variable holding the operand. It returns a form that performs
+the operation atomically and returns the old value of PLACE, or NIL if
+PLACE can't do that operation natively.
 The keyword arguments are passed unmodified to the expander, except that
 defaulting of ORDER is applied."
   (declare (ignore order))
@@ -78,7 +83,8 @@ defaulting of ORDER is applied."
                                   &body body)
   "Analogous to DEFINE-SETF-EXPANDER; defines how to access (accessor ...)
 places atomically.
-The body must return the seven values of GET-ATOMIC-EXPANSION.
+The body must return the seven values of GET-ATOMIC-EXPANSION, and may
+return the optional eighth.
 It is up to you the definer to ensure the swap is performed atomically.
 This means you will almost certainly need Clasp's synchronization operators
 (e.g., CAS on some other place).
@@ -170,13 +176,13 @@ PLACE must be a CAS-able place. CAS-able places are either symbol macros,
 special variables,
 or accessor forms with a CAR of
 SYMBOL-VALUE, SYMBOL-PLIST, CLOS:STANDARD-INSTANCE-ACCESS, THE,
-SLOT-VALUE, CLOS:SLOT-VALUE-USING-CLASS, CAR, CDR, FIRST, REST, SVREF,
+SLOT-VALUE, CLOS:SLOT-VALUE-USING-CLASS, CAR, CDR, FIRST, REST, SVREF, AREF,
+structure accessors,
 or macro forms that expand into CAS-able places,
 or an accessor defined with DEFINE-ATOMIC-EXPANDER.
 Some CAS accessors have additional semantic constraints.
 You can see their documentation with e.g. (documentation 'slot-value 'mp:atomic)
-This is planned to be expanded to include variables,
-possibly other simple vectors, and slot accessors.
+This is planned to be expanded to include variables.
 Keys are passed to GET-ATOMIC-EXPANSION.
 Experimental."
   (declare (ignore order))
@@ -221,8 +227,9 @@ sense for fences and will be rejected."
               (,gfn ,update-fn)
               ,@(mapcar #'list asyms arguments)
               (,old ,read))
+         ;; EQL, since CAS on a specialized vector returns a fresh number.
          (loop for ,new = (funcall ,gfn ,old ,@asyms)
-               until (eq ,old (setf ,old ,cas))
+               until (eql ,old (setf ,old ,cas))
                finally (return ,new))))))
 
 (defmacro atomic-update (place update-fn &rest arguments)
@@ -236,21 +243,119 @@ evaluations of the update-fn and arguments, and passes arguments to the update
 function in a different order."
   `(atomic-update-explicit (,place) ,update-fn ,@arguments))
 
+(defun rmw-update-form (operation old value)
+  (ecase operation
+    ((:xchg) value)
+    ((:add) `(+ ,old ,value))
+    ((:sub) `(- ,old ,value))
+    ((:and) `(logand ,old ,value))
+    ((:or) `(logior ,old ,value))
+    ((:xor) `(logxor ,old ,value))))
+
+;;; A CAS loop doing OPERATION, for places without a native one.
+;;; Returns the old value.
+(defun rmw-cas-loop (operation old new value read cas)
+  `(let ((,old ,read))
+     (loop for ,new = ,(rmw-update-form operation old value)
+           until (eql ,old (setf ,old ,cas))
+           finally (return ,old))))
+
+(defun expand-atomic-fetch (operation place value keys env)
+  (multiple-value-bind (vars vals old new read write cas rmw)
+      (apply #'get-atomic-expansion place :environment env keys)
+    (declare (ignore write))
+    (let ((gvalue (gensym "VALUE")))
+      `(let* (,@(mapcar #'list vars vals)
+              (,gvalue ,value))
+         ,(or (and rmw (funcall rmw operation gvalue))
+              (rmw-cas-loop operation old new gvalue read cas))))))
+
+;;; Like ATOMIC-UPDATE-EXPLICIT with + or -, but uses the place's native
+;;; fetch-add or fetch-sub if it has one.
+(defun expand-atomic-incf (operation place delta keys env)
+  (multiple-value-bind (vars vals old new read write cas rmw)
+      (apply #'get-atomic-expansion place :environment env keys)
+    (declare (ignore old new read write cas))
+    (let* ((gdelta (gensym "DELTA"))
+           (native (and rmw (funcall rmw operation gdelta))))
+      (if native
+          `(let* (,@(mapcar #'list vars vals)
+                  (,gdelta ,delta))
+             ,(rmw-update-form operation native gdelta))
+          `(atomic-update-explicit (,place ,@keys)
+                                   ,(if (eq operation :add) '#'+ '#'-)
+                                   ,delta)))))
+
 (defmacro atomic-incf-explicit ((place &rest keys &key order &allow-other-keys)
-                                &optional (delta 1))
+                                &optional (delta 1) &environment env)
   (declare (ignore order))
-  `(atomic-update-explicit (,place ,@keys) #'+ ,delta))
+  (expand-atomic-incf :add place delta keys env))
 
 (defmacro atomic-decf-explicit ((place &rest keys &key order &allow-other-keys)
-                                &optional (delta 1))
+                                &optional (delta 1) &environment env)
   (declare (ignore order))
-  `(atomic-update-explicit (,place ,@keys) #'- ,delta))
+  (expand-atomic-incf :sub place delta keys env))
 
 (defmacro atomic-incf (place &optional (delta 1))
-  `(atomic-update ,place #'+ ,delta))
+  "Atomically increment PLACE by DELTA and return the new value.
+If PLACE has a native fetch-add, as elements of specialized integer vectors
+and fixnum structure slots do, it is used and the addition is modular in the
+width of the place (see ATOMIC-FETCH-ADD); the value returned is then the
+old value plus DELTA. Otherwise this is ATOMIC-UPDATE with +."
+  `(atomic-incf-explicit (,place) ,delta))
 
 (defmacro atomic-decf (place &optional (delta 1))
-  `(atomic-update ,place #'- ,delta))
+  "As ATOMIC-INCF, but subtracting DELTA."
+  `(atomic-decf-explicit (,place) ,delta))
+
+(defmacro atomic-fetch-add (place value &rest keys &key order &allow-other-keys
+                            &environment env)
+  "Atomically add VALUE to PLACE, and return the old value of PLACE.
+On elements of vectors specialized to (UNSIGNED-BYTE 8), (UNSIGNED-BYTE 16),
+(UNSIGNED-BYTE 32), (UNSIGNED-BYTE 64), (SIGNED-BYTE 64) or FIXNUM, and on
+structure slots of type FIXNUM, this is a single hardware instruction; VALUE
+must then be of the element type and the addition wraps around modulo the
+width of the element. The consequences are undefined if a FIXNUM place
+overflows. Other places use a CAS loop.
+Keys are passed to GET-ATOMIC-EXPANSION.
+Experimental."
+  (declare (ignore order))
+  (expand-atomic-fetch :add place value keys env))
+
+(defmacro atomic-fetch-sub (place value &rest keys &key order &allow-other-keys
+                            &environment env)
+  "As ATOMIC-FETCH-ADD, but subtracting VALUE."
+  (declare (ignore order))
+  (expand-atomic-fetch :sub place value keys env))
+
+(defmacro atomic-fetch-and (place value &rest keys &key order &allow-other-keys
+                            &environment env)
+  "Atomically set PLACE to (LOGAND PLACE VALUE), and return the old value.
+Native on the same places as ATOMIC-FETCH-ADD."
+  (declare (ignore order))
+  (expand-atomic-fetch :and place value keys env))
+
+(defmacro atomic-fetch-or (place value &rest keys &key order &allow-other-keys
+                           &environment env)
+  "Atomically set PLACE to (LOGIOR PLACE VALUE), and return the old value.
+Native on the same places as ATOMIC-FETCH-ADD."
+  (declare (ignore order))
+  (expand-atomic-fetch :or place value keys env))
+
+(defmacro atomic-fetch-xor (place value &rest keys &key order &allow-other-keys
+                            &environment env)
+  "Atomically set PLACE to (LOGXOR PLACE VALUE), and return the old value.
+Native on the same places as ATOMIC-FETCH-ADD."
+  (declare (ignore order))
+  (expand-atomic-fetch :xor place value keys env))
+
+(defmacro atomic-exchange (place value &rest keys &key order &allow-other-keys
+                           &environment env)
+  "Atomically store VALUE in PLACE, and return the old value of PLACE.
+Native on the places ATOMIC-FETCH-ADD is, and on elements of simple vectors
+and instance slots."
+  (declare (ignore order))
+  (expand-atomic-fetch :xchg place value keys env))
 
 (defmacro atomic-push-explicit
     (item (place &rest keys &key order &allow-other-keys) &environment env)
@@ -334,12 +439,16 @@ same order as they are for CL:PUSHNEW, specified in CLHS 5.1.1.1."
 
 (define-atomic-expander the (type place) (&rest keys)
   "(cas (the y x) o n) = (cas x (the y o) (the y n))"
-  (multiple-value-bind (vars vals old new read write cas)
+  (multiple-value-bind (vars vals old new read write cas rmw)
       (apply #'get-atomic-expansion place keys)
     (values vars vals old new
             `(the ,type ,read)
             `(let ((,new (the ,type ,new))) ,write)
-            `(let ((,old (the ,type ,old)) (,new (the ,type ,new))) ,cas))))
+            `(let ((,old (the ,type ,old)) (,new (the ,type ,new))) ,cas)
+            (when rmw
+              (lambda (operation value)
+                (let ((form (funcall rmw operation value)))
+                  (when form `(the ,type ,form))))))))
 
 (define-atomic-expander first (list) (&rest keys)
   (apply #'get-atomic-expansion `(car ,list) keys))
@@ -351,8 +460,28 @@ same order as they are for CL:PUSHNEW, specified in CLHS 5.1.1.1."
 (define-simple-atomic-expander cdr (list)
   core::cdr-atomic core::rplacd-atomic core::cas-cdr)
 
-(define-simple-atomic-expander core:rack-ref (rack index)
-  core::atomic-rack-read core::atomic-rack-write core::cas-rack)
+;;; Structure accessors pass SLOT-TYPE FIXNUM for fixnum slots, which can do
+;;; arithmetic on the tagged word directly. Any slot can be exchanged.
+(define-atomic-expander core:rack-ref (rack index)
+    (&key order environment slot-type)
+  (declare (ignore environment))
+  (let ((gr (gensym "RACK")) (gi (gensym "INDEX"))
+        (cmp (gensym "CMP")) (new (gensym "NEW"))
+        (fixnump (eq slot-type 'fixnum)))
+    (values (list gr gi) (list rack index) cmp new
+            `(core::atomic-rack-read ,(reduce-read-order order) ,gr ,gi)
+            `(progn (core::atomic-rack-write ,(reduce-write-order order)
+                                             ,new ,gr ,gi)
+                    ,new)
+            `(core::cas-rack ,order ,cmp ,new ,gr ,gi)
+            (lambda (operation value)
+              (cond (fixnump
+                     `(if (typep ,value 'fixnum)
+                          (core::rmw-rack ,order ,operation ,value ,gr ,gi)
+                          (error 'type-error :datum ,value
+                                             :expected-type 'fixnum)))
+                    ((eq operation :xchg)
+                     `(core::rmw-rack ,order :xchg ,value ,gr ,gi)))))))
 
 ;; Ignores order specification for the moment.
 (define-atomic-expander symbol-value (symbol) (&key order environment)
@@ -374,29 +503,94 @@ are no bindings (in which case the global, thread-shared value is used."
             `(progn (core:atomic-set-symbol-plist ,new ,gs) ,new)
             `(core:cas-symbol-plist ,cmp ,new ,gs))))
 
+;;; The element types of simple vectors with atomic accessors. Only integer
+;;; elements have native arithmetic, and double-floats only have CAS.
+(defparameter *atomic-vector-element-types*
+  '(t ext:byte8 ext:byte16 ext:byte32 ext:byte64 ext:integer64 fixnum
+    double-float))
+
+(defun atomic-vector-native-rmw-p (element-type operation)
+  (case element-type
+    ((t) (eq operation :xchg))
+    ((double-float) nil)
+    (otherwise t)))
+
+;;; Expand an atomic access to an element of a simple vector with one of
+;;; ELEMENT-TYPES, dispatching on the vector's actual type. Each branch has
+;;; a constant element type for the compiler; declaring the type of the
+;;; vector lets it drop the others.
+(defun expand-atomic-vector-access (vector index order element-types)
+  (let* ((gv (gensym "VECTOR")) (gi (gensym "INDEX"))
+         (cmp (gensym "CMP")) (new (gensym "NEW"))
+         (read-order (reduce-read-order order))
+         (write-order (reduce-write-order order))
+         (vector-type (if (equal element-types '(t))
+                          'simple-vector
+                          `(or ,@(loop for et in element-types
+                                       collect `(simple-array ,et (*)))))))
+    (flet ((dispatch (function)
+             (if (rest element-types)
+                 `(etypecase ,gv
+                    ,@(loop for et in element-types
+                            collect `((simple-array ,et (*))
+                                      ,(funcall function et))))
+                 (funcall function (first element-types))))
+           (check (var et)
+             (unless (eq et t)
+               `((unless (typep ,var ',et)
+                   (error 'type-error :datum ,var :expected-type ',et))))))
+      (values (list gv gi)
+              (list `(let ((,gv ,vector))
+                       (unless (typep ,gv ',vector-type)
+                         (error 'type-error
+                                :datum ,gv :expected-type ',vector-type))
+                       ,gv)
+                    `(let ((,gi ,index))
+                       (unless (array-in-bounds-p ,gv ,gi)
+                         (error 'core:sequence-out-of-bounds
+                                :datum ,gi
+                                :expected-type (list 'integer 0 (length ,gv))
+                                :object ,gv))
+                       ,gi))
+              cmp new
+              (dispatch (lambda (et)
+                          `(core::atomic-vref ,read-order ,et ,gv ,gi)))
+              `(progn
+                 ,(dispatch (lambda (et)
+                              `(progn ,@(check new et)
+                                      (core::atomic-vset ,write-order ,et
+                                                         ,new ,gv ,gi))))
+                 ,new)
+              (dispatch (lambda (et)
+                          `(progn ,@(check cmp et) ,@(check new et)
+                                  (core::vcas ,order ,et ,cmp ,new ,gv ,gi))))
+              (lambda (operation value)
+                (dispatch
+                 (lambda (et)
+                   (if (atomic-vector-native-rmw-p et operation)
+                       `(progn ,@(check value et)
+                               (core::vrmw ,order ,et ,operation
+                                           ,value ,gv ,gi))
+                       (let ((rold (gensym "OLD")) (rnew (gensym "NEW")))
+                         (rmw-cas-loop
+                          operation rold rnew value
+                          `(core::atomic-vref ,read-order ,et ,gv ,gi)
+                          `(core::vcas ,order ,et ,rold ,rnew ,gv ,gi)))))))))))
+
 (define-atomic-expander svref (simple-vector index) (&key order environment)
   (declare (ignore environment))
-  (let ((gv (gensym "VECTOR")) (gi (gensym "INDEX"))
-        (cmp (gensym "CMP")) (new (gensym "NEW"))
-        (read-order (reduce-read-order order))
-        (write-order (reduce-write-order order)))
-    (values (list gv gi)
-            (list `(let ((,gv ,simple-vector))
-                     (unless (typep ,gv 'simple-vector)
-                       (error 'type-error
-                              :datum ,gv :expected-type 'simple-vector))
-                     ,gv)
-                  `(let ((,gi ,index))
-                     (unless (array-in-bounds-p ,gv ,gi)
-                       (error 'core:sequence-out-of-bounds
-                              :datum ,gi
-                              :expected-type (list 'integer 0 (length ,gv))
-                              :object ,gv))
-                     ,gi))
-            cmp new
-            `(core::atomic-vref ,read-order T ,gv ,gi)
-            `(progn (core::atomic-vset ,write-order T ,new ,gv ,gi) ,new)
-            `(core::vcas ,order T ,cmp ,new ,gv ,gi))))
+  (expand-atomic-vector-access simple-vector index order '(t)))
+
+(define-atomic-expander aref (vector index) (&key order environment)
+  "Only one-dimensional simple arrays with element type T, (UNSIGNED-BYTE 8),
+(UNSIGNED-BYTE 16), (UNSIGNED-BYTE 32), (UNSIGNED-BYTE 64), (SIGNED-BYTE 64),
+FIXNUM or DOUBLE-FLOAT can be accessed atomically.
+CAS compares elements of specialized vectors as if by EQL, not EQ. New values
+must be of the element type.
+See ATOMIC-FETCH-ADD for the read-modify-write operations that are native."
+  (declare (ignore environment))
+  (expand-atomic-vector-access vector index order
+                               *atomic-vector-element-types*))
 
 #+(or)
 (define-simple-atomic-expander svref (vector index)
@@ -66,6 +66,26 @@
 
 (export '(with-locked-hash-table))
 
+(defmacro with-pinned-objects ((&rest objects) &body body)
+  "Evaluate the OBJECTS forms and then BODY, keeping the objects alive and
+unmoved by the garbage collector until BODY returns."
+  (let ((vars (mapcar #'(lambda (object) (declare (ignore object)) (gensym "PINNED")) objects)))
+    `(let (,@(mapcar #'list vars objects))
+       (multiple-value-prog1 (progn ,@body)
+         ,@(mapcar #'(lambda (var) `(core:keep-alive ,var)) vars)))))
+
+(defmacro with-pointer-to-vector-data ((pointer vector) &body body)
+  "Evaluate BODY with POINTER bound to a foreign pointer to the first element of
+VECTOR, a simple vector of one of the element types ext:make-pinned-vector accepts.
+VECTOR is pinned while BODY runs, and POINTER must not be used after it returns."
+  (let ((pinned (gensym "VECTOR")))
+    `(let* ((,pinned ,vector)
+            (,pointer (core:vector-data-pointer ,pinned)))
+       (with-pinned-objects (,pinned)
+         ,@body))))
+
+(export '(with-pinned-objects with-pointer-to-vector-data))
+
 (in-package :core)
 
 ;;; We use progn in these expansions so that the programmer can't DECLARE anything.
@@ -74,9 +94,38 @@
     (lambda () (declare (core:lambda-name unwind-protected-lambda)) (progn ,protected-form))
     (lambda () (declare (core:lambda-name unwind-cleanup-lambda)) (progn ,@cleanup-forms))))
 
-(defmacro cl:catch (tag &rest forms)
-  `(core:catch-function
-    ,tag (lambda () (declare (core:lambda-name catch-lambda)) (progn ,@forms))))
+;;; CATCH records itself in the lexical environment, as the symbol macro
+;;; %LEXICAL-CATCHES, so that the compiler can turn a THROW to a constant tag
+;;; that is lexically inside the catch, in the same function, into a
+;;; RETURN-FROM to a block around the catch body. Such a RETURN-FROM is a
+;;; local exit and doesn't need a C++ exception. See the compiler macro
+;;; for CORE:THROW-FUNCTION in cleavir/inline.lisp.
+;;; Each entry is (tag block depth) where depth is the value of
+;;; *LEXICAL-FUNCTION-DEPTH* inside the catch thunk. If the tag isn't a
+;;; constant symbol the entry is (nil nil depth), which stops the search,
+;;; since that catch could catch anything.
+;;; *LEXICAL-FUNCTION-DEPTH* is bound by the compiler as it converts each
+;;; function; it's NIL when no compiler that does this is active.
+(defvar *lexical-function-depth* nil)
+
+(defmacro cl:catch (tag &rest forms &environment env)
+  (let* ((constant-tag-p (or (and (symbolp tag) (or (keywordp tag) (member tag '(nil t))))
+                             (and (consp tag) (eq (car tag) 'quote)
+                                  (consp (cdr tag)) (null (cddr tag))
+                                  (symbolp (cadr tag)))))
+         (block (gensym "CATCH"))
+         (depth (if *lexical-function-depth* (1+ *lexical-function-depth*) 0))
+         (outer (multiple-value-bind (expansion expandedp)
+                    (macroexpand-1 '%lexical-catches env)
+                  (if expandedp (cadr expansion) nil)))
+         (entry (if constant-tag-p
+                    (list (if (consp tag) (cadr tag) tag) block depth)
+                    (list nil nil depth))))
+    `(core:catch-function
+      ,tag (lambda () (declare (core:lambda-name catch-lambda))
+             (block ,block
+               (symbol-macrolet ((%lexical-catches '(,entry ,@outer)))
+                 (progn ,@forms)))))))
 
 (defmacro cl:throw (tag result-form)
   `(core:throw-function
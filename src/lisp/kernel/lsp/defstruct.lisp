@@ -298,10 +298,14 @@
               :datum object
               :expected-type ',structure-name)))
 
-(defun defstruct-class-cas-body (structure-name element-type location)
-  (declare (ignore structure-name element-type))
+;;; Unlike the other bodies this gets the slot's type, so that fixnum slots
+;;; can use native atomic arithmetic (see the CORE:RACK-REF atomic expander).
+(defun defstruct-class-cas-body (structure-name slot-type location)
+  (declare (ignore structure-name))
   `(apply #'mp:get-atomic-expansion
           (list 'clos::standard-instance-access object ,location)
+          ,@(when (subtypep slot-type 'fixnum)
+              '(:slot-type 'fixnum))
           keys))
 
 (defun defstruct-vector-reader-body (structure-name element-type location)
@@ -343,7 +347,7 @@
                ,(funcall gen-write structure-name element-type location))
             (when gen-cas
               `((mp:define-atomic-expander ,accessor (object) (&rest keys)
-                  ,(funcall gen-cas structure-name element-type location)))))))))))
+                  ,(funcall gen-cas structure-name type location)))))))))))
 
 (defun process-boa-lambda-list (original-lambda-list slot-descriptions)
   (let ((lambda-list (copy-list original-lambda-list))
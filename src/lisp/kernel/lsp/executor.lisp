@@ -0,0 +1,269 @@
+(in-package "MP")
+
+;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+;;;
+;;; Futures, promises and parallel loops on the executor.
+;;;
+;;; The executor itself (worker processes, their deques and the injection
+;;; queue) is in mpPackage.cc; %EXECUTOR-SUBMIT queues a function of no
+;;; arguments and %EXECUTOR-RUN-ONE lets a waiting worker run another task.
+;;;
+
+(export '(start-executor stop-executor executor-statistics executor-worker-p
+          future futurep future-state future-done-p future-name
+          promise promisep make-promise fulfill-promise fail-promise
+          submit force wait-for-future cancel-future
+          future-cancel-requested-p *current-future*
+          future-error future-error-future future-error-original-condition
+          future-cancelled future-timeout
+          pmap preduce pdotimes))
+
+(defvar *current-future* nil
+  "The future whose task the current process is running, or NIL.")
+
+;;; STATE is one of :PENDING, :RUNNING, :DONE, :FAILED or :CANCELLED.
+;;; A task moves its future from :PENDING to :RUNNING with a CAS; every other
+;;; change happens with LOCK held, so that waiters can't miss it.
+(defstruct (future (:constructor %make-future (name))
+                   (:predicate futurep)
+                   (:copier nil))
+  (name nil)
+  (state :pending)
+  (values nil)
+  (condition nil)
+  (cancel-requested nil)
+  (lock (make-lock :name "FUTURE"))
+  (done (make-condition-variable :name "FUTURE")))
+
+;;; A promise is a future without a task. Whoever has it completes it.
+(defstruct (promise (:include future)
+                    (:constructor %make-promise (name))
+                    (:predicate promisep)
+                    (:copier nil)))
+
+(define-condition future-error (error)
+  ((future :initarg :future :reader future-error-future)
+   (original-condition :initarg :original-condition :initform nil
+                       :reader future-error-original-condition))
+  (:report
+   (lambda (condition stream)
+     (format stream "Future ~s failed~:[.~; due to error:~%  ~:*~a~]"
+             (future-error-future condition)
+             (future-error-original-condition condition))))
+  (:documentation "FORCE signals a condition of this type when the future failed without a condition."))
+
+(define-condition future-cancelled (future-error) ()
+  (:report
+   (lambda (condition stream)
+     (format stream "Future ~s was cancelled." (future-error-future condition))))
+  (:documentation "FORCE signals a condition of this type when the future was cancelled."))
+
+(define-condition future-timeout (future-error)
+  ((timeout :initarg :timeout :reader future-timeout-timeout))
+  (:report
+   (lambda (condition stream)
+     (format stream "Future ~s did not complete within ~a seconds."
+             (future-error-future condition)
+             (future-timeout-timeout condition))))
+  (:documentation "FORCE signals a condition of this type when its timeout runs out."))
+
+(defmethod print-object ((future future) stream)
+  (print-unreadable-object (future stream :type t :identity t)
+    (format stream "~@[~a ~]~s" (future-name future) (atomic (future-state future)))))
+
+(defun future-done-p (future)
+  "Return true if FUTURE has completed, failed or been cancelled."
+  (not (member (atomic (future-state future)) '(:pending :running))))
+
+(defun %complete-future (future from to values condition)
+  "Move FUTURE from state FROM to TO, store its VALUES and CONDITION and wake
+its waiters. Return true if FUTURE was in state FROM."
+  (with-lock ((future-lock future))
+    (when (eq (future-state future) from)
+      (setf (future-values future) values
+            (future-condition future) condition)
+      (when (eq (cas (future-state future) from to) from)
+        (condition-variable-broadcast (future-done future))
+        t))))
+
+(defun %call-with-special-bindings (bindings function)
+  ;; Like the SPECIAL-BINDINGS of PROCESS-RUN-FUNCTION: each form is
+  ;; evaluated in the null lexical environment with the earlier ones bound.
+  (if (null bindings)
+      (funcall function)
+      (destructuring-bind (symbol . form) (first bindings)
+        (progv (list symbol) (list (eval form))
+          (%call-with-special-bindings (rest bindings) function)))))
+
+(defun %run-future (future function special-bindings)
+  (when (eq (cas (future-state future) :pending :running) :pending)
+    (let ((completed nil))
+      (unwind-protect
+           (handler-case
+               (let ((values (multiple-value-list
+                              (let ((*current-future* future))
+                                (%call-with-special-bindings special-bindings function)))))
+                 (setf completed t)
+                 (%complete-future future :running :done values nil))
+             (serious-condition (condition)
+               (setf completed t)
+               (%complete-future future :running :failed nil condition)))
+        ;; A non-local exit out of the task still has to wake the waiters.
+        (unless completed
+          (%complete-future future :running :failed nil nil))))))
+
+(defun submit (function &key name special-bindings)
+  "Queue FUNCTION to be called with no arguments by a worker of the executor
+and return a future for its values. The workers start with the bindings of
+MP:PUSH-DEFAULT-SPECIAL-BINDING like any process. SPECIAL-BINDINGS is an alist
+of (symbol . form) as for PROCESS-RUN-FUNCTION: the forms are evaluated in the
+worker and their values bound to the symbols around the call."
+  (let ((future (%make-future name)))
+    (%executor-submit (lambda () (%run-future future function special-bindings)))
+    future))
+
+(defun make-promise (&optional name)
+  "Return a new promise. A promise is a future without a task; it completes
+when FULFILL-PROMISE or FAIL-PROMISE is called on it."
+  (%make-promise name))
+
+(defun fulfill-promise (promise &rest values)
+  "Complete PROMISE with VALUES. Return true unless PROMISE was already
+completed or cancelled."
+  (%complete-future promise :pending :done values nil))
+
+(defun fail-promise (promise condition)
+  "Complete PROMISE so that forcing it signals CONDITION. Return true unless
+PROMISE was already completed or cancelled."
+  (%complete-future promise :pending :failed nil condition))
+
+(defun cancel-future (future)
+  "Cancel FUTURE. A future whose task has not started never runs it, and
+forcing it signals FUTURE-CANCELLED; return true in that case. A task that is
+already running is only asked to stop: FUTURE-CANCEL-REQUESTED-P becomes true
+and it's up to the task to look. Return false in that case."
+  (if (%complete-future future :pending :cancelled nil nil)
+      t
+      (progn
+        (when (eq (atomic (future-state future)) :running)
+          (setf (atomic (future-cancel-requested future)) t))
+        nil)))
+
+(defun future-cancel-requested-p (&optional (future *current-future*))
+  "Return true if CANCEL-FUTURE was called on FUTURE while its task was running.
+Tasks can poll this to stop early."
+  (and future (atomic (future-cancel-requested future)) t))
+
+(defun wait-for-future (future &optional timeout)
+  "Wait until FUTURE is done or TIMEOUT seconds have passed. Return true if
+FUTURE is done. An executor worker runs other tasks while it waits, so tasks
+can force the futures of their subtasks without tying up the pool."
+  (let ((deadline (and timeout
+                       (+ (get-internal-real-time)
+                          (* timeout internal-time-units-per-second))))
+        (worker (executor-worker-p)))
+    (flet ((remaining ()
+             (and deadline
+                  (/ (float (- deadline (get-internal-real-time)) 1d0)
+                     internal-time-units-per-second))))
+      (loop
+        (when (future-done-p future) (return t))
+        (unless (and worker (%executor-run-one))
+          (let ((remaining (remaining)))
+            (when (and remaining (<= remaining 0)) (return nil))
+            (with-lock ((future-lock future))
+              (unless (future-done-p future)
+                (cond (worker
+                       ;; New tasks don't signal us, so look again soon.
+                       (condition-variable-timedwait
+                        (future-done future) (future-lock future)
+                        (if remaining (min remaining 0.001d0) 0.001d0)))
+                      (remaining
+                       (condition-variable-timedwait
+                        (future-done future) (future-lock future) remaining))
+                      (t
+                       (condition-variable-wait
+                        (future-done future) (future-lock future))))))))))))
+
+(defun force (future &key timeout)
+  "Wait for FUTURE and return the values of its task or promise. If the task
+signaled an error, signal that condition again. Signal FUTURE-CANCELLED if
+FUTURE was cancelled, and FUTURE-TIMEOUT if TIMEOUT seconds pass first."
+  (unless (wait-for-future future timeout)
+    (error 'future-timeout :future future :timeout timeout))
+  (ecase (atomic (future-state future))
+    (:done (values-list (future-values future)))
+    (:failed (let ((condition (future-condition future)))
+               (if condition
+                   (error condition)
+                   (error 'future-error :future future))))
+    (:cancelled (error 'future-cancelled :future future))))
+
+;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+;;;
+;;; Parallel loops
+;;;
+
+(defun %map-chunks (function start end &optional grain)
+  "Call FUNCTION with the bounds of consecutive chunks of GRAIN indices from
+START below END, the first in this process and the rest on the executor, and
+return the list of the primary values in order. GRAIN defaults to enough for
+four chunks per worker."
+  (when (< start end)
+    (let* ((grain (or grain (max 1 (ceiling (- end start) (* 4 (start-executor))))))
+           (futures (loop for chunk from (+ start grain) below end by grain
+                          collect (let ((chunk chunk))
+                                    (submit (lambda ()
+                                              (funcall function chunk
+                                                       (min end (+ chunk grain)))))))))
+      (cons (funcall function start (min end (+ start grain)))
+            (mapcar #'force futures)))))
+
+(defun pmap (result-type function sequence &rest more-sequences)
+  "Like MAP, but FUNCTION is called on the executor in parallel, in no
+particular order. The result is in the order of the sequences."
+  (let* ((vectors (mapcar (lambda (sequence) (coerce sequence 'simple-vector))
+                          (cons sequence more-sequences)))
+         (length (reduce #'min vectors :key #'length))
+         (results (make-array length)))
+    (%map-chunks (lambda (start end)
+                   (loop for index from start below end
+                         do (setf (svref results index)
+                                  (apply function
+                                         (mapcar (lambda (vector) (svref vector index))
+                                                 vectors)))))
+                 0 length)
+    (if result-type
+        (coerce results result-type)
+        nil)))
+
+(defun preduce (function sequence &key key (start 0) end grain
+                                       (initial-value nil initial-value-p))
+  "Like REDUCE, but reduces chunks of SEQUENCE on the executor in parallel and
+then reduces their results. FUNCTION must be associative; INITIAL-VALUE is
+used once, on the left."
+  (let* ((vector (coerce sequence 'vector))
+         (end (or end (length vector)))
+         (partials (%map-chunks (lambda (start end)
+                                  (reduce function vector :key key :start start :end end))
+                                start end grain)))
+    (if initial-value-p
+        (reduce function partials :initial-value initial-value)
+        (reduce function partials))))
+
+(defun %pdotimes (count function &optional grain)
+  (%map-chunks (lambda (start end)
+                 (loop for index from start below end
+                       do (funcall function index)))
+               0 count grain)
+  nil)
+
+(defmacro pdotimes ((var count &optional result) &body body)
+  "Like DOTIMES, but the iterations run on the executor in parallel, in no
+particular order. RESULT is evaluated with VAR bound to COUNT."
+  (let ((scount (gensym "COUNT")))
+    `(let ((,scount ,count))
+       (%pdotimes ,scount (lambda (,var) ,@body))
+       (let ((,var ,scount))
+         (declare (ignorable ,var))
+         ,result))))
@@ -19,7 +19,7 @@
   (:import-from :CORE "WITH-UNIQUE-NAMES")
   (:export "WITH-LOCK" "WITH-RWLOCK" "WITHOUT-INTERRUPTS" "WITH-INTERRUPTS"
            "WITH-LOCAL-INTERRUPTS" "WITH-RESTORED-INTERRUPTS" "ALLOW-WITH-INTERRUPTS"
-           "ABORT-PROCESS"))
+           "ABORT-PROCESS" "LOCK-CONTENTION-REPORT"))
 
 #+threads
 (in-package "MP")
@@ -156,3 +156,18 @@ If DATUM is provided, it and ARGUMENTS designate a condition of default type SIM
    (if datum
        (core::coerce-to-condition datum arguments 'simple-error 'abort-process)
        nil)))
+
+#+threads
+(defun lock-contention-report (&key (limit 20) (stream *standard-output*))
+  "Print the LIMIT mutex names whose contended locks have waited longest in
+total since MP:RESET-LOCK-CONTENTION-STATISTICS was last called, and return
+their entries from MP:LOCK-CONTENTION-STATISTICS."
+  (let* ((stats (sort (remove 0 (lock-contention-statistics) :key #'third)
+                      #'> :key #'fourth))
+         (worst (if (> (length stats) limit) (subseq stats 0 limit) stats)))
+    (format stream "~&~8a ~14@a ~12@a ~12@a ~12@a~%"
+            "Name" "Acquisitions" "Contended" "Wait (s)" "Max wait (s)")
+    (loop for (name acquisitions contended wait max-wait) in worst
+          do (format stream "~8a ~14d ~12d ~12,6f ~12,6f~%"
+                     name acquisitions contended wait max-wait))
+    worst))
@@ -120,6 +120,8 @@
             atomic-incf atomic-decf atomic-incf-explicit atomic-decf-explicit
             atomic-push atomic-pop
             atomic-pushnew atomic-pushnew-explicit
+            atomic-fetch-add atomic-fetch-sub atomic-fetch-and
+            atomic-fetch-or atomic-fetch-xor atomic-exchange
             ))
   (core:select-package "CORE"))
 
@@ -152,6 +154,9 @@
             stack-overflow-size
             stack-overflow-type
             storage-exhausted
+            heap-limit-exceeded
+            heap-limit-exceeded-in-use
+            heap-limit-exceeded-limit
             illegal-instruction
             unix-signal-received
             unix-signal-received-code
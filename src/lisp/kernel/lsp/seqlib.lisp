@@ -516,7 +516,21 @@
                :start start :end end :from-end from-end :count count))
 
 
+;;; True if a search for a character in a string can use the
+;;; vectorized string kernels: no key and an EQL or CHAR= test.
+(defun string-kernel-test-p (test test-not key)
+  (and (null key) (null test-not)
+       (or (null test)
+           (eq test 'eql) (eq test #'eql)
+           (eq test 'char=) (eq test #'char=))))
+
 (defun find (item sequence &key test test-not (start 0) end from-end key)
+  (when (and (characterp item) (stringp sequence)
+             (string-kernel-test-p test test-not key))
+    (return-from find
+      (with-start-end (start end sequence)
+        (when (position-char item sequence start end from-end)
+          item))))
   (with-tests (test test-not key)
     (declare (optimize (speed 3) (safety 0) (debug 0)))
     (with-start-end (start end sequence)
@@ -539,6 +553,11 @@
 
 
 (defun position (item sequence &key test test-not from-end (start 0) end key)
+  (when (and (characterp item) (stringp sequence)
+             (string-kernel-test-p test test-not key))
+    (return-from position
+      (with-start-end (start end sequence)
+        (position-char item sequence start end from-end))))
   (with-tests (test test-not key)
     (declare (optimize (speed 3) (safety 0) (debug 0)))
     (with-start-end (start end sequence)
@@ -771,7 +790,7 @@ subsequence is found.  Returns NIL otherwise."
     (with-start-end (start2 end2 sequence2)
       (cond
         ((and (stringp sequence1) (stringp sequence2)
-              (not from-end) (not test) (not test-not) (not key))
+              (not from-end) (string-kernel-test-p test test-not key))
          (search-string sequence1 start1 end1 sequence2 start2 end2))
         ((and (vectorp sequence1) (vectorp sequence2))
          (search-vector sequence1 start1 end1 sequence2 start2 end2
@@ -0,0 +1,63 @@
+(in-package #:clasp-tests)
+
+;;; Allocate a known mix of conses and double-float vectors and check that
+;;; the sampler estimates the bytes of each close to what was allocated.
+
+(defun allocation-sampler-mix (conses vectors)
+  (let ((list nil)
+        (arrays nil))
+    (dotimes (i conses)
+      (push i list))
+    (dotimes (i vectors)
+      (push (make-array 1000 :element-type 'double-float) arrays))
+    (values (length list) (length arrays))))
+
+(defun allocation-sampler-bytes (stamps name)
+  (loop for (stamp-name nil bytes) in stamps
+        when (search name stamp-name)
+          sum bytes))
+
+(test-true allocation-sampler-mix
+      (progn
+        (gctools:allocation-sampler-start :interval 8192)
+        (unwind-protect (allocation-sampler-mix 1000000 3000)
+          (gctools:allocation-sampler-stop))
+        (let* ((stamps (gctools:allocation-sampler-stamps))
+               (cons-bytes (allocation-sampler-bytes stamps "Cons_O"))
+               (vector-bytes (allocation-sampler-bytes stamps "SimpleVector_double")))
+          ;; 24MB of conses and about 24MB of vectors
+          (and (< (* 0.8 24000000) cons-bytes (* 1.25 24000000))
+               (< 0.8 (/ vector-bytes cons-bytes) 1.25)))))
+
+(test-true allocation-sampler-sites
+      (progn
+        (gctools:allocation-sampler-start :interval 8192 :depth 4)
+        (unwind-protect (allocation-sampler-mix 100000 0)
+          (gctools:allocation-sampler-stop))
+        (loop for (nil samples bytes frames) in (gctools:allocation-sampler-sites :limit 5)
+              always (and (plusp samples) (plusp bytes)
+                          (<= (length frames) 4)
+                          (every #'stringp frames)))))
+
+(test allocation-sampler-stopped
+      (progn
+        (gctools:allocation-sampler-start)
+        (gctools:allocation-sampler-stop)
+        (allocation-sampler-mix 100000 100)
+        ;; Nothing is recorded once the sampler is stopped
+        (gctools:allocation-sampler-stop))
+      (0))
+
+;;; Samples stay in the buffer of the thread that took them until they are
+;;; merged, which must still happen after that thread has exited.
+(test-true allocation-sampler-exited-thread
+      (progn
+        (gctools:allocation-sampler-start :interval 8192)
+        (unwind-protect
+             (mp:process-join
+              (mp:process-run-function nil (lambda () (allocation-sampler-mix 200000 0))))
+          (gctools:allocation-sampler-stop))
+        ;; 4.8MB of conses
+        (< (* 0.8 4800000)
+           (allocation-sampler-bytes (gctools:allocation-sampler-stamps) "Cons_O")
+           (* 1.25 4800000))))
@@ -0,0 +1,37 @@
+(in-package #:clasp-tests)
+
+;;; The CLBIND-TEST classes are registered in src/clbind/open.cc.
+;;; TEST-GRAND-CHILD derives from TEST-CHILD (which derives from TEST)
+;;; and from TEST-MIXIN, so calling GET-TAG on one casts the pointer
+;;; to a base at a non-zero offset and GET-MULTIPLIER casts it up two levels.
+
+(test clbind-upcast
+      (let ((g (clbind-test::make-test-grand-child)))
+        (clbind-test::set-multiplier g 7)
+        (list (clbind-test::get-multiplier g) (clbind-test::get-tag g)))
+      ((7 42)))
+
+(test-true clbind-cast-cache-precomputed
+      (multiple-value-bind (entries precomputed capacity)
+          (clbind:cast-cache-statistics)
+        (and (plusp precomputed)
+             (<= precomputed entries)
+             (< entries capacity))))
+
+(defun clbind-cast-stress (nobjects niterations)
+  (let ((objects (loop for i below nobjects
+                       collect (let ((g (clbind-test::make-test-grand-child)))
+                                 (clbind-test::set-multiplier g i)
+                                 g))))
+    (loop repeat niterations
+          always (loop for g in objects
+                       for i from 0
+                       always (and (= (clbind-test::get-multiplier g) i)
+                                   (= (clbind-test::get-tag g) 42))))))
+
+(test-true clbind-cast-threads
+      (let ((threads (loop repeat 8
+                           collect (mp:process-run-function
+                                    "clbind-cast-stress"
+                                    (lambda () (clbind-cast-stress 16 2000))))))
+        (every (lambda (thread) (mp:process-join thread)) threads)))
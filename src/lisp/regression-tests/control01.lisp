@@ -164,3 +164,64 @@
                   item))
           result))
       (4))
+
+;;; Lexical THROWs to a constant tag are compiled as RETURN-FROMs.
+;;; These make sure that doesn't change which CATCH gets the throw.
+(test lexical-throw-1
+      (funcall (compile nil '(lambda (x)
+                              (catch 'lexical-throw
+                                (when x (throw 'lexical-throw (values 1 2)))
+                                3)))
+               t)
+      (1 2))
+
+(test lexical-throw-2
+      (funcall (compile nil '(lambda (f)
+                              (catch 'lexical-throw
+                                (list :outer
+                                      (catch 'lexical-throw
+                                        (funcall f (lambda () (throw 'lexical-throw :inner))))))))
+               #'funcall)
+      ((:outer :inner)))
+
+;;; The inner catch has a variable tag, so the throw must not skip it.
+(test lexical-throw-3
+      (funcall (compile nil '(lambda (tag)
+                              (catch 'lexical-throw
+                                (list :outer
+                                      (catch tag
+                                        (throw 'lexical-throw :inner))))))
+               'lexical-throw)
+      ((:outer :inner)))
+
+;;; A closure made inside the CATCH may be called from within a dynamically
+;;; nested CATCH for the same tag, which must get the throw.
+(test lexical-throw-4
+      (funcall (compile nil '(lambda ()
+                              (catch 'lexical-throw
+                                (let ((thrower (lambda () (throw 'lexical-throw :inner))))
+                                  (list :outer
+                                        (catch 'lexical-throw
+                                          (funcall thrower))))))))
+      ((:outer :inner)))
+
+;;; A constant's value is the tag, not the constant's name.
+(defconstant +lexical-throw-tag+ :lexical-throw-other)
+
+(test lexical-throw-defconstant
+      (funcall (compile nil '(lambda ()
+                              (catch :lexical-throw-other
+                                (list :outer
+                                      (catch '+lexical-throw-tag+
+                                        (throw +lexical-throw-tag+ :inner)))))))
+      (:inner))
+
+(test lexical-throw-unwind-protect
+      (let ((cleanup nil))
+        (list (funcall (compile nil '(lambda (f)
+                                      (catch 'lexical-throw
+                                        (unwind-protect (throw 'lexical-throw :thrown)
+                                          (funcall f)))))
+                       (lambda () (setf cleanup t)))
+              cleanup))
+      ((:thrown t)))
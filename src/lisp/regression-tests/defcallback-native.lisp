@@ -34,3 +34,37 @@
                      collect (clasp-ffi:%mem-ref array :int (* i intsize))))
           (clasp-ffi:%foreign-free array)))
       ((1 2 3 4 5 6 7 8 9 10)))
+
+(test cffi-defcallback-pinned-vector
+      (let ((vector (ext:make-pinned-vector 'ext:integer32 10)))
+        (replace vector '(7 2 10 4 3 5 1 6 9 8))
+        (ext:with-pointer-to-vector-data (pointer vector)
+          (qsort pointer 10 (clasp-ffi:%foreign-type-size :int) (clasp-ffi:%get-callback '<)))
+        (coerce vector 'list))
+      ((1 2 3 4 5 6 7 8 9 10)))
+
+(test pointer-to-vector-data-is-foreign
+      (let ((vector (ext:make-pinned-vector 'ext:integer32 3)))
+        (replace vector '(5 -6 7))
+        (ext:with-pointer-to-vector-data (pointer vector)
+          (values (clasp-ffi::%pointerp pointer)
+                  (clasp-ffi:%mem-ref pointer :int32 4))))
+      (t -6))
+
+(test pinned-vector-element-type
+      (let ((vector (ext:make-pinned-vector 'double-float 3 1d0)))
+        (values (array-element-type vector) (aref vector 2)))
+      (double-float 1d0))
+
+(test with-pinned-objects-values
+      (let ((vector (make-array 4 :element-type 'single-float :initial-element 2f0)))
+        (ext:with-pinned-objects (vector)
+          (values (aref vector 0) (length vector))))
+      (2f0 4))
+
+(test-expect-error pinned-vector-bad-element-type
+                   (ext:make-pinned-vector t 3))
+
+(test-expect-error pointer-rejects-string
+                   (ext:with-pointer-to-vector-data (pointer (copy-seq "cab"))
+                     (qsort pointer 3 1 (clasp-ffi:%get-callback '<))))
@@ -67,3 +67,17 @@
         count)
       (0)
       :description "Check if list of general finalizers were discarded")
+
+;;; A finalizer that signals an error must not stop the others, nor leave
+;;; gctools:garbage-collect waiting for a finalizer thread that is stuck.
+(test finalizers-error
+      (let ((count 0))
+        (let ((s (make-array 5)))
+          (gctools:finalize s (lambda (a) (declare (ignore a)) (incf count)))
+          (gctools:finalize s (lambda (a) (declare (ignore a)) (error "Bad finalizer")))
+          (gctools:finalize s (lambda (a) (declare (ignore a)) (incf count))))
+        (let ((*error-output* (make-broadcast-stream)))
+          (loop repeat 10 do (gctools:garbage-collect)))
+        count)
+      (2)
+      :description "Check that an error in one finalizer doesn't stop the others")
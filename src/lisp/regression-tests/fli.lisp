@@ -0,0 +1,119 @@
+(in-package #:clasp-tests)
+
+;;; clasp-ffi:%mem-ref and %mem-set with a constant foreign type are compiled
+;;; to inline loads and stores (see def-fli-transforms in cleavir/transform.lisp).
+;;; A type that is only known at run time still goes through the generic
+;;; functions, so these check that both paths agree.
+
+(defun fli-ref-out-of-line (pointer type offset)
+  (clasp-ffi:%mem-ref pointer type offset))
+
+(defun fli-set-out-of-line (pointer type value offset)
+  (clasp-ffi:%mem-set pointer type value offset))
+
+(defmacro with-fli-buffer ((pointer size) &body body)
+  `(let ((,pointer (clasp-ffi:%foreign-alloc ,size)))
+     (unwind-protect (progn ,@body)
+       (clasp-ffi:%foreign-free ,pointer))))
+
+;;; Bytes 0-7 are all ones and 8-15 zero but for #x80 in byte 11, so sign and zero
+;;; extension of the same bits give different results.
+(defun fli-fill-pattern (pointer)
+  (dotimes (i 16)
+    (fli-set-out-of-line pointer :uint8 (if (< i 8) #xff 0) i))
+  (fli-set-out-of-line pointer :uint8 #x80 11))
+
+(defparameter *fli-small-types* '(:int8 :uint8 :int16 :uint16 :int32 :uint32 :int32 :uint32))
+(defparameter *fli-small-offsets* '(0 0 0 0 0 0 8 8))
+
+(test fli-ref-small-integers
+      (with-fli-buffer (pointer 16)
+        (fli-fill-pattern pointer)
+        (let ((inline (list (clasp-ffi:%mem-ref pointer :int8 0)
+                            (clasp-ffi:%mem-ref pointer :uint8 0)
+                            (clasp-ffi:%mem-ref pointer :int16 0)
+                            (clasp-ffi:%mem-ref pointer :uint16 0)
+                            (clasp-ffi:%mem-ref pointer :int32)
+                            (clasp-ffi:%mem-ref pointer :uint32)
+                            (clasp-ffi:%mem-ref pointer :int32 8)
+                            (clasp-ffi:%mem-ref pointer :uint32 8))))
+          (values inline
+                  (equal inline (mapcar (lambda (type offset)
+                                          (fli-ref-out-of-line pointer type offset))
+                                        *fli-small-types* *fli-small-offsets*)))))
+      ((-1 255 -1 65535 -1 4294967295 -2147483648 2147483648) t))
+
+(test fli-set-small-integers
+      (with-fli-buffer (pointer 16)
+        (fli-fill-pattern pointer)
+        (clasp-ffi:%mem-set pointer :int8 -2 0)
+        (clasp-ffi:%mem-set pointer :uint16 #xfffe 2)
+        (clasp-ffi:%mem-set pointer :int32 -3 4)
+        (clasp-ffi:%mem-set pointer :uint32 #xfffffffd 8)
+        (list (fli-ref-out-of-line pointer :uint8 0)
+              (fli-ref-out-of-line pointer :int8 1)
+              (fli-ref-out-of-line pointer :int16 2)
+              (fli-ref-out-of-line pointer :uint32 4)
+              (fli-ref-out-of-line pointer :int32 8)))
+      ((254 -1 -2 #xfffffffd -3)))
+
+;;; 64 bit integers that don't fit in a fixnum, and pointers, are boxed by
+;;; the translators on the inline path too.
+(test fli-int64-and-pointer
+      (with-fli-buffer (pointer 24)
+        (let ((big (1+ most-positive-fixnum))
+              (small (1- most-negative-fixnum)))
+          (clasp-ffi:%mem-set pointer :int64 small 0)
+          (clasp-ffi:%mem-set pointer :uint64 (1- (expt 2 64)) 8)
+          (fli-set-out-of-line pointer :pointer (clasp-ffi::%make-pointer big) 16)
+          (values (list (clasp-ffi:%mem-ref pointer :int64 0)
+                        (clasp-ffi:%mem-ref pointer :uint64 8)
+                        (clasp-ffi:%mem-ref pointer :int64 8)
+                        (clasp-ffi::%foreign-data-address
+                         (clasp-ffi:%mem-ref pointer :pointer 16)))
+                  (list (= small (fli-ref-out-of-line pointer :int64 0))
+                        (fli-ref-out-of-line pointer :uint64 8)
+                        (fli-ref-out-of-line pointer :int64 8)
+                        (= big (clasp-ffi::%foreign-data-address
+                                (fli-ref-out-of-line pointer :pointer 16)))))))
+      ((#.(1- most-negative-fixnum) #.(1- (expt 2 64)) -1 #.(1+ most-positive-fixnum))
+       (t #.(1- (expt 2 64)) -1 t)))
+
+(test fli-floats
+      (with-fli-buffer (pointer 16)
+        (clasp-ffi:%mem-set pointer :double -0d0 0)
+        (clasp-ffi:%mem-set pointer :float most-positive-single-float 8)
+        (fli-set-out-of-line pointer :float 1.5f0 12)
+        (values (list (clasp-ffi:%mem-ref pointer :double 0)
+                      (clasp-ffi:%mem-ref pointer :float 8)
+                      (clasp-ffi:%mem-ref pointer :single-float 12))
+                (list (fli-ref-out-of-line pointer :double 0)
+                      (fli-ref-out-of-line pointer :float 8)
+                      (fli-ref-out-of-line pointer :float 12))))
+      ((-0d0 #.most-positive-single-float 1.5f0)
+       (-0d0 #.most-positive-single-float 1.5f0)))
+
+;;; Foreign calls pass floats unboxed when their type is known, and convert
+;;; any other real through the translator.
+(defun fli-copysign-typed (x y)
+  (declare (double-float x y))
+  (clasp-ffi:%foreign-funcall "copysign" :double x :double y :double))
+
+(defun fli-copysign-untyped (x y)
+  (clasp-ffi:%foreign-funcall "copysign" :double x :double y :double))
+
+(defun fli-copysignf-typed (x y)
+  (declare (single-float x y))
+  (clasp-ffi:%foreign-funcall "copysignf" :float x :float y :float))
+
+(defun fli-copysignf-untyped (x y)
+  (clasp-ffi:%foreign-funcall "copysignf" :float x :float y :float))
+
+(test fli-foreign-call-floats
+      (values (list (fli-copysign-typed 2.5d0 -1d0)
+                    (fli-copysign-untyped 2.5d0 -1d0)
+                    (fli-copysign-untyped 5/2 -1))
+              (list (fli-copysignf-typed 2.5f0 -1f0)
+                    (fli-copysignf-untyped 2.5f0 -1f0)
+                    (fli-copysignf-untyped 5/2 -1)))
+      ((-2.5d0 -2.5d0 -2.5d0) (-2.5f0 -2.5f0 -2.5f0)))
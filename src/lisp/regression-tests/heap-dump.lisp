@@ -0,0 +1,42 @@
+(in-package #:clasp-tests)
+
+;;; Build a chain of structs that each hold a vector of 1000 double-floats,
+;;; dump the heap and check that the chain is found to retain about 8MB, and
+;;; that the variable holding it is the root it is attributed to.
+
+(defstruct heap-dump-leak-node
+  (next nil)
+  (data (make-array 1000 :element-type 'double-float :initial-element 0d0)))
+
+(defparameter *heap-dump-leak-chain*
+  (let ((chain nil))
+    (dotimes (i 1000 chain)
+      (setf chain (make-heap-dump-leak-node :next chain)))))
+
+(defun heap-dump-analyze-leak ()
+  (let ((filename (namestring (core:mkstemp "/tmp/clasp-heap-dump-"))))
+    (unwind-protect
+         (progn
+           (gctools:heap-dump filename)
+           (gctools:heap-dump-analyze filename :limit 100000))
+      (delete-file filename))))
+
+(test-true heap-dump-leak-node
+      (multiple-value-bind (types roots)
+          (heap-dump-analyze-leak)
+        (let ((entry (find-if (lambda (entry) (search "HEAP-DUMP-LEAK-NODE" (first entry))) types))
+              (root (find-if (lambda (root) (search "*HEAP-DUMP-LEAK-CHAIN*" (first root))) roots)))
+          (and entry
+               (= (second entry) 1000)
+               (>= (fourth entry) 8000000)
+               root
+               (>= (second root) 8000000)))))
+
+(test-expect-error heap-dump-not-a-dump
+    (let ((filename (namestring (core:mkstemp "/tmp/clasp-heap-dump-"))))
+      (unwind-protect
+           (progn
+             (with-open-file (stream filename :direction :output :if-exists :supersede)
+               (write-line "not a heap dump" stream))
+             (gctools:heap-dump-analyze filename))
+        (delete-file filename))))
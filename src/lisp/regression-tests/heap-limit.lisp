@@ -0,0 +1,123 @@
+(in-package #:clasp-tests)
+
+(test-true heap-in-use
+      (let ((in-use (gctools:heap-in-use)))
+        (and (integerp in-use) (>= in-use 0))))
+
+(test heap-limit-round-trip
+      (let ((old (gctools:heap-limit)))
+        (unwind-protect
+             (list (progn (gctools:set-heap-limit 123456789) (gctools:heap-limit))
+                   (progn (gctools:set-heap-limit nil) (gctools:heap-limit)))
+          (gctools:set-heap-limit old)))
+      ((123456789 nil)))
+
+(test-expect-error heap-limit-bad-type (gctools:set-heap-limit :big) :type type-error)
+(test-expect-error heap-limit-zero (gctools:set-heap-limit 0) :type type-error)
+
+;;; With a limit of one byte every collection goes over it, and the main
+;;; thread, which runs the tests, signals HEAP-LIMIT-EXCEEDED at its next safepoint.
+(defun heap-limit-signal (restart &rest arguments)
+  (let ((old (gctools:heap-limit))
+        (signaled nil))
+    (unwind-protect
+         (handler-bind ((ext:heap-limit-exceeded
+                          (lambda (condition)
+                            (setf signaled
+                                  (and (typep condition 'storage-condition)
+                                       (eql (ext:heap-limit-exceeded-limit condition) 1)
+                                       (> (ext:heap-limit-exceeded-in-use condition) 1)))
+                            (apply #'invoke-restart restart arguments))))
+           (gctools:set-heap-limit 1)
+           (gctools:garbage-collect)
+           (make-list 10)
+           (list signaled (gctools:heap-limit)))
+      (gctools:set-heap-limit old))))
+
+#+(or use-boehm use-mps)
+(test-true heap-limit-continue
+      (destructuring-bind (signaled limit) (heap-limit-signal 'continue)
+        (and signaled (> limit (gctools:heap-in-use)))))
+
+#+(or use-boehm use-mps)
+(test heap-limit-use-value
+      (heap-limit-signal 'use-value nil)
+      ((t nil)))
+
+;;; A collection in another thread is over the limit too, and is signaled in
+;;; that thread, even though the main thread is blocked in PROCESS-JOIN.
+#+(or use-boehm use-mps)
+(test heap-limit-worker-thread
+      (let ((old (gctools:heap-limit))
+            (signaled nil))
+        (flet ((handle (condition)
+                 (declare (ignore condition))
+                 (invoke-restart 'use-value nil)))
+          (unwind-protect
+               (handler-bind ((ext:heap-limit-exceeded #'handle))
+                 (gctools:set-heap-limit 1)
+                 (mp:process-join
+                  (mp:process-run-function
+                   'heap-limit-worker
+                   (lambda ()
+                     (handler-bind ((ext:heap-limit-exceeded
+                                      (lambda (condition)
+                                        (setf signaled t)
+                                        (handle condition))))
+                       (gctools:garbage-collect)
+                       (core:check-pending-interrupts)))))
+                 (core:check-pending-interrupts)
+                 (list signaled (gctools:heap-limit)))
+            (gctools:set-heap-limit old))))
+      ((t nil)))
+
+;;; Close to the limit the collector holds back on growing the heap; away
+;;; from it the heap is free to grow again.
+#+use-boehm
+(test heap-limit-free-space-divisor
+      (let ((old (gctools:heap-limit))
+            (default (gctools:free-space-divisor)))
+        (unwind-protect
+             (handler-bind ((ext:heap-limit-exceeded
+                              (lambda (condition)
+                                (declare (ignore condition))
+                                (invoke-restart 'use-value nil))))
+               (gctools:garbage-collect)
+               (gctools:set-heap-limit (floor (* 3 (gctools:heap-in-use)) 2))
+               (gctools:garbage-collect)
+               (list (> (gctools:free-space-divisor) default)
+                     (progn (gctools:set-heap-limit nil)
+                            (gctools:garbage-collect)
+                            (= (gctools:free-space-divisor) default))))
+          (gctools:set-heap-limit old)))
+      ((t t)))
+
+;;; The sizes are read before the collector starts, so check them in a fresh
+;;; clasp. Return the exit code of (core:exit (if form 0 1)) run there.
+(defun heap-option-check (environment options form)
+  (values (ext:system (format nil "~a ~a ~a --norc --noinform --non-interactive --eval '(core:exit (if ~a 0 1))'"
+                              environment (core:argv 0) options
+                              (let ((*package* (find-package "KEYWORD")))
+                                (prin1-to-string form))))))
+
+(test heap-max-environment
+      (heap-option-check "CLASP_HEAP_MAX=6G" ""
+                         '(eql (gctools:heap-limit) (* 6 1024 1024 1024)))
+      (0))
+
+(test heap-max-option-overrides-environment
+      (heap-option-check "CLASP_HEAP_MAX=6G" "--heap-max 7G"
+                         '(eql (gctools:heap-limit) (* 7 1024 1024 1024)))
+      (0))
+
+#+use-boehm
+(test heap-min-option
+      (heap-option-check "" "--heap-min 256M"
+                         '(>= (getf (gctools:metrics-snapshot) :heap-size-bytes) (* 256 1024 1024)))
+      (0))
+
+#+use-boehm
+(test heap-min-environment
+      (heap-option-check "CLASP_HEAP_MIN=256M" ""
+                         '(>= (getf (gctools:metrics-snapshot) :heap-size-bytes) (* 256 1024 1024)))
+      (0))
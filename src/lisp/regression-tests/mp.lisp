@@ -154,6 +154,31 @@
         (setf (mp:atomic x) s)
         (eq (mp:atomic x) s)))
 
+;;; Writing a dynamically bound variable must not touch its global value.
+(defvar *atomic-symbol-value-3* :global)
+(test atomic-symbol-value-3
+      (list (let ((*atomic-symbol-value-3* :local))
+              (setf (mp:atomic *atomic-symbol-value-3*) :new)
+              (mp:atomic *atomic-symbol-value-3*))
+            *atomic-symbol-value-3*)
+      ((:new :global)))
+
+;;; Bindings in one thread are invisible in others, including threads
+;;; started after the variable got its binding index.
+(defvar *thread-local-special* :global)
+(test thread-local-special-1
+      (let ((*thread-local-special* :outer))
+        (list *thread-local-special*
+              (mp:process-join
+               (mp:process-run-function
+                nil (lambda ()
+                      (list *thread-local-special*
+                            (let ((*thread-local-special* :inner))
+                              *thread-local-special*)
+                            *thread-local-special*))))
+              *thread-local-special*))
+      ((:outer (:global :inner :global) :outer)))
+
 (defun spam-processes (nthreads thunk)
   (let ((threads (loop repeat nthreads
                        collect (mp:process-run-function nil thunk))))
@@ -245,3 +270,411 @@
         (spam-processes nthreads (lambda () (mp:atomic-push nil (car place))))
         (car place))
       ((nil nil nil nil nil nil nil)))
+
+;;; Native read-modify-write on specialized vectors and fixnum struct slots.
+(defun atomic-aref-adds (element-type nthreads n)
+  (let ((vector (make-array 4 :element-type element-type :initial-element 0)))
+    (spam-processes nthreads
+                    (lambda () (dotimes (i n) (mp:atomic-fetch-add (aref vector 2) 1))))
+    (list (aref vector 1) (aref vector 2) (aref vector 3))))
+
+(test atomic-aref-fetch-add
+      (loop for type in '((unsigned-byte 8) (unsigned-byte 16) (unsigned-byte 32)
+                          (unsigned-byte 64) (signed-byte 64) fixnum t)
+            collect (atomic-aref-adds type 8 10000))
+      (((0 128 0) (0 14464 0) (0 80000 0) (0 80000 0) (0 80000 0) (0 80000 0)
+        (0 80000 0))))
+
+(test atomic-aref-fetch-ops
+      (let ((v (make-array 1 :element-type '(unsigned-byte 64)
+                             :initial-element #xff00)))
+        (list (mp:atomic-fetch-or (aref v 0) #x0f)
+              (mp:atomic-fetch-and (aref v 0) #xf0f0)
+              (mp:atomic-fetch-xor (aref v 0) #xffff)
+              (mp:atomic-exchange (aref v 0) (1- (expt 2 64)))
+              (mp:atomic-fetch-add (aref v 0) 2)
+              (mp:atomic-fetch-sub (aref v 0) 2)
+              (aref v 0)))
+      ((#xff00 #xff0f #xf000 #x0fff #.(1- (expt 2 64)) 1 #.(1- (expt 2 64)))))
+
+(test atomic-aref-signed
+      (let ((v (make-array 1 :element-type '(signed-byte 64) :initial-element -5)))
+        (list (mp:atomic-incf (aref v 0) 3)
+              (mp:atomic-fetch-add (aref v 0) most-negative-fixnum)
+              (mp:cas (aref v 0) (+ -2 most-negative-fixnum) 7)
+              (aref v 0)))
+      ((-2 -2 #.(+ -2 most-negative-fixnum) 7)))
+
+(test atomic-aref-double-float
+      (let ((v (make-array 1 :element-type 'double-float :initial-element 1d0)))
+        (list (mp:cas (aref v 0) 2d0 3d0)
+              (mp:cas (aref v 0) 1d0 3d0)
+              (progn (setf (mp:atomic (aref v 0)) 0d0)
+                     (spam-processes 4 (lambda ()
+                                         (dotimes (i 1000)
+                                           (mp:atomic-incf (aref v 0) 0.5d0))))
+                     (mp:atomic (aref v 0)))))
+      ((1d0 1d0 2000d0)))
+
+(test-expect-error atomic-aref-type
+      (let ((v (make-array 1 :element-type '(unsigned-byte 8) :initial-element 0)))
+        (mp:atomic-fetch-add (aref v 0) 256))
+      :type type-error)
+
+(defstruct atomic-counters
+  (hits 0 :type fixnum)
+  (name nil))
+
+(test atomic-struct-slots
+      (let ((counters (make-atomic-counters)))
+        (spam-processes 8 (lambda ()
+                            (dotimes (i 10000)
+                              (mp:atomic-fetch-add (atomic-counters-hits counters) 3))))
+        (list (atomic-counters-hits counters)
+              (mp:atomic-fetch-or (atomic-counters-hits counters) 1)
+              (mp:atomic-exchange (atomic-counters-hits counters) -4)
+              (mp:atomic-incf (atomic-counters-hits counters))
+              (mp:atomic-exchange (atomic-counters-name counters) :new)
+              (mp:cas (atomic-counters-name counters) :new :newer)
+              (atomic-counters-name counters)))
+      ((240000 240000 240001 -3 nil :new :newer)))
+
+(test-true shared-mutex-readers
+      (let ((m (mp:make-shared-mutex)))
+        (mp:shared-lock m)
+        (prog1 (mp:process-join
+                (mp:process-run-function
+                 nil (lambda ()
+                       (mp:shared-lock m)
+                       (mp:shared-unlock m)
+                       (not (mp:write-try-lock m)))))
+          (mp:shared-unlock m))))
+
+(test shared-mutex-upgrade
+      (let ((m (mp:make-shared-mutex)))
+        (mp:shared-lock m)
+        (mp:write-lock m t)
+        ;; Still holding the shared lock after the write lock is released
+        (mp:write-unlock m)
+        (let ((writer (mp:process-run-function
+                       nil (lambda () (mp:write-try-lock m)))))
+          (prog1 (list (mp:process-join writer)
+                       (progn (mp:shared-unlock m) (mp:write-try-lock m)))
+            (mp:write-unlock m))))
+      ((nil t)))
+
+(test shared-mutex-read-biased
+      (let ((m (mp:make-shared-mutex 'reads 'writes t)))
+        (mp:shared-lock m)
+        (let ((writer (mp:process-run-function
+                       nil (lambda () (mp:write-lock m) (mp:write-unlock m) t))))
+          (mp:process-yield)
+          (mp:shared-unlock m)
+          (mp:process-join writer)))
+      (t))
+
+(test shared-mutex-read-biased-try-lock
+      (let ((m (mp:make-shared-mutex 'reads 'writes t)))
+        (mp:shared-lock m)
+        (let ((here (mp:write-try-lock m))
+              (there (mp:process-join
+                      (mp:process-run-function nil (lambda () (mp:write-try-lock m))))))
+          (mp:shared-unlock m)
+          (list here there
+                (prog1 (mp:write-try-lock m) (mp:write-unlock m)))))
+      ((nil nil t)))
+
+(test shared-mutex-contention
+      (loop for kind in '(:futex :futex-read-biased)
+            collect (reduce #'+ (spam-processes
+                                 8 (lambda ()
+                                     (mp:shared-mutex-contention-loop kind 20000 10)))))
+      ((0 0)))
+
+(test-true lock-contention-statistics
+      (let ((mut (mp:make-lock :name "CONTEND")))
+        (mp:reset-lock-contention-statistics)
+        (mp:get-lock mut)
+        (let ((p (mp:process-run-function
+                  nil (lambda () (mp:get-lock mut) (mp:giveup-lock mut)))))
+          (sleep 0.1)
+          (mp:giveup-lock mut)
+          (mp:process-join p))
+        (destructuring-bind (name acquisitions contended wait max-wait)
+            (find "CONTEND" (mp:lock-contention-statistics)
+                  :key #'first :test #'string=)
+          (declare (ignore name acquisitions))
+          (and (>= contended 1) (>= wait max-wait) (> max-wait 0)))))
+
+(test process-join-timeout
+      (let ((p (mp:process-run-function nil (lambda () (sleep 0.5) :done))))
+        (list (mp:process-join p :timeout 0.01 :default :late)
+              (mp:process-join p :timeout 10)))
+      ((:late :done)))
+
+(test-expect-error process-join-timeout-error
+                   (mp:process-join (mp:process-run-function nil (lambda () (sleep 0.5)))
+                                    :timeout 0.01)
+                   :type mp:process-join-timeout)
+
+(test process-wait-for-any
+      (let* ((slow (mp:process-run-function nil (lambda () (sleep 60))))
+             (fast (mp:process-run-function nil (lambda () (sleep 0.05)))))
+        (prog1 (list (eq (mp:wait-for-any-process (list slow fast) :timeout 10) fast)
+                     (mp:wait-for-any-process (list slow) :timeout 0.01)
+                     (mp:wait-for-any-process nil))
+          (mp:process-kill slow)
+          (mp:process-join slow :timeout 10)))
+      ((t nil nil)))
+
+;;; Each process gets its own binding of the hooks, so pushing onto them
+;;; in one process doesn't add hooks to the others.
+(test process-exit-hooks
+      (let* ((ran (list nil))
+             (p (mp:process-run-function
+                 nil (lambda ()
+                       (push (lambda () (push :hook (car ran))) mp:*process-exit-hooks*)
+                       :value))))
+        (list (mp:process-join p)
+              (car ran)
+              mp:*process-exit-hooks*))
+      ((:value (:hook) nil)))
+
+(test process-kill-sleeping
+      (let* ((ran (list nil))
+             (p (mp:process-run-function
+                 nil (lambda ()
+                       (push (lambda () (setf (car ran) :hook)) mp:*process-exit-hooks*)
+                       (sleep 60)
+                       :woke))))
+        (sleep 0.1)
+        (mp:process-kill p)
+        (list (multiple-value-list (mp:process-join p :timeout 10 :default :stuck))
+              (car ran)))
+      ((nil :hook)))
+
+(test process-kill-nascent
+      (let* ((ran (list nil))
+             (p (mp:make-process nil (lambda () (setf (car ran) t)))))
+        (mp:process-kill p)
+        (mp:process-start p)
+        (list (multiple-value-list (mp:process-join p :timeout 10 :default :stuck))
+              (car ran)))
+      ((nil nil)))
+
+(test process-kill-suspended
+      (let ((p (mp:process-run-function nil (lambda () (loop (sleep 0.01))))))
+        (sleep 0.05)
+        (mp:process-suspend p)
+        (loop repeat 1000
+              until (= (mp:process-phase p) 2)
+              do (sleep 0.01))
+        (mp:process-kill p)
+        (multiple-value-list (mp:process-join p :timeout 10 :default :stuck)))
+      (nil))
+
+;;; Spin without allocating or calling anything, so that interrupts can
+;;; only get in through the safepoint poll at the loop header.
+(defun safepoint-spin (flag)
+  (declare (optimize speed (safety 1)))
+  (let ((n 0))
+    (declare (fixnum n))
+    (loop until (car flag)
+          do (setf n (logand (1+ n) most-positive-fixnum)))
+    n))
+
+(test interrupt-compiled-loop
+      (let* ((flag (list nil))
+             (p (mp:process-run-function nil (lambda () (safepoint-spin flag)))))
+        (sleep 0.1)
+        (mp:interrupt-process p (lambda () (mp:exit-process :interrupted)))
+        (prog1 (multiple-value-list (mp:process-join p :timeout 10 :default :stuck))
+          (setf (car flag) t)
+          (mp:process-join p :timeout 10 :default nil)))
+      ((:interrupted)))
+
+(test suspend-compiled-loop
+      (let* ((flag (list nil))
+             (p (mp:process-run-function nil (lambda () (safepoint-spin flag)))))
+        (sleep 0.1)
+        (mp:process-suspend p)
+        (let ((suspended (loop repeat 1000
+                               thereis (= (mp:process-phase p) 2)
+                               do (sleep 0.01))))
+          (mp:process-resume p)
+          (setf (car flag) t)
+          (list suspended
+                (integerp (mp:process-join p :timeout 10 :default :stuck)))))
+      ((t t)))
+
+;;; Writers each count up in their own area of the same symbols while
+;;; another puts and removes a third area. Readers check that every value
+;;; they see was written and that no count goes backwards, which a lost
+;;; update to the per-symbol sysprops would show.
+(defparameter *sysprop-areas* '(sysprop-area-0 sysprop-area-1 sysprop-area-2))
+
+(defun sysprop-stress-read (symbols rounds)
+  (let ((last (make-hash-table :test #'equal))
+        (bad 0))
+    (dotimes (round rounds bad)
+      (dolist (symbol symbols)
+        (dolist (area *sysprop-areas*)
+          (multiple-value-bind (value foundp) (core:get-sysprop symbol area)
+            (let ((key (cons symbol area)))
+              (cond ((not foundp)
+                     (when (gethash key last) (incf bad)))
+                    ((or (not (typep value 'fixnum))
+                         (< value (gethash key last 0)))
+                     (incf bad))
+                    (t (setf (gethash key last) value))))))))))
+
+(test sysprop-parallel
+      (let* ((symbols (loop for i below 64
+                            collect (make-symbol (format nil "SYSPROP-~d" i))))
+             (n 500)
+             (writers (loop for area in (butlast *sysprop-areas*)
+                            collect (let ((area area))
+                                      (mp:process-run-function
+                                       nil (lambda ()
+                                             (loop for count from 1 to n
+                                                   do (dolist (symbol symbols)
+                                                        (core:put-sysprop symbol area count))))))))
+             (churn (mp:process-run-function
+                     nil (lambda ()
+                           (dotimes (i n)
+                             (dolist (symbol symbols)
+                               (core:put-sysprop symbol 'sysprop-churn i)
+                               (core:rem-sysprop symbol 'sysprop-churn))))))
+             (readers (loop repeat 4
+                            collect (mp:process-run-function
+                                     nil (lambda () (sysprop-stress-read symbols n))))))
+        (mapc #'mp:process-join (cons churn writers))
+        (list (reduce #'+ (mapcar #'mp:process-join readers))
+              (loop for symbol in symbols
+                    always (and (eql (core:get-sysprop symbol 'sysprop-area-0) n)
+                                (eql (core:get-sysprop symbol 'sysprop-area-1) n)
+                                (null (nth-value 1 (core:get-sysprop symbol 'sysprop-area-2)))
+                                (null (nth-value 1 (core:get-sysprop symbol 'sysprop-churn)))))))
+      ((0 t)))
+
+(test sysprop-non-symbol-key
+      (let ((name (list 'setf (make-symbol "SYSPROP-SETF"))))
+        (list (core:put-sysprop name 'sysprop-area-0 :value)
+              (multiple-value-list (core:get-sysprop name 'sysprop-area-0))
+              (core:rem-sysprop name 'sysprop-area-0)
+              (multiple-value-list (core:get-sysprop name 'sysprop-area-0))))
+      ((:value (:value t) t (nil nil))))
+
+(defun executor-fib (n)
+  (if (< n 10)
+      (if (< n 2) n (+ (executor-fib (- n 1)) (executor-fib (- n 2))))
+      (let ((left (mp:submit (lambda () (executor-fib (- n 1))))))
+        (+ (executor-fib (- n 2)) (mp:force left)))))
+
+;;; Each task forces the futures of its subtasks, which only finishes if
+;;; waiting workers run other tasks.
+(test executor-nested-force
+      (executor-fib 20)
+      (6765))
+
+(test executor-values
+      (multiple-value-list (mp:force (mp:submit (lambda () (values 1 2 3)))))
+      ((1 2 3)))
+
+(test-expect-error executor-error
+                   (mp:force (mp:submit (lambda () (car 42))))
+                   :type type-error)
+
+(defvar *executor-special* :global)
+
+(test executor-special-bindings
+      (list (mp:force (mp:submit (lambda () *executor-special*)))
+            (mp:force (mp:submit (lambda () *executor-special*)
+                                 :special-bindings '((*executor-special* . (list :task))))))
+      ((:global (:task))))
+
+(test executor-promise
+      (let* ((promise (mp:make-promise))
+             (waiter (mp:process-run-function
+                      nil (lambda () (mp:force promise :timeout 10)))))
+        (list (mp:future-done-p promise)
+              (mp:fulfill-promise promise :kept)
+              (mp:fulfill-promise promise :again)
+              (mp:process-join waiter)))
+      ((nil t nil :kept)))
+
+(test-expect-error executor-force-timeout
+                   (mp:force (mp:make-promise) :timeout 0.05)
+                   :type mp:future-timeout)
+
+(test executor-cancel
+      (let* ((gate (mp:make-promise))
+             (running (mp:submit (lambda ()
+                                   (mp:force gate)
+                                   (mp:future-cancel-requested-p))))
+             (promise (mp:make-promise)))
+        (loop until (eq (mp:future-state running) :running)
+              do (mp:process-yield))
+        (list (mp:cancel-future promise)
+              (handler-case (mp:force promise) (mp:future-cancelled () :cancelled))
+              (mp:cancel-future running)
+              (progn (mp:fulfill-promise gate t)
+                     (mp:force running))))
+      ((t :cancelled nil t)))
+
+;;; With every worker busy a submitted task stays pending, and once it is
+;;; cancelled it never runs, not even when mp:stop-executor drains the queues.
+(test executor-cancel-pending
+      (let* ((gate (mp:make-promise))
+             (blockers (loop repeat (mp:start-executor)
+                             collect (mp:submit (lambda ()
+                                                  (loop until (mp:future-done-p gate)
+                                                        do (mp:process-yield))))))
+             (ran nil)
+             (pending (progn
+                        (loop until (every (lambda (future)
+                                             (eq (mp:future-state future) :running))
+                                           blockers)
+                              do (mp:process-yield))
+                        (mp:submit (lambda () (setf ran t))))))
+        (list (mp:future-state pending)
+              (mp:cancel-future pending)
+              (handler-case (mp:force pending) (mp:future-cancelled () :cancelled))
+              (progn (mp:fulfill-promise gate t)
+                     (mapc #'mp:force blockers)
+                     (mp:stop-executor)
+                     ran)))
+      ((:pending t :cancelled nil)))
+
+(test executor-pmap
+      (list (mp:pmap 'list #'+ '(1 2 3 4) #(10 20 30))
+            (mp:pmap 'vector #'1+ (make-list 1000 :initial-element 1))
+            (mp:pmap nil #'identity '(1 2)))
+      ((11 22 33) #.(make-array 1000 :initial-element 2) nil))
+
+(test executor-preduce
+      (let ((vector (make-array 100000 :initial-contents (loop for i below 100000 collect i))))
+        (list (mp:preduce #'+ vector)
+              (mp:preduce #'+ vector :key #'1+ :start 10 :end 20)
+              (mp:preduce #'+ #() :initial-value 7)
+              (mp:preduce #'list '(1 2 3) :grain 1 :initial-value 0)))
+      ((4999950000 155 7 (((0 1) 2) 3))))
+
+(test executor-pdotimes
+      (let ((vector (make-array 10000 :initial-element 0)))
+        (list (mp:pdotimes (i 10000 i)
+                (setf (svref vector i) (* i i)))
+              (loop for i below 10000 always (= (svref vector i) (* i i)))))
+      ((10000 t)))
+
+;;; An interrupt that reaches a process as it exits never runs, and its
+;;; safepoint request must not outlive the thread.
+(test safepoint-requests-exiting-process
+      (let ((before (core:safepoint-requests)))
+        (loop repeat 100
+              do (let ((process (mp:process-run-function nil (lambda ()))))
+                   ;; It may not be active yet, or may be gone already
+                   (ignore-errors (mp:interrupt-process process (lambda ())))
+                   (mp:process-join process)))
+        (- (core:safepoint-requests) before))
+      (0))
@@ -72,3 +72,145 @@
        nil)))
 
 
+
+;;; cl:directory
+(defun make-directory-test-tree ()
+  (let ((dir (core:mkdtemp "/tmp/clasp-directory-")))
+    (dolist (file '("a.lisp" "b.lisp" "c.fasl" "d.e.lisp" ".hidden"
+                    "sub1/x.lisp" "sub2/y.lisp" "sub2/deeper/z.lisp"))
+      (let ((path (merge-pathnames file dir)))
+        (ensure-directories-exist path)
+        (with-open-file (stream path :direction :output :if-exists :supersede)
+          (write-line file stream))))
+    (ext:system (format nil "ln -s ~a ~a"
+                        (namestring (merge-pathnames "a.lisp" dir))
+                        (namestring (merge-pathnames "link.lisp" dir))))
+    dir))
+
+(defun directory-test-names (paths)
+  (sort (mapcar (lambda (path)
+                  (if (pathname-name path)
+                      (file-namestring path)
+                      (car (last (pathname-directory path)))))
+                paths)
+        #'string<))
+
+(test directory-files
+      (let ((dir (make-directory-test-tree)))
+        (unwind-protect
+             (values (directory-test-names (directory (merge-pathnames "*.lisp" dir)))
+                     (directory-test-names (directory (merge-pathnames "*.fasl" dir)))
+                     (directory-test-names (directory (merge-pathnames "?.lisp" dir)))
+                     (directory-test-names (directory (merge-pathnames "*.*" dir))))
+          (ext:rmtree (namestring dir))))
+      (("a.lisp" "a.lisp" "b.lisp" "d.e.lisp")
+       ("c.fasl")
+       ("a.lisp" "b.lisp")
+       (".hidden" "a.lisp" "a.lisp" "b.lisp" "c.fasl" "d.e.lisp")))
+
+(test directory-no-resolve-symlinks
+      (let ((dir (make-directory-test-tree)))
+        (unwind-protect
+             (directory-test-names (directory (merge-pathnames "*.lisp" dir)
+                                              :resolve-symlinks nil))
+          (ext:rmtree (namestring dir))))
+      (("a.lisp" "b.lisp" "d.e.lisp" "link.lisp")))
+
+(test directory-subdirectories
+      (let ((dir (make-directory-test-tree)))
+        (unwind-protect
+             (values (directory-test-names (directory (merge-pathnames "*/" dir)))
+                     (directory-test-names (directory (merge-pathnames "sub*/*.lisp" dir)))
+                     (directory-test-names (directory (merge-pathnames "**/*.lisp" dir)))
+                     (every (lambda (path) (equal path (truename path)))
+                            (directory (merge-pathnames "**/" dir))))
+          (ext:rmtree (namestring dir))))
+      (("sub1" "sub2")
+       ("x.lisp" "y.lisp")
+       ("a.lisp" "a.lisp" "b.lisp" "d.e.lisp" "x.lisp" "y.lisp" "z.lisp")
+       t))
+
+;;; Links to directories are entered when symlinks are resolved, and a
+;;; link back to an ancestor does not make ** go around in circles.
+(test directory-symlinked-directories
+      (let* ((dir (make-directory-test-tree))
+             (links (list (cons "sub2/" "sub1/linked")
+                          (cons "" "sub2/loop"))))
+        (loop for (target . link) in links
+              do (ext:system (format nil "ln -s ~a ~a"
+                                     (namestring (merge-pathnames target dir))
+                                     (namestring (merge-pathnames link dir)))))
+        (unwind-protect
+             (values (directory-test-names (directory (merge-pathnames "sub1/*/" dir)))
+                     (directory-test-names (directory (merge-pathnames "sub1/*/*.lisp" dir)))
+                     (directory-test-names (directory (merge-pathnames "**/z.lisp" dir))))
+          (loop for (nil . link) in links
+                do (ext:system (format nil "rm -f ~a" (namestring (merge-pathnames link dir)))))
+          (ext:rmtree (namestring dir))))
+      (("sub2")
+       ("y.lisp")
+       ("z.lisp")))
+
+;;; pathname parsing and namestrings
+(test namestring-cached
+      (let* ((path (pathname "/tmp/clasp/foo.lisp"))
+             (namestring (namestring path)))
+        (setf (char namestring 1) #\x)
+        (values (namestring path)
+                (eq (namestring path) (namestring path))))
+      ("/tmp/clasp/foo.lisp" nil))
+
+(test pathname-components-shared
+      (let ((a (pathname "/usr/lib/a.lisp"))
+            (b (pathname "/usr/share/b.lisp")))
+        (values (equal (second (pathname-directory a))
+                       (second (pathname-directory b)))
+                (pathname-type a)))
+      (t "lisp"))
+
+;;; Components may be shared between pathnames, so modifying what an
+;;; accessor returned must not change any pathname.
+(test pathname-components-unshared
+      (let ((a (pathname "/usr/lib/a.lisp"))
+            (b (pathname "/usr/share/b.lisp")))
+        (nstring-upcase (pathname-type a))
+        (nstring-upcase (second (pathname-directory a)))
+        (values (pathname-type b)
+                (namestring a)
+                (namestring (pathname "/usr/lib/c.lisp"))))
+      ("lisp" "/usr/lib/a.lisp" "/usr/lib/c.lisp"))
+
+(test pathname-components-threads
+      (let ((names (loop for i below 64 collect (format nil "/tmp/d~d/f~d.t~d" i i (mod i 8)))))
+        (every #'identity
+               (mapcar #'mp:process-join
+                       (loop repeat 4
+                             collect (mp:process-run-function
+                                      'pathnames
+                                      (lambda ()
+                                        (loop repeat 200
+                                              always (every (lambda (name)
+                                                              (string= name (namestring (pathname name))))
+                                                            names))))))))
+      (t))
+
+(test parse-namestring-displaced
+      (let* ((text "xx/tmp/dir/file.fasl")
+             (displaced (make-array 18 :element-type 'character
+                                       :displaced-to text
+                                       :displaced-index-offset 2))
+             (filled (make-array 30 :element-type 'character
+                                    :fill-pointer 15 :initial-element #\z)))
+        (replace filled "/tmp/other.txt/")
+        (setf (fill-pointer filled) 14)
+        (values (namestring (pathname displaced))
+                (pathname-name (pathname filled))
+                (pathname-type (pathname filled))))
+      ("/tmp/dir/file.fasl" "other" "txt"))
+
+(test make-pathname-copies-directory
+      (let* ((directory (list :absolute (copy-seq "tmp")))
+             (path (make-pathname :directory directory :name "x")))
+        (setf (char (second directory) 0) #\q)
+        (namestring path))
+      ("/tmp/x"))
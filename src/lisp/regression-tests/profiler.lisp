@@ -0,0 +1,94 @@
+(in-package #:clasp-tests)
+
+;;; Profile the ctak benchmark and check that the samples were
+;;; symbolized back to its Lisp functions.
+(load "sys:regression-tests;time-ctak.lisp")
+
+(test-true profiler-ctak
+      (progn
+        (ext:profiler-start :frequency 1000)
+        (unwind-protect (run-ctak)
+          (ext:profiler-stop))
+        (let ((report (with-output-to-string (s)
+                        (ext:profiler-report :output s))))
+          (and (search "CTAK-AUX" report) t))))
+
+(test-true profiler-report-format
+      ;; Every line is "frame;frame;... count"
+      (with-input-from-string (s (with-output-to-string (s)
+                                   (ext:profiler-report :output s :threads t)))
+        (loop for line = (read-line s nil)
+              while line
+              always (let ((space (position #\Space line :from-end t)))
+                       (and space
+                            (plusp (parse-integer line :start (1+ space))))))))
+
+(test-expect-error profiler-report-while-running
+      (progn
+        (ext:profiler-start)
+        (unwind-protect (ext:profiler-report :output (make-broadcast-stream))
+          (ext:profiler-stop))))
+
+;;; Once the profiler has stopped, a SIGPROF sent with kill reaches clasp's
+;;; own handler again, here a Lisp function pushed for it.
+(defvar *sigprof-received* nil)
+(defun note-sigprof () (setf *sigprof-received* t))
+
+(test-true profiler-chains-sigprof
+      (let ((sigprof (cdr (assoc :sigprof (core:signal-code-alist)))))
+        (core:push-unix-signal-handler sigprof :sigprof 'note-sigprof)
+        (unwind-protect
+             (progn
+               (ext:profiler-start :duration 1)
+               (ext:profiler-stop)
+               (ext:system (format nil "kill -PROF ~d" (core:getpid)))
+               (loop repeat 100 until *sigprof-received* do (sleep 0.01))
+               *sigprof-received*)
+          (core:push-unix-signal-handler sigprof :sigprof nil))))
+
+;;; Runtime metrics
+
+(test-true metrics-snapshot-plist
+      (let ((snapshot (gctools:metrics-snapshot)))
+        (and (integerp (getf snapshot :gc-collections))
+             (integerp (getf snapshot :threads-active))
+             (let ((pauses (getf snapshot :gc-pause-seconds)))
+               (and (integerp (getf pauses :count))
+                    (listp (getf pauses :buckets)))))))
+
+#+use-boehm
+(test-true metrics-gc-collections
+      (let ((before (getf (gctools:metrics-snapshot) :gc-collections)))
+        (gctools:garbage-collect)
+        (let ((after (gctools:metrics-snapshot)))
+          (and (> (getf after :gc-collections) before)
+               (plusp (getf (getf after :gc-pause-seconds) :count))))))
+
+#+use-boehm
+(test-true metrics-allocation-rate-stable
+      ;; Reading the rate doesn't move the window, so two reads in a row agree.
+      (progn
+        (gctools:garbage-collect)
+        (make-list 100000)
+        (let ((first (getf (gctools:metrics-snapshot) :allocation-bytes-per-second))
+              (second (getf (gctools:metrics-snapshot) :allocation-bytes-per-second)))
+          (and (plusp first) (plusp second)
+               (< (abs (- first second)) (/ first 2))))))
+
+(test-true metrics-dump-format
+      ;; Every line is a comment or "name value"
+      (with-input-from-string (s (with-output-to-string (s)
+                                   (gctools:metrics-dump s)))
+        (loop for line = (read-line s nil)
+              while line
+              always (or (char= (char line 0) #\#)
+                         (and (eql 0 (search "clasp_" line))
+                              (position #\Space line))))))
+
+#+use-boehm
+(test-true metrics-gc-mark-time
+      (progn
+        (gctools:garbage-collect)
+        (let ((snapshot (gctools:metrics-snapshot)))
+          (and (plusp (getf (getf snapshot :gc-mark-seconds) :count))
+               (plusp (getf snapshot :gc-markers))))))
@@ -11,6 +11,7 @@
 ;;; Run tests
 (reset-clasp-tests)
 (load-if-compiled-correctly "sys:regression-tests;defcallback-native.lisp")
+(load-if-compiled-correctly "sys:regression-tests;fli.lisp")
 (load-if-compiled-correctly "sys:regression-tests;lowlevel.lisp")
 (load-if-compiled-correctly "sys:regression-tests;fastgf.lisp")
 (load-if-compiled-correctly "sys:regression-tests;stamps.lisp")
@@ -56,7 +57,12 @@
         )
 #+(and)(load-if-compiled-correctly "sys:regression-tests;debug.lisp")
 (load-if-compiled-correctly "sys:regression-tests;mp.lisp")
+(load-if-compiled-correctly "sys:regression-tests;profiler.lisp")
+(load-if-compiled-correctly "sys:regression-tests;allocation-sampler.lisp")
+(load-if-compiled-correctly "sys:regression-tests;heap-dump.lisp")
+(load-if-compiled-correctly "sys:regression-tests;heap-limit.lisp")
 (load-if-compiled-correctly "sys:regression-tests;posix.lisp")
+(load-if-compiled-correctly "sys:regression-tests;clbind.lisp")
 ;;; system-construction should be last for now.
 ;;; When we have it before debug.lisp, debug.lisp will fail
 (load-if-compiled-correctly "sys:regression-tests;system-construction.lisp")
@@ -87,3 +87,54 @@
            (equal
             (type-of "zażółć gęślą jaźń")
             '(SIMPLE-ARRAY CHARACTER (17))))
+
+;;; The string kernels work a vector at a time, so use strings longer than
+;;; a vector register and put the interesting characters past the first block
+(test string-kernel-position-1
+      (let ((s (make-string 100 :initial-element #\a :element-type 'base-char)))
+        (setf (char s 70) #\b (char s 90) #\b)
+        (values (position #\b s) (position #\b s :from-end t)
+                (position #\b s :start 71) (position #\b s :end 70)
+                (position #\b s :test #'char=) (position #\z s)))
+      (70 90 90 nil 70 nil))
+(test string-kernel-position-2
+      (let ((s (make-string 100 :initial-element #\a)))
+        (setf (char s 37) (code-char 955) (char s 99) (code-char 955))
+        (values (position (code-char 955) s) (position (code-char 955) s :from-end t)
+                (position (code-char 955) (coerce "aaa" 'base-string))
+                (find (code-char 955) s :test 'eql)))
+      (37 99 nil #.(code-char 955)))
+(test string-kernel-position-displaced
+      (let* ((base (concatenate 'string (make-string 40 :initial-element #\x) "needle"
+                                (make-string 40 :initial-element #\x)))
+             (s (make-array 50 :element-type 'character :displaced-to base
+                               :displaced-index-offset 20 :fill-pointer 30)))
+        (values (position #\n s) (position #\e s :from-end t) (position #\y s)))
+      (20 25 nil))
+(test string-kernel-search-1
+      (let ((hay (concatenate 'string (make-string 200 :initial-element #\a) "aab"
+                              (make-string 10 :initial-element #\a) "aab")))
+        (values (search "aab" hay) (search "aab" hay :start2 202)
+                (search "aab" hay :test #'char=) (search "aac" hay)
+                (search "" hay) (search (coerce "aab" 'base-string) hay)))
+      (200 213 200 nil 0 200))
+(test string-kernel-equal-1
+      (let ((a (make-string 70 :initial-element #\q))
+            (b (make-string 70 :initial-element #\Q :element-type 'base-char)))
+        (values (string= a a) (string= a b) (string-equal a b)
+                (string/= a (string-downcase b)) (string-not-equal a b)
+                (string= a (subseq a 1)) (string/= a (subseq a 1))
+                (progn (setf (char a 65) #\r) (string-not-equal a b))))
+      (t nil t nil nil nil 69 65))
+(test string-kernel-equal-2
+      (values (string-equal "@[`{" "@[`{") (string-equal "@" "`") (string-equal "[" "{"))
+      (t nil nil))
+(test string-kernel-case-1
+      (let ((s (concatenate 'string "Hello, World! " (make-string 40 :initial-element #\z)
+                            (string (code-char 955)) "Zz")))
+        (values (string-upcase s :start 40) (string-downcase (string-upcase s))
+                (nstring-upcase (copy-seq "abc[]{}@`xyz"))))
+      ("Hello, World! zzzzzzzzzzzzzzzzzzzzzzzzzzZZZZZZZZZZZZZZΛZZ"
+       "hello, world! zzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzλzz"
+       "ABC[]{}@`XYZ")
+      :test 'string=)
@@ -0,0 +1,66 @@
+;;; Timing atomic counters under contention: native fetch-add on
+;;; specialized vectors and fixnum structure slots against the CAS loop
+;;; that other places use.
+
+(load "sys:regression-tests;time-common.lisp")
+
+(defpackage #:time-atomics
+  (:use #:cl #:clasp-timing)
+  (:export #:run-all))
+
+(in-package #:time-atomics)
+
+(defstruct atomic-timing-counter (count 0 :type fixnum))
+
+;;; Each thread adds 1 to the same element N times.
+(defun time-fetch-add (&optional (nthreads 1) (n 1000000))
+  (let ((vector (make-array 1 :element-type '(unsigned-byte 64) :initial-element 0)))
+    (declare (type (simple-array (unsigned-byte 64) (1)) vector))
+    (seconds-in-threads nthreads
+                        (lambda (n)
+                          (dotimes (i n) (mp:atomic-fetch-add (aref vector 0) 1)))
+                        n)))
+
+(defun time-fetch-add-fixnum (&optional (nthreads 1) (n 1000000))
+  (let ((vector (make-array 1 :element-type 'fixnum :initial-element 0)))
+    (declare (type (simple-array fixnum (1)) vector))
+    (seconds-in-threads nthreads
+                        (lambda (n)
+                          (dotimes (i n) (mp:atomic-fetch-add (aref vector 0) 1)))
+                        n)))
+
+(defun time-fetch-add-struct (&optional (nthreads 1) (n 1000000))
+  (let ((counter (make-atomic-timing-counter)))
+    (seconds-in-threads nthreads
+                        (lambda (n)
+                          (dotimes (i n)
+                            (mp:atomic-fetch-add (atomic-timing-counter-count counter) 1)))
+                        n)))
+
+;;; The same counter with a CAS loop, as before fetch-add was native.
+(defun time-cas-loop (&optional (nthreads 1) (n 1000000))
+  (let ((vector (make-array 1 :element-type '(unsigned-byte 64) :initial-element 0)))
+    (declare (type (simple-array (unsigned-byte 64) (1)) vector))
+    (seconds-in-threads nthreads
+                        (lambda (n)
+                          (dotimes (i n) (mp:atomic-update (aref vector 0) #'+ 1)))
+                        n)))
+
+(defun time-cas-loop-svref (&optional (nthreads 1) (n 1000000))
+  (let ((vector (make-array 1 :initial-element 0)))
+    (seconds-in-threads nthreads
+                        (lambda (n)
+                          (dotimes (i n) (mp:atomic-incf (svref vector 0))))
+                        n)))
+
+(defun run-all (&optional (max-threads 64) (n 1000000))
+  (format t "~&threads   fetch-add  fetch-add-fixnum  fetch-add-struct    cas-loop  cas-loop-svref~%")
+  (loop for threads = 1 then (* 2 threads)
+        while (<= threads max-threads)
+        do (format t "~7d ~11,3f ~17,3f ~17,3f ~11,3f ~15,3f~%"
+                   threads
+                   (time-fetch-add threads n)
+                   (time-fetch-add-fixnum threads n)
+                   (time-fetch-add-struct threads n)
+                   (time-cas-loop threads n)
+                   (time-cas-loop-svref threads n))))
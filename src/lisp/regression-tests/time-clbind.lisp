@@ -0,0 +1,63 @@
+;;; Timing calls through clbind wrappers against Lisp functions that do the
+;;; same work.
+
+(load "sys:regression-tests;time-common.lisp")
+
+(defpackage #:time-clbind
+  (:use #:cl #:clasp-timing)
+  (:export #:run-all))
+
+(in-package #:time-clbind)
+
+;;; A Lisp stand-in for clbind-test::test, whose GET-MULTIPLIER method
+;;; is a one line C++ getter.
+(defstruct lisp-test (multiplier 1234 :type fixnum))
+
+(declaim (notinline lisp-get-multiplier))
+(defun lisp-get-multiplier (test)
+  (lisp-test-multiplier test))
+
+(defun sum-wrapped-getter (test n)
+  (let ((sum 0))
+    (declare (fixnum sum))
+    (dotimes (i n sum)
+      (setf sum (logand most-positive-fixnum (+ sum (clbind-test::get-multiplier test)))))))
+
+(defun sum-lisp-getter (test n)
+  (let ((sum 0))
+    (declare (fixnum sum))
+    (dotimes (i n sum)
+      (setf sum (logand most-positive-fixnum (+ sum (lisp-get-multiplier test)))))))
+
+(defun call-wrapped-setter (test n)
+  (dotimes (i n)
+    (clbind-test::set-multiplier test i)))
+
+(defun call-lisp-setter (test n)
+  (dotimes (i n)
+    (setf (lisp-test-multiplier test) i)))
+
+(defun time-wrapped-getter (&optional (nthreads 1) (n 10000000))
+  (time-in-threads nthreads (lambda (n) (sum-wrapped-getter (clbind-test::make-test) n)) n))
+
+;;; The getter is inherited from TEST, so each call on a TEST-GRAND-CHILD
+;;; also casts the object to the base.
+(defun time-wrapped-getter-upcast (&optional (nthreads 1) (n 10000000))
+  (time-in-threads nthreads (lambda (n) (sum-wrapped-getter (clbind-test::make-test-grand-child) n)) n))
+
+(defun time-lisp-getter (&optional (nthreads 1) (n 10000000))
+  (time-in-threads nthreads (lambda (n) (sum-lisp-getter (make-lisp-test) n)) n))
+
+(defun time-wrapped-setter (&optional (nthreads 1) (n 10000000))
+  (time-in-threads nthreads (lambda (n) (call-wrapped-setter (clbind-test::make-test) n)) n))
+
+(defun time-lisp-setter (&optional (nthreads 1) (n 10000000))
+  (time-in-threads nthreads (lambda (n) (call-lisp-setter (make-lisp-test) n)) n))
+
+(defun run-all (&optional (nthreads 4))
+  (dolist (threads (list 1 nthreads))
+    (time-wrapped-getter threads)
+    (time-wrapped-getter-upcast threads)
+    (time-lisp-getter threads)
+    (time-wrapped-setter threads)
+    (time-lisp-setter threads)))
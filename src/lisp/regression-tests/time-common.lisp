@@ -0,0 +1,28 @@
+;;; Helpers for the time-*.lisp benchmarks, which are not part of run-all.
+;;; Each benchmark file loads this one and has its own package named after
+;;; the file, e.g. load time-cons.lisp and call (time-cons:run-all) or one
+;;; of the time- functions in that package.
+
+(defpackage #:clasp-timing
+  (:use #:cl)
+  (:export #:seconds-in-threads #:time-in-threads))
+
+(in-package #:clasp-timing)
+
+;;; Call FUNCTION with N in each of NTHREADS new threads and return the
+;;; seconds until they have all finished.
+(defun seconds-in-threads (nthreads function n)
+  (let* ((start (get-internal-real-time))
+         (threads (loop repeat nthreads
+                        collect (mp:process-run-function
+                                 'timing (lambda () (funcall function n))))))
+    (mapc #'mp:process-join threads)
+    (/ (float (- (get-internal-real-time) start) 1d0)
+       internal-time-units-per-second)))
+
+;;; The same, but report with TIME.
+(defun time-in-threads (nthreads function n)
+  (let ((threads (loop repeat nthreads
+                       collect (mp:process-run-function
+                                'timing (lambda () (funcall function n))))))
+    (time (mapc #'mp:process-join threads))))
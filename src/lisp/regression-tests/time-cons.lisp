@@ -0,0 +1,45 @@
+;;; Timing cons allocation as the number of consing threads grows. Each
+;;; thread takes its conses from its own free list and only goes to the
+;;; collector for a new batch, so the time per thread should stay flat
+;;; until the collector itself is the limit.
+
+(load "sys:regression-tests;time-common.lisp")
+
+(defpackage #:time-cons
+  (:use #:cl #:clasp-timing)
+  (:export #:run-all))
+
+(in-package #:time-cons)
+
+;;; Each thread builds lists of LENGTH conses until it has made N.
+(defun time-list (&optional (nthreads 1) (n 10000000) (length 1000))
+  (seconds-in-threads nthreads
+                      (lambda (n)
+                        (loop repeat (floor n length)
+                              do (make-list length)))
+                      n))
+
+(defun time-mapcar (&optional (nthreads 1) (n 10000000) (length 1000))
+  (let ((list (make-list length :initial-element 1)))
+    (seconds-in-threads nthreads
+                        (lambda (n)
+                          (loop repeat (floor n length)
+                                do (mapcar #'1+ list)))
+                        n)))
+
+(defun time-collect (&optional (nthreads 1) (n 10000000) (length 1000))
+  (seconds-in-threads nthreads
+                      (lambda (n)
+                        (loop repeat (floor n length)
+                              do (loop for i below length collect i)))
+                      n))
+
+(defun run-all (&optional (max-threads 64) (n 10000000))
+  (format t "~&threads        list      mapcar     collect~%")
+  (loop for threads = 1 then (* 2 threads)
+        while (<= threads max-threads)
+        do (format t "~7d ~11,3f ~11,3f ~11,3f~%"
+                   threads
+                   (time-list threads n)
+                   (time-mapcar threads n)
+                   (time-collect threads n))))
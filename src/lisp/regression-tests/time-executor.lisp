@@ -0,0 +1,71 @@
+;;; Timing the executor as the number of workers grows: nested futures
+;;; (fib), a parallel merge sort and PREDUCE over a large vector.
+
+(load "sys:regression-tests;time-common.lisp")
+
+(defpackage #:time-executor
+  (:use #:cl)
+  (:export #:run-all))
+
+(in-package #:time-executor)
+
+(defun seconds-with-workers (nworkers function)
+  (mp:stop-executor)
+  (mp:start-executor nworkers)
+  (let ((start (get-internal-real-time)))
+    (funcall function)
+    (/ (float (- (get-internal-real-time) start) 1d0)
+       internal-time-units-per-second)))
+
+(defun serial-fib (n)
+  (if (< n 2) n (+ (serial-fib (- n 1)) (serial-fib (- n 2)))))
+
+;;; Below CUTOFF the work is done serially, above it one branch is a task.
+(defun parallel-fib (n cutoff)
+  (if (< n cutoff)
+      (serial-fib n)
+      (let ((left (mp:submit (lambda () (parallel-fib (- n 1) cutoff)))))
+        (+ (parallel-fib (- n 2) cutoff) (mp:force left)))))
+
+(defun time-fib (&optional (nworkers 1) (n 32) (cutoff 18))
+  (seconds-with-workers nworkers
+                        (lambda ()
+                          (mp:force (mp:submit (lambda () (parallel-fib n cutoff)))))))
+
+;;; Sort the halves in parallel and merge them.
+(defun parallel-sort (vector start end cutoff)
+  (if (< (- end start) cutoff)
+      (sort (subseq vector start end) #'<)
+      (let* ((middle (floor (+ start end) 2))
+             (left (mp:submit (lambda () (parallel-sort vector start middle cutoff))))
+             (right (parallel-sort vector middle end cutoff)))
+        (merge 'simple-vector (mp:force left) right #'<))))
+
+(defun random-vector (n)
+  (let ((vector (make-array n)))
+    (dotimes (i n vector)
+      (setf (svref vector i) (random most-positive-fixnum)))))
+
+(defun time-sort (&optional (nworkers 1) (n 1000000) (cutoff 10000))
+  (let ((vector (random-vector n)))
+    (seconds-with-workers nworkers
+                          (lambda ()
+                            (mp:force (mp:submit (lambda ()
+                                                   (parallel-sort vector 0 n cutoff))))))))
+
+(defun time-reduce (&optional (nworkers 1) (n 10000000))
+  (let ((vector (make-array n :element-type 'double-float :initial-element 1d0)))
+    (seconds-with-workers nworkers
+                          (lambda ()
+                            (mp:preduce #'+ vector :key (lambda (x) (* x x)))))))
+
+(defun run-all (&optional (max-workers 64))
+  (format t "~&workers         fib        sort      reduce~%")
+  (loop for workers = 1 then (* 2 workers)
+        while (<= workers max-workers)
+        do (format t "~7d ~11,3f ~11,3f ~11,3f~%"
+                   workers
+                   (time-fib workers)
+                   (time-sort workers)
+                   (time-reduce workers)))
+  (mp:stop-executor))
@@ -0,0 +1,40 @@
+;;; Timing finalizer registration and collection.
+
+(load "sys:regression-tests;time-common.lisp")
+
+(defpackage #:time-finalizers
+  (:use #:cl #:clasp-timing)
+  (:export #:run-all))
+
+(in-package #:time-finalizers)
+
+(defvar *finalized* (list 0))
+
+;;; Register a finalizer on each of N fresh objects and drop them.
+(defun register-finalizers (n)
+  (dotimes (i n)
+    (gctools:finalize (make-array 4) (lambda (o)
+                                       (declare (ignore o))
+                                       (mp:atomic-incf (car *finalized*))))))
+
+;;; Register and then remove the finalizer, as a resource wrapper does when
+;;; it is closed explicitly.
+(defun register-definalize (n)
+  (dotimes (i n)
+    (let ((object (make-array 4)))
+      (gctools:finalize object (lambda (o) (declare (ignore o))))
+      (gctools:definalize object))))
+
+(defun time-register-finalizers (&optional (nthreads 1) (n 1000000))
+  (setf (car *finalized*) 0)
+  (time-in-threads nthreads #'register-finalizers n)
+  (time (loop repeat 3 do (gctools:garbage-collect)))
+  (format t "~d of ~d finalizers ran~%" (car *finalized*) (* nthreads n)))
+
+(defun time-register-definalize (&optional (nthreads 1) (n 1000000))
+  (time-in-threads nthreads #'register-definalize n))
+
+(defun run-all (&optional (nthreads 4))
+  (dolist (threads (list 1 nthreads))
+    (time-register-finalizers threads)
+    (time-register-definalize threads)))
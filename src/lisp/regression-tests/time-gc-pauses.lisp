@@ -0,0 +1,54 @@
+;;; Timing full collections as the live heap grows. The number of marker
+;;; threads is fixed when clasp starts, so run this once per marker count,
+;;; e.g. clasp --gc-markers 1, then 4, then 16, and compare the tables.
+
+(load "sys:regression-tests;time-common.lisp")
+
+(defpackage #:time-gc-pauses
+  (:use #:cl)
+  (:export #:run-all))
+
+(in-package #:time-gc-pauses)
+
+(defvar *live* nil)
+
+;;; A live heap of about MEGABYTES: conses for the pointer chasing plus
+;;; simple vectors that the marker can split between threads.
+(defun make-live-heap (megabytes)
+  (let ((conses (make-list (floor (* megabytes 1024 1024) 2 32)))
+        (vectors (loop repeat (floor (* megabytes 1024 1024) 2 8192)
+                       collect (make-array 1024 :initial-element nil))))
+    (list conses vectors)))
+
+(defun gc-metric (snapshot name field)
+  (getf (getf snapshot name) field))
+
+;;; Collect N times with a live heap of MEGABYTES and return the mean pause,
+;;; the longest pause since startup and the mean mark time, in seconds.
+;;; The heaps grow from one call of RUN-ALL to the next, so the longest pause
+;;; is the one at the current size.
+(defun time-gc-pauses (&optional (megabytes 256) (n 5))
+  (setf *live* (make-live-heap megabytes))
+  (gctools:garbage-collect)
+  (let ((before (gctools:metrics-snapshot)))
+    (loop repeat n do (gctools:garbage-collect))
+    (let* ((after (gctools:metrics-snapshot))
+           (collections (- (gc-metric after :gc-pause-seconds :count)
+                           (gc-metric before :gc-pause-seconds :count)))
+           (pause (- (gc-metric after :gc-pause-seconds :sum)
+                     (gc-metric before :gc-pause-seconds :sum)))
+           (mark (- (gc-metric after :gc-mark-seconds :sum)
+                    (gc-metric before :gc-mark-seconds :sum))))
+      (setf *live* nil)
+      (values (/ pause (max 1 collections))
+              (gc-metric after :gc-pause-seconds :max)
+              (/ mark (max 1 collections))))))
+
+(defun run-all (&optional (max-megabytes 2048))
+  (format t "~&markers ~d~%" (getf (gctools:metrics-snapshot) :gc-markers))
+  (format t "heap-mb  mean-pause   max-pause   mean-mark~%")
+  (loop for megabytes = 64 then (* 2 megabytes)
+        while (<= megabytes max-megabytes)
+        do (multiple-value-bind (pause max-pause mark)
+               (time-gc-pauses megabytes)
+             (format t "~7d ~11,4f ~11,4f ~11,4f~%" megabytes pause max-pause mark))))
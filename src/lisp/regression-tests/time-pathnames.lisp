@@ -0,0 +1,52 @@
+;;; Pathname heavy microbenchmarks, similar to what build tools such as
+;;; ASDF do when they compute output files.
+
+(load "sys:regression-tests;time-common.lisp")
+
+(defpackage #:time-pathnames
+  (:use #:cl)
+  (:export #:run-all))
+
+(in-package #:time-pathnames)
+
+(defparameter *namestrings*
+  (loop for i below 200
+        collect (format nil "/home/user/quicklisp/dists/quicklisp/software/system-~d/src/module-~d/file-~d.lisp"
+                        (mod i 17) (mod i 5) i)))
+
+(defun parse-namestrings (n)
+  (dotimes (i n)
+    (dolist (namestring *namestrings*)
+      (pathname namestring))))
+
+(defun print-namestrings (n)
+  (let ((paths (mapcar #'pathname *namestrings*)))
+    (dotimes (i n)
+      (dolist (path paths)
+        (namestring path)))))
+
+(defun merge-fasl-pathnames (n)
+  (let ((paths (mapcar #'pathname *namestrings*))
+        (output (pathname "/home/user/.cache/common-lisp/clasp/")))
+    (dotimes (i n)
+      (dolist (path paths)
+        (namestring (merge-pathnames (make-pathname :type "fasl"
+                                                    :directory (cons :relative (cdr (pathname-directory path)))
+                                                    :defaults path)
+                                     output))))))
+
+(defun probe-files (n)
+  (let ((paths (directory "sys:src;core;*.cc")))
+    (dotimes (i n)
+      (dolist (path paths)
+        (probe-file path)))))
+
+(defun run-all (&optional (n 1000))
+  (format t "Parsing ~a namestrings~%" (* n (length *namestrings*)))
+  (time (parse-namestrings n))
+  (format t "Computing ~a namestrings~%" (* n (length *namestrings*)))
+  (time (print-namestrings n))
+  (format t "Merging ~a fasl pathnames~%" (* n (length *namestrings*)))
+  (time (merge-fasl-pathnames n))
+  (format t "Probing files ~a times~%" (floor n 10))
+  (time (probe-files (floor n 10))))
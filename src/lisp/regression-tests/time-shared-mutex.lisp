@@ -0,0 +1,43 @@
+;;; Timing shared mutexes under contention, comparing the old
+;;; UpgradableSharedMutex with the futex lock that shared mutexes and
+;;; thread-safe hash tables use now.
+
+(load "sys:regression-tests;time-common.lisp")
+
+(defpackage #:time-shared-mutex
+  (:use #:cl #:clasp-timing)
+  (:export #:run-all))
+
+(in-package #:time-shared-mutex)
+
+;;; Each thread locks the mutex N times, writing once every WRITE-EVERY.
+(defun time-shared-mutex (kind &optional (nthreads 1) (n 1000000) (write-every 100))
+  (seconds-in-threads nthreads
+                      (lambda (n)
+                        (let ((torn (mp:shared-mutex-contention-loop kind n write-every)))
+                          (unless (zerop torn)
+                            (error "~d torn reads with ~s" torn kind))))
+                      n))
+
+;;; Lookups in a thread-safe hash table go through the shared lock.
+(defun time-gethash (&optional (nthreads 1) (n 1000000) (write-every 100))
+  (let ((table (make-hash-table :thread-safe t)))
+    (dotimes (i 100) (setf (gethash i table) i))
+    (seconds-in-threads nthreads
+                        (lambda (n)
+                          (dotimes (i n)
+                            (if (zerop (mod i write-every))
+                                (setf (gethash (mod i 100) table) i)
+                                (gethash (mod i 100) table))))
+                        n)))
+
+(defun run-all (&optional (max-threads 64) (write-every 100))
+  (format t "~&threads  upgradable       futex  futex-read-biased     gethash~%")
+  (loop for threads = 1 then (* 2 threads)
+        while (<= threads max-threads)
+        do (format t "~7d ~11,3f ~11,3f ~18,3f ~11,3f~%"
+                   threads
+                   (time-shared-mutex :upgradable threads 1000000 write-every)
+                   (time-shared-mutex :futex threads 1000000 write-every)
+                   (time-shared-mutex :futex-read-biased threads 1000000 write-every)
+                   (time-gethash threads 1000000 write-every))))
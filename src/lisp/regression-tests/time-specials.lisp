@@ -0,0 +1,63 @@
+;;; Timing special variable binding and reading.
+
+(load "sys:regression-tests;time-common.lisp")
+
+(defpackage #:time-specials
+  (:use #:cl #:clasp-timing)
+  (:export #:run-all))
+
+(in-package #:time-specials)
+
+(defvar *special-counter* 0)
+(defvar *special-flag* nil)
+
+;;; Read a special that is not bound in this thread (global value).
+(defun read-global-special (n)
+  (let ((sum 0))
+    (declare (fixnum sum))
+    (dotimes (i n sum)
+      (when *special-flag* (incf sum))
+      (incf sum (the fixnum *special-counter*)))))
+
+;;; Read a special that is bound in this thread.
+(defun read-bound-special (n)
+  (let ((*special-counter* 1))
+    (read-global-special n)))
+
+;;; Bind and read in a loop.
+(defun bind-special (n)
+  (let ((sum 0))
+    (declare (fixnum sum))
+    (dotimes (i n sum)
+      (let ((*special-counter* i))
+        (incf sum (logand (the fixnum *special-counter*) 1))))))
+
+;;; Nested bindings of a few of the variables printing binds.
+(defun bind-printer-specials (n)
+  (let ((sum 0))
+    (declare (fixnum sum))
+    (dotimes (i n sum)
+      (let ((*print-pretty* nil)
+            (*print-circle* nil)
+            (*print-base* 10))
+        (when (and (not *print-pretty*) (= *print-base* 10))
+          (incf sum))))))
+
+(defun time-read-global-special (&optional (nthreads 1) (n 100000000))
+  (time-in-threads nthreads #'read-global-special n))
+
+(defun time-read-bound-special (&optional (nthreads 1) (n 100000000))
+  (time-in-threads nthreads #'read-bound-special n))
+
+(defun time-bind-special (&optional (nthreads 1) (n 10000000))
+  (time-in-threads nthreads #'bind-special n))
+
+(defun time-bind-printer-specials (&optional (nthreads 1) (n 10000000))
+  (time-in-threads nthreads #'bind-printer-specials n))
+
+(defun run-all (&optional (nthreads 4))
+  (dolist (threads (list 1 nthreads))
+    (time-read-global-special threads)
+    (time-read-bound-special threads)
+    (time-bind-special threads)
+    (time-bind-printer-specials threads)))
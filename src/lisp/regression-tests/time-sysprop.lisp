@@ -0,0 +1,64 @@
+;;; Timing sysprop lookups as the number of reading threads grows, and
+;;; compile-file-parallel on a generated file of defstructs and defuns,
+;;; which looks up sysprops for every type and function name it meets.
+;;; Run it on builds before and after a change to compare.
+
+(load "sys:regression-tests;time-common.lisp")
+
+(defpackage #:time-sysprop
+  (:use #:cl #:clasp-timing)
+  (:export #:run-all))
+
+(in-package #:time-sysprop)
+
+(defparameter *sysprop-symbols*
+  (loop for i below 1000
+        for symbol = (make-symbol (format nil "TIMING-~d" i))
+        do (core:put-sysprop symbol 'timing-area i)
+           (core:put-sysprop symbol 'other-area i)
+        collect symbol))
+
+;;; Each thread looks up every symbol N times, writing once every
+;;; WRITE-EVERY rounds if that is given.
+(defun time-get-sysprop (&optional (nthreads 1) (n 1000) write-every)
+  (seconds-in-threads nthreads
+                      (lambda (n)
+                        (dotimes (round n)
+                          (if (and write-every (zerop (mod round write-every)))
+                              (dolist (symbol *sysprop-symbols*)
+                                (core:put-sysprop symbol 'timing-area round))
+                              (dolist (symbol *sysprop-symbols*)
+                                (core:get-sysprop symbol 'timing-area)))))
+                      n))
+
+(defun write-compile-timing-file (pathname nforms)
+  (with-open-file (stream pathname :direction :output :if-exists :supersede)
+    (let ((*package* (find-package "CL-USER")))
+      (dotimes (i nforms)
+        (format stream "~s~%~s~%"
+                `(defstruct ,(intern (format nil "TIMING-STRUCT-~d" i)) a b c)
+                `(defun ,(intern (format nil "TIMING-FUN-~d" i)) (x)
+                   (declare (type ,(intern (format nil "TIMING-STRUCT-~d" i)) x))
+                   (list (,(intern (format nil "TIMING-STRUCT-~d-A" i)) x)
+                         (,(intern (format nil "TIMING-STRUCT-~d-B" i)) x))))))))
+
+(defun time-compile-file-parallel (&optional (nforms 500))
+  (let ((source (namestring (core:mkstemp "/tmp/time-sysprop-"))))
+    (write-compile-timing-file source nforms)
+    (unwind-protect
+         (let ((start (get-internal-real-time)))
+           (cmp:compile-file-parallel source :output-file (concatenate 'string source ".fasl"))
+           (/ (float (- (get-internal-real-time) start) 1d0)
+              internal-time-units-per-second))
+      (ignore-errors (delete-file source))
+      (ignore-errors (delete-file (concatenate 'string source ".fasl"))))))
+
+(defun run-all (&optional (max-threads 64))
+  (format t "~&threads         get   get+write~%")
+  (loop for threads = 1 then (* 2 threads)
+        while (<= threads max-threads)
+        do (format t "~7d ~11,3f ~11,3f~%"
+                   threads
+                   (time-get-sysprop threads)
+                   (time-get-sysprop threads 1000 10)))
+  (format t "compile-file-parallel ~,3f~%" (time-compile-file-parallel)))
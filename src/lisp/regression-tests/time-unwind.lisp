@@ -0,0 +1,66 @@
+;;; Timing non-local exits.
+
+(load "sys:regression-tests;time-common.lisp")
+
+(defpackage #:time-unwind
+  (:use #:cl)
+  (:export #:run-all))
+
+(in-package #:time-unwind)
+
+;;; THROW lexically inside its CATCH - compiled as a local exit.
+(defun lexical-catch-throw (n)
+  (let ((sum 0))
+    (dotimes (i n sum)
+      (incf sum (catch 'lexical (when (evenp i) (throw 'lexical 1)) 2)))))
+
+;;; THROW from another function - needs a real unwind.
+(defun thrower (i)
+  (when (evenp i) (throw 'dynamic 1))
+  2)
+
+(defun dynamic-catch-throw (n)
+  (let ((sum 0))
+    (dotimes (i n sum)
+      (incf sum (catch 'dynamic (thrower i))))))
+
+;;; RETURN-FROM out of a closure passed to another function,
+;;; as in an early exit from a search.
+(defun closure-return-from (n)
+  (let ((v (make-array 16 :initial-element 0))
+        (found 0))
+    (setf (aref v 8) 1)
+    (dotimes (i n found)
+      (when (block search
+              (map nil (lambda (x) (when (eql x 1) (return-from search t))) v)
+              nil)
+        (incf found)))))
+
+;;; Same thing written with CATCH/THROW as older code often does.
+(defun closure-throw (n)
+  (let ((v (make-array 16 :initial-element 0))
+        (found 0))
+    (setf (aref v 8) 1)
+    (dotimes (i n found)
+      (when (catch 'search
+              (map nil (lambda (x) (when (eql x 1) (throw 'search t))) v)
+              nil)
+        (incf found)))))
+
+(defun time-lexical-catch-throw (&optional (n 10000000))
+  (time (lexical-catch-throw n)))
+
+(defun time-dynamic-catch-throw (&optional (n 1000000))
+  (time (dynamic-catch-throw n)))
+
+(defun time-closure-return-from (&optional (n 1000000))
+  (time (closure-return-from n)))
+
+(defun time-closure-throw (&optional (n 1000000))
+  (time (closure-throw n)))
+
+(defun run-all ()
+  (time-lexical-catch-throw)
+  (time-dynamic-catch-throw)
+  (time-closure-return-from)
+  (time-closure-throw))
@@ -525,37 +525,6 @@ CL_DEFUN core::T_sp jit_code_entries() {
 }
 
 
-CL_DOCSTRING(R"dx(Generate a list of JITted symbols to /tmp/perf-<pid>.map)dx")
-DOCGROUP(clasp)
-CL_DEFUN void ext__generate_perf_map() {
-  stringstream ss;
-  ss << "/tmp/perf-" << getpid() << ".map";
-  core::write_bf_stream(fmt::sprintf("Writing to %s\n" , ss.str()));
-  FILE* fout = fopen(ss.str().c_str(),"w");
-  jit_code_entry* jce = __jit_debug_descriptor.first_entry;
-  ql::list ll;
-  size_t idx;
-  while (jce) {
-    const char* of_start = jce->symfile_addr;
-    size_t of_length = jce->symfile_size;
-    llvm::StringRef sbuffer((const char*)of_start, of_length);
-    stringstream ss;
-    ss << "buffer" << (void*)of_start;
-    std::string mem = ss.str();
-    llvm::StringRef name(mem);
-    std::unique_ptr<llvm::MemoryBuffer> memoryBuffer(llvm::MemoryBuffer::getMemBuffer(sbuffer,name,false));
-    llvm::MemoryBufferRef memr = *(memoryBuffer);
-    llvm::Expected<std::unique_ptr<llvm::object::ObjectFile>> obj = llvm::object::ObjectFile::createObjectFile(memr);
-    for ( auto sym : (*obj)->symbols() ) {
-      if ((*sym.getAddress())!=0)
-        fprintf(fout,"%lX %lX %s\n", (uintptr_t)(*sym.getAddress()), (size_t)sym.getCommonSize(), (sym).getName()->str().c_str() );
-    }
-    jce = jce->next_entry;
-  }
-  fclose(fout);
-}
-
-
 CL_LISPIFY_NAME(describe_code);
 DOCGROUP(clasp)
 CL_DEFUN void describe_code() {
@@ -9,6 +9,7 @@
            #~"irtests.cc"
            #~"llvmoExpose.cc"
            #~"code.cc"
+           #~"jitProfiling.cc"
            #~"llvmoPackage.cc"
            #~"clbindLlvmExpose.cc")
 
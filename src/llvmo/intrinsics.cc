@@ -117,6 +117,18 @@ ALWAYS_INLINE core::T_O* cc_ensure_valid_object(core::T_O* tagged_object)
   NO_UNWIND_END();
 }
 
+/* Every special variable reference in compiled code comes here, and
+   it is inlined. The binding index is loaded from the symbol rather than
+   baked into the code as a load-time constant for two reasons.
+   The index of every symbol is cleared when a snapshot is saved (see
+   Symbol_O::fixupInternalsForSnapshotSaveLoad), so an index in the
+   literals of a saved function would name some other variable after
+   the snapshot is loaded.
+   The bindings of a thread live in a vector that grows as indices are
+   handed out, not at a fixed offset from the thread pointer, so the
+   code would still have to load the vector and bounds check the index.
+   Loading the index is one more load from a symbol that is already in
+   a register. */
 ALWAYS_INLINE T_O *cc_safe_symbol_value(core::T_O *sym) {
   core::Symbol_O *symP = reinterpret_cast<core::Symbol_O *>(gctools::untag_general<core::T_O *>(sym));
   T_O *sv = symP->symbolValueUnsafe().raw_();
@@ -864,6 +876,17 @@ ALWAYS_INLINE core::T_O* to_object_pointer( void * x )
   return clasp_ffi::ForeignData_O::create(x).raw_();
 }
 
+// The address offset bytes past ptr, which is anything clasp-ffi:%mem-ref accepts.
+// Used by the inlined FLI memory accessors (see the fli-ref/fli-set primops).
+ALWAYS_INLINE char* cc_fli_address( core::T_O* ptr, int64_t offset )
+{
+  T_sp tptr((gctools::Tagged)ptr);
+  if (tptr.fixnump()) {
+    return (char*)tptr.unsafe_fixnum() + offset;
+  }
+  return (char*)from_object_pointer(ptr) + offset;
+}
+
 
 
 
@@ -0,0 +1,363 @@
+/*
+    File: jitProfiling.cc
+*/
+
+/*
+Copyright (c) 2014, Christian E. Schafmeister
+
+CLASP is free software; you can redistribute it and/or
+modify it under the terms of the GNU Library General Public
+License as published by the Free Software Foundation; either
+version 2 of the License, or (at your option) any later version.
+
+See directory 'clasp/licenses' for full details.
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+/* -^- */
+
+// Let perf see JITted code.
+//
+// perf map: /tmp/perf-<pid>.map, one "address size name" line per function.
+//   perf report reads it when it finds samples in anonymous executable memory.
+// jitdump: <dir>/jit-<pid>.dump in the format described in the linux sources
+//   (tools/perf/Documentation/jitdump-specification.txt).  It has the code bytes
+//   and line numbers, so "perf inject --jit" can make real ELF files for the
+//   JITted functions and perf annotate works on them.  The file has to be
+//   mmap'd executable so that "perf record -k mono" notices it.
+//
+// Records are written as each object file is linked (ClaspReturnObjectBuffer),
+// which also happens for every object file loaded from a snapshot, so code
+// from the snapshot is described again at startup.
+// The functions and their sizes come from the ELF symbol table of the object
+// file; the old ext:generate-perf-map used getCommonSize, which is only
+// meaningful for common symbols and gave garbage sizes for functions.
+
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#ifdef _TARGET_OS_LINUX
+#include <sys/syscall.h>
+#endif
+#include <llvm/Object/ObjectFile.h>
+#include <llvm/Object/ELFObjectFile.h>
+#include <llvm/DebugInfo/DWARF/DWARFContext.h>
+#include <clasp/core/foundation.h>
+#include <clasp/core/lisp.h>
+#include <clasp/core/lispStream.h>
+#include <clasp/core/array.h>
+#include <clasp/core/sequence.h>
+#include <clasp/core/mpPackage.h>
+#include <clasp/llvmo/code.h>
+#include <clasp/llvmo/jitProfiling.h>
+#include <clasp/core/wrappers.h>
+
+namespace llvmo {
+
+#define JITDUMP_MAGIC 0x4A695444
+#define JITDUMP_VERSION 1
+#define JIT_CODE_LOAD 0
+#define JIT_CODE_DEBUG_INFO 2
+
+struct JitDumpFileHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t total_size;
+  uint32_t elf_mach;
+  uint32_t pad1;
+  uint32_t pid;
+  uint64_t timestamp;
+  uint64_t flags;
+};
+
+struct JitDumpRecordHeader {
+  uint32_t id;
+  uint32_t total_size;
+  uint64_t timestamp;
+};
+
+struct JitDumpCodeLoad {
+  JitDumpRecordHeader header;
+  uint32_t pid;
+  uint32_t tid;
+  uint64_t vma;
+  uint64_t code_addr;
+  uint64_t code_size;
+  uint64_t code_index;
+  // followed by the name and the code bytes
+};
+
+struct JitDumpDebugInfo {
+  JitDumpRecordHeader header;
+  uint64_t code_addr;
+  uint64_t nr_entry;
+  // followed by nr_entry debug entries
+};
+
+struct JitDumpDebugEntry {
+  uint64_t addr;
+  int32_t lineno;
+  int32_t discrim;
+  // followed by the file name
+};
+
+struct JITProfiling {
+  bool        _CheckedEnvironment = false;
+  pid_t       _Pid = 0;
+  bool        _WantPerfMap = false;
+  bool        _WantJitDump = false;
+  std::string _JitDumpDirectory;
+  FILE*       _PerfMap = NULL;
+  FILE*       _JitDump = NULL;
+  void*       _JitDumpMarker = NULL;
+  uint64_t    _CodeIndex = 0;
+};
+
+JITProfiling global_JITProfiling;
+mp::Mutex global_JITProfilingMutex(JITPROFL_NAMEWORD);
+
+static uint64_t jitdump_timestamp() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static uint32_t jitdump_elf_machine() {
+#if defined(__x86_64__)
+  return 62; // EM_X86_64
+#elif defined(__aarch64__)
+  return 183; // EM_AARCH64
+#else
+  return 0;
+#endif
+}
+
+static void jit_profiling_close() {
+  JITProfiling& prof = global_JITProfiling;
+  if (prof._PerfMap) fclose(prof._PerfMap);
+  prof._PerfMap = NULL;
+  if (prof._JitDump) {
+    if (prof._JitDumpMarker) munmap(prof._JitDumpMarker, sysconf(_SC_PAGESIZE));
+    fclose(prof._JitDump);
+  }
+  prof._JitDump = NULL;
+  prof._JitDumpMarker = NULL;
+}
+
+// Open the files for the current process. Called again after a fork,
+// since the file names have the pid in them.
+static void jit_profiling_open() {
+  JITProfiling& prof = global_JITProfiling;
+  jit_profiling_close();
+  prof._Pid = getpid();
+  if (prof._WantPerfMap) {
+    std::string name = fmt::sprintf("/tmp/perf-%d.map", prof._Pid);
+    prof._PerfMap = fopen(name.c_str(), "w");
+    if (!prof._PerfMap)
+      fprintf(stderr, "%s:%d Could not open %s for the perf map: %s\n", __FILE__, __LINE__, name.c_str(), strerror(errno));
+  }
+  if (prof._WantJitDump) {
+    std::string name = fmt::sprintf("%s/jit-%d.dump", prof._JitDumpDirectory, prof._Pid);
+    int fd = open(name.c_str(), O_CREAT | O_TRUNC | O_RDWR, 0666);
+    if (fd < 0) {
+      fprintf(stderr, "%s:%d Could not open %s for the jitdump: %s\n", __FILE__, __LINE__, name.c_str(), strerror(errno));
+      return;
+    }
+    // perf record finds the jitdump file through this executable mapping.
+    prof._JitDumpMarker = mmap(NULL, sysconf(_SC_PAGESIZE), PROT_READ | PROT_EXEC, MAP_PRIVATE, fd, 0);
+    if (prof._JitDumpMarker == MAP_FAILED) prof._JitDumpMarker = NULL;
+    prof._JitDump = fdopen(fd, "w+");
+    JitDumpFileHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = JITDUMP_MAGIC;
+    header.version = JITDUMP_VERSION;
+    header.total_size = sizeof(header);
+    header.elf_mach = jitdump_elf_machine();
+    header.pid = prof._Pid;
+    header.timestamp = jitdump_timestamp();
+    fwrite(&header, sizeof(header), 1, prof._JitDump);
+    fflush(prof._JitDump);
+  }
+}
+
+static bool jit_profiling_active() {
+  JITProfiling& prof = global_JITProfiling;
+  if (!prof._CheckedEnvironment) {
+    prof._CheckedEnvironment = true;
+    const char* perf_map = getenv("CLASP_PERF_MAP");
+    if (perf_map && *perf_map && strcmp(perf_map, "0") != 0) prof._WantPerfMap = true;
+    const char* jitdump = getenv("CLASP_JITDUMP");
+    if (jitdump && *jitdump && strcmp(jitdump, "0") != 0) {
+      prof._WantJitDump = true;
+      prof._JitDumpDirectory = (strcmp(jitdump, "1") == 0) ? "/tmp" : jitdump;
+    }
+  }
+  if (!(prof._WantPerfMap || prof._WantJitDump)) return false;
+  if (prof._Pid != getpid()) jit_profiling_open();
+  return true;
+}
+
+static void jitdump_write_debug_info(FILE* fout, uintptr_t address, size_t size,
+                                     llvm::DWARFContext* dwarf, uint64_t sectionIndex, uint64_t offset) {
+  llvm::DILineInfoSpecifier spec(llvm::DILineInfoSpecifier::FileLineInfoKind::AbsoluteFilePath,
+                                 llvm::DILineInfoSpecifier::FunctionNameKind::None);
+  llvm::object::SectionedAddress sa;
+  sa.SectionIndex = sectionIndex;
+  sa.Address = offset;
+  llvm::DILineInfoTable lines = dwarf->getLineInfoForAddressRange(sa, size, spec);
+  if (lines.empty()) return;
+  size_t total = sizeof(JitDumpDebugInfo);
+  for (auto& line : lines) total += sizeof(JitDumpDebugEntry) + line.second.FileName.size() + 1;
+  JitDumpDebugInfo record;
+  record.header.id = JIT_CODE_DEBUG_INFO;
+  record.header.total_size = total;
+  record.header.timestamp = jitdump_timestamp();
+  record.code_addr = address;
+  record.nr_entry = lines.size();
+  fwrite(&record, sizeof(record), 1, fout);
+  for (auto& line : lines) {
+    JitDumpDebugEntry entry;
+    entry.addr = address + (line.first - offset);
+    entry.lineno = line.second.Line;
+    entry.discrim = line.second.Discriminator;
+    fwrite(&entry, sizeof(entry), 1, fout);
+    fwrite(line.second.FileName.c_str(), line.second.FileName.size() + 1, 1, fout);
+  }
+}
+
+static void jitdump_write_code_load(FILE* fout, const std::string& name, uintptr_t address, size_t size) {
+  JITProfiling& prof = global_JITProfiling;
+  JitDumpCodeLoad record;
+  record.header.id = JIT_CODE_LOAD;
+  record.header.total_size = sizeof(record) + name.size() + 1 + size;
+  record.header.timestamp = jitdump_timestamp();
+  record.pid = prof._Pid;
+#ifdef _TARGET_OS_LINUX
+  record.tid = (uint32_t)syscall(SYS_gettid);
+#else
+  record.tid = prof._Pid;
+#endif
+  record.vma = address;
+  record.code_addr = address;
+  record.code_size = size;
+  record.code_index = prof._CodeIndex++;
+  fwrite(&record, sizeof(record), 1, fout);
+  fwrite(name.c_str(), name.size() + 1, 1, fout);
+  fwrite((const void*)address, size, 1, fout);
+}
+
+// Write records for every function in the text section of ofi to the open files.
+// The caller holds global_JITProfilingMutex.
+static void jit_profiling_write_object_file(ObjectFile_sp ofi, FILE* perfMap, FILE* jitDump) {
+  if (!ofi->_MemoryBuffer) return;
+  auto eobj = ofi->getObjectFile();
+  if (!eobj) {
+    llvm::consumeError(eobj.takeError());
+    return;
+  }
+  llvm::object::ObjectFile& obj = **eobj;
+  // Only ELF symbols know their sizes.
+  if (!obj.isELF()) return;
+  Code_sp code = ofi->_Code;
+  uintptr_t textStart = (uintptr_t)code->_TextSectionStart;
+  std::unique_ptr<llvm::DWARFContext> dwarf;
+  if (jitDump) dwarf = llvm::DWARFContext::create(obj);
+  for (auto sym : obj.symbols()) {
+    auto etype = sym.getType();
+    if (!etype) { llvm::consumeError(etype.takeError()); continue; }
+    if (*etype != llvm::object::SymbolRef::ST_Function) continue;
+    auto esection = sym.getSection();
+    if (!esection) { llvm::consumeError(esection.takeError()); continue; }
+    if (*esection == obj.section_end() || (*esection)->getIndex() != code->_TextSectionId) continue;
+    auto eoffset = sym.getAddress();
+    if (!eoffset) { llvm::consumeError(eoffset.takeError()); continue; }
+    auto ename = sym.getName();
+    if (!ename) { llvm::consumeError(ename.takeError()); continue; }
+    uint64_t size = llvm::object::ELFSymbolRef(sym).getSize();
+    if (size == 0) continue;
+    uintptr_t address = textStart + *eoffset;
+    std::string name = ename->str();
+    if (perfMap) fprintf(perfMap, "%lx %lx %s\n", (unsigned long)address, (unsigned long)size, name.c_str());
+    if (jitDump) {
+      if (dwarf) jitdump_write_debug_info(jitDump, address, size, dwarf.get(), code->_TextSectionId, *eoffset);
+      jitdump_write_code_load(jitDump, name, address, size);
+    }
+  }
+  if (perfMap) fflush(perfMap);
+  if (jitDump) fflush(jitDump);
+}
+
+void jit_profiling_register_object_file(ObjectFile_sp ofi) {
+  mp::RAIIReadWriteLock<mp::Mutex> lock(global_JITProfilingMutex);
+  if (!jit_profiling_active()) return;
+  JITProfiling& prof = global_JITProfiling;
+  jit_profiling_write_object_file(ofi, prof._PerfMap, prof._JitDump);
+}
+
+static void jit_profiling_write_all_object_files(FILE* perfMap, FILE* jitDump) {
+  core::List_sp objectFiles = core::cl__reverse(_lisp->_Roots._AllObjectFiles.load());
+  for (auto cur : objectFiles) {
+    jit_profiling_write_object_file(gc::As<ObjectFile_sp>(CONS_CAR(cur)), perfMap, jitDump);
+  }
+}
+
+CL_LAMBDA(&key (perf-map t) jitdump)
+CL_DOCSTRING(R"dx(Start describing JITted code to perf. If PERF-MAP is true /tmp/perf-<pid>.map is written.
+If JITDUMP is true a jitdump file jit-<pid>.dump is written for perf inject --jit, in the directory JITDUMP
+if it is a string and in /tmp otherwise. Code that is already loaded is written out immediately, and every object
+file linked afterwards is appended as it is linked.
+The same thing can be done from startup with the environment variables CLASP_PERF_MAP=1 and CLASP_JITDUMP=1 or CLASP_JITDUMP=<dir>.)dx")
+DOCGROUP(clasp)
+CL_DEFUN void ext__jit_profiling_start(core::T_sp perf_map, core::T_sp jitdump) {
+  mp::RAIIReadWriteLock<mp::Mutex> lock(global_JITProfilingMutex);
+  JITProfiling& prof = global_JITProfiling;
+  prof._CheckedEnvironment = true;
+  prof._WantPerfMap = perf_map.notnilp();
+  prof._WantJitDump = jitdump.notnilp();
+  if (gc::IsA<core::String_sp>(jitdump))
+    prof._JitDumpDirectory = gc::As_unsafe<core::String_sp>(jitdump)->get_std_string();
+  else prof._JitDumpDirectory = "/tmp";
+  jit_profiling_open();
+  jit_profiling_write_all_object_files(prof._PerfMap, prof._JitDump);
+}
+
+CL_DOCSTRING(R"dx(Stop writing the perf map and jitdump files started by ext:jit-profiling-start or the environment.)dx")
+DOCGROUP(clasp)
+CL_DEFUN void ext__jit_profiling_stop() {
+  mp::RAIIReadWriteLock<mp::Mutex> lock(global_JITProfilingMutex);
+  JITProfiling& prof = global_JITProfiling;
+  prof._CheckedEnvironment = true;
+  prof._WantPerfMap = false;
+  prof._WantJitDump = false;
+  jit_profiling_close();
+  prof._Pid = 0;
+}
+
+CL_DOCSTRING(R"dx(Write the JITted functions loaded so far to /tmp/perf-<pid>.map.
+To keep the file up to date as more code is compiled use ext:jit-profiling-start instead.)dx")
+DOCGROUP(clasp)
+CL_DEFUN void ext__generate_perf_map() {
+  mp::RAIIReadWriteLock<mp::Mutex> lock(global_JITProfilingMutex);
+  std::string name = fmt::sprintf("/tmp/perf-%d.map", getpid());
+  if (global_JITProfiling._PerfMap) {
+    core::write_bf_stream(fmt::sprintf("%s is already being written continuously\n", name));
+    return;
+  }
+  core::write_bf_stream(fmt::sprintf("Writing to %s\n" , name));
+  FILE* fout = fopen(name.c_str(), "w");
+  if (!fout) SIMPLE_ERROR(("Could not open %s: %s"), name, strerror(errno));
+  jit_profiling_write_all_object_files(fout, NULL);
+  fclose(fout);
+}
+
+};
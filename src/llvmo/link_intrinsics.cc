@@ -67,6 +67,7 @@ extern "C" {
 #include <clasp/llvmo/code.h>
 #include <clasp/gctools/gc_interface.fwd.h>
 #include <clasp/core/exceptions.h>
+#include <clasp/gctools/interrupt.h>
 
 #if defined(_TARGET_OS_DARWIN)
 #include <mach-o/ldsyms.h>
@@ -585,6 +586,18 @@ void cc_unset_breakstep() {
   my_thread->_Breakstep = false;
 }
 
+// Called by a safepoint poll in compiled code when clasp_safepoint_requests
+// is nonzero.
+NOINLINE void cc_safepoint() {
+  gctools::safepoint();
+}
+
+// A use of object that the optimizer can't see through, so object stays live
+// (and, held by the caller's frame, unmoved) up to the call.  See core:keep-alive.
+NOINLINE void cc_keep_alive(core::T_O* object) {
+  __asm__ __volatile__("" : : "r"(object) : "memory");
+}
+
 // RAII thing to toggle breakstep while respecting nonlocal exit.
 struct BreakstepToggle {
   ThreadLocalState* mthread;
@@ -139,6 +139,8 @@ Error enableObjCRegistration(const char *PathToLibObjC);
 #include <clasp/llvmo/insertPoint.h>
 #include <clasp/llvmo/debugLoc.h>
 #include <clasp/llvmo/intrinsics.h>
+#include <clasp/llvmo/jitProfiling.h>
+#include <clasp/gctools/metrics.h>
 #include <clasp/core/external_wrappers.h>
 #include <clasp/core/wrappers.h>
 #include <clasp/core/symbolTable.h>
@@ -4696,6 +4698,7 @@ void ClaspReturnObjectBuffer(std::unique_ptr<llvm::MemoryBuffer> buffer) {
   printf("%s:%d:%s Add support to set _TextSectionID for this os\n", __FILE__, __LINE__, __FUNCTION__);
 #endif
   save_object_file_and_code_info(my_thread->topObjectFile());
+  jit_profiling_register_object_file(my_thread->topObjectFile());
   buffer.reset();
 }
 
@@ -5083,7 +5086,12 @@ void* ClaspJIT_O::runStartupCode(JITDylib& dylib, const std::string& startupName
 {
   DEBUG_OBJECT_FILES_PRINT(("%s:%d:%s About to evaluate the LoadtimeCode - with startupName: %s\n", __FILE__, __LINE__, __FUNCTION__, startupName.c_str() ));
   void* ptr;
-  bool found = this->do_lookup(dylib,startupName,ptr);
+  bool found;
+  {
+    // The lookup is what compiles and links the module.
+    gctools::metrics::RAIITimer timer(gctools::metrics::global_JITCompileTime);
+    found = this->do_lookup(dylib,startupName,ptr);
+  }
   if (!found) {
     SIMPLE_ERROR(("Could not find function %s - exit program and look at llvm::errs() stream") , startupName.c_str() );
   }
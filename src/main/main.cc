@@ -563,6 +563,9 @@ int main( int argc, char *argv[] )
   // - COMMAND LINE OPTONS HANDLING
 
   core::CommandLineOptions options(argc, argv);
+  gctools::global_gc_markers = options._GcMarkers;
+  gctools::global_heap_min = options._HeapMin;
+  gctools::global_heap_max = options._HeapMax;
 
   // - MPI ENABLEMENT
 
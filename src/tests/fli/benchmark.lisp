@@ -0,0 +1,93 @@
+;;;; -*- Mode: lisp; indent-tabs-mode: nil -*-
+;;;
+;;; benchmark.lisp --- Timing FLI memory access and foreign calls.
+;;;
+;;; Not part of the test suite; load bindings.lisp (for libtest) and then
+;;; this file, and call (run-all-benchmarks) or the individual time- functions.
+;;; With cclasp the accessors below, whose foreign types are constant and
+;;; whose offsets are known fixnums, compile to direct loads and stores, and
+;;; the calls pass their floats unboxed, so none of the loops should cons.
+
+(in-package #:clasp-ffi.tests)
+
+(defun sum-doubles (pointer n)
+  (let ((sum 0d0))
+    (declare (double-float sum))
+    (dotimes (i n sum)
+      (incf sum (%mem-ref pointer :double (the fixnum (* i 8)))))))
+
+(defun sum-int32s (pointer n)
+  (let ((sum 0))
+    (declare (fixnum sum))
+    (dotimes (i n sum)
+      (setf sum (logand most-positive-fixnum
+                        (+ sum (%mem-ref pointer :int32 (the fixnum (* i 4)))))))))
+
+(defun fill-doubles (pointer n)
+  (dotimes (i n)
+    (%mem-set pointer :double (float i 1d0) (the fixnum (* i 8)))))
+
+;;; A record of a double, an int32 and a uint16, as binary parsers see them
+(defun sum-records (pointer n)
+  (let ((sum 0d0))
+    (declare (double-float sum))
+    (dotimes (i n sum)
+      (let ((base (* i 16)))
+        (declare (fixnum base))
+        (incf sum (%mem-ref pointer :double base))
+        (incf sum (float (%mem-ref pointer :int32 (the fixnum (+ base 8))) 1d0))
+        (incf sum (float (%mem-ref pointer :uint16 (the fixnum (+ base 12))) 1d0))))))
+
+(defun call-add-double (n)
+  (let ((sum 0d0))
+    (declare (double-float sum))
+    (dotimes (i n sum)
+      (setf sum (%foreign-funcall "fli_bench_add_double"
+                                  :double sum :double 1d0 :double)))))
+
+(defun call-add-int (n)
+  (let ((sum 0))
+    (dotimes (i n sum)
+      (setf sum (%foreign-funcall "fli_bench_add_int"
+                                  :int (logand sum #xffff) :int 1 :int)))))
+
+(defmacro with-foreign-buffer ((pointer size) &body body)
+  `(let ((,pointer (%foreign-alloc ,size)))
+     (unwind-protect (progn ,@body)
+       (%foreign-free ,pointer))))
+
+(defun time-mem-ref-double (&optional (n 1000000) (repeat 100))
+  (with-foreign-buffer (pointer (* n 8))
+    (fill-doubles pointer n)
+    (time (dotimes (i repeat) (sum-doubles pointer n)))))
+
+(defun time-mem-ref-int32 (&optional (n 1000000) (repeat 100))
+  (with-foreign-buffer (pointer (* n 4))
+    (dotimes (i n) (%mem-set pointer :int32 i (* i 4)))
+    (time (dotimes (i repeat) (sum-int32s pointer n)))))
+
+(defun time-mem-set-double (&optional (n 1000000) (repeat 100))
+  (with-foreign-buffer (pointer (* n 8))
+    (time (dotimes (i repeat) (fill-doubles pointer n)))))
+
+(defun time-mem-ref-records (&optional (n 1000000) (repeat 20))
+  (with-foreign-buffer (pointer (* n 16))
+    (dotimes (i n)
+      (%mem-set pointer :double (float i 1d0) (* i 16))
+      (%mem-set pointer :int32 i (+ (* i 16) 8))
+      (%mem-set pointer :uint16 (logand i #xffff) (+ (* i 16) 12)))
+    (time (dotimes (i repeat) (sum-records pointer n)))))
+
+(defun time-foreign-call-double (&optional (n 10000000))
+  (time (call-add-double n)))
+
+(defun time-foreign-call-int (&optional (n 10000000))
+  (time (call-add-int n)))
+
+(defun run-all-benchmarks ()
+  (time-mem-ref-double)
+  (time-mem-ref-int32)
+  (time-mem-set-double)
+  (time-mem-ref-records)
+  (time-foreign-call-double)
+  (time-foreign-call-int))
@@ -91,6 +91,22 @@ unsigned long long ullong(unsigned long long n)
   return n == ULLONG_MAX ? n : 42;
 }
 
+/*
+ * Trivial functions for timing the cost of a foreign call (benchmark.lisp)
+ */
+
+DLLEXPORT
+double fli_bench_add_double(double a, double b)
+{
+  return a + b;
+}
+
+DLLEXPORT
+int fli_bench_add_int(int a, int b)
+{
+  return a + b;
+}
+
 /*
  * Foreign Globals
  *